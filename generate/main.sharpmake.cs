@@ -56,6 +56,7 @@ class Rynx : Solution
 
         conf.AddProject<TestTech>(target);
         conf.AddProject<TestScheduler>(target);
+        conf.AddProject<TestRulesets>(target);
     }
 }
 
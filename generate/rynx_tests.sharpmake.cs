@@ -44,4 +44,19 @@ public class TestFilesystem : TestProject
     {
         conf.AddPublicDependency<FileSystem>(target);
     }
-}
\ No newline at end of file
+}
+
+[Generate]
+public class TestRulesets : TestProject
+{
+    public TestRulesets()
+    {
+        SourceRootPath = @"[project.SharpmakeCsPath]\..\src\test\rulesets\";
+    }
+
+    [Configure]
+    public void conf_test(Project.Configuration conf, Target target)
+    {
+        conf.AddPublicDependency<RuleSets>(target);
+    }
+}
@@ -75,7 +75,24 @@ void DefaultProcessingFunctionality::logic_frame_start() {
   auto scoped_inhibitor = menuSystem.inhibit_dedicated_inputs(gameInput);
   {
     rynx_profile("Main", "Construct frame tasks");
-    m_host->simulation().generate_tasks(m_dt);
+    if (m_host->pipelined_frames()) {
+      // previous frame is copied for rendering at the start of this frame,
+      // and then prepared for rendering while this frame simulates.
+      rynx::scheduler::barrier snapshot_taken = m_host->snapshot_for_rendering();
+      {
+        rynx::scheduler::scoped_barrier_before after_snapshot(
+            *m_host->simulation_context());
+        after_snapshot.addDependency(snapshot_taken);
+        m_host->simulation().generate_tasks(m_dt);
+      }
+
+      rynx::scheduler::scoped_barrier_before after_snapshot(
+          *m_host->render_context());
+      after_snapshot.addDependency(snapshot_taken);
+      prepare_rendering(m_host->render_context());
+    } else {
+      m_host->simulation().generate_tasks(m_dt);
+    }
   }
 
   {
@@ -109,19 +126,32 @@ void DefaultProcessingFunctionality::menu_frame_execute() {
   menuSystem.update(m_dt, m_host->aspectRatio());
 }
 
+void DefaultProcessingFunctionality::prepare_rendering(
+    rynx::scheduler::context *ctx) {
+  auto &render = *m_host->rendering_steps();
+  render.light_global_ambient({1.0f, 1.0f, 1.0f, 1.0f});
+  render.light_global_directed({1.0f, 1.0f, 1.0f, 1.0f}, {1.0f, 0.0f, 0.0f});
+
+  // the snapshot gets its render components from the simulation.
+  if (m_host->pipelined_frames()) {
+    render.prepare_passes(ctx);
+  } else {
+    render.prepare(ctx);
+  }
+}
+
 void DefaultProcessingFunctionality::render() {
   if (true) {
     rynx::timer render_calls_timer;
     rynx_profile("Main", "graphics");
+    const bool pipelined = m_host->pipelined_frames();
 
     {
       rynx_profile("Main", "prepare");
-      auto &render = *m_host->rendering_steps();
-      render.light_global_ambient({1.0f, 1.0f, 1.0f, 1.0f});
-      render.light_global_directed({1.0f, 1.0f, 1.0f, 1.0f},
-                                   {1.0f, 0.0f, 0.0f});
-      render.prepare(m_host->simulation().m_context.get());
-      m_host->scheduler().start_frame();
+      if (!pipelined) {
+        prepare_rendering(m_host->simulation().m_context.get());
+        m_host->scheduler().start_frame();
+      }
 
       // while waiting for computing to be completed, draw menus.
       {
@@ -156,7 +186,9 @@ void DefaultProcessingFunctionality::render() {
         };
       }
 
-      m_host->scheduler().wait_until_complete();
+      if (!pipelined) {
+        m_host->scheduler().wait_until_complete();
+      }
     }
 
     {
@@ -206,6 +238,9 @@ void rynx::application::Application::openWindow(int width, int height,
   m_rendering_steps = rynx::make_unique<rynx::application::renderer>(
       textures(), shaders(), renderer(),
       this->simulation_context()->get_resource_ptr<rynx::camera>());
+  if (m_pipelined_frames) {
+    m_rendering_steps->set_camera(&m_render_camera);
+  }
 
   on_resize([this](size_t width, size_t height) {
     rendering_steps()->on_resolution_change(width, height);
@@ -213,6 +248,48 @@ void rynx::application::Application::openWindow(int width, int height,
   rendering_steps()->on_resolution_change(width, height);
 }
 
+rynx::application::Application &
+rynx::application::Application::enable_pipelined_frames(bool enabled) {
+  if (enabled && !m_render_context) {
+    m_render_context = m_scheduler.make_context();
+    m_render_context->set_resource(m_render_snapshot);
+    m_render_context->set_resource(m_render_camera);
+    m_render_owned_types.set(
+        rynx::type_index::id<rynx::components::transform::matrix>());
+  }
+
+  // simulation may move the camera while the previous frame is rendered.
+  if (m_rendering_steps) {
+    m_rendering_steps->set_camera(enabled ? &m_render_camera : &m_camera);
+  }
+  m_pipelined_frames = enabled;
+  return *this;
+}
+
+rynx::scheduler::barrier
+rynx::application::Application::snapshot_for_rendering() {
+  // render components are added to the simulation, so that the snapshot keeps
+  // the same categories from frame to frame.
+  if (m_rendering_steps) {
+    m_rendering_steps->add_render_components(*m_simulation.m_ecs);
+  }
+  m_render_camera = m_camera;
+
+  rynx::scheduler::barrier snapshot_taken("render snapshot");
+  m_render_context
+      ->add_task("render snapshot",
+                 [this](rynx::scheduler::task &task_context) {
+                   const uint64_t changed_since = std::exchange(
+                       m_render_snapshot_version, rynx::ecs::change_version());
+                   m_simulation.m_ecs->mirror_to(m_render_snapshot,
+                                                 changed_since,
+                                                 m_render_owned_types,
+                                                 task_context);
+                 })
+      .required_for(snapshot_taken);
+  return snapshot_taken;
+}
+
 void rynx::application::Application::loadTextures(rynx::string path) {
   m_textures->loadTexturesFromPath(path);
 }
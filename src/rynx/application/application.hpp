@@ -60,6 +60,10 @@ namespace rynx {
 				rynx::shared_ptr<rynx::graphics::framebuffer> m_fbo_menu;
 				rynx::shared_ptr<rynx::camera> m_menuCamera;
 
+			private:
+				void prepare_rendering(rynx::scheduler::context* ctx);
+
+			public:
 				rynx::timer m_wall_clock_frame_timer;
 				rynx::timer m_render_timer;
 				float m_dt = 0.016f;
@@ -79,6 +83,19 @@ namespace rynx {
 				return *this;
 			}
 
+			// with pipelined frames, rendering of frame N is prepared from a snapshot of the ecs on the same
+			// scheduler frame that simulates frame N+1. the snapshot has its own camera. call between frames.
+			Application& enable_pipelined_frames(bool enabled = true);
+			bool pipelined_frames() const { return m_pipelined_frames; }
+
+			// context where rendering is prepared. the simulation context, unless frames are pipelined.
+			rynx::scheduler::context* render_context() { return m_pipelined_frames ? m_render_context.get() : simulation_context(); }
+
+			// adds a task that brings the render snapshot up to date with the simulation, at the start of the next frame.
+			// simulation and render preparation tasks of that frame must depend on the returned barrier. call between frames,
+			// after the previous snapshot is drawn.
+			rynx::scheduler::barrier snapshot_for_rendering();
+
 			void openWindow(int width = 1000, int height = 1000, rynx::string name = "Rynx Application");
 			void loadTextures(rynx::string path);
 			void startFrame();
@@ -118,6 +135,12 @@ namespace rynx {
 			rynx::shared_ptr<rynx::graphics::renderer> m_renderer;
 			
 			rynx::camera m_camera;
+			rynx::camera m_render_camera;
+			rynx::ecs m_render_snapshot; // simulation state of the previous frame, while the next one simulates.
+			uint64_t m_render_snapshot_version = 0; // change version when the snapshot was last updated.
+			dynamic_bitset m_render_owned_types; // components that render preparation derives in the snapshot.
+			rynx::observer_ptr<rynx::scheduler::context> m_render_context;
+			bool m_pipelined_frames = false;
 			std::vector<rynx::function<void(size_t, size_t)>> m_resizeCallbacks;
 			bool m_window_resized = false;
 		};
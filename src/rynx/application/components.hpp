@@ -140,8 +140,8 @@ namespace rynx {
 			};
 
 			struct translucent {}; // tag for partially see-through objects. graphics needs to know.
-			struct ANNOTATE("hidden") frustum_culled : public rynx::ecs_no_serialize_tag {}; // object is not visible due to frustum culling.
-			struct invisible {}; // tag to prevent rendering of object.
+			struct ANNOTATE("hidden") frustum_culled : public rynx::ecs_no_serialize_tag, public rynx::ecs_sparse_tag {}; // object is not visible due to frustum culling.
+			struct invisible : public rynx::ecs_sparse_tag {}; // tag to prevent rendering of object.
 		}
 
 		namespace phys {
@@ -22,6 +22,7 @@ rynx::scheduler::barrier rynx::application::logic::iruleset::barrier() const { r
 
 void rynx::application::logic::iruleset::required_for(iruleset& other) {
 	other.m_dependOn.emplace_back(rynx::make_unique<rynx::scheduler::barrier>(*m_barrier));
+	other.structure_changed(); // recorded tasks of the other ruleset do not wait for this one yet.
 }
 
 rynx::serialization::vector_writer rynx::application::logic::iruleset::apply_to_all::serialize(rynx::scheduler::context& context) {
@@ -43,10 +44,27 @@ rynx::application::logic& rynx::application::logic::add_ruleset(rynx::unique_ptr
 }
 
 void rynx::application::logic::generate_tasks(rynx::scheduler::context& context, float dt) {
+	m_parameters.dt = dt;
 	for (auto& ruleset : m_rules) {
-		if (ruleset->state_id().is_enabled()) {
+		if (!ruleset->state_id().is_enabled()) {
+			continue;
+		}
+
+		if (!ruleset->replayable()) {
 			ruleset->process(context, dt);
+			continue;
 		}
+
+		if (ruleset->m_recorded && !ruleset->m_structure_changed) {
+			context.replay(ruleset->m_recorded_frame);
+			continue;
+		}
+
+		ruleset->m_structure_changed = false;
+		context.begin_recording(ruleset->m_recorded_frame);
+		ruleset->process(context, dt);
+		context.end_recording();
+		ruleset->m_recorded = true;
 	}
 }
 
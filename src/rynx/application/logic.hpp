@@ -4,6 +4,7 @@
 #include <rynx/tech/binary_config.hpp>
 #include <rynx/std/memory.hpp>
 #include <rynx/std/string.hpp>
+#include <rynx/scheduler/task_graph.hpp>
 
 #include <vector>
 #include <queue>
@@ -22,6 +23,10 @@ namespace rynx {
 	namespace application {
 		class logic {
 		public:
+			// per frame values for tasks of replayed frames, which can not capture them. set as a resource of the simulation context.
+			struct frame_parameters {
+				float dt = 0;
+			};
 
 			class iruleset {
 			public:
@@ -51,6 +56,14 @@ namespace rynx {
 					return m_state_id;
 				}
 
+				// replayable rulesets create the same tasks every frame, and their tasks read per frame values from context resources.
+				// the tasks of a replayable ruleset are recorded on its first frame and replayed on later frames,
+				// rulesets that are not replayable create their tasks again every frame next to them.
+				virtual bool replayable() const { return false; }
+
+				// tasks of this ruleset must be created again on next frame, for example after the ruleset configuration has changed.
+				void structure_changed() { m_structure_changed = true; }
+
 				virtual void on_entities_erased(rynx::scheduler::context&, const std::vector<rynx::id>&) {}
 				virtual void clear(rynx::scheduler::context&) {}
 				virtual void serialize(rynx::scheduler::context&, rynx::serialization::vector_writer&) {}
@@ -83,6 +96,10 @@ namespace rynx {
 				rynx::binary_config::id m_state_id;
 				rynx::unique_ptr<rynx::scheduler::barrier> m_barrier;
 				std::vector<rynx::unique_ptr<rynx::scheduler::barrier>> m_dependOn;
+				bool m_structure_changed = false;
+
+				rynx::scheduler::task_graph m_recorded_frame;
+				bool m_recorded = false;
 			};
 
 			logic& add_ruleset(rynx::unique_ptr<rynx::application::logic::iruleset> ruleset);
@@ -95,8 +112,11 @@ namespace rynx {
 			
 			void deserialize(rynx::scheduler::context& context, rynx::serialization::vector_reader& in);
 
+			frame_parameters& parameters() { return m_parameters; }
+
 		private:
 			std::vector<rynx::unique_ptr<rynx::application::logic::iruleset>> m_rules;
+			frame_parameters m_parameters;
 		};
 	}
 }
@@ -263,10 +263,24 @@ void rynx::application::renderer::execute() {
 }
 
 void rynx::application::renderer::prepare(rynx::scheduler::context* ctx) {
+    add_render_components(ctx->get_resource<rynx::ecs>());
+    prepare_passes(ctx);
+}
 
-    {
-        auto& ecs = ctx->get_resource<rynx::ecs>();
+void rynx::application::renderer::prepare_passes(rynx::scheduler::context* ctx) {
+    geometry_pass->prepare(ctx);
+    lighting_pass->prepare(ctx);
+}
+
+void rynx::application::renderer::set_camera(rynx::observer_ptr<rynx::camera> new_camera) {
+    camera = new_camera;
+    m_omnilights->set_camera(camera);
+    m_directedlights->set_camera(camera);
+    m_ambients->set_camera(camera);
+}
 
+void rynx::application::renderer::add_render_components(rynx::ecs& ecs) {
+    {
         // add missing texture components
         {
             std::vector<rynx::ecs::id> ids =
@@ -309,9 +323,6 @@ void rynx::application::renderer::prepare(rynx::scheduler::context* ctx) {
             }
         }
     }
-
-    geometry_pass->prepare(ctx);
-    lighting_pass->prepare(ctx);
 }
 
 void rynx::application::renderer::geometry_step_insert_front(
@@ -31,6 +31,16 @@ public:
   virtual void execute() override;
   virtual void prepare(rynx::scheduler::context *ctx) override;
 
+  // adds the components that rendering derives from other components, such as
+  // model matrices. prepare does this too, not allowed while tasks are running.
+  void add_render_components(rynx::ecs &ecs);
+
+  // prepare without adding render components, for an ecs that already has them.
+  void prepare_passes(rynx::scheduler::context *ctx);
+
+  // camera used by lights and for drawing. not allowed while tasks are running.
+  void set_camera(rynx::observer_ptr<rynx::camera> camera);
+
   void geometry_step_insert_front(rynx::unique_ptr<igraphics_step>);
 
   void light_global_ambient(rynx::floats4 color);
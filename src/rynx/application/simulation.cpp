@@ -9,6 +9,7 @@ rynx::application::simulation::simulation(rynx::scheduler::task_scheduler& sched
 	m_context->set_resource(*m_vfs);
 	m_context->set_resource(m_ecs);
 	m_context->set_resource(m_scenes);
+	m_context->set_resource(m_logic.parameters());
 }
 
 void rynx::application::simulation::generate_tasks(float dt) {
@@ -19,9 +19,17 @@ namespace rynx {
 
 				virtual void prepare(rynx::scheduler::context* ctx) override {
 					ctx->add_task("model matrices", [this](rynx::scheduler::task& task_context, rynx::ecs& ecs) mutable {
+						
+						// only entities that have moved, resized or become visible since previous update need new matrices.
+						// another ecs, for example after toggling pipelined frames, has none of the earlier matrices.
+						uint64_t changed_since = std::exchange(m_change_version, ecs.change_version());
+						if (std::exchange(m_ecs, &ecs) != &ecs) {
+							changed_since = 0;
+						}
 
 						// update model matrices
 						ecs.query().notIn<components::graphics::frustum_culled, components::graphics::invisible, components::transform::scale>()
+							.changed_since<components::transform::position, components::transform::radius>(changed_since)
 							.for_each_parallel(task_context, [this](
 								rynx::components::transform::position pos,
 								rynx::components::transform::radius r,
@@ -35,6 +43,7 @@ namespace rynx {
 						);
 
 						ecs.query().notIn<components::graphics::frustum_culled, components::graphics::invisible>()
+							.changed_since<components::transform::position, components::transform::radius, components::transform::scale>(changed_since)
 							.for_each_parallel(task_context, [this](
 								rynx::components::transform::position pos,
 								rynx::components::transform::radius r,
@@ -51,6 +60,10 @@ namespace rynx {
 				}
 
 				virtual void execute() {}
+
+			private:
+				uint64_t m_change_version = 0;
+				const rynx::ecs* m_ecs = nullptr;
 			};
 		}
 	}
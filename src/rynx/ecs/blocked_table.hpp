@@ -0,0 +1,146 @@
+#pragma once
+
+#include <rynx/tech/memory_block_pool.hpp>
+#include <rynx/system/assert.hpp>
+
+#include <vector>
+#include <bit>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+
+namespace rynx {
+	namespace ecs_internal {
+
+		// vector-like storage that keeps elements in fixed size blocks taken from a memory_block_pool.
+		// growing never moves existing elements, so their addresses stay valid until they are erased or moved by the ecs.
+		// elements per block is a power of two, so iteration can be split at block boundaries cheaply.
+		template<typename T>
+		class blocked_table {
+		public:
+			blocked_table(rynx::tech::memory_block_pool* pool) : m_pool(pool) {
+				rynx_assert(pool->block_size() >= sizeof(T), "component does not fit in a block");
+				static_assert(alignof(T) <= rynx::tech::memory_block_pool::block_alignment, "component alignment is too large for pooled blocks");
+				m_block_bits = uint32_t(std::bit_width(pool->block_size() / sizeof(T)) - 1);
+			}
+
+			blocked_table(const blocked_table& other) : blocked_table(other.m_pool) {
+				for (size_t i = 0; i < other.size(); ++i) {
+					emplace_back(other[i]);
+				}
+			}
+
+			blocked_table(blocked_table&& other) noexcept : m_pool(other.m_pool), m_blocks(std::move(other.m_blocks)), m_size(other.m_size), m_block_bits(other.m_block_bits) {
+				other.m_size = 0;
+				other.m_blocks.clear();
+			}
+
+			blocked_table& operator = (const blocked_table& other) {
+				if (this != &other) {
+					clear();
+					for (size_t i = 0; i < other.size(); ++i) {
+						emplace_back(other[i]);
+					}
+				}
+				return *this;
+			}
+
+			blocked_table& operator = (blocked_table&& other) noexcept {
+				if (this != &other) {
+					clear();
+					release_blocks(0);
+					m_pool = other.m_pool;
+					m_blocks = std::move(other.m_blocks);
+					m_size = other.m_size;
+					m_block_bits = other.m_block_bits;
+					other.m_size = 0;
+					other.m_blocks.clear();
+				}
+				return *this;
+			}
+
+			~blocked_table() {
+				clear();
+				release_blocks(0);
+			}
+
+			size_t size() const { return m_size; }
+			bool empty() const { return m_size == 0; }
+			size_t block_capacity() const { return size_t(1) << m_block_bits; }
+
+			T& operator[](size_t index) { return m_blocks[index >> m_block_bits][index & block_mask()]; }
+			const T& operator[](size_t index) const { return m_blocks[index >> m_block_bits][index & block_mask()]; }
+
+			T& back() { return (*this)[m_size - 1]; }
+			const T& back() const { return (*this)[m_size - 1]; }
+
+			// elements [index, contiguous_end(index, end)) are consecutive in memory.
+			size_t contiguous_end(size_t index, size_t end) const {
+				size_t block_end = (index | block_mask()) + 1;
+				return block_end < end ? block_end : end;
+			}
+
+			template<typename... Ts> T& emplace_back(Ts&& ... ts) {
+				if ((m_size >> m_block_bits) == m_blocks.size()) {
+					m_blocks.emplace_back(static_cast<T*>(m_pool->acquire()));
+				}
+				T* ptr = new (&m_blocks[m_size >> m_block_bits][m_size & block_mask()]) T(std::forward<Ts>(ts)...);
+				++m_size;
+				return *ptr;
+			}
+
+			void push_back(const T& t) { emplace_back(t); }
+			void push_back(T&& t) { emplace_back(std::move(t)); }
+
+			// blocks that become empty are returned to the pool.
+			void pop_back() {
+				rynx_assert(m_size > 0, "pop from empty table");
+				--m_size;
+				(*this)[m_size].~T();
+				if ((m_size & block_mask()) == 0) {
+					release_blocks(m_size >> m_block_bits);
+				}
+			}
+
+			void replace_with_back_and_pop(size_t index) {
+				if (index != m_size - 1) {
+					(*this)[index] = std::move(back());
+				}
+				pop_back();
+			}
+
+			void reserve(size_t n) { m_blocks.reserve((n + block_mask()) >> m_block_bits); }
+
+			void resize(size_t n) {
+				while (m_size > n) {
+					pop_back();
+				}
+				while (m_size < n) {
+					emplace_back();
+				}
+			}
+
+			void clear() {
+				while (m_size > 0) {
+					pop_back();
+				}
+			}
+
+		private:
+			size_t block_mask() const { return block_capacity() - 1; }
+
+			void release_blocks(size_t first) {
+				while (m_blocks.size() > first) {
+					m_pool->release(m_blocks.back());
+					m_blocks.pop_back();
+				}
+			}
+
+			rynx::tech::memory_block_pool* m_pool;
+			std::vector<T*> m_blocks;
+			size_t m_size = 0;
+			uint32_t m_block_bits = 0;
+		};
+	}
+}
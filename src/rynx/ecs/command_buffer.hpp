@@ -0,0 +1,385 @@
+#pragma once
+
+#include <rynx/ecs/ecs.hpp>
+#include <rynx/thread/this_thread.hpp>
+#include <rynx/std/memory.hpp>
+#include <rynx/system/assert.hpp>
+
+#include <vector>
+#include <tuple>
+#include <algorithm>
+
+namespace rynx {
+
+	// records structural changes (create, attach, remove, erase) so that they can be made from parallel tasks,
+	// for example from inside for_each_parallel. each thread records to its own buffer, selected by rynx::this_thread::id().
+	//
+	// apply() plays the changes back in one pass. edits are merged per entity, and entities are grouped by
+	// their source and destination categories, so that each table does one bulk move per group instead of one move per edit.
+	// erases are applied first, then attach/remove edits, then creates. created entities get their ids only when applied.
+	//
+	// NOTE: value segregated types, virtual types and sparse tags can not be recorded. type aliases are not supported.
+	// NOTE: recording must not happen concurrently with apply().
+	class ecs_command_buffer {
+	public:
+		ecs_command_buffer(size_t max_threads = 64) : m_threads(max_threads) {}
+		ecs_command_buffer(const ecs_command_buffer&) = delete;
+		ecs_command_buffer& operator = (const ecs_command_buffer&) = delete;
+
+		template<typename... Components>
+		void create(Components&& ... components) {
+			static_assert(sizeof...(Components) > 0, "entity must have at least one component");
+			(verify_recordable<Components>(), ...);
+			local().template creates_for<std::remove_cvref_t<Components>...>().emplace_back(std::forward<Components>(components)...);
+		}
+
+		template<typename... Components>
+		void attach(rynx::id id, Components&& ... components) {
+			(verify_recordable<Components>(), ...);
+			auto& buffer = local();
+			(buffer.attach(id.value, std::forward<Components>(components)), ...);
+		}
+
+		template<typename... Components>
+		void remove(rynx::id id) {
+			(verify_recordable<Components>(), ...);
+			auto& buffer = local();
+			(buffer.edits.emplace_back(edit{ id.value, rynx::type_index::id<Components>(), nullptr, 0, true }), ...);
+		}
+
+		void erase(rynx::id id) {
+			local().erased.emplace_back(id.value);
+		}
+
+		bool empty() const {
+			for (auto&& buffer : m_threads) {
+				if (!buffer.empty()) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void clear() {
+			for (auto&& buffer : m_threads) {
+				buffer.clear();
+			}
+		}
+
+		// the edit view must have access to all types recorded in this buffer.
+		template<typename... TypeConstraints>
+		void apply(rynx::ecs::edit_view<TypeConstraints...> ecs) {
+			apply(*static_cast<rynx::ecs::view<TypeConstraints...>&>(ecs).m_ecs);
+		}
+
+		void apply(rynx::ecs& ecs) {
+			for (auto&& buffer : m_threads) {
+				for (entity_id_t id : buffer.erased) {
+					ecs.erase(id);
+				}
+			}
+
+			apply_edits(ecs);
+
+			for (auto&& buffer : m_threads) {
+				for (auto&& batch : buffer.creates) {
+					batch->create_all(ecs);
+				}
+			}
+
+			clear();
+		}
+
+	private:
+		using entity_category = rynx::ecs::entity_category;
+
+		struct icolumn;
+
+		struct edit {
+			entity_id_t id;
+			type_id_t type_id;
+			icolumn* values; // nullptr for removes and tag types.
+			index_t value_index;
+			bool remove;
+		};
+
+		// recorded values of one component type, on one thread.
+		struct icolumn {
+			virtual ~icolumn() {}
+
+			// appends the values referred by edits to the table of type_id in dst. all edits must refer to columns of the same type.
+			virtual void append_to(entity_category& dst, type_id_t type_id, const std::vector<const edit*>& edits) = 0;
+
+			// replaces the value of a component that the entity at index of dst already has.
+			virtual void assign_to(entity_category& dst, type_id_t type_id, index_t index, const edit* e) = 0;
+			virtual void clear() = 0;
+		};
+
+		template<typename T>
+		struct column : public icolumn {
+			virtual void append_to(entity_category& dst, type_id_t type_id, const std::vector<const edit*>& edits) override {
+				auto& table = dst.template table<T>(type_id);
+				for (const edit* e : edits) {
+					table.emplace_back(std::move(static_cast<column*>(e->values)->values[e->value_index]));
+				}
+			}
+
+			virtual void assign_to(entity_category& dst, type_id_t type_id, index_t index, const edit* e) override {
+				auto& table = dst.template table<T>(type_id);
+				table[index] = std::move(static_cast<column*>(e->values)->values[e->value_index]);
+				table.mark_changed(index);
+			}
+
+			virtual void clear() override { values.clear(); }
+
+			std::vector<T> values;
+		};
+
+		// recorded creates of one set of component types, on one thread.
+		struct icreate_batch {
+			virtual ~icreate_batch() {}
+			virtual void create_all(rynx::ecs& ecs) = 0;
+			virtual bool empty() const = 0;
+			virtual void clear() = 0;
+			const void* signature = nullptr;
+		};
+
+		template<typename... Ts>
+		struct create_batch : public icreate_batch {
+			template<typename... Us> void emplace_back(Us&& ... us) {
+				(std::get<std::vector<Ts>>(values).emplace_back(std::forward<Us>(us)), ...);
+			}
+
+			virtual void create_all(rynx::ecs& ecs) override {
+				if (!empty()) {
+					rynx::ecs::spawner<Ts...> spawner(ecs);
+					std::apply([&spawner](auto&... vectors) { spawner.spawn(std::move(vectors)...); }, values);
+				}
+				clear();
+			}
+
+			virtual bool empty() const override { return std::get<0>(values).empty(); }
+			virtual void clear() override { std::apply([](auto&... vectors) { (vectors.clear(), ...); }, values); }
+
+			std::tuple<std::vector<Ts>...> values;
+		};
+
+		// address is unique for each set of component types.
+		template<typename... Ts> static inline const char create_signature = 0;
+
+		struct thread_buffer {
+			std::vector<edit> edits;
+			std::vector<entity_id_t> erased;
+			std::vector<std::pair<type_id_t, rynx::unique_ptr<icolumn>>> columns;
+			std::vector<rynx::unique_ptr<icreate_batch>> creates;
+
+			template<typename T> void attach(entity_id_t id, T&& component) {
+				using U = std::remove_cvref_t<T>;
+				type_id_t type_id = rynx::type_index::id<U>();
+				if constexpr (std::is_empty_v<U>) {
+					edits.emplace_back(edit{ id, type_id, nullptr, 0, false });
+				}
+				else {
+					auto& values = column_for<U>(type_id);
+					edits.emplace_back(edit{ id, type_id, &values, index_t(values.values.size()), false });
+					values.values.emplace_back(std::forward<T>(component));
+				}
+			}
+
+			template<typename T> column<T>& column_for(type_id_t type_id) {
+				for (auto&& entry : columns) {
+					if (entry.first == type_id) {
+						return *static_cast<column<T>*>(entry.second.get());
+					}
+				}
+				columns.emplace_back(type_id, rynx::make_unique<column<T>>());
+				return *static_cast<column<T>*>(columns.back().second.get());
+			}
+
+			template<typename... Ts> create_batch<Ts...>& creates_for() {
+				const void* signature = &create_signature<Ts...>;
+				for (auto&& batch : creates) {
+					if (batch->signature == signature) {
+						return *static_cast<create_batch<Ts...>*>(batch.get());
+					}
+				}
+				creates.emplace_back(rynx::make_unique<create_batch<Ts...>>());
+				creates.back()->signature = signature;
+				return *static_cast<create_batch<Ts...>*>(creates.back().get());
+			}
+
+			bool empty() const {
+				bool no_creates = std::all_of(creates.begin(), creates.end(), [](auto& batch) { return batch->empty(); });
+				return edits.empty() & erased.empty() & no_creates;
+			}
+
+			void clear() {
+				edits.clear();
+				erased.clear();
+				for (auto&& entry : columns) {
+					entry.second->clear();
+				}
+				for (auto&& batch : creates) {
+					batch->clear();
+				}
+			}
+		};
+
+		// entity moving from source to the category of types.
+		struct migration {
+			entity_category* source;
+			entity_id_t id;
+			uint32_t first_value; // range of component values added to the entity, in m_added_values.
+			uint32_t num_values;
+			index_t source_index; // filled in right before moving, earlier moves can change it.
+		};
+
+		template<typename T>
+		static constexpr void verify_recordable() {
+			using U = std::remove_cvref_t<T>;
+			static_assert(!std::is_base_of_v<rynx::ecs_value_segregated_component_tag, U>, "value segregated types can not be recorded to a command buffer");
+			static_assert(!std::is_same_v<U, rynx::type_index::virtual_type>, "virtual types can not be recorded to a command buffer");
+			static_assert(!rynx::ecs_internal::is_sparse_tag_v<U>, "sparse tags do not need a command buffer, use ecs::set_tags and ecs::clear_tags");
+		}
+
+		thread_buffer& local() {
+			uint64_t tid = rynx::this_thread::id();
+			rynx_assert(tid < m_threads.size(), "command buffer is not allowed to realloc worker thread count.");
+			return m_threads[tid];
+		}
+
+		void apply_edits(rynx::ecs& ecs) {
+			std::vector<const edit*> edits;
+			for (auto&& buffer : m_threads) {
+				for (auto&& e : buffer.edits) {
+					edits.emplace_back(&e);
+				}
+			}
+
+			if (edits.empty()) {
+				return;
+			}
+
+			// per thread recording order is kept for edits of the same entity.
+			std::stable_sort(edits.begin(), edits.end(), [](const edit* a, const edit* b) { return a->id < b->id; });
+
+			// merge edits of each entity to a single migration, and group the migrations by destination types.
+			rynx::unordered_map<dynamic_bitset, std::vector<migration>, rynx::ecs::bitset_hash> groups;
+			m_added_values.clear();
+			m_replaced_values.clear();
+			std::vector<const edit*> entity_values;
+			for (size_t begin = 0; begin < edits.size();) {
+				const entity_id_t id = edits[begin]->id;
+				size_t end = begin + 1;
+				while (end < edits.size() && edits[end]->id == id) {
+					++end;
+				}
+
+				auto* slot = ecs.m_entities.find(id);
+				if (slot == nullptr) {
+					begin = end; // entity was erased.
+					continue;
+				}
+
+				entity_category* source = slot->category;
+				dynamic_bitset types = source->types();
+				entity_values.clear();
+				for (size_t i = begin; i < end; ++i) {
+					const edit* e = edits[i];
+					auto it = std::find_if(entity_values.begin(), entity_values.end(), [e](const edit* other) { return other->type_id == e->type_id; });
+					if (it != entity_values.end()) {
+						entity_values.erase(it);
+					}
+
+					if (e->remove) {
+						types.reset(e->type_id);
+					}
+					else {
+						rynx_assert(!types.test(e->type_id), "attaching a component type that the entity already has");
+						types.set(e->type_id);
+						if (e->values) {
+							entity_values.emplace_back(e);
+						}
+					}
+				}
+				begin = end;
+
+				// a component that was removed and attached again stays in its table, only its value is replaced.
+				auto replaced = std::stable_partition(entity_values.begin(), entity_values.end(), [source](const edit* e) { return !source->types().test(e->type_id); });
+				m_replaced_values.insert(m_replaced_values.end(), replaced, entity_values.end());
+				entity_values.erase(replaced, entity_values.end());
+
+				if (types == source->types()) {
+					continue;
+				}
+
+				// added values are ordered by type, so that entities of the same group have them in the same order.
+				std::sort(entity_values.begin(), entity_values.end(), [](const edit* a, const edit* b) { return a->type_id < b->type_id; });
+				groups[types].emplace_back(migration{ source, id, uint32_t(m_added_values.size()), uint32_t(entity_values.size()), 0 });
+				m_added_values.insert(m_added_values.end(), entity_values.begin(), entity_values.end());
+			}
+
+			for (auto&& group : groups) {
+				const dynamic_bitset& types = group.first;
+				auto& migrations = group.second;
+
+				auto destination_it = ecs.m_categories.find(types);
+				if (destination_it == ecs.m_categories.end()) {
+					destination_it = ecs.create_category(types);
+				}
+				entity_category* destination = destination_it->second.get();
+
+				std::sort(migrations.begin(), migrations.end(), [](const migration& a, const migration& b) { return a.source < b.source; });
+				for (size_t begin = 0; begin < migrations.size();) {
+					size_t end = begin + 1;
+					while (end < migrations.size() && migrations[end].source == migrations[begin].source) {
+						++end;
+					}
+					move_entities(ecs, destination, types, migrations.data() + begin, migrations.data() + end);
+					begin = end;
+				}
+			}
+
+			// after the moves, so that the values land at the final index of the entity.
+			for (const edit* e : m_replaced_values) {
+				auto& slot = ecs.m_entities[e->id];
+				e->values->assign_to(*slot.category, e->type_id, slot.index, e);
+			}
+		}
+
+		// moves entities of one source category to destination, and appends the added component values.
+		void move_entities(rynx::ecs& ecs, entity_category* destination, const dynamic_bitset& types, migration* begin, migration* end) {
+			entity_category* source = begin->source;
+			for (migration* it = begin; it != end; ++it) {
+				it->source_index = ecs.m_entities[it->id].index;
+			}
+			std::sort(begin, end, [](const migration& a, const migration& b) { return a.source_index > b.source_index; });
+
+			m_source_indices.clear();
+			for (migration* it = begin; it != end; ++it) {
+				m_source_indices.emplace_back(it->source_index);
+			}
+			source->migrate_entities_to(destination, types, m_source_indices, ecs.m_entities);
+
+			// every entity of the group has the same added types, in the same order.
+			for (uint32_t value = 0; value < begin->num_values; ++value) {
+				const edit* first = m_added_values[begin->first_value + value];
+				m_column_values.clear();
+				for (migration* it = begin; it != end; ++it) {
+					m_column_values.emplace_back(m_added_values[it->first_value + value]);
+				}
+				first->values->append_to(*destination, first->type_id, m_column_values);
+			}
+
+			ecs.erase_category_if_empty(source);
+		}
+
+		std::vector<thread_buffer> m_threads;
+
+		// playback scratch buffers.
+		std::vector<const edit*> m_added_values;
+		std::vector<const edit*> m_replaced_values;
+		std::vector<const edit*> m_column_values;
+		std::vector<index_t> m_source_indices;
+	};
+}
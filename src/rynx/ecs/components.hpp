@@ -9,14 +9,14 @@
 
 namespace rynx::components {
 	namespace transform {
-		struct position {
+		struct position : rynx::ecs_track_changes_tag {
 			position() = default;
 			position(rynx::vec3<float> pos, float angle = 0) : value(pos), angle(angle) {}
 			rynx::vec3<float> value;
 			float angle = 0;
 		};
 
-		struct scale {
+		struct scale : rynx::ecs_track_changes_tag {
 			operator vec3f() const {
 				return value;
 			}
@@ -30,7 +30,7 @@ namespace rynx::components {
 			vec3f ANNOTATE(">=0") value;
 		};
 
-		struct radius {
+		struct radius : rynx::ecs_track_changes_tag {
 			radius() = default;
 			radius(float r) : r(r) {}
 			float r = 0;
@@ -11,11 +11,17 @@
 #include <rynx/std/serialization_declares.hpp>
 #include <rynx/reflection/reflection.hpp>
 #include <rynx/ecs/table.hpp>
+#include <rynx/ecs/entity_index.hpp>
+#include <rynx/ecs/sparse_tags.hpp>
 #include <rynx/ecs/components.hpp>
+#include <rynx/math/morton.hpp>
 
 #include <vector>
 #include <type_traits>
 #include <tuple>
+#include <array>
+#include <memory>
+#include <atomic>
 #include <algorithm>
 #include <numeric>
 
@@ -43,16 +49,25 @@ namespace rynx {
 		class scene_serializer;
 	}
 
+	class ecs_command_buffer;
+
 	class ecs {
 		friend class rynx::ecs_detail::raw_serializer;
 		friend class rynx::ecs_detail::scene_serializer;
+		friend class rynx::ecs_command_buffer;
 	public:
 		struct range {
 			index_t begin = 0;
 			index_t step = 0;
 		};
 
+		// scope filters of a scoped_view. categories in scope have all types of with, and none of the types of without.
+		template<typename... Ts> struct with {};
+		template<typename... Ts> struct without {};
+
 		class entity_category;
+		using entity_index_t = rynx::ecs_internal::entity_index<entity_category>;
+		using sparse_tag_bits_t = rynx::ecs_internal::sparse_tag_bits_t;
 
 	private:
 		enum class DataAccess {
@@ -74,10 +89,10 @@ namespace rynx {
 			}
 		};
 
-		rynx::ecs_internal::entity_index m_entities;
-
-		rynx::unordered_map<entity_id_t, std::pair<entity_category*, index_t>> m_idCategoryMap;
+		entity_index_t m_entities; // entity id -> category & index in category.
 		rynx::unordered_map<dynamic_bitset, rynx::unique_ptr<entity_category>, bitset_hash> m_categories;
+		std::vector<entity_category*> m_category_list; // categories in creation order. cached queries only test the categories added since their previous run.
+		uint64_t m_category_epoch = next_category_epoch(); // renewed when categories are erased or re-keyed, which makes cached queries rebuild.
 		rynx::unordered_map<type_id_t, opaque_unique_ptr<rynx::ecs_internal::ivalue_segregation_map>> m_value_segregated_types_maps;
 		std::vector<type_id_t> m_virtual_types_released;
 		std::vector<rynx::function<void(rynx::ecs&, rynx::entity_range_t, rynx::scheduler::context&)>> m_post_deserialize_actions;
@@ -85,6 +100,29 @@ namespace rynx {
 		auto& categories() { return m_categories; }
 		const auto& categories() const { return m_categories; }
 
+		static uint64_t next_category_epoch() {
+			static std::atomic<uint64_t> s_epoch = 0;
+			return ++s_epoch;
+		}
+
+		auto create_category(const dynamic_bitset& types) {
+			auto it = m_categories.emplace(types, rynx::make_unique<entity_category>(types)).first;
+			m_category_list.emplace_back(it->second.get());
+			return it;
+		}
+
+		void erase_category(const dynamic_bitset& types) {
+			auto it = m_categories.find(types);
+			rynx_assert(it != m_categories.end(), "erasing a category that does not exist");
+			m_category_list.erase(std::find(m_category_list.begin(), m_category_list.end(), it->second.get()));
+			m_categories.erase(it);
+			invalidate_cached_queries();
+		}
+
+		void invalidate_cached_queries() {
+			m_category_epoch = next_category_epoch();
+		}
+
 		rynx::ecs_internal::ivalue_segregation_map& value_segregated_types_map(type_id_t type_id, rynx::function<rynx::unique_ptr<rynx::ecs_internal::ivalue_segregation_map>()> map_create_func) {
 			auto it = m_value_segregated_types_maps.find(type_id);
 			if (it == m_value_segregated_types_maps.end()) {
@@ -110,6 +148,7 @@ namespace rynx {
 
 	public:
 		using id = rynx::id;
+		template<typename T> using component_vector = rynx::ecs_internal::component_vector<T>;
 
 
 		ecs(ecs&& other) = default;
@@ -119,14 +158,15 @@ namespace rynx {
 			ecs copy;
 			copy.m_entities = this->m_entities;
 			
-			for (auto&& entry : m_categories) {
-				copy.m_categories.emplace(entry.first, rynx::make_unique<entity_category>(entry.second->clone()));
+			for (auto* category : m_category_list) {
+				auto it = copy.m_categories.emplace(category->types(), rynx::make_unique<entity_category>(category->clone())).first;
+				copy.m_category_list.emplace_back(it->second.get());
 			}
 
-			// Rebuild id category map
+			// Point id slots to the copied categories
 			for (auto&& category : copy.m_categories) {
 				for (index_t index_in_category = 0; index_in_category < category.second->m_ids.size(); ++index_in_category) {
-					copy.m_idCategoryMap.emplace(category.second->m_ids[index_in_category], std::pair{ category.second.get(), index_in_category });
+					copy.m_entities.assign(category.second->m_ids[index_in_category].value, category.second.get(), index_in_category);
 				}
 			}
 
@@ -142,6 +182,80 @@ namespace rynx {
 			return copy;
 		}
 
+		// brings mirror up to date with this ecs, for example for rendering the previous frame while the next one simulates.
+		// unlike clone, the categories of the mirror are kept. when a category still has the same entities, only the chunks
+		// written after changed_since are copied, so changed_since queries on the mirror keep working. tables of the types
+		// in mirror_owned are left alone in such categories, the mirror derives those itself. tables are copied in parallel
+		// jobs of the task; neither ecs may be used by others until the jobs are done.
+		template<typename TaskContext>
+		void mirror_to(ecs& mirror, uint64_t changed_since, const dynamic_bitset& mirror_owned, TaskContext&& task_context) const {
+			struct job {
+				entity_category* source;
+				entity_category* target;
+				type_id_t type_id; // table to copy, or ids_job for the ids and sparse tags of the category.
+				bool same_entities;
+			};
+			static constexpr type_id_t ids_job = ~type_id_t(0);
+
+			std::vector<dynamic_bitset> removed_categories;
+			for (auto&& entry : mirror.m_categories) {
+				if (m_categories.find(entry.first) == m_categories.end()) {
+					removed_categories.emplace_back(entry.first);
+				}
+			}
+			for (auto&& types : removed_categories) {
+				mirror.erase_category(types);
+			}
+
+			mirror.m_entities = m_entities;
+			auto jobs = rynx::make_shared<std::vector<job>>();
+			for (auto* category : m_category_list) {
+				auto it = mirror.m_categories.find(category->types());
+				if (it == mirror.m_categories.end()) {
+					it = mirror.create_category(category->types());
+				}
+
+				entity_category* target = it->second.get();
+				const bool same_entities = target->m_ids == category->m_ids;
+				for (type_id_t type_id = 0; type_id < category->m_tables.size(); ++type_id) {
+					if (!category->m_tables[type_id]) {
+						continue;
+					}
+					if (type_id >= target->m_tables.size() || !target->m_tables[type_id]) {
+						category->m_tables[type_id]->copyTableTypeTo(type_id, target->m_tables);
+					}
+					if (same_entities && mirror_owned.test(type_id)) {
+						continue;
+					}
+					jobs->emplace_back(job{ category, target, type_id, same_entities });
+				}
+				jobs->emplace_back(job{ category, target, ids_job, same_entities });
+			}
+
+			mirror.m_value_segregated_types_maps.clear();
+			for (auto&& entry : m_value_segregated_types_maps) {
+				auto* copy_ptr = entry.second->clone_ptr();
+				mirror.m_value_segregated_types_maps.emplace(
+					entry.first,
+					rynx::opaque_unique_ptr<rynx::ecs_internal::ivalue_segregation_map>(copy_ptr, entry.second.get_deleter())
+				);
+			}
+			mirror.m_virtual_types_released = m_virtual_types_released;
+
+			task_context.parallel().range(0, int64_t(jobs->size()), 1).execute([jobs, changed_since, &mirror](int64_t index) {
+				const job& j = (*jobs)[index];
+				if (j.type_id == ids_job) {
+					j.target->mirror_ids_from(*j.source, changed_since, j.same_entities, mirror.m_entities);
+				}
+				else if (j.same_entities) {
+					j.target->m_tables[j.type_id]->assign_changed_from(*j.source->m_tables[j.type_id], changed_since);
+				}
+				else {
+					j.target->m_tables[j.type_id]->assign_from(*j.source->m_tables[j.type_id]);
+				}
+			});
+		}
+
 		void register_post_deserialize_init_function(rynx::function<void(rynx::ecs&, rynx::entity_range_t, rynx::scheduler::context&)> func) {
 			m_post_deserialize_actions.emplace_back(std::move(func));
 		}
@@ -158,12 +272,17 @@ namespace rynx {
 		public:
 			entity_category(dynamic_bitset types) : m_types(std::move(types)) {}
 
+			// unique for each category instance. the scheduler reserves categories by this id for scoped views.
+			uint64_t resource_id() const { return m_resource_id; }
+
 			bool includesAll(const dynamic_bitset& types) const { return m_types.includes(types); }
 			bool includesNone(const dynamic_bitset& types) const { return m_types.excludes(types); }
 
 			entity_category clone() const {
 				entity_category copy(m_types);
 				copy.m_ids = m_ids;
+				copy.m_sparse_tags = m_sparse_tags;
+				copy.m_sparse_tag_versions = m_sparse_tag_versions;
 				for (auto& itable_ptr : m_tables) {
 					if (itable_ptr) {
 						copy.m_tables.emplace_back(itable_ptr->clone_ptr());
@@ -183,7 +302,7 @@ namespace rynx {
 				m_tables[typeId] = std::move(tablePtr);
 			}
 
-			void erase(index_t index, rynx::unordered_map<entity_id_t, std::pair<entity_category*, index_t>>& idmap) {
+			void erase(index_t index, entity_index_t& idmap) {
 				for (auto&& table : m_tables) {
 					if(table)
 						table->erase(index);
@@ -192,17 +311,19 @@ namespace rynx {
 				rynx_assert(index < m_ids.size(), "out of bounds");
 				auto erasedEntityId = m_ids[index];
 				m_ids[index] = std::move(m_ids.back());
+				m_sparse_tags[index] = m_sparse_tags.back();
 				
 				// update ecs-wide id<->category mapping
-				idmap.find(m_ids[index].value)->second = { this, index };
+				idmap.set_index(m_ids[index].value, index);
 				idmap.erase(erasedEntityId.value);
 				
 				m_ids.pop_back();
+				m_sparse_tags.pop_back();
 			}
 
 			// TODO: Rename better. This is like bubble-sort single step.
 			// TODO: Use some smarter algorithm?
-			template<typename T> void sort_one_step(rynx::unordered_map<entity_id_t, std::pair<entity_category*, index_t>>& idmap) {
+			template<typename T> void sort_one_step(entity_index_t& idmap) {
 				auto type_index_of_t = rynx::type_index::id<T>();
 				auto& table_t = table<T>(type_index_of_t);
 				
@@ -213,10 +334,12 @@ namespace rynx {
 						
 						// swap content of T and index mapping.
 						std::swap(table_t[table_index - 1], table_t[table_index]);
+						table_t.mark_changed(table_index - 1, table_index + 1);
 						
 						std::swap(m_ids[table_index - 1], m_ids[table_index]);
-						idmap.find(m_ids[table_index - 1])->second.second = table_index - 1;
-						idmap.find(m_ids[table_index])->second.second = table_index;
+						std::swap(m_sparse_tags[table_index - 1], m_sparse_tags[table_index]);
+						idmap.set_index(m_ids[table_index - 1].value, table_index - 1);
+						idmap.set_index(m_ids[table_index].value, table_index);
 					}
 				}
 
@@ -228,7 +351,7 @@ namespace rynx {
 				}
 			}
 
-			template<typename T> void sort(rynx::unordered_map<entity_id_t, std::pair<entity_category*, index_t>>& idmap) {
+			template<typename T> void sort(entity_index_t& idmap) {
 				auto type_index_of_t = rynx::type_index::id<T>();
 				auto& table_t = table<T>(type_index_of_t);
 
@@ -239,39 +362,100 @@ namespace rynx {
 						return table_t[a] < table_t[b];
 					}
 				);
-				
+				apply_order(relative_sort_order, idmap);
+			}
+
+			// reorders all entities of the category. entity at index i is moved from index order[i].
+			void apply_order(const std::vector<index_t>& order, entity_index_t& idmap) {
 				for (auto& table_ptr : m_tables) {
 					if (table_ptr) {
-						table_ptr->swap_to_given_order(relative_sort_order);
+						table_ptr->apply_order(order);
 					}
 				}
+				apply_order_to_ids(order, idmap);
+			}
+
+			// same as apply_order, but each table is reordered in a separate parallel job of the task.
+			// order must remain valid until the jobs are done, which is why it is shared.
+			template<typename TaskContext>
+			void apply_order_parallel(TaskContext&& task_context, rynx::shared_ptr<const std::vector<index_t>> order, entity_index_t& idmap) {
+				auto tables = rynx::make_shared<std::vector<rynx::ecs_internal::itable*>>();
+				for (auto& table_ptr : m_tables) {
+					if (table_ptr) {
+						tables->emplace_back(table_ptr.get());
+					}
+				}
+
+				const int64_t num_jobs = int64_t(tables->size()) + 1;
+				task_context.parallel().range(0, num_jobs, 1).execute([this, order, tables, &idmap](int64_t job) {
+					if (job == int64_t(tables->size())) {
+						apply_order_to_ids(*order, idmap);
+					}
+					else {
+						(*tables)[job]->apply_order(*order);
+					}
+				});
+			}
 
-				{
-					std::vector<index_t> current_index_to_original_index(m_ids.size());
-					std::vector<index_t> original_index_to_current_index(m_ids.size());
 
-					std::iota(current_index_to_original_index.begin(), current_index_to_original_index.end(), 0);
-					std::iota(original_index_to_current_index.begin(), original_index_to_current_index.end(), 0);
 
-					for (index_t i = 0, size = index_t(m_ids.size()); i < size; ++i) {
-						index_t mapped_location = original_index_to_current_index[relative_sort_order[i]];
-						if (mapped_location != i) {
-							idmap.find(m_ids[i].value)->second.second = mapped_location;
-							idmap.find(m_ids[mapped_location].value)->second.second = index_t(i);
-							std::swap(m_ids[i], m_ids[mapped_location]);
+		private:
+			void mark_sparse_tags_changed(index_t index) {
+				const size_t chunk = index >> rynx::ecs_internal::change_chunk_bits;
+				if (chunk < m_sparse_tag_versions.size()) {
+					std::atomic_ref<uint64_t>(m_sparse_tag_versions[chunk]).store(rynx::ecs_internal::current_change_version(), std::memory_order_relaxed);
+				}
+			}
+
+			// gives a version stamp to each chunk of entities. toggling tags may happen in parallel, so the stamps are added when entities are.
+			void cover_sparse_tag_versions() {
+				const size_t chunks = (m_sparse_tags.size() + rynx::ecs_internal::change_chunk_size - 1) >> rynx::ecs_internal::change_chunk_bits;
+				if (m_sparse_tag_versions.size() < chunks) {
+					m_sparse_tag_versions.resize(chunks, rynx::ecs_internal::current_change_version());
+				}
+			}
 
-							std::swap(current_index_to_original_index[i], current_index_to_original_index[mapped_location]);
-							std::swap(
-								original_index_to_current_index[current_index_to_original_index[i]],
-								original_index_to_current_index[current_index_to_original_index[mapped_location]]
-							);
+			// ids and sparse tags of ecs::mirror_to. with the same entities only the tags toggled after changed_since are copied.
+			// slots of the entities are pointed to this category.
+			void mirror_ids_from(const entity_category& source, uint64_t changed_since, bool same_entities, entity_index_t& idmap) {
+				if (same_entities) {
+					for (index_t begin = 0; begin < index_t(m_sparse_tags.size()); begin += rynx::ecs_internal::change_chunk_size) {
+						const index_t chunk = begin >> rynx::ecs_internal::change_chunk_bits;
+						if (source.sparse_tags_changed_since(chunk, changed_since)) {
+							const index_t end = std::min(index_t(m_sparse_tags.size()), begin + rynx::ecs_internal::change_chunk_size);
+							std::copy(source.m_sparse_tags.begin() + begin, source.m_sparse_tags.begin() + end, m_sparse_tags.begin() + begin);
+							mark_sparse_tags_changed(begin);
 						}
 					}
 				}
+				else {
+					m_ids = source.m_ids;
+					m_sparse_tags = source.m_sparse_tags;
+					m_sparse_tag_versions.clear();
+					cover_sparse_tag_versions();
+				}
+
+				for (index_t index = 0; index < m_ids.size(); ++index) {
+					auto& slot = idmap[m_ids[index].value];
+					slot.category = this;
+					slot.index = index;
+				}
 			}
 
+			// ids and sparse tags are reordered together, entity index is updated to match.
+			void apply_order_to_ids(const std::vector<index_t>& order, entity_index_t& idmap) {
+				rynx_assert(order.size() == m_ids.size(), "order must contain each index exactly once");
+				std::vector<id> ordered_ids(m_ids.size());
+				std::vector<sparse_tag_bits_t> ordered_tags(m_sparse_tags.size());
+				for (index_t i = 0; i < index_t(order.size()); ++i) {
+					ordered_ids[i] = m_ids[order[i]];
+					ordered_tags[i] = m_sparse_tags[order[i]];
+					idmap.set_index(ordered_ids[i].value, i);
+				}
+				m_ids = std::move(ordered_ids);
+				m_sparse_tags = std::move(ordered_tags);
+			}
 
-		private:
 			// private implementation details for insertion operations.
 			// virtual types are not added because they hold no data by definition.
 			template<typename T> void insertSingleComponent([[maybe_unused]] const rynx::unordered_map<type_id_t, type_id_t>& typeAliases, [[maybe_unused]] T&& component) {
@@ -280,14 +464,14 @@ namespace rynx {
 				}
 			}
 
-			template<typename T> void insertSingleComponentVector(const rynx::unordered_map<type_id_t, type_id_t>& typeAliases, std::vector<T>&& component) {
-				if constexpr (!std::is_same_v<std::remove_cvref_t<T>, rynx::type_index::virtual_type>) {
+			template<typename T, typename Allocator> void insertSingleComponentVector(const rynx::unordered_map<type_id_t, type_id_t>& typeAliases, std::vector<T, Allocator>&& component) {
+				if constexpr (!std::is_same_v<std::remove_cvref_t<T>, rynx::type_index::virtual_type> && !std::is_empty_v<std::remove_cvref_t<T>>) {
 					table<T>(typeAliases).insert(std::move(component));
 				}
 			}
 
 		public:
-			template<typename...Components> size_t insertNew(const rynx::unordered_map<type_id_t, type_id_t>& typeAliases, std::vector<rynx::id>&& ids, std::vector<Components>&& ... components) {
+			template<typename...Components, typename...Allocators> size_t insertNew(const rynx::unordered_map<type_id_t, type_id_t>& typeAliases, std::vector<rynx::id>&& ids, sparse_tag_bits_t sparse_tags, std::vector<Components, Allocators>&& ... components) {
 				(insertSingleComponentVector(typeAliases, std::move(components)), ...);
 				size_t index = m_ids.size();
 				if (m_ids.empty()) {
@@ -296,10 +480,30 @@ namespace rynx {
 				else {
 					m_ids.insert(m_ids.end(), ids.begin(), ids.end());
 				}
+				m_sparse_tags.resize(m_ids.size(), sparse_tags);
+				cover_sparse_tag_versions();
 
 				return index;
 			}
 
+			// appends ids of n consecutive entities from entity_index::generate_range, and registers them to the id map.
+			// components must be inserted to the tables separately.
+			void insertIdRange(entity_id_t first_id, size_t n, sparse_tag_bits_t sparse_tags, entity_index_t& idmap) {
+				const size_t first_index = m_ids.size();
+				m_ids.resize(first_index + n);
+				for (size_t i = 0; i < n; ++i) {
+					m_ids[first_index + i] = first_id + i;
+				}
+				m_sparse_tags.resize(m_ids.size(), sparse_tags);
+				cover_sparse_tag_versions();
+				idmap.assign_range(first_id, n, this, index_t(first_index));
+			}
+
+			void reserve(size_t capacity) {
+				m_ids.reserve(capacity);
+				m_sparse_tags.reserve(capacity);
+			}
+
 			void insertComponent_typeErased(const rynx::unordered_map<type_id_t, type_id_t>& typeAliases, type_id_t type_id, rynx::ecs_table_create_func& creator, opaque_unique_ptr<void> data) {
 				auto it = typeAliases.find(type_id);
 				if (it == typeAliases.end()) {
@@ -322,14 +526,14 @@ namespace rynx {
 				insertComponents(typeAliases, std::forward<Components>(components)...);
 				size_t index = m_ids.size();
 				m_ids.emplace_back(id);
+				m_sparse_tags.emplace_back(rynx::ecs_internal::sparse_tag_mask_of<Components...>());
+				cover_sparse_tag_versions();
 				return index;
 			}
 
 			template<typename Component> void eraseComponentFromIndex([[maybe_unused]] const rynx::unordered_map<type_id_t, type_id_t>& typeAliases, [[maybe_unused]] index_t index) {
 				if constexpr (!std::is_empty_v<std::remove_cvref_t<Component>> && !std::is_base_of_v<rynx::ecs_value_segregated_component_tag, std::remove_cvref_t<Component>>) {
-					auto& t = table<Component>(typeAliases);
-					t[index] = std::move(t.back());
-					t.pop_back();
+					table<Component>(typeAliases).replace_with_back_and_pop(index);
 				}
 			}
 
@@ -372,6 +576,41 @@ namespace rynx {
 			std::vector<id>& ids() { return m_ids; }
 			const std::vector<id>& ids() const { return m_ids; }
 
+			// sparse tag bits of each entity, in the same order as ids.
+			const sparse_tag_bits_t* sparse_tags() const { return m_sparse_tags.data(); }
+			sparse_tag_bits_t sparse_tags(index_t index) const { return std::atomic_ref(const_cast<sparse_tag_bits_t&>(m_sparse_tags[index])).load(std::memory_order_relaxed); }
+
+			// atomic, so that tasks toggling different tags of the same entity do not race.
+			// toggling stamps the chunk of the entity, so that changed_since queries filtering by sparse tags see entities that start to pass the filter.
+			void set_sparse_tags(index_t index, sparse_tag_bits_t mask) {
+				const sparse_tag_bits_t previous = std::atomic_ref(m_sparse_tags[index]).fetch_or(mask, std::memory_order_relaxed);
+				if ((previous & mask) != mask) {
+					mark_sparse_tags_changed(index);
+				}
+			}
+
+			void clear_sparse_tags(index_t index, sparse_tag_bits_t mask) {
+				const sparse_tag_bits_t previous = std::atomic_ref(m_sparse_tags[index]).fetch_and(~mask, std::memory_order_relaxed);
+				if ((previous & mask) != 0) {
+					mark_sparse_tags_changed(index);
+				}
+			}
+
+			// have sparse tags been toggled in the chunk after version. chunks without a stamp are treated as changed.
+			bool sparse_tags_changed_since(index_t chunk, uint64_t version) const {
+				return (chunk >= m_sparse_tag_versions.size()) || (m_sparse_tag_versions[chunk] > version);
+			}
+
+			// does the entity at index have component or tag T.
+			template<typename T> bool has(index_t index) const {
+				if constexpr (rynx::ecs_internal::is_sparse_tag_v<T>) {
+					return (sparse_tags(index) & rynx::ecs_internal::sparse_tag_mask<T>()) != 0;
+				}
+				else {
+					return m_types.test(rynx::type_index::id<T>());
+				}
+			}
+
 			template<DataAccess accessType, typename ComponentsTuple> auto tables() {
 				return getTables<accessType, ComponentsTuple>()(*this);
 			}
@@ -390,7 +629,7 @@ namespace rynx {
 				const dynamic_bitset& types,
 				entity_category* source,
 				index_t source_index,
-				rynx::unordered_map<entity_id_t, std::pair<entity_category*, index_t>>& idmap
+				entity_index_t& idmap
 			) {
 				type_id_t typeId = types.nextOne(0);
 				while (typeId != dynamic_bitset::npos) {
@@ -403,15 +642,63 @@ namespace rynx {
 				}
 
 				m_ids.emplace_back(source->m_ids[source_index]);
+				m_sparse_tags.emplace_back(source->m_sparse_tags[source_index]);
+				cover_sparse_tag_versions();
 				
 				rynx_assert(source->m_ids.size() > source_index, "out of bounds");
 				source->m_ids[source_index] = source->m_ids.back();
+				source->m_sparse_tags[source_index] = source->m_sparse_tags.back();
 				
 				// update mapping
-				idmap.find(source->m_ids[source_index].value)->second = { source, index_t(source_index) };
+				idmap.assign(source->m_ids[source_index].value, source, index_t(source_index));
 				source->m_ids.pop_back();
+				source->m_sparse_tags.pop_back();
 				
-				idmap.find(m_ids.back().value)->second = { this, index_t(m_ids.size() - 1) };
+				idmap.assign(m_ids.back().value, this, index_t(m_ids.size() - 1));
+			}
+
+			// bulk version of migrateEntityFrom. moves the entities at source_indices (in descending order) from this category to dst.
+			// tables of types are moved, tables of types not in types are erased.
+			void migrate_entities_to(
+				entity_category* dst,
+				const dynamic_bitset& types,
+				const std::vector<index_t>& source_indices,
+				entity_index_t& idmap
+			) {
+				rynx_assert(std::is_sorted(source_indices.rbegin(), source_indices.rend()), "source indices must be in descending order");
+				for (type_id_t type_id = 0; type_id < m_tables.size(); ++type_id) {
+					auto& table_ptr = m_tables[type_id];
+					if (!table_ptr) {
+						continue;
+					}
+
+					if (types.test(type_id)) {
+						if (type_id >= dst->m_tables.size() || !dst->m_tables[type_id]) {
+							table_ptr->copyTableTypeTo(type_id, dst->m_tables);
+						}
+						table_ptr->move_indices_to(source_indices, dst->m_tables[type_id].get());
+					}
+					else {
+						table_ptr->erase_indices(source_indices);
+					}
+				}
+
+				dst->m_ids.reserve(dst->m_ids.size() + source_indices.size());
+				dst->m_sparse_tags.reserve(dst->m_sparse_tags.size() + source_indices.size());
+				for (index_t source_index : source_indices) {
+					dst->m_ids.emplace_back(m_ids[source_index]);
+					dst->m_sparse_tags.emplace_back(m_sparse_tags[source_index]);
+					idmap.assign(m_ids[source_index].value, dst, index_t(dst->m_ids.size() - 1));
+					
+					m_ids[source_index] = m_ids.back();
+					m_ids.pop_back();
+					m_sparse_tags[source_index] = m_sparse_tags.back();
+					m_sparse_tags.pop_back();
+					if (source_index < m_ids.size()) {
+						idmap.set_index(m_ids[source_index].value, source_index);
+					}
+				}
+				dst->cover_sparse_tag_versions();
 			}
 
 			template<typename T, typename U = std::remove_const_t<std::remove_reference_t<T>>> auto& table(type_id_t typeIndex) {
@@ -454,6 +741,22 @@ namespace rynx {
 			template<typename T> const auto& table() const { return const_cast<entity_category*>(this)->table<T>(); }
 			template<typename T> const auto& table(const rynx::unordered_map<type_id_t, type_id_t>& typeAliases) const { return const_cast<entity_category*>(this)->table<T>(typeAliases); }
 
+			// order of entities along a z-order curve over their positions.
+			std::vector<index_t> spatial_order(float cell_size) {
+				const auto& positions = table<rynx::components::transform::position>();
+				std::vector<std::pair<uint64_t, index_t>> keyed(positions.size());
+				for (index_t i = 0; i < index_t(keyed.size()); ++i) {
+					keyed[i] = std::make_pair(rynx::math::morton_key_2d(positions[i].value, cell_size), i);
+				}
+				std::sort(keyed.begin(), keyed.end());
+
+				std::vector<index_t> order(keyed.size());
+				for (size_t i = 0; i < keyed.size(); ++i) {
+					order[i] = keyed[i].second;
+				}
+				return order;
+			}
+
 			rynx::ecs_internal::itable* table_ptr(type_id_t type_index_value) {
 				if (type_index_value < m_tables.size()) {
 					return m_tables[type_index_value].get();
@@ -527,6 +830,56 @@ namespace rynx {
 			dynamic_bitset m_types;
 			std::vector<rynx::unique_ptr<rynx::ecs_internal::itable>> m_tables;
 			std::vector<rynx::id> m_ids;
+			std::vector<sparse_tag_bits_t> m_sparse_tags; // one word per entity, see rynx::ecs_sparse_tag.
+			std::vector<uint64_t> m_sparse_tag_versions; // change version of the latest tag toggle, per change chunk.
+			uint64_t m_resource_id = next_resource_id();
+
+			static uint64_t next_resource_id() {
+				static std::atomic<uint64_t> s_next_id = 0;
+				return s_next_id++;
+			}
+		};
+
+		template<typename category_source> class gatherer;
+
+		// consecutive entities of a category, visited by a query.
+		struct category_span {
+			entity_category& category;
+			id* ids;
+			size_t size;
+		};
+
+		// persistent result of category matching for a query. keep one alive per query call site (for example as a ruleset member)
+		// and pass it to query().cached(...) every time the query is run. only categories created since the previous run are tested,
+		// everything is rebuilt if categories have been erased or the query filters have changed.
+		// table pointers of the iterated component types are cached as well.
+		// NOTE: not thread safe. the same cache must not be used by queries running concurrently.
+		class query_cache {
+		public:
+			void clear() {
+				m_ecs = nullptr;
+				m_epoch = 0;
+				m_num_categories_checked = 0;
+				m_categories.clear();
+				m_table_types.clear();
+				m_tables.clear();
+			}
+
+			size_t num_categories() const { return m_categories.size(); }
+
+		private:
+			template<typename category_source> friend class rynx::ecs::gatherer;
+
+			const rynx::ecs* m_ecs = nullptr;
+			uint64_t m_epoch = 0;
+			size_t m_num_categories_checked = 0;
+			dynamic_bitset m_include;
+			dynamic_bitset m_exclude;
+			std::vector<entity_category*> m_categories;
+
+			// m_table_types.size() table pointers per matching category, for the types of the latest iteration.
+			std::vector<type_id_t> m_table_types;
+			std::vector<rynx::ecs_internal::itable*> m_tables;
 		};
 
 		// TODO: is is ok to have the parallel implementation baked into iterator?
@@ -539,26 +892,159 @@ namespace rynx {
 
 			gatherer& include(dynamic_bitset inTypes) { includeTypes = std::move(inTypes); return *this; }
 			gatherer& exclude(dynamic_bitset notInTypes) { excludeTypes = std::move(notInTypes); return *this; }
+			gatherer& cache(query_cache* cache) { m_cache = cache; return *this; }
+			
+			// only visit the chunks of entities where any of the given tables have been written to after version.
+			gatherer& changed_since(std::vector<type_id_t> types, uint64_t version) {
+				for (auto& type : types) {
+					type = use_mapped_type_if_present(type);
+				}
+				m_changedTypes = std::move(types);
+				m_changedSince = version;
+				return *this;
+			}
+
+			// only visit entities whose sparse tag bits pass the filter.
+			gatherer& sparse_tags(rynx::ecs_internal::sparse_tag_filter filter) {
+				m_sparseTags = filter;
+				return *this;
+			}
 
 			void ids(std::vector<rynx::ecs::id>& out) const {
-				auto& categories = m_ecs.categories();
-				for (auto&& entity_category : categories) {
-					if (entity_category.second->includesAll(includeTypes) & entity_category.second->includesNone(excludeTypes)) {
-						auto& ids = entity_category.second->ids();
-						out.insert(out.end(), ids.begin(), ids.end());
-					}
-				}
+				for_each_category([this, &out](entity_category& category) {
+					const auto* ids = category.ids().data();
+					for_each_span(category, [&out, ids](index_t begin, index_t end) {
+						out.insert(out.end(), ids + begin, ids + end);
+					});
+				});
 			}
 
 			index_t count() const {
 				index_t result = 0;
-				auto& categories = m_ecs.categories();
-				for (auto&& entity_category : categories) {
-					if (entity_category.second->includesAll(includeTypes) & entity_category.second->includesNone(excludeTypes)) {
-						result += static_cast<index_t>(entity_category.second->ids().size());
+				for_each_category([this, &result](entity_category& category) {
+					for_each_span(category, [&result](index_t begin, index_t end) {
+						result += end - begin;
+					});
+				});
+				return result;
+			}
+
+			bool matches(const entity_category& category) const {
+				return category.includesAll(includeTypes) & category.includesNone(excludeTypes);
+			}
+
+			// calls op(category) for each category matching the query.
+			template<typename F> void for_each_category(F&& op) const {
+				if (m_cache) {
+					update_cache();
+					for (auto* category : m_cache->m_categories) {
+						op(*category);
 					}
 				}
-				return result;
+				else {
+					for (auto&& entity_category : m_ecs.categories()) {
+						if (matches(*entity_category.second)) {
+							op(*entity_category.second);
+						}
+					}
+				}
+			}
+
+			// calls op(begin, end) for the index ranges of the category that pass the change filter and the sparse tag filter.
+			template<typename F> void for_each_span(entity_category& category, F&& op) const {
+				if (m_sparseTags.empty()) {
+					for_each_changed_span(category, op);
+				}
+				else {
+					const sparse_tag_bits_t* tags = category.sparse_tags();
+					for_each_changed_span(category, [this, tags, &op](index_t begin, index_t end) {
+						while (begin < end) {
+							while (begin < end && !m_sparseTags.accepts(tags[begin])) {
+								++begin;
+							}
+							index_t run_end = begin;
+							while (run_end < end && m_sparseTags.accepts(tags[run_end])) {
+								++run_end;
+							}
+							if (begin < run_end) {
+								op(begin, run_end);
+							}
+							begin = run_end;
+						}
+					});
+				}
+			}
+
+			// calls op(begin, end) for the index ranges of the category that pass the change filter.
+			template<typename F> void for_each_changed_span(entity_category& category, F&& op) const {
+				const index_t size = index_t(category.size());
+				if (m_changedTypes.empty()) {
+					op(index_t(0), size);
+					return;
+				}
+
+				constexpr index_t chunk_size = rynx::ecs_internal::change_chunk_size;
+				const index_t num_chunks = (size + chunk_size - 1) / chunk_size;
+				index_t span_begin = 0;
+				bool in_span = false;
+				for (index_t chunk = 0; chunk < num_chunks; ++chunk) {
+					bool changed = false;
+					for (type_id_t type : m_changedTypes) {
+						auto* table = category.table_ptr(type);
+						changed |= (table != nullptr) && table->changed_since(chunk, m_changedSince);
+					}
+
+					// entities that start to pass the sparse tag filter are new to the query, even when their components are unchanged.
+					changed |= !m_sparseTags.empty() && category.sparse_tags_changed_since(chunk, m_changedSince);
+
+					if (changed != in_span) {
+						if (changed) {
+							span_begin = chunk * chunk_size;
+						}
+						else {
+							op(span_begin, chunk * chunk_size);
+						}
+						in_span = changed;
+					}
+				}
+
+				if (in_span) {
+					op(span_begin, size);
+				}
+			}
+
+			// calls op(span, data...) for each span of matching entities, where data are pointers to the beginning of span in the tables of Ts.
+			// Ts may be given as reference or pointer types. spans are marked as changed in the tables of non-const Ts.
+			// spans are split at the block boundaries of blocked tables, so that the data of each span is contiguous.
+			template<DataAccess accessType, typename... Ts, typename F> void for_each_category_data(F&& op) {
+				auto visit = [this, &op](entity_category& category, auto*... tables) {
+					for_each_span(category, [&](index_t begin, index_t end) {
+						if constexpr (accessType == DataAccess::Mutable) {
+							(mark_written<Ts>(*tables, begin, end), ...);
+						}
+						while (begin < end) {
+							index_t contiguous_end = end;
+							((contiguous_end = tables->contiguous_end(begin, contiguous_end)), ...);
+							op(category_span{ category, category.ids().data() + begin, size_t(contiguous_end - begin) }, table_data<accessType>(*tables, begin)...);
+							begin = contiguous_end;
+						}
+					});
+				};
+
+				if (m_cache) {
+					update_cache();
+					update_table_cache<Ts...>();
+					auto* tables = m_cache->m_tables.data();
+					for (auto* category : m_cache->m_categories) {
+						visit_cached_tables<Ts...>(visit, *category, tables, std::index_sequence_for<Ts...>());
+						tables += sizeof...(Ts);
+					}
+				}
+				else {
+					for_each_category([this, &visit](entity_category& category) {
+						visit(category, &category.template table<component_t<Ts>>(m_typeAliases)...);
+					});
+				}
 			}
 
 			gatherer& type_aliases(rynx::unordered_map<type_id_t, type_id_t>&& typeAliases) {
@@ -603,6 +1089,80 @@ namespace rynx {
 			dynamic_bitset excludeTypes;
 			rynx::unordered_map<type_id_t, type_id_t> m_typeAliases;
 			category_source& m_ecs;
+			query_cache* m_cache = nullptr;
+			std::vector<type_id_t> m_changedTypes;
+			uint64_t m_changedSince = 0;
+			rynx::ecs_internal::sparse_tag_filter m_sparseTags;
+
+		private:
+			template<typename T> using component_t = std::remove_cvref_t<std::remove_pointer_t<T>>;
+			template<typename T> static constexpr bool is_write_access =
+				(std::is_pointer_v<T> && !std::is_const_v<std::remove_pointer_t<T>>) ||
+				(std::is_lvalue_reference_v<T> && !std::is_const_v<std::remove_reference_t<T>>);
+
+			void update_cache() const {
+				const rynx::ecs* host = m_ecs.host();
+				auto& cache = *m_cache;
+				const auto& category_list = host->m_category_list;
+				
+				bool rebuild = (cache.m_ecs != host) ||
+					(cache.m_epoch != host->m_category_epoch) ||
+					(cache.m_num_categories_checked > category_list.size()) ||
+					!(cache.m_include == includeTypes) ||
+					!(cache.m_exclude == excludeTypes);
+
+				if (rebuild) {
+					cache.clear();
+					cache.m_ecs = host;
+					cache.m_epoch = host->m_category_epoch;
+					cache.m_include = includeTypes;
+					cache.m_exclude = excludeTypes;
+				}
+
+				for (size_t i = cache.m_num_categories_checked; i < category_list.size(); ++i) {
+					if (matches(*category_list[i])) {
+						cache.m_categories.emplace_back(category_list[i]);
+					}
+				}
+				cache.m_num_categories_checked = category_list.size();
+			}
+
+			template<typename... Ts> void update_table_cache() {
+				if constexpr (sizeof...(Ts) > 0) {
+					auto& cache = *m_cache;
+					std::array<type_id_t, sizeof...(Ts)> types{ use_mapped_type_if_present(rynx::type_index::id<component_t<Ts>>())... };
+					if (!std::equal(types.begin(), types.end(), cache.m_table_types.begin(), cache.m_table_types.end())) {
+						cache.m_table_types.assign(types.begin(), types.end());
+						cache.m_tables.clear();
+					}
+
+					// tables are owned by the category and never replaced, so the pointers stay valid as long as the category exists.
+					for (size_t i = cache.m_tables.size() / sizeof...(Ts); i < cache.m_categories.size(); ++i) {
+						auto* category = cache.m_categories[i];
+						(cache.m_tables.emplace_back(&category->template table<component_t<Ts>>(m_typeAliases)), ...);
+					}
+				}
+			}
+
+			template<DataAccess accessType, typename U> static auto* table_data(rynx::ecs_internal::component_table<U>& table, index_t index) {
+				if constexpr (accessType == DataAccess::Const) {
+					return static_cast<const rynx::ecs_internal::component_table<U>&>(table).data_at(index);
+				}
+				else {
+					return table.data_at(index);
+				}
+			}
+
+			template<typename T, typename U> static void mark_written([[maybe_unused]] rynx::ecs_internal::component_table<U>& table, [[maybe_unused]] index_t begin, [[maybe_unused]] index_t end) {
+				if constexpr (is_write_access<T>) {
+					table.mark_changed(begin, end);
+				}
+			}
+
+			template<typename... Ts, typename F, size_t... Is>
+			static void visit_cached_tables(F& visit, entity_category& category, rynx::ecs_internal::itable* const* tables, std::index_sequence<Is...>) {
+				visit(category, static_cast<rynx::ecs_internal::component_table<component_t<Ts>>*>(tables[Is])...);
+			}
 		};
 
 		template<typename category_source>
@@ -618,28 +1178,34 @@ namespace rynx {
 			sorter& notIn(rynx::type_index::virtual_type t) { this->excludeTypes.set(t.type_value); return *this; }
 
 			template<typename T> void sort_categories_by() {
-				auto& categories = this->m_ecs.categories();
 				this->template unpack_types<T>();
-				for (auto&& entity_category : categories) {
-					if (entity_category.second->includesAll(this->includeTypes) &
-						entity_category.second->includesNone(this->excludeTypes))
-					{
-						entity_category.second->template sort<T>(this->m_ecs.entity_category_map());
-					}
-				}
+				this->for_each_category([this](entity_category& category) {
+					category.template sort<T>(this->m_ecs.entity_category_map());
+				});
+			}
+
+			// reorders each category along a z-order curve of entity positions, so that entities near each other in the world
+			// are also near each other in memory. cell_size is the world space size of one curve step.
+			void sort_categories_spatially(float cell_size) {
+				this->template unpack_types<rynx::components::transform::position>();
+				this->for_each_category([this, cell_size](entity_category& category) {
+					category.apply_order(category.spatial_order(cell_size), this->m_ecs.entity_category_map());
+				});
+			}
+
+			template<typename TaskContext> void sort_categories_spatially_parallel(TaskContext&& task_context, float cell_size) {
+				this->template unpack_types<rynx::components::transform::position>();
+				this->for_each_category([this, &task_context, cell_size](entity_category& category) {
+					auto order = rynx::make_shared<const std::vector<index_t>>(category.spatial_order(cell_size));
+					category.apply_order_parallel(task_context, std::move(order), this->m_ecs.entity_category_map());
+				});
 			}
 
 			template<typename T> void sort_buckets_one_step() {
-				auto& categories = this->m_ecs.categories();
 				this->template unpack_types<T>();
-				for (auto&& entity_category : categories) {
-					if (entity_category.second->includesAll(this->includeTypes) &
-						entity_category.second->includesNone(this->excludeTypes))
-					{
-						auto& ids = entity_category.second->ids();
-						entity_category.second->template sort_one_step<T>(this->m_ecs.entity_category_map());
-					}
-				}
+				this->for_each_category([this](entity_category& category) {
+					category.template sort_one_step<T>(this->m_ecs.entity_category_map());
+				});
 			}
 		};
 
@@ -671,24 +1237,80 @@ namespace rynx {
 					this->template unpack_types<types_t>(std::make_index_sequence<std::tuple_size<types_t>::value>());
 				}
 
-				auto& categories = this->m_ecs.categories();
-				for (auto&& entity_category : categories) {
-					if (entity_category.second->includesAll(this->includeTypes) & entity_category.second->includesNone(this->excludeTypes)) {
-						auto& ids = entity_category.second->ids();
-						if constexpr (is_id_query) {
-							auto call_user_op = [size = ids.size(), ids_data = ids.data(), &op](auto*... args) {
-								op(size, ids_data, args...);
-							};
-							std::apply(call_user_op, entity_category.second->template table_datas<accessType, id_types_t>(this->m_typeAliases));
+				if constexpr (is_id_query) {
+					this->template for_each_category_data<accessType, Args...>([&op](category_span span, auto*... args) {
+						op(span.size, span.ids, args...);
+					});
+				}
+				else {
+					this->template for_each_category_data<accessType, FArg, Args...>([&op](category_span span, auto*... args) {
+						op(span.size, args...);
+					});
+				}
+			}
+
+			// splits each matching category to chunks of chunk_size entities, and calls op(n, ptrs...) for each chunk in parallel.
+			// chunk size is rounded up so that every chunk begins at a cache line boundary in each of the component tables,
+			// when the span of entities does. spans cut by a sparse tag filter begin at any entity, their chunks are not aligned.
+			template<typename F, typename TaskContext> auto for_each_chunk_parallel(TaskContext&& task_context, size_t chunk_size, F&& op) {
+				constexpr bool is_id_query = std::is_same_v<FArg, rynx::ecs::id const*>;
+				if constexpr (!is_id_query) {
+					this->template unpack_types<std::remove_const_t<std::remove_pointer_t<FArg>>>();
+				}
+				this->template unpack_types<std::remove_const_t<std::remove_pointer_t<Args>>...>();
+
+				auto parallel_ops_container = task_context.parallel();
+				auto chunk_op = [&op, &parallel_ops_container, chunk_size](category_span span, auto*... data_ptrs) {
+					const rynx::ecs::id* ids_data = span.ids;
+					const int64_t num_entities = int64_t(span.size);
+					if (num_entities == 0) {
+						return;
+					}
+
+					const int64_t chunk = int64_t(aligned_chunk_size<std::remove_pointer_t<decltype(data_ptrs)>...>(chunk_size));
+					const bool aligned = ((reinterpret_cast<uintptr_t>(data_ptrs) % rynx::ecs_internal::component_storage_alignment == 0) && ...);
+					parallel_ops_container
+						.range(0, (num_entities + chunk - 1) / chunk, 1)
+						.execute([op, chunk, num_entities, aligned, ids_data, data_ptrs...](int64_t chunk_index) mutable {
+						const int64_t begin = chunk_index * chunk;
+						const size_t n = size_t(std::min(chunk, num_entities - begin));
+						if (aligned) {
+							if constexpr (is_id_query) {
+								op(n, ids_data + begin, std::assume_aligned<rynx::ecs_internal::component_storage_alignment>(data_ptrs + begin)...);
+							}
+							else {
+								op(n, std::assume_aligned<rynx::ecs_internal::component_storage_alignment>(data_ptrs + begin)...);
+							}
 						}
 						else {
-							auto call_user_op = [size = ids.size(), &op](auto... args) {
-								op(size, args...);
-							};
-							std::apply(call_user_op, entity_category.second->template table_datas<accessType, types_t>(this->m_typeAliases));
+							if constexpr (is_id_query) {
+								op(n, ids_data + begin, (data_ptrs + begin)...);
+							}
+							else {
+								op(n, (data_ptrs + begin)...);
+							}
 						}
-					}
+					});
+				};
+
+				if constexpr (is_id_query) {
+					this->template for_each_category_data<accessType, Args...>(chunk_op);
 				}
+				else {
+					this->template for_each_category_data<accessType, FArg, Args...>(chunk_op);
+				}
+
+				return parallel_ops_container;
+			}
+
+		private:
+			// smallest chunk size that is at least requested_size, and keeps chunk boundaries aligned for all types.
+			template<typename... Ts> static constexpr size_t aligned_chunk_size(size_t requested_size) {
+				constexpr size_t alignment = rynx::ecs_internal::component_storage_alignment;
+				size_t granularity = 1;
+				((granularity = std::max(granularity, alignment / std::gcd(alignment, sizeof(Ts)))), ...);
+				requested_size = std::max(requested_size, size_t(1));
+				return ((requested_size + granularity - 1) / granularity) * granularity;
 			}
 		};
 
@@ -723,40 +1345,25 @@ namespace rynx {
 				}
 
 				std::vector<id> gathered_ids;
-				auto& categories = this->m_ecs.categories();
-				for (auto&& entity_category : categories) {
-					if (entity_category.second->includesAll(this->includeTypes) & entity_category.second->includesNone(this->excludeTypes)) {
-						auto& ids = entity_category.second->ids();
-						auto* id_begin = ids.data();
-						auto* id_end = id_begin + ids.size();
-						
-						if constexpr (is_id_query) {
-							auto parameters_tuple = entity_category.second->template table_datas<accessType, components_without_first_t>(this->m_typeAliases);
-							auto iteration_func = [&op, id_begin, id_end, &gathered_ids](auto*... ptrs) mutable {
-								while (id_begin != id_end) {
-									if (op(*id_begin, *ptrs...)) {
-										gathered_ids.emplace_back(*id_begin);
-									}
-									(++ptrs, ...);
-									++id_begin;
-								}
-							};
-							std::apply(iteration_func, parameters_tuple);
+				if constexpr (is_id_query) {
+					this->template for_each_category_data<accessType, Args...>([&op, &gathered_ids](category_span span, auto*... ptrs) {
+						for (auto* id_it = span.ids, *id_end = id_it + span.size; id_it != id_end; ++id_it) {
+							if (op(*id_it, *ptrs...)) {
+								gathered_ids.emplace_back(*id_it);
+							}
+							(++ptrs, ...);
 						}
-						else {
-							auto parameters_tuple = entity_category.second->template table_datas<accessType, components_t>(this->m_typeAliases);
-							auto iteration_func = [&op, id_begin, id_end, &gathered_ids](auto*... ptrs) mutable {
-								while (id_begin != id_end) {
-									if (op(*ptrs...)) {
-										gathered_ids.emplace_back(*id_begin);
-									}
-									(++ptrs, ...);
-									++id_begin;
-								}
-							};
-							std::apply(iteration_func, parameters_tuple);
+					});
+				}
+				else {
+					this->template for_each_category_data<accessType, FArg, Args...>([&op, &gathered_ids](category_span span, auto*... ptrs) {
+						for (auto* id_it = span.ids, *id_end = id_it + span.size; id_it != id_end; ++id_it) {
+							if (op(*ptrs...)) {
+								gathered_ids.emplace_back(*id_it);
+							}
+							(++ptrs, ...);
 						}
-					}
+					});
 				}
 				return gathered_ids;
 			}
@@ -768,17 +1375,15 @@ namespace rynx {
 				}
 				this->template unpack_types<Args...>();
 				
-				auto& categories = this->m_ecs.categories();
-				for (auto&& entity_category : categories) {
-					if (entity_category.second->includesAll(this->includeTypes) & entity_category.second->includesNone(this->excludeTypes)) {
-						auto& ids = entity_category.second->ids();
-						if constexpr (is_id_query) {
-							call_user_op<is_id_query>(std::forward<F>(op), ids, entity_category.second->template table_data<accessType, Args>(this->m_typeAliases)...);
-						}
-						else {
-							call_user_op<is_id_query>(std::forward<F>(op), ids, entity_category.second->template table_data<accessType, FArg>(this->m_typeAliases), entity_category.second->template table_data<accessType, Args>(this->m_typeAliases)...);
-						}
-					}
+				if constexpr (is_id_query) {
+					this->template for_each_category_data<accessType, Args...>([&op](category_span span, auto*... data_ptrs) {
+						call_user_op<is_id_query>(op, span, data_ptrs...);
+					});
+				}
+				else {
+					this->template for_each_category_data<accessType, FArg, Args...>([&op](category_span span, auto*... data_ptrs) {
+						call_user_op<is_id_query>(op, span, data_ptrs...);
+					});
 				}
 			}
 
@@ -791,40 +1396,38 @@ namespace rynx {
 
 				index_t current_index = 0;
 
-				auto& categories = this->m_ecs.categories();
-				for (auto&& entity_category : categories) {
-					if (entity_category.second->includesAll(this->includeTypes) & entity_category.second->includesNone(this->excludeTypes)) {
-						auto& ids = entity_category.second->ids();
-						auto ids_size = index_t(ids.size());
+				auto partial_op = [&](category_span span, auto*... data_ptrs) {
+					auto ids_size = index_t(span.size);
 
-						if ((current_index + ids_size <= r.begin) | (current_index >= r.begin + r.step)) {
-							current_index += ids_size;
-							continue;
-						}
+					if ((current_index + ids_size <= r.begin) | (current_index >= r.begin + r.step)) {
+						current_index += ids_size;
+						return;
+					}
 
-						rynx::ecs::range category_range;
+					rynx::ecs::range category_range;
 
-						if (r.begin < current_index) {
-							category_range.begin = 0;
-							index_t step_offset = current_index % r.step;
-							category_range.step = (category_range.begin + r.step - step_offset <= ids_size) ? r.step - step_offset : ids_size - category_range.begin;
-						}
-						else {
-							category_range.begin = r.begin - current_index;
-							category_range.step = (category_range.begin + r.step <= ids_size) ? r.step : ids_size - category_range.begin;
-						}
+					if (r.begin < current_index) {
+						category_range.begin = 0;
+						index_t step_offset = current_index % r.step;
+						category_range.step = (category_range.begin + r.step - step_offset <= ids_size) ? r.step - step_offset : ids_size - category_range.begin;
+					}
+					else {
+						category_range.begin = r.begin - current_index;
+						category_range.step = (category_range.begin + r.step <= ids_size) ? r.step : ids_size - category_range.begin;
+					}
 
-						rynx_assert(category_range.begin < ids_size, "hehe");
-						rynx_assert(category_range.step <= ids_size, "hehe");
-						current_index += ids_size;
+					rynx_assert(category_range.begin < ids_size, "hehe");
+					rynx_assert(category_range.step <= ids_size, "hehe");
+					current_index += ids_size;
 
-						if constexpr (is_id_query) {
-							call_user_op_range<is_id_query>(category_range, std::forward<F>(op), ids, entity_category.second->template table_data<accessType, Args>(this->m_typeAliases)...);
-						}
-						else {
-							call_user_op_range<is_id_query>(category_range, std::forward<F>(op), ids, entity_category.second->template table_data<accessType, FArg>(this->m_typeAliases), entity_category.second->template table_data<accessType, Args>(this->m_typeAliases)...);
-						}
-					}
+					call_user_op_range<is_id_query>(category_range, op, span, data_ptrs...);
+				};
+
+				if constexpr (is_id_query) {
+					this->template for_each_category_data<accessType, Args...>(partial_op);
+				}
+				else {
+					this->template for_each_category_data<accessType, FArg, Args...>(partial_op);
 				}
 			}
 
@@ -837,17 +1440,15 @@ namespace rynx {
 
 				auto parallel_ops_container = task_context.parallel();
 				
-				auto& categories = this->m_ecs.categories();
-				for (auto&& entity_category : categories) {
-					if (entity_category.second->includesAll(this->includeTypes) & entity_category.second->includesNone(this->excludeTypes)) {
-						auto& ids = entity_category.second->ids();
-						if constexpr (is_id_query) {
-							call_user_op_parallel<is_id_query>(std::forward<F>(op), parallel_ops_container, ids, entity_category.second->template table_data<accessType, Args>(this->m_typeAliases)...);
-						}
-						else {
-							call_user_op_parallel<is_id_query>(std::forward<F>(op), parallel_ops_container, ids, entity_category.second->template table_data<accessType, FArg>(this->m_typeAliases), entity_category.second->template table_data<accessType, Args>(this->m_typeAliases)...);
-						}
-					}
+				auto parallel_op = [&op, &parallel_ops_container](category_span span, auto*... data_ptrs) {
+					call_user_op_parallel<is_id_query>(op, parallel_ops_container, span, data_ptrs...);
+				};
+
+				if constexpr (is_id_query) {
+					this->template for_each_category_data<accessType, Args...>(parallel_op);
+				}
+				else {
+					this->template for_each_category_data<accessType, FArg, Args...>(parallel_op);
 				}
 
 				return parallel_ops_container;
@@ -855,27 +1456,27 @@ namespace rynx {
 
 		private:
 			template<bool isIdQuery, typename F, typename... Ts>
-			static void call_user_op(F&& op, std::vector<id>& ids, Ts* rynx_restrict ... data_ptrs) {
-				auto ids_size = ids.size();
+			static void call_user_op(F&& op, category_span span, Ts* rynx_restrict ... data_ptrs) {
+				[[maybe_unused]] auto category_size = span.category.size();
 				if constexpr (isIdQuery) {
-					std::for_each(ids.data(), ids.data() + ids_size, [=](const id entityId) mutable {
+					std::for_each(span.ids, span.ids + span.size, [=](const id entityId) mutable {
 						op(entityId, (*data_ptrs++)...);
 					});
 				}
 				else {
-					for (size_t i = 0; i < ids_size; ++i) {
+					for (size_t i = 0; i < span.size; ++i) {
 						op((*data_ptrs++)...);
 					}
 				}
-				rynx_assert(ids.size() == ids_size, "creating/deleting entities is not allowed during iteration.");
+				rynx_assert(span.category.size() == category_size, "creating/deleting entities is not allowed during iteration.");
 			}
 
 			template<bool isIdQuery, typename F, typename... Ts>
-			static void call_user_op_range(rynx::ecs::range iteration_range, F&& op, std::vector<id>& ids, Ts* rynx_restrict ... data_ptrs) {
-				[[maybe_unused]] auto ids_size = ids.size();
+			static void call_user_op_range(rynx::ecs::range iteration_range, F&& op, category_span span, Ts* rynx_restrict ... data_ptrs) {
+				[[maybe_unused]] auto category_size = span.category.size();
 				((data_ptrs += iteration_range.begin), ...);
 				if constexpr (isIdQuery) {
-					std::for_each(ids.data() + iteration_range.begin, ids.data() + (iteration_range.begin + iteration_range.step), [=](const id entityId) mutable {
+					std::for_each(span.ids + iteration_range.begin, span.ids + (iteration_range.begin + iteration_range.step), [=](const id entityId) mutable {
 						op(entityId, (*data_ptrs++)...);
 					});
 				}
@@ -885,23 +1486,23 @@ namespace rynx {
 						op((*data_ptrs++)...);
 					}
 				}
-				rynx_assert(ids.size() == ids_size, "creating/deleting entities is not allowed during iteration.");
+				rynx_assert(span.category.size() == category_size, "creating/deleting entities is not allowed during iteration.");
 			}
 
 			template<bool isIdQuery, typename F, typename ParallelOp, typename... Ts>
-			static void call_user_op_parallel(F&& op, ParallelOp&& parallel_ops_container, std::vector<id>& ids, Ts* rynx_restrict ... data_ptrs) {
+			static void call_user_op_parallel(F&& op, ParallelOp&& parallel_ops_container, category_span span, Ts* rynx_restrict ... data_ptrs) {
 				if constexpr (isIdQuery) {
 					parallel_ops_container
-						.range(0, ids.size())
-						.execute([op, &ids, args = std::make_tuple(data_ptrs...)](int64_t index) mutable {
-						std::apply([&ids, op, index](auto*... ptrs) mutable {
+						.range_auto(0, span.size)
+						.execute([op, ids = span.ids, args = std::make_tuple(data_ptrs...)](int64_t index) mutable {
+						std::apply([ids, op, index](auto*... ptrs) mutable {
 							op(ids[index], ptrs[index]...);
 						}, args);
 					});
 				}
 				else {
 					parallel_ops_container
-						.range(0, ids.size())
+						.range_auto(0, span.size)
 						.execute([op, args = std::make_tuple(data_ptrs...)](int64_t index) mutable {
 						std::apply([op, index](auto*... ptrs) mutable {
 							op(ptrs[index]...);
@@ -968,14 +1569,18 @@ namespace rynx {
 				categorySource->template componentTypesAllowed<T&>();
 				rynx_assert(has<T>(), "requested component type not in entity");
 				rynx_assert(m_entity_category->ids().size() > m_category_index && m_entity_category->ids()[m_category_index] == m_id, "entity mapping is broken");
-				return m_entity_category->template table<T>()[m_category_index];
+				auto& table = m_entity_category->template table<T>();
+				mark_changed<T>(table);
+				return table[m_category_index];
 			}
 
 			template<typename T> T& get(rynx::type_index::virtual_type type) {
 				categorySource->template componentTypesAllowed<T&>();
 				rynx_assert(has<T>(), "requested component type not in entity");
 				rynx_assert(m_entity_category->ids().size() > m_category_index && m_entity_category->ids()[m_category_index] == m_id, "entity mapping is broken");
-				return m_entity_category->template table<T>(type.type_value)[m_category_index];
+				auto& table = m_entity_category->template table<T>(type.type_value);
+				mark_changed<T>(table);
+				return table[m_category_index];
 			}
 
 			template<typename T> T* try_get() {
@@ -984,7 +1589,9 @@ namespace rynx {
 				rynx_assert(m_entity_category != nullptr, "referenced entity seems to not exist.");
 				rynx_assert(m_entity_category->ids().size() > m_category_index && m_entity_category->ids()[m_category_index] == m_id, "entity mapping is broken");
 				if (m_entity_category->types().test(typeIndex)) {
-					return &m_entity_category->template table<T>(typeIndex)[m_category_index];
+					auto& table = m_entity_category->template table<T>(typeIndex);
+					mark_changed<T>(table);
+					return &table[m_category_index];
 				}
 				return nullptr;
 			}
@@ -995,7 +1602,9 @@ namespace rynx {
 				rynx_assert(m_entity_category != nullptr, "referenced entity seems to not exist.");
 				rynx_assert(m_entity_category->ids().size() > m_category_index && m_entity_category->ids()[m_category_index] == m_id, "entity mapping is broken");
 				if (m_entity_category->types().test(typeIndex)) {
-					return &m_entity_category->template table<T>(typeIndex)[m_category_index];
+					auto& table = m_entity_category->template table<T>(typeIndex);
+					mark_changed<T>(table);
+					return &table[m_category_index];
 				}
 				return nullptr;
 			}
@@ -1004,12 +1613,19 @@ namespace rynx {
 				categorySource->template componentTypesAllowed<std::add_const_t<Ts> ...>();
 				rynx_assert(m_entity_category, "referenced entity seems to not exist.");
 				rynx_assert(m_entity_category->ids().size() > m_category_index && m_entity_category->ids()[m_category_index] == m_id, "entity mapping is broken");
-				return true & (m_entity_category->types().test(rynx::type_index::id<Ts>()) & ...);
+				return true & (m_entity_category->template has<Ts>(m_category_index) & ...);
 			}
 
 			bool has(type_id_t t) const noexcept {
 				rynx_assert(m_entity_category, "referenced entity seems to not exist.");
-				return m_entity_category->types().test(t);
+				if (m_entity_category->types().test(t)) {
+					return true;
+				}
+
+				// sparse tags are not in the category types, only in the tag bits of the entity.
+				uint32_t sparse_tag_bit = rynx::ecs_internal::find_sparse_tag_bit(t);
+				return sparse_tag_bit != rynx::ecs_internal::max_sparse_tags &&
+					(m_entity_category->sparse_tags(m_category_index) & (sparse_tag_bits_t(1) << sparse_tag_bit)) != 0;
 			}
 
 			bool has(rynx::type_index::virtual_type t) const noexcept {
@@ -1048,6 +1664,12 @@ namespace rynx {
 
 			entity_id_t id() const { return m_id; }
 		private:
+			template<typename T, typename Table> void mark_changed([[maybe_unused]] Table& table) {
+				if constexpr (!std::is_const_v<T>) {
+					table.mark_changed(m_category_index);
+				}
+			}
+
 			category_source* categorySource;
 			entity_category* m_entity_category;
 			index_t m_category_index;
@@ -1102,7 +1724,7 @@ namespace rynx {
 			template<typename... Ts> bool has() const {
 				categorySource->template componentTypesAllowed<Ts...>();
 				rynx_assert(m_entity_category != nullptr, "referenced entity seems to not exist.");
-				return true & (m_entity_category->types().test(rynx::type_index::id<Ts>()) & ...);
+				return true & (m_entity_category->template has<Ts>(m_category_index) & ...);
 			}
 			bool has(rynx::type_index::virtual_type t) const noexcept {
 				rynx_assert(m_entity_category, "referenced entity seems to not exist.");
@@ -1124,8 +1746,30 @@ namespace rynx {
 			dynamic_bitset notInTypes;
 			category_source m_ecs;
 			rynx::unordered_map<type_id_t, type_id_t> m_typeAliases;
+			query_cache* m_cache = nullptr;
+			std::vector<type_id_t> m_changedTypes;
+			uint64_t m_changedSince = 0;
+			rynx::ecs_internal::sparse_tag_filter m_sparseTags;
 			bool m_consumed = false;
 
+			template<typename T> void include_type() {
+				if constexpr (rynx::ecs_internal::is_sparse_tag_v<T>) {
+					m_sparseTags.include |= rynx::ecs_internal::sparse_tag_mask<T>();
+				}
+				else {
+					inTypes.set(rynx::type_index::id<std::add_const_t<T>>());
+				}
+			}
+
+			template<typename T> void exclude_type() {
+				if constexpr (rynx::ecs_internal::is_sparse_tag_v<T>) {
+					m_sparseTags.exclude |= rynx::ecs_internal::sparse_tag_mask<T>();
+				}
+				else {
+					notInTypes.set(rynx::type_index::id<std::add_const_t<T>>());
+				}
+			}
+
 		public:
 			// no copy
 			query_t(const query_t& other) = delete;
@@ -1139,8 +1783,9 @@ namespace rynx {
 			query_t(const category_source& ecs_) : m_ecs(const_cast<category_source&>(ecs_)) {}
 			~query_t() {}
 			
-			template<typename...Ts> query_t& in() { (inTypes.set(rynx::type_index::id<std::add_const_t<Ts>>()), ...); return *this; }
-			template<typename...Ts> query_t& notIn() { (notInTypes.set(rynx::type_index::id<std::add_const_t<Ts>>()), ...); return *this; }
+			// sparse tags are filtered per entity while iterating, other types per category.
+			template<typename...Ts> query_t& in() { (include_type<Ts>(), ...); return *this; }
+			template<typename...Ts> query_t& notIn() { (exclude_type<Ts>(), ...); return *this; }
 			
 			query_t& in(rynx::type_index::virtual_type t) { inTypes.set(t.type_value); return *this; }
 			query_t& notIn(rynx::type_index::virtual_type t) { notInTypes.set(t.type_value); return *this; }
@@ -1150,6 +1795,22 @@ namespace rynx {
 				return *this;
 			}
 
+			// use a persistent cache for category matching. see query_cache.
+			query_t& cached(query_cache& cache) {
+				m_cache = &cache;
+				return *this;
+			}
+
+			// only visit entities for which any of Ts has been written to after version was taken with change_version().
+			// changes are tracked per chunk of entities, so some unchanged neighbours are visited as well. implies in<Ts...>().
+			template<typename...Ts> query_t& changed_since(uint64_t version) {
+				static_assert((std::is_base_of_v<rynx::ecs_track_changes_tag, std::remove_cvref_t<Ts>> && ...), "changes are only tracked for types tagged with rynx::ecs_track_changes_tag");
+				in<Ts...>();
+				(m_changedTypes.emplace_back(rynx::type_index::id<Ts>()), ...);
+				m_changedSince = version;
+				return *this;
+			}
+
 			template<typename F>
 			query_t& for_each(F&& op) {
 				rynx_assert(!m_consumed, "same query object cannot be executed twice.");
@@ -1158,6 +1819,9 @@ namespace rynx {
 				it.include(std::move(inTypes));
 				it.exclude(std::move(notInTypes));
 				it.type_aliases(std::move(m_typeAliases));
+				it.cache(m_cache);
+				it.changed_since(std::move(m_changedTypes), m_changedSince);
+				it.sparse_tags(m_sparseTags);
 				it.for_each(std::forward<F>(op));
 				return *this;
 			}
@@ -1170,6 +1834,9 @@ namespace rynx {
 				it.include(std::move(inTypes));
 				it.exclude(std::move(notInTypes));
 				it.type_aliases(std::move(m_typeAliases));
+				it.cache(m_cache);
+				it.changed_since(std::move(m_changedTypes), m_changedSince);
+				it.sparse_tags(m_sparseTags);
 				it.for_each_partial(r, std::forward<F>(op));
 				index_t num = it.count();
 				
@@ -1190,9 +1857,27 @@ namespace rynx {
 				it.include(std::move(this->inTypes));
 				it.exclude(std::move(this->notInTypes));
 				it.type_aliases(std::move(this->m_typeAliases));
+				it.cache(this->m_cache);
+				it.changed_since(std::move(this->m_changedTypes), this->m_changedSince);
+				it.sparse_tags(this->m_sparseTags);
 				return it.for_each_parallel(task_context, std::forward<F>(op));
 			}
 
+			// op(size_t n, T* rynx_restrict...) is called for chunks of at most chunk_size entities, in parallel.
+			template<typename F, typename TaskContext>
+			auto for_each_chunk_parallel(TaskContext&& task_context, F&& op, size_t chunk_size = 256) {
+				rynx_assert(!m_consumed, "same query object cannot be executed twice.");
+				m_consumed = true;
+				buffer_iterator<accessType, category_source, decltype(&F::operator())> it(m_ecs);
+				it.include(std::move(inTypes));
+				it.exclude(std::move(notInTypes));
+				it.type_aliases(std::move(m_typeAliases));
+				it.cache(m_cache);
+				it.changed_since(std::move(m_changedTypes), m_changedSince);
+				it.sparse_tags(m_sparseTags);
+				return it.for_each_chunk_parallel(task_context, chunk_size, std::forward<F>(op));
+			}
+
 			template<typename F>
 			query_t& for_each_buffer(F&& op) {
 				rynx_assert(!m_consumed, "same query object cannot be executed twice.");
@@ -1201,6 +1886,9 @@ namespace rynx {
 				it.include(std::move(inTypes));
 				it.exclude(std::move(notInTypes));
 				it.type_aliases(std::move(m_typeAliases));
+				it.cache(m_cache);
+				it.changed_since(std::move(m_changedTypes), m_changedSince);
+				it.sparse_tags(m_sparseTags);
 				it.for_each_buffer(std::forward<F>(op));
 				return *this;
 			}
@@ -1213,6 +1901,9 @@ namespace rynx {
 				it.include(std::move(inTypes));
 				it.exclude(std::move(notInTypes));
 				it.type_aliases(std::move(m_typeAliases));
+				it.cache(m_cache);
+				it.changed_since(std::move(m_changedTypes), m_changedSince);
+				it.sparse_tags(m_sparseTags);
 				it.ids(result);
 				return result;
 			}
@@ -1225,6 +1916,9 @@ namespace rynx {
 				it.include(std::move(inTypes));
 				it.exclude(std::move(notInTypes));
 				it.type_aliases(std::move(m_typeAliases));
+				it.cache(m_cache);
+				it.changed_since(std::move(m_changedTypes), m_changedSince);
+				it.sparse_tags(m_sparseTags);
 				return it.ids_if(std::forward<F>(f));
 			}
 			
@@ -1242,6 +1936,9 @@ namespace rynx {
 				it.include(std::move(inTypes));
 				it.exclude(std::move(notInTypes));
 				it.type_aliases(std::move(m_typeAliases));
+				it.cache(m_cache);
+				it.changed_since(std::move(m_changedTypes), m_changedSince);
+				it.sparse_tags(m_sparseTags);
 				return it.count();
 			}
 
@@ -1253,9 +1950,33 @@ namespace rynx {
 				it.include(std::move(inTypes));
 				it.exclude(std::move(notInTypes));
 				it.type_aliases(std::move(m_typeAliases));
+				it.cache(m_cache);
 				it.template sort_categories_by<T>();
 			}
 
+			void sort_spatially(float cell_size = 1.0f) {
+				rynx_assert(!m_consumed, "same query object cannot be executed twice.");
+				m_consumed = true;
+				sorter<category_source> it(m_ecs);
+				it.include(std::move(inTypes));
+				it.exclude(std::move(notInTypes));
+				it.type_aliases(std::move(m_typeAliases));
+				it.cache(m_cache);
+				it.sort_categories_spatially(cell_size);
+			}
+
+			template<typename TaskContext>
+			void sort_spatially_parallel(TaskContext&& task_context, float cell_size = 1.0f) {
+				rynx_assert(!m_consumed, "same query object cannot be executed twice.");
+				m_consumed = true;
+				sorter<category_source> it(m_ecs);
+				it.include(std::move(inTypes));
+				it.exclude(std::move(notInTypes));
+				it.type_aliases(std::move(m_typeAliases));
+				it.cache(m_cache);
+				it.sort_categories_spatially_parallel(task_context, cell_size);
+			}
+
 			template<typename T>
 			void sort_single_step_by() {
 				rynx_assert(!m_consumed, "same query object cannot be executed twice.");
@@ -1264,6 +1985,7 @@ namespace rynx {
 				it.include(std::move(inTypes));
 				it.exclude(std::move(notInTypes));
 				it.type_aliases(std::move(m_typeAliases));
+				it.cache(m_cache);
 				it.template sort_buckets_one_step<T>();
 			}
 		};
@@ -1274,13 +1996,36 @@ namespace rynx {
 		
 		~ecs() {}
 
+		// take a version at the start of a system update, and pass it to query().changed_since<Ts...>(version) on the next update.
+		// every write after taking the version counts as a change.
+		static uint64_t change_version() { return rynx::ecs_internal::advance_change_version(); }
+
 		constexpr size_t size() const {
-			return m_idCategoryMap.size();
+			return m_entities.size();
 		}
 
-		bool exists(entity_id_t id) const { return m_idCategoryMap.find(id) != m_idCategoryMap.end(); }
+		bool exists(entity_id_t id) const { return m_entities.contains(id); }
 		bool exists(id id) const { return exists(id.value); }
 
+		// sparse tags are toggled in place, the entity is not moved to another category. see rynx::ecs_sparse_tag.
+		// safe to call from parallel iteration, as long as no other task is adding or removing entities.
+		template<typename... Tags> ecs& set_tags(entity_id_t id) {
+			static_assert((rynx::ecs_internal::is_sparse_tag_v<Tags> && ...), "only sparse tags can be set");
+			auto& slot = m_entities[id];
+			slot.category->set_sparse_tags(slot.index, rynx::ecs_internal::sparse_tag_mask_of<Tags...>());
+			return *this;
+		}
+
+		template<typename... Tags> ecs& clear_tags(entity_id_t id) {
+			static_assert((rynx::ecs_internal::is_sparse_tag_v<Tags> && ...), "only sparse tags can be cleared");
+			auto& slot = m_entities[id];
+			slot.category->clear_sparse_tags(slot.index, rynx::ecs_internal::sparse_tag_mask_of<Tags...>());
+			return *this;
+		}
+
+		template<typename... Tags> ecs& set_tags(id id) { return set_tags<Tags...>(id.value); }
+		template<typename... Tags> ecs& clear_tags(id id) { return clear_tags<Tags...>(id.value); }
+
 		entity<ecs, true> operator[](entity_id_t id) { return entity<ecs, true>(*this, id); }
 		entity<ecs, true> operator[](id id) { return entity<ecs, true>(*this, id.value); }
 		const_entity<ecs> operator[](entity_id_t id) const { return const_entity<ecs>(*this, id); }
@@ -1295,7 +2040,8 @@ namespace rynx {
 			template<typename T> type_id_t typeId() { return rynx::type_index::id<T>(); }
 			template<typename...Ts> void componentTypesAllowed() const { m_ecs->componentTypesAllowed<Ts...>(); };
 
-			auto& entity_category_map() { return m_ecs->m_idCategoryMap; }
+			auto& entity_category_map() { return m_ecs->m_entities; }
+			const ecs* host() const { return m_ecs; }
 
 		private:
 			ecs* m_ecs;
@@ -1304,19 +2050,29 @@ namespace rynx {
 		query_t<DataAccess::Mutable, ecs_reference> query() { return query_t<DataAccess::Mutable, ecs_reference>(ecs_reference(this)); }
 		query_t<DataAccess::Const, ecs_reference> query() const { return query_t<DataAccess::Const, ecs_reference>(ecs_reference(this)); }
 
+		// resource ids of categories that have all include types and none of exclude types. see rynx::scheduler::context.
+		template<typename Container>
+		void category_resource_ids(const dynamic_bitset& include, const dynamic_bitset& exclude, Container& out) const {
+			for (auto* category : m_category_list) {
+				if (category->includesAll(include) && category->includesNone(exclude)) {
+					out.emplace_back(category->resource_id());
+				}
+			}
+		}
+
 		std::pair<entity_category*, index_t> category_and_index_for(entity_id_t id) const {
-			auto it = m_idCategoryMap.find(id);
-			rynx_assert(it != m_idCategoryMap.end(), "requesting category and index for an entity id that does not exist");
-			return it->second;
+			const auto* slot = m_entities.find(id);
+			rynx_assert(slot != nullptr, "requesting category and index for an entity id that does not exist");
+			return { slot->category, slot->index };
 		}
 
 		void erase(entity_id_t entityId) {
-			auto it = m_idCategoryMap.find(entityId);
-			if (it != m_idCategoryMap.end()) [[likely]] {
-				auto* category = it->second.first;
-				index_t entity_index = it->second.second;
+			auto* slot = m_entities.find(entityId);
+			if (slot != nullptr) [[likely]] {
+				auto* category = slot->category;
+				index_t entity_index = slot->index;
 				
-				category->erase(entity_index, m_idCategoryMap);
+				category->erase(entity_index, m_entities);
 				erase_category_if_empty(category);
 			}
 		}
@@ -1337,7 +2093,8 @@ namespace rynx {
 				}
 			}
 			this->m_categories.clear();
-			this->m_idCategoryMap.clear();
+			this->m_category_list.clear();
+			this->invalidate_cached_queries();
 			this->m_value_segregated_types_maps.clear();
 			this->m_entities.clear();
 		}
@@ -1371,7 +2128,7 @@ namespace rynx {
 			return;
 			if (source_category->ids().empty()) {
 				rynx_assert(m_categories.find(source_category->types())->second.get() == source_category, "???");
-				m_categories.erase(source_category->types());
+				erase_category(source_category->types());
 			}
 		}
 
@@ -1389,6 +2146,9 @@ namespace rynx {
 
 			template<typename T>
 			void compute_type_category(rynx::dynamic_bitset& dst, T& component) {
+				if constexpr (rynx::ecs_internal::is_sparse_tag_v<T>) {
+					return; // not part of the category.
+				}
 				dst.set(mapped_type_id(m_ecs.type_id_for(component)));
 				if constexpr (std::is_base_of_v<rynx::ecs_value_segregated_component_tag, std::remove_cvref_t<T>>) {
 					auto& map = m_ecs.value_segregated_types_map<std::remove_cvref_t<T>>();
@@ -1425,8 +2185,11 @@ namespace rynx {
 				}
 			}
 
-			template<typename T>
-			void compute_type_category_n(rynx::dynamic_bitset& dst, std::vector<T>& component) {
+			template<typename T, typename Allocator>
+			void compute_type_category_n(rynx::dynamic_bitset& dst, std::vector<T, Allocator>& component) {
+				if constexpr (rynx::ecs_internal::is_sparse_tag_v<T>) {
+					return; // not part of the category.
+				}
 				dst.set(mapped_type_id(m_ecs.type_id_for(component.front())));
 				if constexpr (std::is_base_of_v<rynx::ecs_value_segregated_component_tag, std::remove_cvref_t<T>>) {
 					auto& map = m_ecs.value_segregated_types_map<std::remove_cvref_t<T>>();
@@ -1467,44 +2230,46 @@ namespace rynx {
 
 			template<typename... Components>
 			entity_id_t create(Components&& ... components) {
-				entity_id_t id = m_ecs.m_entities.generateOne();
 				dynamic_bitset targetCategory;
 				(compute_type_category(targetCategory, components), ...);
 				auto category_it = m_ecs.m_categories.find(targetCategory);
-				if (category_it == m_ecs.m_categories.end()) { category_it = m_ecs.m_categories.emplace(targetCategory, rynx::make_unique<entity_category>(targetCategory)).first; }
-				auto index = category_it->second->insertNew(m_typeAliases, id, std::forward<Components>(components)...);
-				m_ecs.m_idCategoryMap.emplace(id, std::make_pair(category_it->second.get(), index_t(index)));
+				if (category_it == m_ecs.m_categories.end()) { category_it = m_ecs.create_category(targetCategory); }
+				entity_id_t id = m_ecs.m_entities.generate_at(category_it->second.get(), index_t(category_it->second->size()));
+				[[maybe_unused]] auto index = category_it->second->insertNew(m_typeAliases, id, std::forward<Components>(components)...);
+				rynx_assert(m_ecs.m_entities[id].index == index, "entity must be appended to the location given to its id");
 				return id;
 			}
 
 			// TODO: The api for tags is super unclear for user. Should have some kind of ..
 			//       create_n(ids, vector<Ts>).with_tags<Tag1, Tag2...>(); // style format.
-			template<typename... Tags, typename... Components>
-			rynx::ecs::range create_n(std::vector<Components>&& ... components) {
+			template<typename... Tags, typename... Components, typename... Allocators>
+			rynx::ecs::range create_n(std::vector<Components, Allocators>&& ... components) {
 				rynx_assert((components.size() & ...) == (components.size() | ...), "components vector sizes do not match!");
 				
 				if constexpr (true) {
 					std::vector<rynx::id> ids(rynx::first_of(components...).size());
 
-					// TODO: generate_n might be more efficient. benchmark if this shows up in profiler.
-					for (rynx::id& id : ids) {
-						id = m_ecs.m_entities.generateOne();
+					entity_id_t first_id = m_ecs.m_entities.generate_range(ids.size());
+					for (size_t i = 0; i < ids.size(); ++i) {
+						ids[i] = first_id + i;
 					}
 					rynx_assert(rynx::first_of(components...).size() == ids.size(), "ahaa");
 
 					// target category is the same for all entities created in this call.
 					dynamic_bitset targetCategory;
 					(compute_type_category_n(targetCategory, components), ...);
-					(targetCategory.set(mapped_type_id(rynx::type_index::id<Tags>())), ...);
+					([&]() {
+						if constexpr (!rynx::ecs_internal::is_sparse_tag_v<Tags>) {
+							targetCategory.set(mapped_type_id(rynx::type_index::id<Tags>()));
+						}
+					}(), ...);
 					auto category_it = m_ecs.m_categories.find(targetCategory);
-					if (category_it == m_ecs.m_categories.end()) { category_it = m_ecs.m_categories.emplace(targetCategory, rynx::make_unique<entity_category>(targetCategory)).first; }
+					if (category_it == m_ecs.m_categories.end()) { category_it = m_ecs.create_category(targetCategory); }
 
 					auto first_index = category_it->second->ids().size();
-					for (size_t i = 0; i < ids.size(); ++i) {
-						m_ecs.m_idCategoryMap.emplace(ids[i].value, std::make_pair(category_it->second.get(), index_t(first_index + i)));
-					}
+					m_ecs.m_entities.assign_range(first_id, ids.size(), category_it->second.get(), index_t(first_index));
 					rynx::ecs::range ids_range{first_index, first_index + ids.size()};
-					category_it->second->insertNew(m_typeAliases, std::move(ids), std::move(components)...);
+					category_it->second->insertNew(m_typeAliases, std::move(ids), rynx::ecs_internal::sparse_tag_mask_of<Tags..., Components...>(), std::move(components)...);
 					return ids_range;
 				}
 				else {
@@ -1521,15 +2286,21 @@ namespace rynx {
 				entity_id_t id,
 				type_id_t type_id,
 				bool is_value_segregated,
+				bool is_sparse_tag,
 				rynx::ecs_table_create_func& table_create_func,
 				rynx::function<rynx::unique_ptr<rynx::ecs_internal::ivalue_segregation_map>()> map_create_func,
 				opaque_unique_ptr<void> component)
 			{
-				auto it = m_ecs.m_idCategoryMap.find(id);
-				auto* source_category = it->second.first;
-				index_t source_index = it->second.second;
+				auto* it = m_ecs.m_entities.find(id);
+				rynx_assert(it != nullptr, "attachToEntity called for entity that does not exist.");
+				if (is_sparse_tag) {
+					// the tag may not have been used by typed code yet, so its bit is assigned here if needed.
+					it->category->set_sparse_tags(it->index, sparse_tag_bits_t(1) << rynx::ecs_internal::sparse_tag_bit(type_id));
+					return *this;
+				}
 
-				rynx_assert(it != m_ecs.m_idCategoryMap.end(), "attachToEntity called for entity that does not exist.");
+				auto* source_category = it->category;
+				index_t source_index = it->index;
 				rynx_assert(source_category->ids()[source_index] == id, "Entity mapping is broken");
 
 				const dynamic_bitset& initialTypes = source_category->types();
@@ -1540,7 +2311,7 @@ namespace rynx {
 
 				auto destinationCategoryIt = m_ecs.m_categories.find(resultTypes);
 				if (destinationCategoryIt == m_ecs.m_categories.end()) {
-					destinationCategoryIt = m_ecs.m_categories.emplace(resultTypes, rynx::make_unique<entity_category>(resultTypes)).first;
+					destinationCategoryIt = m_ecs.create_category(resultTypes);
 					destinationCategoryIt->second->copyTypesFrom(source_category); // NOTE: Must make copies of table types for tables for which we don't know the type in this context.
 				}
 
@@ -1549,7 +2320,7 @@ namespace rynx {
 					initialTypes, // types moved
 					source_category, // source category
 					source_index, // source index
-					m_ecs.m_idCategoryMap
+					m_ecs.m_entities
 				);
 
 				m_ecs.erase_category_if_empty(source_category);
@@ -1559,11 +2330,18 @@ namespace rynx {
 
 			template<typename... Components>
 			edit_t& attachToEntity(entity_id_t id_value, Components&& ... components) {
-				auto it = m_ecs.m_idCategoryMap.find(id_value);
-				auto* source_category = it->second.first;
-				index_t source_index = it->second.second;
+				if constexpr ((rynx::ecs_internal::is_sparse_tag_v<Components> && ...)) {
+					m_ecs.set_tags<std::remove_cvref_t<Components>...>(id_value);
+					return *this;
+				}
+				else {
+					static_assert(!(rynx::ecs_internal::is_sparse_tag_v<Components> || ...), "attach sparse tags separately from other components");
+				}
 
-				rynx_assert(it != m_ecs.m_idCategoryMap.end(), "attachToEntity called for entity that does not exist.");
+				auto* it = m_ecs.m_entities.find(id_value);
+				rynx_assert(it != nullptr, "attachToEntity called for entity that does not exist.");
+				auto* source_category = it->category;
+				index_t source_index = it->index;
 				rynx_assert(source_category->ids()[source_index] == id_value, "Entity mapping is broken");
 				
 				const dynamic_bitset& initialTypes = source_category->types();
@@ -1574,7 +2352,7 @@ namespace rynx {
 				
 				auto destinationCategoryIt = m_ecs.m_categories.find(resultTypes);
 				if (destinationCategoryIt == m_ecs.m_categories.end()) {
-					destinationCategoryIt = m_ecs.m_categories.emplace(resultTypes, rynx::make_unique<entity_category>(resultTypes)).first;
+					destinationCategoryIt = m_ecs.create_category(resultTypes);
 					destinationCategoryIt->second->copyTypesFrom(source_category); // NOTE: Must make copies of table types for tables for which we don't know the type in this context.
 				}
 
@@ -1583,7 +2361,7 @@ namespace rynx {
 					initialTypes, // types moved
 					source_category, // source category
 					source_index, // source index
-					m_ecs.m_idCategoryMap
+					m_ecs.m_entities
 				);
 				
 				m_ecs.erase_category_if_empty(source_category);
@@ -1593,11 +2371,18 @@ namespace rynx {
 
 			template<typename... Components>
 			edit_t& removeFromEntity(entity_id_t id) {
-				auto it = m_ecs.m_idCategoryMap.find(id);
-				auto* source_category = it->second.first;
-				index_t source_index = it->second.second;
+				if constexpr ((rynx::ecs_internal::is_sparse_tag_v<Components> && ...)) {
+					m_ecs.clear_tags<Components...>(id);
+					return *this;
+				}
+				else {
+					static_assert(!(rynx::ecs_internal::is_sparse_tag_v<Components> || ...), "remove sparse tags separately from other components");
+				}
 
-				rynx_assert(it != m_ecs.m_idCategoryMap.end(), "removeFromEntity called for entity that does not exist.");
+				auto* it = m_ecs.m_entities.find(id);
+				rynx_assert(it != nullptr, "removeFromEntity called for entity that does not exist.");
+				auto* source_category = it->category;
+				index_t source_index = it->index;
 				rynx_assert(source_category->ids()[source_index] == id, "Entity mapping is broken");
 
 				const dynamic_bitset& initialTypes = source_category->types();
@@ -1609,7 +2394,7 @@ namespace rynx {
 
 				auto destinationCategoryIt = m_ecs.m_categories.find(resultTypes);
 				if (destinationCategoryIt == m_ecs.m_categories.end()) {
-					destinationCategoryIt = m_ecs.m_categories.emplace(resultTypes, rynx::make_unique<entity_category>(resultTypes)).first;
+					destinationCategoryIt = m_ecs.create_category(resultTypes);
 					destinationCategoryIt->second->copyTypesFrom(source_category, resultTypes);
 				}
 
@@ -1618,7 +2403,7 @@ namespace rynx {
 					resultTypes,
 					source_category,
 					source_index,
-					m_ecs.m_idCategoryMap
+					m_ecs.m_entities
 				);
 				
 				m_ecs.erase_category_if_empty(source_category);
@@ -1626,11 +2411,16 @@ namespace rynx {
 			}
 
 			edit_t& removeFromEntity(entity_id_t id, type_id_t t) {
-				auto it = m_ecs.m_idCategoryMap.find(id);
-				rynx_assert(it != m_ecs.m_idCategoryMap.end(), "removeFromEntity called for entity that does not exist.");
+				auto* it = m_ecs.m_entities.find(id);
+				rynx_assert(it != nullptr, "removeFromEntity called for entity that does not exist.");
+				uint32_t sparse_tag_bit = rynx::ecs_internal::find_sparse_tag_bit(t);
+				if (sparse_tag_bit != rynx::ecs_internal::max_sparse_tags) {
+					it->category->clear_sparse_tags(it->index, sparse_tag_bits_t(1) << sparse_tag_bit);
+					return *this;
+				}
 
-				auto* source_category = it->second.first;
-				index_t source_index = it->second.second;
+				auto* source_category = it->category;
+				index_t source_index = it->index;
 
 				const dynamic_bitset& initialTypes = source_category->types();
 				rynx_assert(initialTypes.test(t), "attempting to remove a type from entity but it doesn't exist for entity");
@@ -1649,7 +2439,7 @@ namespace rynx {
 
 				auto destinationCategoryIt = m_ecs.m_categories.find(resultTypes);
 				if (destinationCategoryIt == m_ecs.m_categories.end()) {
-					destinationCategoryIt = m_ecs.m_categories.emplace(resultTypes, rynx::make_unique<entity_category>(resultTypes)).first;
+					destinationCategoryIt = m_ecs.create_category(resultTypes);
 					destinationCategoryIt->second->copyTypesFrom(source_category, resultTypes);
 				}
 				
@@ -1657,7 +2447,7 @@ namespace rynx {
 					resultTypes,
 					source_category,
 					source_index,
-					m_ecs.m_idCategoryMap
+					m_ecs.m_entities
 				);
 
 				m_ecs.erase_category_if_empty(source_category);
@@ -1669,11 +2459,11 @@ namespace rynx {
 			}
 
 			edit_t& removeFromEntity(entity_id_t id, rynx::type_index::virtual_type t) {
-				auto it = m_ecs.m_idCategoryMap.find(id);
-				rynx_assert(it != m_ecs.m_idCategoryMap.end(), "removeFromEntity called for entity that does not exist.");
+				auto* it = m_ecs.m_entities.find(id);
+				rynx_assert(it != nullptr, "removeFromEntity called for entity that does not exist.");
 				
-				auto* source_category = it->second.first;
-				index_t source_index = it->second.second;
+				auto* source_category = it->category;
+				index_t source_index = it->index;
 
 				const dynamic_bitset& initialTypes = source_category->types();
 				dynamic_bitset resultTypes = initialTypes;
@@ -1681,7 +2471,7 @@ namespace rynx {
 
 				auto destinationCategoryIt = m_ecs.m_categories.find(resultTypes);
 				if (destinationCategoryIt == m_ecs.m_categories.end()) {
-					destinationCategoryIt = m_ecs.m_categories.emplace(resultTypes, rynx::make_unique<entity_category>(resultTypes)).first;
+					destinationCategoryIt = m_ecs.create_category(resultTypes);
 					destinationCategoryIt->second->copyTypesFrom(source_category, resultTypes);
 				}
 
@@ -1691,7 +2481,7 @@ namespace rynx {
 					resultTypes,
 					source_category,
 					source_index,
-					m_ecs.m_idCategoryMap
+					m_ecs.m_entities
 				);
 				
 				m_ecs.erase_category_if_empty(source_category);
@@ -1708,11 +2498,145 @@ namespace rynx {
 			return edit_t(*this).create(std::forward<Components>(components)...);
 		}
 
-		template<typename... Tags, typename... Components>
-		rynx::ecs::range create_n(std::vector<Components>&& ... components) {
+		// vectors of type component_vector are taken over by empty tables, others are moved over entry by entry.
+		template<typename... Tags, typename... Components, typename... Allocators>
+		rynx::ecs::range create_n(std::vector<Components, Allocators>&& ... components) {
 			return edit_t(*this).create_n<Tags..., Components...>(std::move(components)...);
 		}
 
+		// creates entities of one fixed set of component types in bulk.
+		// target category and its tables are looked up once, and only again after categories have been erased or re-keyed.
+		// ids of each batch are consecutive, and are registered with a single pass over the entity index.
+		// tag types (empty components) are accepted, sparse tags are set on each spawned entity.
+		// value segregated types and type aliases are not supported, their category can not be known in advance.
+		template<typename... Components>
+		class spawner {
+			static_assert(sizeof...(Components) > 0, "spawned entities must have at least one component");
+			static_assert(((!std::is_base_of_v<rynx::ecs_value_segregated_component_tag, Components>) && ...), "value segregated components can not be spawned in bulk");
+			static_assert(((std::is_same_v<Components, std::remove_cvref_t<Components>>) && ...), "spawner component types must be plain value types");
+			static_assert(((!std::is_same_v<Components, rynx::type_index::virtual_type>) && ...), "virtual types can not be spawned in bulk");
+
+			// tag types have no table. a shared instance is handed to the generator instead.
+			template<typename T> using storage_t = std::conditional_t<std::is_empty_v<T>, T, rynx::ecs_internal::component_table<T>>;
+			template<typename T> static inline T s_tag_instance{};
+
+		public:
+			spawner(ecs& host) : m_ecs(host) {
+				([this]() {
+					if constexpr (!rynx::ecs_internal::is_sparse_tag_v<Components>) {
+						m_types.set(rynx::type_index::id<Components>());
+					}
+				}(), ...);
+			}
+
+			// reserves room for n more entities in the target category.
+			spawner& reserve(size_t n) {
+				entity_category& category = resolve();
+				const size_t capacity = category.size() + n;
+				category.reserve(capacity);
+				([this, capacity]() {
+					if constexpr (!std::is_empty_v<Components>) {
+						std::get<storage_t<Components>*>(m_tables)->reserve(capacity);
+					}
+				}(), ...);
+				return *this;
+			}
+
+			// creates n entities. components are default constructed in place, and then
+			// generator(size_t i, Components&... components) is called to fill in the i'th entity.
+			template<typename F>
+			rynx::entity_range_t spawn(size_t n, F&& generator) {
+				entity_category& category = resolve();
+				const index_t first_index = index_t(category.size());
+				([this, n]() {
+					if constexpr (!std::is_empty_v<Components>) {
+						std::get<storage_t<Components>*>(m_tables)->insert_default(n);
+					}
+				}(), ...);
+
+				for (size_t i = 0; i < n; ++i) {
+					generator(i, component_at<Components>(index_t(first_index + i))...);
+				}
+				return register_ids(category, n);
+			}
+
+			// creates entities from component arrays of equal length, one array per component type.
+			// arrays of tag types only need to have the correct length.
+			template<typename... Allocators>
+			rynx::entity_range_t spawn(std::vector<Components, Allocators>&& ... components) {
+				rynx_assert((components.size() & ...) == (components.size() | ...), "components vector sizes do not match!");
+				entity_category& category = resolve();
+				(insert_values(std::move(components)), ...);
+				return register_ids(category, rynx::first_of(components...).size());
+			}
+
+			rynx::entity_range_t spawn(std::span<const Components> ... components) {
+				rynx_assert((components.size() & ...) == (components.size() | ...), "components span sizes do not match!");
+				entity_category& category = resolve();
+				(insert_values(components), ...);
+				return register_ids(category, rynx::first_of(components...).size());
+			}
+
+		private:
+			entity_category& resolve() {
+				if (m_category == nullptr || m_epoch != m_ecs.m_category_epoch) {
+					auto category_it = m_ecs.m_categories.find(m_types);
+					if (category_it == m_ecs.m_categories.end()) { category_it = m_ecs.create_category(m_types); }
+					m_category = category_it->second.get();
+					m_epoch = m_ecs.m_category_epoch;
+					m_tables = std::tuple<storage_t<Components>*...>{ storage_of<Components>(*m_category)... };
+				}
+				return *m_category;
+			}
+
+			template<typename T> static storage_t<T>* storage_of(entity_category& category) {
+				if constexpr (std::is_empty_v<T>) {
+					return &s_tag_instance<T>;
+				}
+				else {
+					return &category.table<T>(rynx::type_index::id<T>());
+				}
+			}
+
+			template<typename T> T& component_at(index_t index) {
+				if constexpr (std::is_empty_v<T>) {
+					return *std::get<storage_t<T>*>(m_tables);
+				}
+				else {
+					return (*std::get<storage_t<T>*>(m_tables))[index];
+				}
+			}
+
+			template<typename T, typename Allocator> void insert_values([[maybe_unused]] std::vector<T, Allocator>&& values) {
+				if constexpr (!std::is_empty_v<T>) {
+					std::get<storage_t<T>*>(m_tables)->insert(std::move(values));
+				}
+			}
+
+			template<typename T> void insert_values([[maybe_unused]] std::span<const T> values) {
+				if constexpr (!std::is_empty_v<T>) {
+					std::get<storage_t<T>*>(m_tables)->insert(values);
+				}
+			}
+
+			rynx::entity_range_t register_ids(entity_category& category, size_t n) {
+				entity_id_t first_id = m_ecs.m_entities.generate_range(n);
+				category.insertIdRange(first_id, n, rynx::ecs_internal::sparse_tag_mask_of<Components...>(), m_ecs.m_entities);
+				return { first_id, first_id + n };
+			}
+
+			ecs& m_ecs;
+			dynamic_bitset m_types;
+			entity_category* m_category = nullptr;
+			uint64_t m_epoch = 0;
+			std::tuple<storage_t<Components>*...> m_tables;
+		};
+
+		template<typename... Components>
+		spawner<Components...> make_spawner() {
+			return spawner<Components...>(*this);
+		}
+
 		template<typename... Components>
 		edit_t& attachToEntity(entity_id_t id, Components&& ... components) {
 			return edit_t(*this).attachToEntity(id, std::forward<Components>(components)...);
@@ -1722,11 +2646,12 @@ namespace rynx {
 			entity_id_t id,
 			type_id_t type_id,
 			bool is_value_segregated,
+			bool is_sparse_tag,
 			rynx::ecs_table_create_func creator,
 			rynx::function<rynx::unique_ptr<rynx::ecs_internal::ivalue_segregation_map>()> map_create_func,
 			rynx::opaque_unique_ptr<void> data)
 		{
-			return edit_t(*this).attachToEntity_typeErased(id, type_id, is_value_segregated, creator, std::move(map_create_func), std::move(data));
+			return edit_t(*this).attachToEntity_typeErased(id, type_id, is_value_segregated, is_sparse_tag, creator, std::move(map_create_func), std::move(data));
 		}
 
 		template<typename... Components>
@@ -1769,6 +2694,7 @@ namespace rynx {
 			template<DataAccess accessType, typename category_source> friend class rynx::ecs::query_t;
 			template<DataAccess accessType, typename category_source, typename F> friend class rynx::ecs::entity_iterator;
 			template<DataAccess accessType, typename category_source, typename F> friend class rynx::ecs::buffer_iterator;
+			friend class rynx::ecs_command_buffer;
 
 			template<typename T> static constexpr bool typeAllowed() { return isAny<std::remove_const_t<T>, id, rynx::type_index::virtual_type, std::remove_const_t<TypeConstraints>...>(); }
 			template<typename T> static constexpr bool typeConstCorrect() {
@@ -1790,7 +2716,7 @@ namespace rynx {
 				return 	!(std::is_base_of_v<rynx::ecs_value_segregated_component_tag, std::remove_cvref_t<Arg>> &&
 					(!std::is_const_v<std::remove_reference_t<Arg>> && std::is_reference_v<Arg>));
 			}
-			auto& entity_category_map() { return m_ecs->m_idCategoryMap; }
+			auto& entity_category_map() { return m_ecs->m_entities; }
 
 		protected:
 			template<typename...Args> void componentTypesAllowedForRemove() const {
@@ -1820,12 +2746,20 @@ namespace rynx {
 			query_t<DataAccess::Const, view> query() const { return query_t<DataAccess::Const, view>(*this); }
 
 			rynx::type_index::virtual_type create_virtual_type() { return m_ecs->create_virtual_type(); }
+			uint64_t change_version() const { return rynx::ecs::change_version(); }
+
+			// toggling sparse tags does not change categories, so write access to the tag type is enough. see rynx::ecs::set_tags.
+			template<typename... Tags> void set_tags(entity_id_t id) { componentTypesAllowed<Tags&...>(); m_ecs->template set_tags<Tags...>(id); }
+			template<typename... Tags> void clear_tags(entity_id_t id) { componentTypesAllowed<Tags&...>(); m_ecs->template clear_tags<Tags...>(id); }
+			template<typename... Tags> void set_tags(id id) { set_tags<Tags...>(id.value); }
+			template<typename... Tags> void clear_tags(id id) { clear_tags<Tags...>(id.value); }
 
 		private:
 			auto& categories() { return m_ecs->categories(); }
 			const auto& categories() const { return m_ecs->categories(); }
 
 			auto category_and_index_for(entity_id_t id) const { return m_ecs->category_and_index_for(id); }
+			const rynx::ecs* host() const { return m_ecs; }
 
 		protected:
 			template<typename T>
@@ -1877,6 +2811,12 @@ namespace rynx {
 				return this->m_ecs->create(components...);
 			}
 
+			template<typename... Components>
+			rynx::ecs::spawner<Components...> make_spawner() {
+				this->template componentTypesAllowed<Components...>();
+				return this->m_ecs->template make_spawner<Components...>();
+			}
+
 			template<typename... Components>
 			edit_view& attachToEntity(entity_id_t id, Components&& ... components) {
 				this->template componentTypesAllowed<Components...>();
@@ -1899,8 +2839,48 @@ namespace rynx {
 			}
 		};
 
+		// view that only accesses entities in the categories of its scope. queries of the view only visit those categories.
+		// the scheduler reserves the types of a scoped view per category, so tasks that write the same types
+		// in disjoint categories can run in parallel. for example scoped_view<with<player>, without<>, motion>.
+		template<typename With, typename Without, typename...TypeConstraints> class scoped_view;
+
+		template<typename... Include, typename... Exclude, typename...TypeConstraints>
+		class scoped_view<with<Include...>, without<Exclude...>, TypeConstraints...> final : public view<TypeConstraints...> {
+			static_assert(((!rynx::ecs_internal::is_sparse_tag_v<Include>) && ...) && ((!rynx::ecs_internal::is_sparse_tag_v<Exclude>) && ...),
+				"sparse tags are not part of categories, they can not define the scope of a view");
+			using base = view<TypeConstraints...>;
+
+		public:
+			scoped_view(const rynx::ecs* ecs) : base(ecs) {}
+
+			auto query() {
+				auto q = base::query();
+				q.template in<Include...>();
+				q.template notIn<Exclude...>();
+				return q;
+			}
+
+			auto query() const {
+				auto q = base::query();
+				q.template in<Include...>();
+				q.template notIn<Exclude...>();
+				return q;
+			}
+
+			bool in_scope(entity_id_t id) const {
+				const auto& types = this->m_ecs->category_and_index_for(id).first->types();
+				return (types.test(rynx::type_index::id<Include>()) && ...) && (!types.test(rynx::type_index::id<Exclude>()) && ...);
+			}
+
+			auto operator[](entity_id_t id) { rynx_assert(in_scope(id), "entity is outside of the scope of the view"); return base::operator[](id); }
+			auto operator[](id id) { return operator[](id.value); }
+			auto operator[](entity_id_t id) const { rynx_assert(in_scope(id), "entity is outside of the scope of the view"); return base::operator[](id); }
+			auto operator[](id id) const { return operator[](id.value); }
+		};
+
 		template<typename...Args> operator view<Args...>() const { return view<Args...>(this); }
 		template<typename...Args> operator edit_view<Args...>() const { return edit_view<Args...>(this); }
+		template<typename With, typename Without, typename...Args> operator scoped_view<With, Without, Args...>() const { return scoped_view<With, Without, Args...>(this); }
 	};
 
 }
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <rynx/ecs/id.hpp>
+#include <rynx/system/assert.hpp>
+
+#include <vector>
+
+namespace rynx {
+	namespace ecs_internal {
+
+		// maps entity ids to their current location (category + index in category).
+		// entity id value is a direct index to a dense slot array, so lookups are a single array access.
+		// released slots are reused via a free list, and each reuse bumps the generation of the slot.
+		// stale ids (entity erased, slot reused) are detected by comparing the generation of the id to the generation of the slot.
+		//
+		// NOTE: ranges of ids are always generated from fresh slots. this keeps the values of the range consecutive,
+		//       which is something deserialization and entity_range_t rely on.
+		template<typename Category>
+		class entity_index {
+		public:
+			struct slot {
+				Category* category = nullptr;
+				index_t index = 0;
+				uint32_t generation = 0;
+
+				bool alive() const noexcept { return category != nullptr; }
+			};
+
+			static_assert(sizeof(slot) <= 16, "keep slots small, they are accessed randomly");
+
+			entity_index() {
+				m_slots.emplace_back(); // slot zero is reserved for InvalidId, never handed out.
+			}
+
+			entity_index(const entity_index& other) = default;
+			entity_index(entity_index&& other) = default;
+			entity_index& operator =(const entity_index& other) = default;
+			entity_index& operator =(entity_index&& other) = default;
+
+			// returns an id for an entity at the given location, reusing a released slot if there is one.
+			// the entity is alive right away, so a slot is never left generated but unassigned.
+			entity_id_t generate_at(Category* category, index_t index) {
+				index_t slot_index;
+				if (!m_free_slots.empty()) {
+					slot_index = m_free_slots.back();
+					m_free_slots.pop_back();
+				}
+				else {
+					rynx_assert(m_slots.size() + 1 <= ecs_slot_mask, "id space out of bounds");
+					slot_index = index_t(m_slots.size());
+					m_slots.emplace_back();
+				}
+
+				auto& s = m_slots[slot_index];
+				s.category = category;
+				s.index = index;
+				++m_num_alive;
+				return make_id(slot_index, s.generation);
+			}
+
+			// returns the first id of n consecutive id values.
+			entity_id_t generate_range(size_t n) {
+				rynx_assert(m_slots.size() + n <= ecs_slot_mask, "id space out of bounds");
+				entity_id_t first = make_id(index_t(m_slots.size()), 0);
+				m_slots.resize(m_slots.size() + n);
+				return first;
+			}
+
+			// first id that will be returned by generate_range.
+			entity_id_t peek_next_id() const {
+				return make_id(index_t(m_slots.size()), 0);
+			}
+
+			bool contains(entity_id_t id) const noexcept {
+				index_t slot_index = slot_of(id);
+				return (slot_index < m_slots.size()) && m_slots[slot_index].alive() && (m_slots[slot_index].generation == generation_of(id));
+			}
+
+			// returns nullptr if id does not refer to a live entity.
+			slot* find(entity_id_t id) noexcept {
+				return contains(id) ? &m_slots[slot_of(id)] : nullptr;
+			}
+
+			const slot* find(entity_id_t id) const noexcept {
+				return contains(id) ? &m_slots[slot_of(id)] : nullptr;
+			}
+
+			slot& operator[](entity_id_t id) noexcept {
+				rynx_assert(contains(id), "entity does not exist");
+				return m_slots[slot_of(id)];
+			}
+
+			const slot& operator[](entity_id_t id) const noexcept {
+				rynx_assert(contains(id), "entity does not exist");
+				return m_slots[slot_of(id)];
+			}
+
+			// sets the location for a generated id. this makes the entity alive.
+			void assign(entity_id_t id, Category* category, index_t index) noexcept {
+				index_t slot_index = slot_of(id);
+				rynx_assert(slot_index < m_slots.size(), "id was not generated by this index");
+				rynx_assert(m_slots[slot_index].generation == generation_of(id), "assigning location to a stale id");
+				if (!m_slots[slot_index].alive())
+					++m_num_alive;
+				m_slots[slot_index].category = category;
+				m_slots[slot_index].index = index;
+			}
+
+			// sets locations for n consecutive ids returned by generate_range, to consecutive indices of category.
+			void assign_range(entity_id_t first, size_t n, Category* category, index_t first_index) noexcept {
+				index_t first_slot = slot_of(first);
+				rynx_assert(first_slot + n <= m_slots.size(), "ids were not generated by this index");
+				for (size_t i = 0; i < n; ++i) {
+					auto& s = m_slots[first_slot + i];
+					rynx_assert(!s.alive() && s.generation == 0, "assign_range is only for fresh ids");
+					s.category = category;
+					s.index = first_index + index_t(i);
+				}
+				m_num_alive += n;
+			}
+
+			void set_index(entity_id_t id, index_t index) noexcept {
+				(*this)[id].index = index;
+			}
+
+			// releases the slot of the id. all copies of the id become stale.
+			void erase(entity_id_t id) {
+				index_t slot_index = slot_of(id);
+				rynx_assert(contains(id), "erasing entity that does not exist");
+				auto& s = m_slots[slot_index];
+				s.category = nullptr;
+				--m_num_alive;
+
+				// when the generation counter runs out, the slot is retired and never reused.
+				if (s.generation < ecs_max_generation) {
+					++s.generation;
+					m_free_slots.emplace_back(slot_index);
+				}
+			}
+
+			template<typename F> void for_each(F&& op) const {
+				for (index_t i = 1; i < index_t(m_slots.size()); ++i) {
+					if (m_slots[i].alive()) {
+						op(make_id(i, m_slots[i].generation), m_slots[i]);
+					}
+				}
+			}
+
+			constexpr size_t size() const noexcept { return m_num_alive; }
+
+			void clear() {
+				m_slots.clear();
+				m_slots.emplace_back();
+				m_free_slots.clear();
+				m_num_alive = 0;
+			}
+
+		private:
+			std::vector<slot> m_slots;
+			std::vector<index_t> m_free_slots;
+			size_t m_num_alive = 0;
+		};
+	}
+}
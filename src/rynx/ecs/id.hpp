@@ -8,6 +8,9 @@ namespace rynx {
 	struct ecs_value_segregated_component_tag {};
 	struct ecs_no_serialize_tag {};
 	struct ecs_no_component_tag {};
+	struct ecs_track_changes_tag {}; // component tables of the type keep write versions, see query().changed_since<T>(version).
+	struct ecs_blocked_storage_tag {}; // component table of the type is stored in fixed size blocks. addresses of components stay valid when the table grows.
+	struct ecs_sparse_tag {}; // empty types only. stored as a bit per entity instead of in the category, so toggling never moves the entity. see ecs::set_tags.
 
 	using type_id_t = uint64_t;
 	using entity_id_t = uint64_t;
@@ -16,38 +19,22 @@ namespace rynx {
 	static constexpr uint32_t ecs_id_bits = 42; // 2^42 - 1 entity ids (zero not included).
 	static constexpr uint64_t ecs_max_id_mask = (uint64_t(1) << ecs_id_bits) - 1;
 
+	// entity id value is split to a slot index and the generation of that slot.
+	// slot index is a direct index to ecs entity index, generation tells apart entities that have reused the same slot.
+	static constexpr uint32_t ecs_slot_bits = 32;
+	static constexpr uint32_t ecs_generation_bits = ecs_id_bits - ecs_slot_bits;
+	static constexpr uint64_t ecs_slot_mask = (uint64_t(1) << ecs_slot_bits) - 1;
+	static constexpr uint32_t ecs_max_generation = (uint32_t(1) << ecs_generation_bits) - 1;
+
 	namespace ecs_internal {
-		// NOTE: Since we are using categories now, it really doesn't matter how far apart the entity ids are.
-		//       Reusing ids is thus very much not important, unless we get to the point of overflow.
-		//       But still it would be easier to "reset" entity_index between levels or something.
-		class entity_index {
-		public:
-			entity_id_t generateOne() {
-				rynx_assert(m_nextId + 1 <= ecs_max_id_mask, "id space out of bounds");
-				return ++m_nextId;
-			} // zero is never generated. we can use that as InvalidId.
-
-			entity_id_t peek_next_id() const {
-				return m_nextId + 1;
-			}
-
-			entity_index() = default;
-			entity_index(const entity_index& other) = default;
-			entity_index& operator =(const entity_index& other) = default;
-
-			void clear() {
-				m_nextId = 0; // reset id space.
-			}
-
-			static constexpr entity_id_t InvalidId = 0;
-		private:
-
-			// does not need to be atomic. creating new entities is not thread-safe anyway, only one thread is allowed to do so at a time.
-			entity_id_t m_nextId = 0;
-		};
+		static constexpr entity_id_t InvalidId = 0; // zero is never generated.
+
+		constexpr index_t slot_of(entity_id_t id) noexcept { return index_t(id & ecs_slot_mask); }
+		constexpr uint32_t generation_of(entity_id_t id) noexcept { return uint32_t((id & ecs_max_id_mask) >> ecs_slot_bits); }
+		constexpr entity_id_t make_id(index_t slot, uint32_t generation) noexcept { return (entity_id_t(generation) << ecs_slot_bits) | slot; }
 
 		struct id {
-			id() noexcept : value(entity_index::InvalidId) {}
+			id() noexcept : value(InvalidId) {}
 			id(entity_id_t v) noexcept : value(v) {}
 			bool operator == (const id& other) const noexcept { return value == other.value; }
 			bool operator == (entity_id_t other) const noexcept { return value == other; }
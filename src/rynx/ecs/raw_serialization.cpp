@@ -7,11 +7,11 @@ void rynx::ecs_detail::raw_serializer::serialize(rynx::reflection::reflections&
 	rynx::unordered_map<uint64_t, uint64_t> idToSerializedId;
 	rynx::unordered_map<uint64_t, uint64_t> serializedIdToId;
 	uint64_t next = 1;
-	for (auto&& id : host->m_idCategoryMap) {
-		idToSerializedId[id.first] = next;
-		serializedIdToId[next] = id.first;
+	host->m_entities.for_each([&](entity_id_t id, const auto&) {
+		idToSerializedId[id] = next;
+		serializedIdToId[next] = id;
 		++next;
-	}
+	});
 
 	if constexpr (false) {
 		// replace id fields with serialized id values.
@@ -24,7 +24,7 @@ void rynx::ecs_detail::raw_serializer::serialize(rynx::reflection::reflections&
 
 	// serialize everything as-is.
 	rynx::serialize(reflections, out); // include reflection of written data
-	rynx::serialize(host->m_idCategoryMap.size(), out);
+	rynx::serialize(host->m_entities.size(), out);
 
 	size_t numNonEmptyCategories = 0;
 	for (auto&& category : host->m_categories) {
@@ -32,6 +32,20 @@ void rynx::ecs_detail::raw_serializer::serialize(rynx::reflection::reflections&
 			++numNonEmptyCategories;
 	}
 	rynx::serialize(numNonEmptyCategories, out);
+
+	std::vector<rynx::string> sparse_tag_names;
+	std::vector<uint32_t> runtime_bits;
+	for (uint32_t bit = 0; bit < rynx::ecs_internal::max_sparse_tags; ++bit) {
+		type_id_t type_id = rynx::ecs_internal::sparse_tag_type(bit);
+		if (type_id == ~type_id_t(0)) {
+			break;
+		}
+		auto* typeReflection = reflections.find(type_id);
+		if (typeReflection && typeReflection->m_serialization_allowed) {
+			sparse_tag_names.emplace_back(typeReflection->m_type_name);
+			runtime_bits.emplace_back(bit);
+		}
+	}
 	// rynx::serialize(m_categories.size(), out);
 	for (auto&& category : host->m_categories) {
 		if (category.second->ids().empty())
@@ -79,6 +93,18 @@ void rynx::ecs_detail::raw_serializer::serialize(rynx::reflection::reflections&
 
 		// serialize category id vector
 		rynx::serialize(idListCopy, out);
+
+		// sparse tags are not part of the category. serialize them by name, bits are renumbered to the order of the names.
+		std::vector<rynx::ecs::sparse_tag_bits_t> sparse_tags(category.second->size(), 0);
+		for (size_t i = 0; i < sparse_tags.size(); ++i) {
+			auto runtime_tags = category.second->sparse_tags(index_t(i));
+			for (uint32_t k = 0; k < runtime_bits.size(); ++k) {
+				sparse_tags[i] |= ((runtime_tags >> runtime_bits[k]) & 1) << k;
+			}
+		}
+
+		rynx::serialize(sparse_tag_names, out);
+		rynx::serialize(sparse_tags, out);
 	}
 
 	if constexpr (false) {
@@ -97,17 +123,17 @@ rynx::entity_range_t rynx::ecs_detail::raw_serializer::deserialize(rynx::reflect
 	size_t numEntities;
 	size_t numCategories;
 
-	auto id_range_begin = host->m_entities.peek_next_id();
-
 	rynx::reflection::reflections format;
 	rynx::deserialize(format, in); // reflection of loaded data
 	rynx::deserialize(numEntities, in);
 	rynx::deserialize(numCategories, in);
 
 	// construct mapping from serialized ids to ecs ids.
+	// ids are generated as one consecutive range so that the returned entity range is valid.
+	auto id_range_begin = host->m_entities.generate_range(numEntities);
 	rynx::unordered_map<uint64_t, uint64_t> serializedIdToEcsId;
 	for (size_t i = 1; i <= numEntities; ++i) {
-		serializedIdToEcsId[i] = host->m_entities.generateOne();
+		serializedIdToEcsId[i] = id_range_begin + i - 1;
 	}
 
 	for (size_t i = 0; i < numCategories; ++i) {
@@ -122,10 +148,10 @@ rynx::entity_range_t rynx::ecs_detail::raw_serializer::deserialize(rynx::reflect
 
 		// if category already does not exist - create category.
 		if (host->m_categories.find(category_id) == host->m_categories.end()) {
-			auto res = host->m_categories.emplace(category_id, rynx::make_unique<rynx::ecs::entity_category>(category_id));
+			auto res = host->create_category(category_id);
 			category_id.forEachOne([&](uint64_t typeId) {
 				auto* typeReflection = reflections.find(typeId);
-				res.first->second->createNewTable(typeId, typeReflection->m_create_table_func());
+				res->second->createNewTable(typeId, typeReflection->m_create_table_func());
 			});
 		}
 		auto category_it = host->m_categories.find(category_id);
@@ -163,8 +189,29 @@ rynx::entity_range_t rynx::ecs_detail::raw_serializer::deserialize(rynx::reflect
 			id.value = serializedIdToEcsId.find(id.value)->second;
 		}
 
+		auto sparse_tag_names = rynx::deserialize<std::vector<rynx::string>>(in);
+		auto sparse_tags = rynx::deserialize<std::vector<rynx::ecs::sparse_tag_bits_t>>(in);
+		rynx_assert(sparse_tags.size() == categoryIds.size(), "sparse tags must be stored for each entity");
+
+		std::vector<uint32_t> runtime_bits;
+		for (auto&& name : sparse_tag_names) {
+			auto* typeReflection = reflections.find(name);
+			rynx_assert(typeReflection != nullptr, "deserializing unknown sparse tag %s", name.c_str());
+			runtime_bits.emplace_back(rynx::ecs_internal::sparse_tag_bit(typeReflection->m_type_index_value));
+		}
+
+		for (auto& tags : sparse_tags) {
+			rynx::ecs::sparse_tag_bits_t runtime_tags = 0;
+			for (uint32_t k = 0; k < runtime_bits.size(); ++k) {
+				runtime_tags |= ((tags >> k) & 1) << runtime_bits[k];
+			}
+			tags = runtime_tags;
+		}
+
 		auto idCount = category_it->second->m_ids.size();
 		category_it->second->m_ids.insert(category_it->second->m_ids.end(), categoryIds.begin(), categoryIds.end());
+		category_it->second->m_sparse_tags.insert(category_it->second->m_sparse_tags.end(), sparse_tags.begin(), sparse_tags.end());
+		category_it->second->cover_sparse_tag_versions();
 
 		// scene serialization does not allow touching the id links.
 		if constexpr (false) {
@@ -177,7 +224,7 @@ rynx::entity_range_t rynx::ecs_detail::raw_serializer::deserialize(rynx::reflect
 		}
 
 		for (auto& id : categoryIds) {
-			host->m_idCategoryMap[id.value] = { category_it->second.get(), index_t(idCount++) };
+			host->m_entities.assign(id.value, category_it->second.get(), index_t(idCount++));
 		}
 
 		// add missing segregation types.
@@ -193,6 +240,7 @@ rynx::entity_range_t rynx::ecs_detail::raw_serializer::deserialize(rynx::reflect
 				category_it->second->m_types = category_id;
 				auto res = host->m_categories.emplace(category_id, std::move(category_it->second));
 				host->m_categories.erase(prev_category_id);
+				host->invalidate_cached_queries();
 			}
 			else {
 				// TODO: Increase perf by migrating all entities from category at once.
@@ -202,10 +250,10 @@ rynx::entity_range_t rynx::ecs_detail::raw_serializer::deserialize(rynx::reflect
 						category_id,
 						category_it->second.get(),
 						0,
-						host->m_idCategoryMap
+						host->m_entities
 					);
 				}
-				host->m_categories.erase(category_it);
+				host->erase_category(category_it->first);
 			}
 		}
 	}
@@ -289,8 +289,8 @@ void rynx::ecs_detail::scene_serializer::serialize_scene(
 				}
 
 				// if matching entity is found, for each component check that they are the same
-				auto [actual_category_ptr, actual_category_index] = host->m_idCategoryMap.find(id)->second;
-				auto [expected_category_ptr, expected_category_index] = expected.m_idCategoryMap.find(matching_entity)->second;
+				auto [actual_category_ptr, actual_category_index] = host->category_and_index_for(id);
+				auto [expected_category_ptr, expected_category_index] = expected.category_and_index_for(matching_entity);
 
 				const auto& actual_types = actual_category_ptr->types();
 				const auto& expected_types = expected_category_ptr->types();
@@ -445,7 +445,7 @@ void rynx::ecs_detail::scene_serializer::serialize_scene(
 			// construct mapping from id references to global id chains (for the top-most scene?).
 			// replace id references with global id chain (for the top-most scene)
 			for (auto id : ids) {
-				auto [category_ptr, entity_index] = copy.m_idCategoryMap[id.value];
+				auto [category_ptr, entity_index] = copy.category_and_index_for(id.value);
 				category_ptr->forEachTable([&path_collection, &copy, id, entity_index](rynx::ecs_internal::itable* table_ptr) {
 					table_ptr->for_each_id_field_for_single_index(entity_index, [&path_collection, &copy, id](rynx::id& target) {
 						auto persistent_id_path = rynx::ecs_detail::scene_serializer{ &copy }.persistent_id_path_create(id, target);
@@ -574,7 +574,7 @@ std::tuple<rynx::entity_range_t, rynx::entity_range_t> rynx::ecs_detail::scene_s
 	//   look at corresponding chain in chains,
 	//     track the chain down the scenes and find the entity pointed to by the chain
 	for (auto id : entity_id_range) {
-		auto [category_ptr, category_index] = host->m_idCategoryMap.find(id)->second;
+		auto [category_ptr, category_index] = host->category_and_index_for(id);
 		category_ptr->forEachTable([this, entity_id_range, &path_collection, id, category_index](rynx::ecs_internal::itable* table_ptr) {
 			table_ptr->for_each_id_field_for_single_index(category_index, [this, entity_id_range, &path_collection, id](rynx::id& target) {
 				target = persistent_id_path_find(entity_id_range, id, path_collection[target.value]);
@@ -620,13 +620,14 @@ std::tuple<rynx::entity_range_t, rynx::entity_range_t> rynx::ecs_detail::scene_s
 				entity_id,
 				type_reflection->m_type_index_value,
 				type_reflection->m_is_type_segregated,
+				type_reflection->m_is_sparse_tag,
 				type_reflection->m_create_table_func,
 				type_reflection->m_create_map_func,
 				type_reflection->m_deserialize_instance_func(added_component.serialized_component)
 			);
 
 			if (!type_reflection->m_fields.empty()) {
-				auto [category_ptr, category_index] = host->m_idCategoryMap.find(entity_id)->second;
+				auto [category_ptr, category_index] = host->category_and_index_for(entity_id);
 				auto& itable = category_ptr->table(type_reflection->m_type_index_value);
 				itable.for_each_id_field_for_single_index(category_index, [this, &path_collection](rynx::id& target) {
 					target = persistent_id_path_find(path_collection[target.value]);
@@ -645,7 +646,7 @@ std::tuple<rynx::entity_range_t, rynx::entity_range_t> rynx::ecs_detail::scene_s
 				continue;
 			}
 			logmsg("apply subscene edit for '%s'", edited_component.component_name.c_str());
-			auto [category_ptr, category_index] = host->m_idCategoryMap.find(entity_id)->second;
+			auto [category_ptr, category_index] = host->category_and_index_for(entity_id);
 			auto& table = category_ptr->table(type_reflection->m_type_index_value);
 			rynx::serialization::vector_reader reader(edited_component.serialized_component);
 			table.deserialize_index(reader, category_index);
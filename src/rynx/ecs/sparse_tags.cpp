@@ -0,0 +1,44 @@
+#include <rynx/ecs/sparse_tags.hpp>
+#include <rynx/system/assert.hpp>
+
+#include <mutex>
+#include <array>
+
+namespace {
+	std::mutex g_sparse_tags_mutex;
+	std::array<rynx::type_id_t, rynx::ecs_internal::max_sparse_tags> g_sparse_tag_types;
+	uint32_t g_num_sparse_tags = 0;
+}
+
+namespace {
+	uint32_t find_bit_locked(rynx::type_id_t type_id) {
+		for (uint32_t bit = 0; bit < g_num_sparse_tags; ++bit) {
+			if (g_sparse_tag_types[bit] == type_id) {
+				return bit;
+			}
+		}
+		return rynx::ecs_internal::max_sparse_tags;
+	}
+}
+
+uint32_t rynx::ecs_internal::sparse_tag_bit(type_id_t type_id) {
+	std::scoped_lock lock(g_sparse_tags_mutex);
+	uint32_t bit = find_bit_locked(type_id);
+	if (bit != max_sparse_tags) {
+		return bit;
+	}
+
+	rynx_assert(g_num_sparse_tags < max_sparse_tags, "too many sparse tag types");
+	g_sparse_tag_types[g_num_sparse_tags] = type_id;
+	return g_num_sparse_tags++;
+}
+
+rynx::type_id_t rynx::ecs_internal::sparse_tag_type(uint32_t bit) {
+	std::scoped_lock lock(g_sparse_tags_mutex);
+	return bit < g_num_sparse_tags ? g_sparse_tag_types[bit] : ~type_id_t(0);
+}
+
+uint32_t rynx::ecs_internal::find_sparse_tag_bit(type_id_t type_id) {
+	std::scoped_lock lock(g_sparse_tags_mutex);
+	return find_bit_locked(type_id);
+}
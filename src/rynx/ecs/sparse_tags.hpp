@@ -0,0 +1,53 @@
+#pragma once
+
+#include <rynx/ecs/id.hpp>
+#include <rynx/std/type_index.hpp>
+#include <type_traits>
+#include <cstdint>
+
+namespace rynx {
+	namespace ecs_internal {
+
+		// sparse tags are not part of the category key. each category stores one word of sparse tag bits per entity,
+		// so attaching or removing a sparse tag is a single bit operation, and queries filter on the bits while iterating.
+		static constexpr uint32_t max_sparse_tags = 64;
+		using sparse_tag_bits_t = uint64_t;
+
+		template<typename T> static constexpr bool is_sparse_tag_v = std::is_base_of_v<rynx::ecs_sparse_tag, std::remove_cvref_t<T>>;
+
+		// bit of a sparse tag type. bits are handed out in order of first use, and are the same for every ecs instance.
+		EcsDLL uint32_t sparse_tag_bit(type_id_t type_id);
+
+		// type id of the sparse tag that has the given bit, or ~0 if the bit is not in use.
+		EcsDLL type_id_t sparse_tag_type(uint32_t bit);
+
+		// for type erased edits. returns max_sparse_tags if the type has not been used as a sparse tag yet.
+		EcsDLL uint32_t find_sparse_tag_bit(type_id_t type_id);
+
+		template<typename T> sparse_tag_bits_t sparse_tag_mask() {
+			static_assert(is_sparse_tag_v<T>, "type is not a sparse tag");
+			static_assert(std::is_empty_v<std::remove_cvref_t<T>>, "sparse tags can not hold data");
+			static const sparse_tag_bits_t mask = sparse_tag_bits_t(1) << sparse_tag_bit(rynx::type_index::id<T>());
+			return mask;
+		}
+
+		// mask of the sparse tags among Ts. other types are ignored.
+		template<typename... Ts> sparse_tag_bits_t sparse_tag_mask_of() {
+			sparse_tag_bits_t mask = 0;
+			([&mask]() {
+				if constexpr (is_sparse_tag_v<Ts>) {
+					mask |= sparse_tag_mask<Ts>();
+				}
+			}(), ...);
+			return mask;
+		}
+
+		struct sparse_tag_filter {
+			sparse_tag_bits_t include = 0;
+			sparse_tag_bits_t exclude = 0;
+
+			bool empty() const noexcept { return (include | exclude) == 0; }
+			bool accepts(sparse_tag_bits_t bits) const noexcept { return ((bits & include) == include) & ((bits & exclude) == 0); }
+		};
+	}
+}
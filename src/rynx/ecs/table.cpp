@@ -0,0 +1,21 @@
+#include <rynx/ecs/table.hpp>
+#include <atomic>
+
+namespace {
+	// starts from one, so that version zero is older than any write.
+	std::atomic<uint64_t> g_change_version = 1;
+}
+
+uint64_t rynx::ecs_internal::current_change_version() noexcept {
+	return g_change_version.load(std::memory_order_relaxed);
+}
+
+uint64_t rynx::ecs_internal::advance_change_version() noexcept {
+	return g_change_version.fetch_add(1, std::memory_order_relaxed);
+}
+
+rynx::tech::memory_block_pool& rynx::ecs_internal::component_block_pool() {
+	// never destroyed, tables of static ecs instances may release their blocks after static destruction has begun.
+	static rynx::tech::memory_block_pool* pool = new rynx::tech::memory_block_pool(component_block_size);
+	return *pool;
+}
@@ -3,15 +3,63 @@
 
 #include <rynx/std/serialization.hpp>
 #include <rynx/ecs/id.hpp>
+#include <rynx/ecs/blocked_table.hpp>
 #include <rynx/std/memory.hpp>
+#include <rynx/std/type_index.hpp>
+#include <rynx/std/unordered_map.hpp>
 #include <rynx/system/assert.hpp>
 #include <rynx/system/typeid.hpp>
 #include <vector>
 #include <numeric>
+#include <algorithm>
+#include <span>
+#include <new>
+#include <atomic>
 
 namespace rynx {
 	namespace ecs_internal {
 
+		// component storage is cache line aligned, so that chunked iteration can hand out aligned spans.
+		static constexpr size_t component_storage_alignment = 64;
+
+		template<typename T, size_t Alignment>
+		struct aligned_allocator {
+			using value_type = T;
+			template<typename U> struct rebind { using other = aligned_allocator<U, Alignment>; };
+
+			aligned_allocator() noexcept = default;
+			template<typename U> aligned_allocator(const aligned_allocator<U, Alignment>&) noexcept {}
+
+			T* allocate(size_t n) {
+				return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+			}
+
+			void deallocate(T* ptr, size_t) noexcept {
+				::operator delete(ptr, std::align_val_t(Alignment));
+			}
+
+			template<typename U> bool operator == (const aligned_allocator<U, Alignment>&) const noexcept { return true; }
+			template<typename U> bool operator != (const aligned_allocator<U, Alignment>&) const noexcept { return false; }
+		};
+
+		// storage of component tables that are not blocked. tables adopt the buffers of these vectors without copying.
+		template<typename T> using component_vector = std::vector<T, aligned_allocator<T, component_storage_alignment>>;
+
+		// component tables of types tagged with ecs_track_changes_tag stamp the current change version
+		// to each chunk of change_chunk_size entities that is written to.
+		static constexpr index_t change_chunk_bits = 8;
+		static constexpr index_t change_chunk_size = index_t(1) << change_chunk_bits;
+
+		// version stamped to written chunks.
+		EcsDLL uint64_t current_change_version() noexcept;
+
+		// returns the current version and moves on to the next one. writes after the call are newer than the returned version.
+		EcsDLL uint64_t advance_change_version() noexcept;
+
+		// tables of types tagged with ecs_blocked_storage_tag take their blocks from this pool.
+		static constexpr size_t component_block_size = 16 * 1024;
+		EcsDLL rynx::tech::memory_block_pool& component_block_pool();
+
 		struct ivalue_segregation_map;
 
 
@@ -43,27 +91,43 @@ namespace rynx {
 			virtual void for_each_id_field_from_index(size_t startingIndex, rynx::function<void(rynx::id&)>) = 0;
 
 			virtual void swap_adjacent_indices_for(const std::vector<index_t>& index_points) = 0;
-			virtual void swap_to_given_order(const std::vector<index_t>& relative_sort_order) = 0;
+			virtual void apply_order(const std::vector<index_t>& order) = 0; // element at index i is moved from order[i].
 
 			virtual void replace_with_back_and_pop(index_t i) = 0;
 
 			virtual void* get(index_t) = 0;
 			virtual const void* get(index_t) const = 0;
+
+			// change tracking. tables of untracked types report every chunk as changed.
+			virtual void mark_changed(index_t index) = 0;
+			virtual bool changed_since(index_t chunk, uint64_t version) const = 0;
+
+			// copying from a table of the same type, for keeping a mirror of an ecs up to date. copied chunks are stamped as changed.
+			// assign_changed_from copies only the chunks that other has written to after version, unless the sizes differ.
+			virtual void assign_from(const itable& other) = 0;
+			virtual void assign_changed_from(const itable& other, uint64_t version) = 0;
+
 			virtual rynx::string type_name() const = 0;
 			virtual bool is_type_segregated() const = 0;
 			
 			virtual void copyTableTypeTo(type_id_t typeId, std::vector<rynx::unique_ptr<itable>>& targetTables) = 0;
 			virtual void moveFromIndexTo(index_t index, itable* dst) = 0;
 
+			// bulk versions of moveFromIndexTo and replace_with_back_and_pop. indices must be in descending order,
+			// so that the entries moved from the back to fill the gaps are never ones that are still to be processed.
+			virtual void move_indices_to(const std::vector<index_t>& indices, itable* dst) = 0;
+			virtual void erase_indices(const std::vector<index_t>& indices) = 0;
+
 			uint64_t m_type_id;
 		};
 
 		template<typename T>
 		class component_table : public itable {
 		public:
-			component_table(uint64_t type_id) : itable(type_id) {}
-			component_table(const component_table& other) : itable(other.m_type_id) {
+			component_table(uint64_t type_id) : itable(type_id), m_data(make_storage()) {}
+			component_table(const component_table& other) : itable(other.m_type_id), m_data(make_storage()) {
 				m_data = other.m_data; // to support cloning.
+				m_chunk_versions = other.m_chunk_versions;
 			}
 
 			virtual ~component_table() {}
@@ -74,6 +138,7 @@ namespace rynx {
 
 			virtual void insert(opaque_unique_ptr<void> data) override {
 				m_data.emplace_back(std::move(*static_cast<T*>(data.get())));
+				mark_appended(m_data.size() - 1);
 			}
 
 			// used for serializing diffs only.
@@ -84,29 +149,19 @@ namespace rynx {
 			virtual void swap_adjacent_indices_for(const std::vector<index_t>& index_points) override {
 				for (auto index : index_points) {
 					std::swap(m_data[index], m_data[index + 1]);
+					mark_changed(index, index + 2);
 				}
 			}
 
-			virtual void swap_to_given_order(const std::vector<index_t>& relative_sort_order) override {
-				// TODO: No need to alloc these separately for each table. Reuse buffers and memcpy contents.
-				std::vector<index_t> current_index_to_original_index(m_data.size());
-				std::vector<index_t> original_index_to_current_index(m_data.size());
-
-				std::iota(current_index_to_original_index.begin(), current_index_to_original_index.end(), 0);
-				std::iota(original_index_to_current_index.begin(), original_index_to_current_index.end(), 0);
-
-				for (index_t i = 0, size = index_t(m_data.size()); i < size; ++i) {
-					index_t mapped_location = original_index_to_current_index[relative_sort_order[i]];
-					if (mapped_location != i) {
-						std::swap(m_data[i], m_data[mapped_location]);
-
-						std::swap(current_index_to_original_index[i], current_index_to_original_index[mapped_location]);
-						std::swap(
-							original_index_to_current_index[current_index_to_original_index[i]],
-							original_index_to_current_index[current_index_to_original_index[mapped_location]]
-						);
-					}
+			virtual void apply_order(const std::vector<index_t>& order) override {
+				rynx_assert(order.size() == m_data.size(), "order must contain each index exactly once");
+				storage_t ordered = make_storage();
+				ordered.reserve(m_data.size());
+				for (index_t source : order) {
+					ordered.emplace_back(std::move(m_data[source]));
 				}
+				m_data = std::move(ordered);
+				mark_changed(0, index_t(m_data.size()));
 			}
 
 
@@ -115,12 +170,31 @@ namespace rynx {
 			}
 
 			virtual void serialize(rynx::serialization::vector_writer& writer) override {
-				if constexpr (!std::is_base_of_v<ecs_no_serialize_tag, T>)
-					rynx::serialize(m_data, writer);
+				if constexpr (!std::is_base_of_v<ecs_no_serialize_tag, T>) {
+					if constexpr (uses_blocked_storage) {
+						// same format as contiguous tables.
+						std::vector<value_type> contiguous;
+						contiguous.reserve(m_data.size());
+						for (size_t i = 0; i < m_data.size(); ++i) {
+							contiguous.emplace_back(m_data[i]);
+						}
+						rynx::serialize(contiguous, writer);
+					}
+					else {
+						rynx::serialize(m_data, writer);
+					}
+				}
 			}
 
 			virtual void deserialize(rynx::serialization::vector_reader& reader) override {
-				rynx::deserialize(m_data, reader);
+				if constexpr (uses_blocked_storage) {
+					m_data.clear();
+					append(rynx::deserialize<std::vector<value_type>>(reader));
+				}
+				else {
+					rynx::deserialize(m_data, reader);
+				}
+				mark_changed(0, index_t(m_data.size()));
 			}
 
 			virtual void serialize_index(rynx::serialization::vector_writer & writer, index_t entity_index) override
@@ -132,17 +206,20 @@ namespace rynx {
 			virtual void deserialize_index(rynx::serialization::vector_reader& reader, index_t entity_index) override
 			{
 				rynx::deserialize(m_data[entity_index], reader);
+				mark_changed(entity_index);
 			}
 
 			// TODO: skip iterating over data if no types in hierarchy have id members.
 			virtual void for_each_id_field(rynx::function<void(rynx::id&)> op) override {
-				for (auto& entry : m_data) {
-					rynx::for_each_id_field(entry, op);
+				for (size_t i = 0; i < m_data.size(); ++i) {
+					rynx::for_each_id_field(m_data[i], op);
 				}
+				mark_changed(0, index_t(m_data.size()));
 			}
 
 			virtual void for_each_id_field_for_single_index(index_t index, rynx::function<void(rynx::id&)> op) override {
 				rynx::for_each_id_field(m_data[index], op);
+				mark_changed(index);
 			}
 
 			// TODO: skip iterating over data if no types in hierarchy have id members.
@@ -150,15 +227,76 @@ namespace rynx {
 				for (size_t i = startingIndex; i < m_data.size(); ++i) {
 					rynx::for_each_id_field(m_data[i], op);
 				}
+				mark_changed(index_t(startingIndex), index_t(m_data.size()));
 			}
 
 			virtual void replace_with_back_and_pop(index_t i) override {
 				m_data[i] = std::move(m_data.back());
 				m_data.pop_back();
+				mark_replaced(i);
 			}
 
-			virtual void* get(index_t i) override { return &m_data[i]; }
+			// non-const access is for the editor, which writes through the returned pointer.
+			virtual void* get(index_t i) override { mark_changed(i); return &m_data[i]; }
 			virtual const void* get(index_t i) const override { return &m_data[i]; }
+
+			virtual void mark_changed(index_t index) override {
+				if constexpr (tracks_changes) {
+					rynx_assert((index >> change_chunk_bits) < m_chunk_versions.size(), "chunk versions must cover the whole table");
+					std::atomic_ref<uint64_t>(m_chunk_versions[index >> change_chunk_bits]).store(current_change_version(), std::memory_order_relaxed);
+				}
+			}
+
+			// stamps all chunks overlapping [begin, end).
+			void mark_changed(index_t begin, index_t end) {
+				if constexpr (tracks_changes) {
+					if (begin >= end) {
+						return;
+					}
+					const size_t last_chunk = (end - 1) >> change_chunk_bits;
+					if (last_chunk >= m_chunk_versions.size()) {
+						m_chunk_versions.resize(last_chunk + 1, 0);
+					}
+					const uint64_t version = current_change_version();
+					for (size_t chunk = begin >> change_chunk_bits; chunk <= last_chunk; ++chunk) {
+						m_chunk_versions[chunk] = version;
+					}
+				}
+			}
+
+			virtual bool changed_since([[maybe_unused]] index_t chunk, [[maybe_unused]] uint64_t version) const override {
+				if constexpr (tracks_changes) {
+					return (chunk >= m_chunk_versions.size()) || (m_chunk_versions[chunk] > version);
+				}
+				else {
+					return true;
+				}
+			}
+			
+			virtual void assign_from(const itable& other) override {
+				m_data = static_cast<const component_table&>(other).m_data;
+				mark_changed(0, index_t(m_data.size()));
+			}
+
+			virtual void assign_changed_from(const itable& other, uint64_t version) override {
+				const auto& source = static_cast<const component_table&>(other);
+				if constexpr (tracks_changes) {
+					if (source.m_data.size() == m_data.size()) {
+						const index_t size = index_t(m_data.size());
+						for (index_t begin = 0; begin < size; begin += change_chunk_size) {
+							if (source.changed_since(begin >> change_chunk_bits, version)) {
+								const index_t end = std::min(size, begin + change_chunk_size);
+								for (index_t i = begin; i < end; ++i) {
+									m_data[i] = source.m_data[i];
+								}
+								mark_changed(begin, end);
+							}
+						}
+						return;
+					}
+				}
+				assign_from(other);
+			}
 			
 			virtual rynx::string type_name() const override {
 				return rynx::traits::template type_name<T>();
@@ -170,6 +308,7 @@ namespace rynx {
 			virtual void erase(entity_id_t id) override {
 				m_data[id] = std::move(m_data.back());
 				m_data.pop_back();
+				mark_replaced(index_t(id));
 			}
 
 			// NOTE: This is required for moving entities between categories reliably.
@@ -184,37 +323,147 @@ namespace rynx {
 				static_cast<component_table*>(dst)->emplace_back(std::move(m_data[index]));
 				m_data[index] = std::move(m_data.back());
 				m_data.pop_back();
+				mark_replaced(index);
 			}
 
-			void insert(T&& t) { m_data.emplace_back(std::forward<T>(t)); }
-			void insert(std::vector<T>&& v) {
-				if (m_data.empty()) {
-					m_data = std::move(v);
+			virtual void move_indices_to(const std::vector<index_t>& indices, itable* dst) override {
+				auto& dst_table = *static_cast<component_table*>(dst);
+				const size_t dst_old_size = dst_table.m_data.size();
+				dst_table.m_data.reserve(dst_old_size + indices.size());
+				for (index_t index : indices) {
+					dst_table.m_data.emplace_back(std::move(m_data[index]));
+					m_data[index] = std::move(m_data.back());
+					m_data.pop_back();
 				}
-				else {
-					m_data.insert(m_data.end(), v.begin(), v.end());
+				dst_table.mark_appended(dst_old_size);
+				mark_gaps_filled(indices);
+			}
+
+			virtual void erase_indices(const std::vector<index_t>& indices) override {
+				for (index_t index : indices) {
+					m_data[index] = std::move(m_data.back());
+					m_data.pop_back();
 				}
+				mark_gaps_filled(indices);
+			}
+
+			void insert(T&& t) {
+				m_data.emplace_back(std::forward<T>(t));
+				mark_appended(m_data.size() - 1);
+			}
+			
+			// an empty table takes over the buffer of a component_vector. other vectors are moved in entry by entry.
+			template<typename Allocator> void insert(std::vector<T, Allocator>&& v) {
+				size_t old_size = m_data.size();
+				if constexpr (std::is_same_v<std::vector<T, Allocator>, storage_t>) {
+					if (m_data.empty()) {
+						m_data = std::move(v);
+						mark_appended(old_size);
+						return;
+					}
+				}
+				append(std::move(v));
+				mark_appended(old_size);
+			}
+			
+			template<typename...Ts> void emplace_back(Ts&& ... ts) {
+				m_data.emplace_back(std::forward<Ts>(ts)...);
+				mark_appended(m_data.size() - 1);
 			}
-			template<typename...Ts> void emplace_back(Ts&& ... ts) { m_data.emplace_back(std::forward<Ts>(ts)...); }
 
 			void insert_default(size_t n) {
+				size_t old_size = m_data.size();
 				m_data.resize(m_data.size() + n);
+				mark_appended(old_size);
 			}
 
+			void insert(std::span<const T> values) {
+				size_t old_size = m_data.size();
+				if constexpr (uses_blocked_storage) {
+					for (const auto& value : values) {
+						m_data.emplace_back(value);
+					}
+				}
+				else {
+					m_data.insert(m_data.end(), values.begin(), values.end());
+				}
+				mark_appended(old_size);
+			}
+
+			void reserve(size_t capacity) { m_data.reserve(capacity); }
+
 			T& back() { return m_data.back(); }
 			const T& back() const { return m_data.back(); }
 			void pop_back() { m_data.pop_back(); }
 
-			T* data() { return m_data.data(); }
-			const T* data() const { return m_data.data(); }
+			T* data() { static_assert(!uses_blocked_storage, "blocked tables are not contiguous, use data_at"); return m_data.data(); }
+			const T* data() const { static_assert(!uses_blocked_storage, "blocked tables are not contiguous, use data_at"); return m_data.data(); }
+
+			// elements [index, contiguous_end(index, end)) can be accessed through data_at(index).
+			T* data_at(index_t index) { return &m_data[index]; }
+			const T* data_at(index_t index) const { return &m_data[index]; }
+			index_t contiguous_end([[maybe_unused]] index_t index, index_t end) const {
+				if constexpr (uses_blocked_storage) {
+					return index_t(m_data.contiguous_end(index, end));
+				}
+				else {
+					return end;
+				}
+			}
 
 			size_t size() const { return m_data.size(); }
 
 			T& operator[](index_t index) { return m_data[index]; }
 			const T& operator[](index_t index) const { return m_data[index]; }
 
+			static constexpr bool uses_blocked_storage = std::is_base_of_v<rynx::ecs_blocked_storage_tag, T>;
+
 		private:
-			std::vector<std::remove_reference_t<T>> m_data;
+			static constexpr bool tracks_changes = std::is_base_of_v<rynx::ecs_track_changes_tag, T>;
+			using value_type = std::remove_reference_t<T>;
+			using storage_t = std::conditional_t<uses_blocked_storage,
+				blocked_table<value_type>,
+				component_vector<value_type>>;
+
+			static storage_t make_storage() {
+				if constexpr (uses_blocked_storage) {
+					return storage_t(&component_block_pool());
+				}
+				else {
+					return storage_t();
+				}
+			}
+
+			template<typename Allocator> void append(std::vector<T, Allocator>&& v) {
+				if constexpr (uses_blocked_storage) {
+					m_data.reserve(m_data.size() + v.size());
+					for (auto& entry : v) {
+						m_data.emplace_back(std::move(entry));
+					}
+				}
+				else {
+					m_data.insert(m_data.end(), std::make_move_iterator(v.begin()), std::make_move_iterator(v.end()));
+				}
+			}
+
+			void mark_appended(size_t old_size) { mark_changed(index_t(old_size), index_t(m_data.size())); }
+			
+			// back entry was moved to index i.
+			void mark_replaced(index_t i) {
+				if (i < m_data.size()) {
+					mark_changed(i);
+				}
+			}
+
+			// entries were moved from the back to the given indices, smallest index is the last one.
+			void mark_gaps_filled(const std::vector<index_t>& indices) {
+				if (!indices.empty()) {
+					mark_changed(indices.back(), index_t(m_data.size()));
+				}
+			}
+
+			storage_t m_data;
+			std::vector<uint64_t> m_chunk_versions; // only used when tracks_changes.
 		};
 
 		// used for value hashes in value segregated component types.
@@ -1322,6 +1322,7 @@ rynx::editor_rules::editor_rules(
 											selected_entity,
 											type_reflection.m_type_index_value,
 											type_reflection.m_is_type_segregated,
+											type_reflection.m_is_sparse_tag,
 											type_reflection.m_create_table_func,
 											type_reflection.m_create_map_func,
 											std::move(component)
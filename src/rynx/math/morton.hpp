@@ -0,0 +1,34 @@
+#pragma once
+
+#include <rynx/math/vector.hpp>
+#include <cinttypes>
+#include <cmath>
+
+namespace rynx {
+	namespace math {
+		// spreads the bits of v to even bit positions.
+		inline constexpr uint64_t morton_spread_bits(uint32_t v) {
+			uint64_t x = v;
+			x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+			x = (x | (x << 8)) & 0x00FF00FF00FF00FFull;
+			x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0Full;
+			x = (x | (x << 2)) & 0x3333333333333333ull;
+			x = (x | (x << 1)) & 0x5555555555555555ull;
+			return x;
+		}
+
+		inline constexpr uint64_t morton_code_2d(uint32_t x, uint32_t y) {
+			return morton_spread_bits(x) | (morton_spread_bits(y) << 1);
+		}
+
+		// z-order key of the grid cell that contains pos. xy-plane only.
+		// positions near each other in the world get keys near each other, so sorting by the key clusters them in memory.
+		inline uint64_t morton_key_2d(rynx::vec3f pos, float cell_size) {
+			auto cell = [inv = 1.0f / cell_size](float v) {
+				// order preserving mapping from signed cell coordinates to unsigned.
+				return uint32_t(int32_t(std::floor(v * inv))) ^ 0x80000000u;
+			};
+			return morton_code_2d(cell(pos.x), cell(pos.y));
+		}
+	}
+}
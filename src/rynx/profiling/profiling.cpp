@@ -21,8 +21,8 @@ namespace rynx {
 					m_pid = 0;
 				}
 
-				rynx::string m_name;
-				rynx::string m_category;
+				char const* m_name = "";
+				char const* m_category = "";
 
 				double m_time_point = 0;
 				uint64_t m_thread_id = 0;
@@ -65,16 +65,16 @@ namespace rynx {
 		}
 
 		void push_event_begin(
-			rynx::string name,
-			rynx::string category,
+			char const* name,
+			char const* category,
 			uint64_t pid
 		) {
 			init_for_this_thread();
 			auto my_index = g_event_counter.fetch_add(1) % g_profiling_storage->size();
 			auto* my_event = &(*g_profiling_storage)[my_index];
 			my_event->m_thread_id = rynx::this_thread::id();
-			my_event->m_name = std::move(name);
-			my_event->m_category = std::move(category);
+			my_event->m_name = name;
+			my_event->m_category = category;
 			my_event->m_pid = pid;
 			my_event->m_time_point = current_time() - g_start_time;
 			my_event->m_type = 'B';
@@ -1,15 +1,16 @@
 
 #pragma once
 
-#include <rynx/std/string.hpp>
+#include <rynx/std/interned_string.hpp>
 
 namespace rynx {
 	namespace profiling {
 		constexpr bool enabled = true;
 
+		// events keep the name pointers, so names must live as long as the profile log. literals and interned strings do.
 		ProfilingDLL void push_event_begin(
-			rynx::string name,
-			rynx::string category,
+			char const* name,
+			char const* category,
 			uint64_t pid
 		);
 
@@ -20,10 +21,8 @@ namespace rynx {
 		ProfilingDLL void write_profile_log();
 
 		struct scope {
-			scope(rynx::string name, rynx::string category) {
-				// TODO: profiling should ensure that names are not dynamically allocated.
-				// rynx_assert(rynx::is_small_space(name), "profiling string requires dynamic alloc, please make it shorter; '%s'", name.c_str());
-				// rynx_assert(rynx::is_small_space(category), "profiling string requires dynamic alloc, please make it shorter; '%s'", category.c_str());
+			scope(rynx::interned_string name, char const* category) : scope(name.c_str(), category) {}
+			scope(char const* name, char const* category) {
 				if constexpr (enabled) {
 					push_event_begin(
 						name,
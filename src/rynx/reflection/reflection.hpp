@@ -69,6 +69,7 @@ namespace rynx {
 			std::vector<field> m_fields;
 			int32_t m_type_index_value = -1;
 			bool m_is_type_segregated = false;
+			bool m_is_sparse_tag = false;
 			bool m_serialization_allowed = true;
 			
 			std::vector<rynx::string> m_annotations;
@@ -191,6 +192,7 @@ namespace rynx {
 
 				// TODO: Ecs utils should be tightly knit somewhere under ecs. It is wrong for reflection to make these assumptions.
 				result.m_is_type_segregated = std::is_base_of_v<rynx::ecs_value_segregated_component_tag, std::remove_cvref_t<T>>;
+				result.m_is_sparse_tag = std::is_base_of_v<rynx::ecs_sparse_tag, std::remove_cvref_t<T>>;
 				result.m_create_table_func = rynx::make_ecs_table_create_func<T>(result.m_type_index_value);
 				result.m_create_instance_func = []() {
 					return opaque_unique_ptr<void>(new T(), [](void* t) { if (t) delete static_cast<T*>(t); });
@@ -2,6 +2,7 @@
 #include <rynx/rulesets/collisions.hpp>
 
 #include <rynx/application/components.hpp>
+#include <rynx/rulesets/physics/contacts.hpp>
 #include <rynx/tech/collision_detection.hpp>
 
 #include <rynx/scheduler/task.hpp>
@@ -11,22 +12,20 @@
 #include <rynx/tech/sphere_tree.hpp>
 #include <rynx/tech/parallel/accumulator.hpp>
 
+#include <algorithm>
+
 namespace {
 
-	rynx::components::transform::motion g_dummy_motion;
-
-	struct collision_event {
-		uint64_t a_id;
-		uint64_t b_id;
-		rynx::components::phys::body a_body;
-		rynx::components::phys::body b_body;
-		rynx::components::transform::motion* a_motion;
-		rynx::components::transform::motion* b_motion;
-		rynx::vec3<float> a_pos;
-		rynx::vec3<float> b_pos;
-		rynx::vec3<float> c_pos; // collision point in world space
-		rynx::vec3<float> normal;
-		float penetration;
+	using collision_event = rynx::ruleset::physics::collision_event;
+	using contact_extra_info = rynx::ruleset::physics::contact_extra_info;
+	using contact_state = rynx::ruleset::physics::contact_state;
+
+	// contacts of one frame, in the same order regardless of which threads found them.
+	struct contact_set {
+		std::vector<collision_event> events;
+		std::vector<contact_extra_info> extras;
+		std::vector<contact_state> states;
+		rynx::contact_partition partition;
 	};
 
 	using ecs_view = rynx::ecs::view<
@@ -45,7 +44,8 @@ namespace {
 		rynx::vec3<float> collisionPoint,
 		rynx::vec3<float> pos_a,
 		rynx::vec3<float> pos_b,
-		float penetration
+		float penetration,
+		uint32_t feature = 0
 	) {
 		// rynx_assert(normal.length_squared() > 0.9f, "normal must be unit length");
 		// rynx_assert(normal.length_squared() < 1.1f, "normal must be unit length");
@@ -69,7 +69,9 @@ namespace {
 		event.b_pos = pos_b;
 		event.c_pos = collisionPoint;
 		event.penetration = penetration;
+		event.feature = feature;
 
+		rynx::ruleset::physics::orient_by_id(event);
 		storage.emplace_back(event);
 	}
 
@@ -252,6 +254,10 @@ namespace {
 		for (int i = 0; i < 2; ++i) {
 			float depth = normal.dot(clip2[i]) - refOffset;
 			if (depth <= 0.0f) { // Penetrating
+				// reference edge, incident edge and clip point identify the contact between frames. the top bit tells which
+				// body has the reference edge by id, not by argument order, so the feature does not change when the pair is swapped.
+				const bool reference_on_larger_id = flip == (poly1.id() < poly2.id());
+				const uint32_t feature = (uint32_t(reference_on_larger_id) << 31) | (uint32_t(refIndex & 0x7fff) << 16) | (uint32_t(incIndex & 0x7fff) << 1) | uint32_t(i);
 				create_collision_event(
 					collisions_accumulator,
 					poly1,
@@ -260,7 +266,8 @@ namespace {
 					clip2[i],
 					pos_a,
 					pos_b,
-					-depth
+					-depth,
+					feature
 				);
 			}
 		}
@@ -328,18 +335,34 @@ namespace {
 					intersectionTest.point(),
 					bulletPos.value,
 					polyPos,
-					0 // NOTE: penetration values don't really mean anything in projectile case.
+					0, // NOTE: penetration values don't really mean anything in projectile case.
+					partIndex
 				);
 			}
 		}
 	}
 
 
+	// the broadphase reports a pair in either order. the narrow phase always gets the entity with the smaller id first,
+	// so that the contacts it finds, such as the reference edge of two polygons, do not depend on the report order.
+	rynx::collision_detection::collision_params oriented_by_id(rynx::collision_detection::collision_params params) {
+		if (params.id1 > params.id2) {
+			std::swap(params.id1, params.id2);
+			std::swap(params.kind1, params.kind2);
+			std::swap(params.part1, params.part2);
+			std::swap(params.radius1, params.radius2);
+			std::swap(params.pos1, params.pos2);
+			params.normal = -params.normal;
+		}
+		return params;
+	}
+
 	void check_all(
 		std::vector<collision_event>& collisions_accumulator,
 		ecs_view ecs,
-		const rynx::collision_detection::collision_params& params)
+		const rynx::collision_detection::collision_params& reported_params)
 	{
+		const auto params = oriented_by_id(reported_params);
 		auto entityA = params.id1;
 		auto entityB = params.id2;
 		
@@ -419,6 +442,7 @@ namespace {
 void rynx::ruleset::physics_2d::clear(rynx::scheduler::context& ctx) {
 	auto& detection = ctx.get_resource<rynx::collision_detection>();
 	detection.clear();
+	m_contact_cache->clear();
 }
 
 void rynx::ruleset::physics_2d::onFrameProcess(rynx::scheduler::context& context, float dt) {
@@ -486,186 +510,99 @@ void rynx::ruleset::physics_2d::onFrameProcess(rynx::scheduler::context& context
 	findCollisionsTask.depends_on(collisions_find_barrier);
 	findCollisionsTask.depends_on(updateBoundaryWorld);
 
-	auto collision_resolution_first_stage = [dt = dt, collisions_accumulator](
+	auto collision_resolution_first_stage = [dt = dt, collisions_accumulator, cache = m_contact_cache, settings = m_solver_settings](
 		rynx::ecs::view<components::transform::motion, rynx::components::phys::collision_events> ecs,
 		rynx::scheduler::task& task)
 	{
-		struct event_extra_info {
-			vec3<float> relative_position_tangent_a;
-			float relative_position_length_a;
-			vec3<float> relative_position_tangent_b;
-			float relative_position_length_b;
-		};
-
-		auto overlaps_vector = rynx::make_shared<std::vector<rynx::shared_ptr<std::vector<collision_event>>>>();
-		auto extra_infos = rynx::make_shared<std::vector<rynx::shared_ptr<std::vector<event_extra_info>>>>();
-
-		collisions_accumulator->for_each([&overlaps_vector](std::vector<collision_event>& overlaps) mutable {
-			overlaps_vector->emplace_back(rynx::make_shared<std::vector<collision_event>>(std::move(overlaps)));
+		auto contacts = rynx::make_shared<contact_set>();
+		collisions_accumulator->for_each([&contacts](std::vector<collision_event>& overlaps) mutable {
+			contacts->events.insert(contacts->events.end(), overlaps.begin(), overlaps.end());
+			overlaps.clear();
 		});
-		extra_infos->resize(overlaps_vector->size());
-		
-		for (size_t i = 0; i < overlaps_vector->size(); ++i) {
-			extra_infos->operator[](i) = rynx::make_shared<std::vector<event_extra_info>>();
-			extra_infos->operator[](i)->resize(overlaps_vector->operator[](i)->size());
+
+		{
+			// the accumulator order depends on which threads found the collisions. the solver result depends on the
+			// order of the contacts, so sort them to get the same result on every run. contacts are oriented by id already.
+			rynx_profile("collisions", "sort contacts");
+			std::sort(contacts->events.begin(), contacts->events.end(), [](const collision_event& a, const collision_event& b) {
+				if (a.a_id != b.a_id) return a.a_id < b.a_id;
+				if (a.b_id != b.b_id) return a.b_id < b.b_id;
+				if (a.feature != b.feature) return a.feature < b.feature;
+				if (a.c_pos.x != b.c_pos.x) return a.c_pos.x < b.c_pos.x;
+				if (a.c_pos.y != b.c_pos.y) return a.c_pos.y < b.c_pos.y;
+				return a.penetration < b.penetration;
+			});
 		}
+		contacts->extras.resize(contacts->events.size());
+		contacts->states.resize(contacts->events.size());
 
-		g_dummy_motion = rynx::components::transform::motion{};
-		std::vector<rynx::scheduler::barrier> barriers;
+		rynx::scheduler::barrier fetched;
 		{
 			rynx_profile("collisions", "fetch motion components");
+			auto parallel_ops = task.parallel();
+			parallel_ops.range_auto(0, contacts->events.size()).execute([contacts, ecs, cache = cache.get(), warm_start = settings.warm_start](int64_t index) mutable {
+				auto& collision = contacts->events[index];
+				collision.a_motion = ecs[collision.a_id].try_get<components::transform::motion>();
+				collision.b_motion = ecs[collision.b_id].try_get<components::transform::motion>();
+				cache->fetch(collision, contacts->extras[index], contacts->states[index], warm_start);
+			});
+			fetched = parallel_ops.barrier();
+		}
+
+		auto collisions_resolve_task = task.extend_task_execute_parallel("collision resolve", [ecs, contacts, cache, settings, dt](rynx::scheduler::task& task) mutable {
 			{
-				auto parallel_ops = task.parallel();
-				for (size_t i = 0; i < overlaps_vector->size(); ++i) {
-					auto overlaps = overlaps_vector->operator[](i);
-					auto extras = extra_infos->operator[](i);
-
-					parallel_ops.range(0, overlaps->size(), 64).execute([overlaps, extras, ecs](int64_t index) mutable {
-						auto& collision = overlaps->operator[](index);
-						collision.a_motion = ecs[collision.a_id].try_get<components::transform::motion>();
-						collision.b_motion = ecs[collision.b_id].try_get<components::transform::motion>();
-
-						if (collision.a_motion == nullptr) {
-							collision.a_motion = &g_dummy_motion;
-						}
-
-						if (collision.b_motion == nullptr) {
-							collision.b_motion = &g_dummy_motion;
-						}
-
-						auto& extra = extras->operator[](index);
-						const vec3<float> rel_pos_a = collision.c_pos - collision.a_pos;
-						const vec3<float> rel_pos_b = collision.c_pos - collision.b_pos;
-
-						const float rel_pos_len_a = rel_pos_a.length();
-						const float rel_pos_len_b = rel_pos_b.length();
-						extra.relative_position_length_a = rel_pos_len_a;
-						extra.relative_position_length_b = rel_pos_len_b;
-						extra.relative_position_tangent_a = rel_pos_a.normal2d() / (rel_pos_len_a + std::numeric_limits<float>::epsilon());
-						extra.relative_position_tangent_b = rel_pos_b.normal2d() / (rel_pos_len_b + std::numeric_limits<float>::epsilon());
-
-						if (auto* storage = ecs[collision.a_id].try_get<rynx::components::phys::collision_events>()) {
-							rynx::components::phys::collision_events::event e;
-							e.body = collision.b_body;
-							e.id = collision.b_id;
-							e.normal = collision.normal;
-
-							auto velocity_at_point = [](float rel_pos_len, vec3<float> rel_pos_tangent, const components::transform::motion& m) {
-								return m.velocity + rel_pos_len * (m.angularVelocity) * rel_pos_tangent;
-							};
-
-							const vec3<float> rel_v_a = velocity_at_point(extra.relative_position_length_a, extra.relative_position_tangent_a, *collision.a_motion);
-							const vec3<float> rel_v_b = velocity_at_point(extra.relative_position_length_b, extra.relative_position_tangent_b, *collision.b_motion);
-							const vec3<float> total_rel_v = rel_v_a - rel_v_b;
-							e.relative_velocity = total_rel_v;
-							storage->events.emplace_back(e);
-						}
-
-						if (auto* storage = ecs[collision.b_id].try_get<rynx::components::phys::collision_events>()) {
-							rynx::components::phys::collision_events::event e;
-							e.body = collision.a_body;
-							e.id = collision.a_id;
-							e.normal = -collision.normal;
-
-							auto velocity_at_point = [](float rel_pos_len, vec3<float> rel_pos_tangent, const components::transform::motion& m) {
-								return m.velocity + rel_pos_len * (m.angularVelocity) * rel_pos_tangent;
-							};
-
-							const vec3<float> rel_v_a = velocity_at_point(extra.relative_position_length_a, extra.relative_position_tangent_a, *collision.a_motion);
-							const vec3<float> rel_v_b = velocity_at_point(extra.relative_position_length_b, extra.relative_position_tangent_b, *collision.b_motion);
-							const vec3<float> total_rel_v = rel_v_a - rel_v_b;
-							e.relative_velocity = -total_rel_v;
-							storage->events.emplace_back(e);
-						}
-					});
+				// several contacts may add events to the same entity, so this is done on one thread.
+				rynx_profile("collisions", "collision events");
+				auto velocity_at_point = [](float rel_pos_len, vec3<float> rel_pos_tangent, const components::transform::motion* m) {
+					return m ? m->velocity + rel_pos_len * (m->angularVelocity) * rel_pos_tangent : vec3<float>();
+				};
+
+				for (size_t i = 0; i < contacts->events.size(); ++i) {
+					const auto& collision = contacts->events[i];
+					const auto& extra = contacts->extras[i];
+					auto* storage_a = ecs[collision.a_id].try_get<rynx::components::phys::collision_events>();
+					auto* storage_b = ecs[collision.b_id].try_get<rynx::components::phys::collision_events>();
+					if (!storage_a && !storage_b)
+						continue;
+
+					const vec3<float> rel_v_a = velocity_at_point(extra.relative_position_length_a, extra.relative_position_tangent_a, collision.a_motion);
+					const vec3<float> rel_v_b = velocity_at_point(extra.relative_position_length_b, extra.relative_position_tangent_b, collision.b_motion);
+					const vec3<float> total_rel_v = rel_v_a - rel_v_b;
+
+					if (storage_a) {
+						rynx::components::phys::collision_events::event e;
+						e.body = collision.b_body;
+						e.id = collision.b_id;
+						e.normal = collision.normal;
+						e.relative_velocity = total_rel_v;
+						storage_a->events.emplace_back(e);
+					}
+
+					if (storage_b) {
+						rynx::components::phys::collision_events::event e;
+						e.body = collision.a_body;
+						e.id = collision.a_id;
+						e.normal = -collision.normal;
+						e.relative_velocity = -total_rel_v;
+						storage_b->events.emplace_back(e);
+					}
 				}
-				barriers.emplace_back(parallel_ops.barrier());
 			}
-		}
 
-		auto collisions_resolve_task = task.extend_task_execute_parallel("collision resolve", [ecs, overlaps_vector, extra_infos, dt](rynx::scheduler::task& task) {
-			// NOTE TODO: The task is not thread-safe. We are now resolving all collision events in parallel, which means
-			//            that we are resolving multiple collisions for the same entity in parallel, which will yield incorrect results.
-			//            however, in practice this issue doesn't appear to be great. Might be that the iterative nature of approaching
-			//            some global correct solution mitigates the damage the error cases cause.
-			rynx_profile("collisions", "resolve 10x");
-			for (int i = 0; i < 10; ++i)
-				for (size_t k = 0; k < overlaps_vector->size(); ++k) {
-					auto& overlaps = overlaps_vector->operator[](k);
-					auto& extras = extra_infos->operator[](k);
-					task.parallel().range(0, overlaps->size(), 2048).deferred_work().execute([overlaps, extras, ecs, dt](int64_t index) mutable {
-						const auto& collision = overlaps->operator[](index);
-						components::transform::motion& motion_a = *collision.a_motion;
-						components::transform::motion& motion_b = *collision.b_motion;
-
-						auto velocity_at_point = [](float rel_pos_len, vec3<float> rel_pos_tangent, const components::transform::motion& m, float dt) {
-							return m.velocity + m.acceleration * dt + rel_pos_len * (m.angularVelocity + m.angularAcceleration * dt) * rel_pos_tangent;
-						};
-
-						const auto& extra = extras->operator[](index);
-						const vec3<float> rel_v_a = velocity_at_point(extra.relative_position_length_a, extra.relative_position_tangent_a, motion_a, dt);
-						const vec3<float> rel_v_b = velocity_at_point(extra.relative_position_length_b, extra.relative_position_tangent_b, motion_b, dt);
-						const vec3<float> total_rel_v = rel_v_a - rel_v_b;
-
-						const float impact_power = -total_rel_v.dot(collision.normal);
-						if (impact_power < 0)
-							return;
-
-						constexpr float bias_start = 0.05f;
-						const float overlap_value = collision.penetration - bias_start;
-						rynx_assert(collision.normal.length_squared() < 1.1f, "normal should be unit length");
-
-						const vec3<float> rel_pos_a = collision.c_pos - collision.a_pos;
-						const vec3<float> rel_pos_b = collision.c_pos - collision.b_pos;
-
-						const float inertia1 = sqr(rel_pos_a.cross2d(collision.normal)) * collision.a_body.inv_moment_of_inertia;
-						const float inertia2 = sqr(rel_pos_b.cross2d(collision.normal)) * collision.b_body.inv_moment_of_inertia;
-						const float collision_elasticity = (collision.a_body.collision_elasticity + collision.b_body.collision_elasticity) * 0.5f; // combine some fun way
-
-						const float top = (1.0f + collision_elasticity) * impact_power;
-						const float bot = collision.a_body.inv_mass + collision.b_body.inv_mass + inertia1 + inertia2;
-
-						const float soft_j = top / bot;
-
-						// This *60 is not the same as dt. Just a random constant.
-						const auto proximity_force =
-							collision.normal * (overlap_value > 0) * overlap_value * 0.5f *
-							(collision.a_body.bias_multiply + collision.b_body.bias_multiply) / (collision.a_body.inv_mass + collision.b_body.inv_mass);
-
-						const vec3<float> normal = collision.normal;
-						const auto impact_linear_force = normal * soft_j;
-
-						const float mu = (collision.a_body.friction_multiplier + collision.b_body.friction_multiplier) * 0.5f;
-						vec3<float> tangent = normal.normal2d();
-						tangent *= ((tangent.dot(total_rel_v) > 0) * 2.0f - 1.0f);
-
-						float friction_power = -tangent.dot(total_rel_v) * mu;
-
-						// if we want to limit friction according to physics, this would do the trick.
-						if constexpr (false) {
-							while (friction_power * friction_power > soft_j * soft_j)
-								friction_power *= 0.9f;
-						}
-
-						const vec3<float> friction_linear_force = tangent * friction_power;
-
-
-						// proximity_force = bias (to keep the simulation stable, and prevent objects from sinking into each other over time)
-						// impact_linear_force = linear collision response along the collision normal
-						// friction_linear_force = friction response along the collision tangent
-						const vec3<float> total_force = proximity_force + impact_linear_force + friction_linear_force;
-						const float inv_dt = 1.0f / dt;
-						const vec3f force_mask_xy(1.0f, 1.0f, 0.0f);
-						motion_a.acceleration += force_mask_xy * total_force * collision.a_body.inv_mass * inv_dt;
-						motion_b.acceleration -= force_mask_xy * total_force * collision.b_body.inv_mass * inv_dt;
-
-						motion_a.angularAcceleration += rel_pos_a.cross2d(total_force) * collision.a_body.inv_moment_of_inertia * inv_dt;
-						motion_b.angularAcceleration -= rel_pos_b.cross2d(total_force) * collision.b_body.inv_moment_of_inertia * inv_dt;
-					});
-				}
+			{
+				rynx_profile("collisions", "partition contacts");
+				rynx::ruleset::physics::partition_contacts(contacts->partition, contacts->events);
+			}
+
+			{
+				rynx_profile("collisions", "resolve");
+				rynx::ruleset::physics::solve_contacts(task, contacts->events, contacts->extras, contacts->states, contacts->partition, dt, settings);
+			}
+
+			rynx_profile("collisions", "store contacts");
+			cache->store(contacts->events, contacts->extras, contacts->states);
 		});
-		for (auto&& bar : barriers)
-			collisions_resolve_task.depends_on(bar);
+		collisions_resolve_task.depends_on(fetched);
 	};
 
 	context.add_task("collisions resolve", collision_resolution_first_stage).depends_on(findCollisionsTask);
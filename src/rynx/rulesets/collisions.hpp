@@ -2,12 +2,18 @@
 
 #include <rynx/application/logic.hpp>
 #include <rynx/ecs/id.hpp>
+#include <rynx/rulesets/physics/contacts.hpp>
 
 namespace rynx {
 	namespace ruleset {
 		class RuleSetsDLL physics_2d : public application::logic::iruleset {
+			physics::contact_solver_settings m_solver_settings;
+
+			// contacts of the previous frame, for warm starting the solver.
+			rynx::shared_ptr<physics::contact_cache> m_contact_cache = rynx::make_shared<physics::contact_cache>();
+
 		public:
-			physics_2d() = default;
+			explicit physics_2d(physics::contact_solver_settings solver_settings = {}) : m_solver_settings(solver_settings) {}
 			virtual ~physics_2d() {}
 			virtual void clear(rynx::scheduler::context&) override;
 			virtual void onFrameProcess(rynx::scheduler::context& context, float dt) override;
@@ -26,8 +26,9 @@ void rynx::ruleset::frustum_culling::on_entities_erased(rynx::scheduler::context
 
 void rynx::ruleset::frustum_culling::onFrameProcess(rynx::scheduler::context& context, float /* dt */) {
 	
+	// the tags are sparse tags, toggling them does not move entities. so plain views are enough here.
 	auto update_new_entities = context.add_task("frustum cull add new entities", [this](
-		rynx::ecs::edit_view<
+		rynx::ecs::view<
 		entity_tracked_by_frustum_culling,
 		const components::graphics::draw_always,
 		const components::graphics::frustum_culled,
@@ -47,10 +48,8 @@ void rynx::ruleset::frustum_culling::onFrameProcess(rynx::scheduler::context& co
 				m_in_frustum.insert_entity(std::get<0>(data).value, std::get<1>(data).value, std::get<2>(data).r);
 			}
 			
-			if (!ids.empty()) {
-				for (auto id : ids) {
-					ecs.attachToEntity(id, entity_tracked_by_frustum_culling());
-				}
+			for (auto id : ids) {
+				ecs.set_tags<entity_tracked_by_frustum_culling>(id);
 			}
 		}
 	);
@@ -66,15 +65,20 @@ void rynx::ruleset::frustum_culling::onFrameProcess(rynx::scheduler::context& co
 				const rynx::components::transform::position,
 				const rynx::components::transform::radius> ecs)
 				{
+					// sphere tree entries only need updating for entities that have moved or resized since the previous frame.
+					const uint64_t changed_since = std::exchange(m_change_version, ecs.change_version());
+
 					ecs.query()
-						.in<entity_tracked_by_frustum_culling, components::transform::motion>()
+						.in<entity_tracked_by_frustum_culling>()
 						.notIn<components::graphics::frustum_culled>()
+						.changed_since<rynx::components::transform::position, rynx::components::transform::radius>(changed_since)
 						.for_each_parallel(task_context, [this](rynx::ecs::id id, rynx::components::transform::position pos, rynx::components::transform::radius r) {
 						m_in_frustum.update_entity(id.value, pos.value, r.r);
 					});
 
 					ecs.query()
-						.in<entity_tracked_by_frustum_culling, components::transform::motion, components::graphics::frustum_culled>()
+						.in<entity_tracked_by_frustum_culling, components::graphics::frustum_culled>()
+						.changed_since<rynx::components::transform::position, rynx::components::transform::radius>(changed_since)
 						.for_each_parallel(task_context, [this](rynx::ecs::id id, rynx::components::transform::position pos, rynx::components::transform::radius r) {
 						m_out_frustum.update_entity(id.value, pos.value, r.r);
 					});
@@ -125,17 +129,17 @@ void rynx::ruleset::frustum_culling::onFrameProcess(rynx::scheduler::context& co
 						if (!move_to_inside.empty() || !move_to_outside.empty()) {
 							task_context.extend_task_independent(
 								"apply frustum migrates",
-								[this, move_to_inside = std::move(move_to_inside), move_to_outside = std::move(move_to_outside)](rynx::ecs::edit_view<components::graphics::frustum_culled> ecs) {
+								[this, move_to_inside = std::move(move_to_inside), move_to_outside = std::move(move_to_outside)](rynx::ecs::view<components::graphics::frustum_culled> ecs) {
 								for (auto id : move_to_inside) {
 									if (ecs.exists(id)) {
-										ecs.removeFromEntity<components::graphics::frustum_culled>(id);
+										ecs.clear_tags<components::graphics::frustum_culled>(id);
 										auto id_data = m_out_frustum.eraseEntity(id);
 										m_in_frustum.insert_entity(id, id_data.first, id_data.second);
 									}
 								}
 								for (auto id : move_to_outside) {
 									if (ecs.exists(id)) {
-										ecs.attachToEntity(id, components::graphics::frustum_culled());
+										ecs.set_tags<components::graphics::frustum_culled>(id);
 										auto id_data = m_in_frustum.eraseEntity(id);
 										m_out_frustum.insert_entity(id, id_data.first, id_data.second);
 									}
@@ -11,7 +11,7 @@ namespace rynx {
 
 	namespace ruleset {
 		class RuleSetsDLL frustum_culling : public application::logic::iruleset {
-			struct entity_tracked_by_frustum_culling {};
+			struct entity_tracked_by_frustum_culling : public rynx::ecs_sparse_tag {};
 		
 		public:
 			frustum_culling(rynx::observer_ptr<camera> camera) 
@@ -27,6 +27,7 @@ namespace rynx {
 			rynx::sphere_tree m_in_frustum;
 			rynx::sphere_tree m_out_frustum;
 			rynx::observer_ptr<camera> m_pCamera;
+			uint64_t m_change_version = 0; // taken at previous sphere tree update, see rynx::ecs::change_version().
 		};
 	}
 }
@@ -7,8 +7,10 @@
 #include <rynx/scheduler/task.hpp>
 #include <rynx/scheduler/barrier.hpp>
 
-void rynx::ruleset::motion_updates::onFrameProcess(rynx::scheduler::context& context, float dt) {
-	auto position_updates = context.add_task("Motion update", [dt](
+void rynx::ruleset::motion_updates::onFrameProcess(rynx::scheduler::context& context, float /* dt */) {
+	// dt is read from frame parameters so that the tasks can be replayed on later frames.
+	auto position_updates = context.add_task("Motion update", [](
+		const rynx::application::logic::frame_parameters& frame,
 		rynx::ecs::view<
 			const components::transform::constant_force,
 			components::transform::motion,
@@ -16,25 +18,17 @@ void rynx::ruleset::motion_updates::onFrameProcess(rynx::scheduler::context& con
 			components::transform::position_relative> ecs,
 		rynx::scheduler::task& task_context)
 		{
-			auto apply_acceleration_to_velocity = ecs.query().for_each_parallel(task_context, [dt](components::transform::position& p, components::transform::motion& m) {
-
-				auto delta_position = m.acceleration * dt * dt + m.velocity * dt;
-				auto delta_orientation = m.angularAcceleration * dt * dt + m.angularVelocity * dt;
-
-				// update velocity
-				m.velocity += m.acceleration * dt;
-				m.angularVelocity += m.angularAcceleration * dt;
-
-				m.acceleration.set(0, 0, 0);
-				m.angularAcceleration = 0;
-
-				// update position
-				p.value += delta_position;
-				p.angle += delta_orientation;
+			const float dt = frame.dt;
+			auto apply_acceleration_to_velocity = ecs.query().for_each_chunk_parallel(task_context, [dt](size_t n, components::transform::position* rynx_restrict p, components::transform::motion* rynx_restrict m) {
+				for (size_t i = 0; i < n; ++i) {
+					integrate(dt, p[i], m[i]);
+				}
 			});
 
-			auto apply_constant_forces = ecs.query().for_each_parallel(task_context, [dt](rynx::components::transform::motion& m, const rynx::components::transform::constant_force force) {
-				m.acceleration += force.force * dt;
+			auto apply_constant_forces = ecs.query().for_each_chunk_parallel(task_context, [dt](size_t n, rynx::components::transform::motion* rynx_restrict m, const rynx::components::transform::constant_force* rynx_restrict force) {
+				for (size_t i = 0; i < n; ++i) {
+					m[i].acceleration += force[i].force * dt;
+				}
 			});
 
 			ecs.query().for_each_parallel(task_context, [ecs](rynx::components::transform::position& pos, rynx::components::transform::position_relative relative_pos) {
@@ -47,10 +41,12 @@ void rynx::ruleset::motion_updates::onFrameProcess(rynx::scheduler::context& con
 		}
 	);
 
-	context.add_task("Apply dampening", [dt](rynx::scheduler::task& task, rynx::ecs::view<components::transform::motion, const components::transform::dampening> ecs) {
-		ecs.query().for_each_parallel(task, [dt](components::transform::motion& m, components::transform::dampening d) {
-			m.velocity *= ::powf(1.0f - d.linearDampening, dt);
-			m.angularVelocity *= ::powf(1.0f - d.angularDampening, dt);
+	context.add_task("Apply dampening", [](const rynx::application::logic::frame_parameters& frame, rynx::scheduler::task& task, rynx::ecs::view<components::transform::motion, const components::transform::dampening> ecs) {
+		const float dt = frame.dt;
+		ecs.query().for_each_chunk_parallel(task, [dt](size_t n, components::transform::motion* rynx_restrict m, const components::transform::dampening* rynx_restrict d) {
+			for (size_t i = 0; i < n; ++i) {
+				dampen(dt, m[i], d[i]);
+			}
 		});
 	}).required_for(position_updates);
 
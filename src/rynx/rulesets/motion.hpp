@@ -1,7 +1,11 @@
 #pragma once
 
 #include <rynx/application/logic.hpp>
+#include <rynx/ecs/components.hpp>
 #include <rynx/math/vector.hpp>
+#include <rynx/tech/components.hpp>
+
+#include <cmath>
 
 namespace rynx {
 	namespace ruleset {
@@ -10,7 +14,30 @@ namespace rynx {
 		public:
 			motion_updates(vec3<float> gravity = vec3<float>(0, 0, 0)) : m_gravity(gravity) {}
 			virtual ~motion_updates() {}
+			virtual bool replayable() const override { return true; }
 			virtual void onFrameProcess(rynx::scheduler::context& context, float dt) override;
+
+			// per entity steps of the frame tasks, which run them over whole component chunks.
+			static void integrate(float dt, components::transform::position& p, components::transform::motion& m) {
+				auto delta_position = m.acceleration * dt * dt + m.velocity * dt;
+				auto delta_orientation = m.angularAcceleration * dt * dt + m.angularVelocity * dt;
+
+				// update velocity
+				m.velocity += m.acceleration * dt;
+				m.angularVelocity += m.angularAcceleration * dt;
+
+				m.acceleration.set(0, 0, 0);
+				m.angularAcceleration = 0;
+
+				// update position
+				p.value += delta_position;
+				p.angle += delta_orientation;
+			}
+
+			static void dampen(float dt, components::transform::motion& m, const components::transform::dampening& d) {
+				m.velocity *= ::powf(1.0f - d.linearDampening, dt);
+				m.angularVelocity *= ::powf(1.0f - d.angularDampening, dt);
+			}
 		};
 	}
 }
@@ -26,21 +26,26 @@ void rynx::ruleset::particle_system::onFrameProcess(rynx::scheduler::context& co
 			});
 		});
 
+		using particle_spawn_view = rynx::ecs::edit_view<
+			rynx::components::graphics::particle_info,
+			rynx::components::transform::position,
+			rynx::components::transform::radius,
+			rynx::components::transform::motion,
+			rynx::components::entity::lifetime,
+			rynx::components::graphics::color,
+			rynx::components::transform::dampening,
+			rynx::components::graphics::translucent,
+			rynx::components::transform::ignore_gravity,
+			rynx::components::transform::constant_force,
+			rynx::components::transform::matrix>;
+
 		context.add_task("particle emitter update",
-			[dt](rynx::ecs::edit_view<
+			[this, dt](rynx::ecs::view<
 				const rynx::components::graphics::particle_emitter,
-				rynx::components::graphics::particle_info,
-				rynx::components::transform::position,
-				rynx::components::transform::radius,
-				rynx::components::transform::motion,
-				rynx::components::entity::lifetime,
-				rynx::components::graphics::color,
-				rynx::components::transform::dampening,
-				rynx::components::graphics::translucent,
-				rynx::components::transform::ignore_gravity,
-				rynx::components::transform::constant_force,
-				rynx::components::transform::matrix> ecs) {
-			ecs.query().for_each([&ecs, dt](rynx::components::transform::position pos, const rynx::components::graphics::particle_emitter& emitter) {
+				const rynx::components::transform::position> ecs,
+				rynx::scheduler::task& task_context) {
+			// emitters only touch their own state, so they can be updated in parallel. spawned particles are recorded and created in one batch after.
+			auto emitter_updates = ecs.query().for_each_parallel(task_context, [this, dt](rynx::components::transform::position pos, const rynx::components::graphics::particle_emitter& emitter) {
 				int count = emitter.get_spawn_count(dt);
 
 				for (int i = 0; i < count; ++i) {
@@ -64,9 +69,7 @@ void rynx::ruleset::particle_system::onFrameProcess(rynx::scheduler::context& co
 					auto particle_pos = pos;
 					particle_pos.value += offset;
 
-					// in general creating new entities is not safe inside a query, but now we know that we are not touching the same entity categories,
-					// because we iterated over particle_emitter components, and we are only creating entities that do not have particle_emitter component.
-					ecs.create(
+					m_spawns.create(
 						p_info,
 						particle_pos,
 						rynx::components::transform::radius(p_info.radius_range.begin),
@@ -81,5 +84,9 @@ void rynx::ruleset::particle_system::onFrameProcess(rynx::scheduler::context& co
 					);
 				}
 				});
+
+			task_context.extend_task_independent("particle spawns", [this](particle_spawn_view ecs) {
+				m_spawns.apply(ecs);
+			}).depends_on(emitter_updates.barrier());
 			});
 		}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <rynx/application/logic.hpp>
+#include <rynx/ecs/command_buffer.hpp>
 
 namespace rynx {
 	namespace ruleset {
@@ -9,6 +10,9 @@ namespace rynx {
 		public:
 			virtual ~particle_system();
 			virtual void onFrameProcess(rynx::scheduler::context& context, float dt) override;
+
+		private:
+			rynx::ecs_command_buffer m_spawns; // particles created by emitters during the frame.
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <rynx/math/vector.hpp>
+#include <rynx/scheduler/context.hpp>
+#include <rynx/std/unordered_map.hpp>
+#include <rynx/system/assert.hpp>
+#include <rynx/tech/components.hpp>
+#include <rynx/tech/contact_partition.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace rynx {
+	namespace ruleset {
+		namespace physics {
+			struct collision_event {
+				uint64_t a_id;
+				uint64_t b_id;
+				rynx::components::phys::body a_body;
+				rynx::components::phys::body b_body;
+				rynx::components::transform::motion* a_motion; // nullptr for bodies without motion.
+				rynx::components::transform::motion* b_motion;
+				rynx::vec3<float> a_pos;
+				rynx::vec3<float> b_pos;
+				rynx::vec3<float> c_pos; // collision point in world space
+				rynx::vec3<float> normal;
+				float penetration;
+				uint32_t feature = 0; // tells apart the contacts of one pair of bodies, stays the same while the contact persists. same in either orientation.
+			};
+
+			// swaps the bodies of a contact so that a has the smaller id. the broadphase reports a pair in either order,
+			// depending on where its entities happened to land, so contacts are oriented by id before anything depends on it.
+			inline void orient_by_id(collision_event& collision) {
+				if (collision.a_id > collision.b_id) {
+					std::swap(collision.a_id, collision.b_id);
+					std::swap(collision.a_body, collision.b_body);
+					std::swap(collision.a_motion, collision.b_motion);
+					std::swap(collision.a_pos, collision.b_pos);
+					collision.normal = -collision.normal;
+				}
+			}
+
+			struct contact_extra_info {
+				rynx::vec3<float> relative_position_a;
+				rynx::vec3<float> relative_position_b;
+				rynx::vec3<float> relative_position_tangent_a;
+				float relative_position_length_a;
+				rynx::vec3<float> relative_position_tangent_b;
+				float relative_position_length_b;
+			};
+
+			inline contact_extra_info make_contact_extra_info(const collision_event& collision) {
+				contact_extra_info extra;
+				const rynx::vec3<float> rel_pos_a = collision.c_pos - collision.a_pos;
+				const rynx::vec3<float> rel_pos_b = collision.c_pos - collision.b_pos;
+				extra.relative_position_a = rel_pos_a;
+				extra.relative_position_b = rel_pos_b;
+
+				const float rel_pos_len_a = rel_pos_a.length();
+				const float rel_pos_len_b = rel_pos_b.length();
+				extra.relative_position_length_a = rel_pos_len_a;
+				extra.relative_position_length_b = rel_pos_len_b;
+				extra.relative_position_tangent_a = rel_pos_a.normal2d() / (rel_pos_len_a + std::numeric_limits<float>::epsilon());
+				extra.relative_position_tangent_b = rel_pos_b.normal2d() / (rel_pos_len_b + std::numeric_limits<float>::epsilon());
+				return extra;
+			}
+
+			// solver state of one contact. the normal impulse carries over to the next frame in the contact cache.
+			struct contact_state {
+				float warm_impulse = 0; // part of the normal impulse applied before the iterations, which the iterations may take back.
+				float normal_impulse = 0; // normal impulse applied during this frame.
+				float residual = 0; // relative velocity change caused by the latest iteration.
+			};
+
+			struct contact_solver_settings {
+				int min_iterations = 2;
+				int max_iterations = 10;
+
+				// iterations stop when no contact changed the relative velocity of its bodies more than this.
+				float residual_threshold = 0.05f;
+
+				// fraction of the previous frame's normal impulse applied before the first iteration. zero disables warm starting.
+				float warm_start = 1.0f;
+			};
+
+			inline void apply_contact_impulse(const collision_event& collision, const contact_extra_info& extra, vec3<float> impulse, float dt) {
+				const float inv_dt = 1.0f / dt;
+				const vec3f force_mask_xy(1.0f, 1.0f, 0.0f);
+				if (collision.a_motion) {
+					collision.a_motion->acceleration += force_mask_xy * impulse * collision.a_body.inv_mass * inv_dt;
+					collision.a_motion->angularAcceleration += extra.relative_position_a.cross2d(impulse) * collision.a_body.inv_moment_of_inertia * inv_dt;
+				}
+				if (collision.b_motion) {
+					collision.b_motion->acceleration -= force_mask_xy * impulse * collision.b_body.inv_mass * inv_dt;
+					collision.b_motion->angularAcceleration -= extra.relative_position_b.cross2d(impulse) * collision.b_body.inv_moment_of_inertia * inv_dt;
+				}
+			}
+
+			inline void warm_start_contact(const collision_event& collision, const contact_extra_info& extra, const contact_state& state, float dt) {
+				if (state.warm_impulse > 0)
+					apply_contact_impulse(collision, extra, collision.normal * state.warm_impulse, dt);
+			}
+
+			// applies one solver iteration of the contact to the motions of both bodies.
+			// contacts that share a body must not be resolved at the same time, see solve_contacts.
+			inline void resolve_contact(const collision_event& collision, const contact_extra_info& extra, contact_state& state, float dt) {
+				static const rynx::components::transform::motion no_motion;
+				const rynx::components::transform::motion& motion_a = collision.a_motion ? *collision.a_motion : no_motion;
+				const rynx::components::transform::motion& motion_b = collision.b_motion ? *collision.b_motion : no_motion;
+
+				auto velocity_at_point = [](float rel_pos_len, vec3<float> rel_pos_tangent, const rynx::components::transform::motion& m, float dt) {
+					return m.velocity + m.acceleration * dt + rel_pos_len * (m.angularVelocity + m.angularAcceleration * dt) * rel_pos_tangent;
+				};
+
+				const vec3<float> rel_v_a = velocity_at_point(extra.relative_position_length_a, extra.relative_position_tangent_a, motion_a, dt);
+				const vec3<float> rel_v_b = velocity_at_point(extra.relative_position_length_b, extra.relative_position_tangent_b, motion_b, dt);
+				const vec3<float> total_rel_v = rel_v_a - rel_v_b;
+
+				const float arm_a = extra.relative_position_a.cross2d(collision.normal);
+				const float arm_b = extra.relative_position_b.cross2d(collision.normal);
+				const float inertia1 = arm_a * arm_a * collision.a_body.inv_moment_of_inertia;
+				const float inertia2 = arm_b * arm_b * collision.b_body.inv_moment_of_inertia;
+				const float bot = collision.a_body.inv_mass + collision.b_body.inv_mass + inertia1 + inertia2;
+
+				const float impact_power = -total_rel_v.dot(collision.normal);
+				if (impact_power < 0) {
+					// separating. only the warm start impulse may be taken back, what the iterations applied on this frame stays.
+					const float take_back = std::min(state.warm_impulse, -impact_power / bot);
+					state.residual = take_back * bot;
+					if (take_back > 0) {
+						state.warm_impulse -= take_back;
+						state.normal_impulse -= take_back;
+						apply_contact_impulse(collision, extra, collision.normal * -take_back, dt);
+					}
+					return;
+				}
+
+				constexpr float bias_start = 0.05f;
+				const float overlap_value = collision.penetration - bias_start;
+				rynx_assert(collision.normal.length_squared() < 1.1f, "normal should be unit length");
+
+				const float collision_elasticity = (collision.a_body.collision_elasticity + collision.b_body.collision_elasticity) * 0.5f; // combine some fun way
+				const float top = (1.0f + collision_elasticity) * impact_power;
+				const float soft_j = top / bot;
+
+				// This *60 is not the same as dt. Just a random constant.
+				const auto proximity_force =
+					collision.normal * (overlap_value > 0) * overlap_value * 0.5f *
+					(collision.a_body.bias_multiply + collision.b_body.bias_multiply) / (collision.a_body.inv_mass + collision.b_body.inv_mass);
+
+				const vec3<float> normal = collision.normal;
+				const auto impact_linear_force = normal * soft_j;
+
+				const float mu = (collision.a_body.friction_multiplier + collision.b_body.friction_multiplier) * 0.5f;
+				vec3<float> tangent = normal.normal2d();
+				tangent *= ((tangent.dot(total_rel_v) > 0) * 2.0f - 1.0f);
+
+				float friction_power = -tangent.dot(total_rel_v) * mu;
+
+				// if we want to limit friction according to physics, this would do the trick.
+				if constexpr (false) {
+					while (friction_power * friction_power > soft_j * soft_j)
+						friction_power *= 0.9f;
+				}
+
+				const vec3<float> friction_linear_force = tangent * friction_power;
+
+				// proximity_force = bias (to keep the simulation stable, and prevent objects from sinking into each other over time)
+				// impact_linear_force = linear collision response along the collision normal
+				// friction_linear_force = friction response along the collision tangent
+				const vec3<float> total_force = proximity_force + impact_linear_force + friction_linear_force;
+				apply_contact_impulse(collision, extra, total_force, dt);
+				state.normal_impulse += soft_j;
+				state.residual = total_force.length() * (collision.a_body.inv_mass + collision.b_body.inv_mass);
+			}
+
+			// colours the contacts by the motions they write to. bodies without motion never conflict.
+			inline void partition_contacts(rynx::contact_partition& partition, const std::vector<collision_event>& events) {
+				auto key = [](const rynx::components::transform::motion* m, uint64_t id) {
+					return m ? id : rynx::contact_partition::static_body;
+				};
+				partition.build(events.size(), [&events, key](size_t i) {
+					return std::pair<uint64_t, uint64_t>(key(events[i].a_motion, events[i].a_id), key(events[i].b_motion, events[i].b_id));
+				});
+			}
+
+			namespace detail {
+				// runs op(contact) for every contact, batch by batch. batches are solved in parallel when a task is given.
+				template<typename F>
+				void for_each_contact_batched(rynx::scheduler::task* task, const rynx::contact_partition& partition, F& op) {
+					// small batches are not worth waking up the workers for.
+					constexpr size_t min_parallel_batch_size = 256;
+					for (size_t batch = 0; batch < partition.batch_count(); ++batch) {
+						const size_t batch_size = partition.batch_size(batch);
+						if (!task || !partition.is_parallel(batch) || batch_size < min_parallel_batch_size) {
+							for (size_t i = 0; i < batch_size; ++i) {
+								op(partition.contact(batch, i));
+							}
+							continue;
+						}
+
+						task->wait(task->parallel().range(0, batch_size, 64).execute([op = &op, partition = &partition, batch](int64_t index) {
+							(*op)(partition->contact(batch, index));
+						}));
+					}
+				}
+
+				inline int solve_contacts(
+					rynx::scheduler::task* task,
+					const std::vector<collision_event>& events,
+					const std::vector<contact_extra_info>& extras,
+					std::vector<contact_state>& states,
+					const rynx::contact_partition& partition,
+					float dt,
+					const contact_solver_settings& settings)
+				{
+					auto warm_start = [&](uint32_t contact) { warm_start_contact(events[contact], extras[contact], states[contact], dt); };
+					auto resolve = [&](uint32_t contact) { resolve_contact(events[contact], extras[contact], states[contact], dt); };
+					for_each_contact_batched(task, partition, warm_start);
+
+					for (int iteration = 1; iteration <= settings.max_iterations; ++iteration) {
+						for_each_contact_batched(task, partition, resolve);
+						if (iteration >= settings.min_iterations) {
+							float residual = 0;
+							for (const auto& state : states)
+								residual = std::max(residual, state.residual);
+							if (residual < settings.residual_threshold)
+								return iteration;
+						}
+					}
+					return settings.max_iterations;
+				}
+			}
+
+			// runs the solver iterations batch by batch on this thread. returns the number of iterations run.
+			inline int solve_contacts(
+				const std::vector<collision_event>& events,
+				const std::vector<contact_extra_info>& extras,
+				std::vector<contact_state>& states,
+				const rynx::contact_partition& partition,
+				float dt,
+				const contact_solver_settings& settings)
+			{
+				return detail::solve_contacts(nullptr, events, extras, states, partition, dt, settings);
+			}
+
+			// runs the solver iterations batch by batch, solving each batch in parallel. the contacts of a batch do not share
+			// bodies, so the result is the same as from the single threaded solve_contacts regardless of the thread count.
+			inline int solve_contacts(
+				rynx::scheduler::task& task,
+				const std::vector<collision_event>& events,
+				const std::vector<contact_extra_info>& extras,
+				std::vector<contact_state>& states,
+				const rynx::contact_partition& partition,
+				float dt,
+				const contact_solver_settings& settings)
+			{
+				return detail::solve_contacts(&task, events, extras, states, partition, dt, settings);
+			}
+
+			// normal impulses and extra info of the previous frame's contacts, keyed by the bodies and the contact feature.
+			// a pair of bodies finds its contacts in either orientation, features must not depend on which body is a.
+			class contact_cache {
+			public:
+				// fills in the extra info and the warm start impulse of a contact. a contact that persists from the previous
+				// frame reuses its extra info, unless the contact point has moved on either body.
+				void fetch(const collision_event& collision, contact_extra_info& extra, contact_state& state, float warm_start) const {
+					state = contact_state();
+					auto it = m_contacts.find(key_of(collision));
+					if (it == m_contacts.end()) {
+						extra = make_contact_extra_info(collision);
+						return;
+					}
+
+					constexpr float max_reuse_distance_sqr = 1e-6f;
+					const auto& cached = it->second;
+					const contact_extra_info cached_extra = collision.a_id < collision.b_id ? cached.extra : swapped(cached.extra);
+					const bool moved =
+						((collision.c_pos - collision.a_pos) - cached_extra.relative_position_a).length_squared() > max_reuse_distance_sqr ||
+						((collision.c_pos - collision.b_pos) - cached_extra.relative_position_b).length_squared() > max_reuse_distance_sqr;
+					extra = moved ? make_contact_extra_info(collision) : cached_extra;
+					state.warm_impulse = cached.normal_impulse * warm_start;
+					state.normal_impulse = state.warm_impulse;
+				}
+
+				// replaces the cached contacts with the contacts of this frame. contacts that did not persist are forgotten.
+				void store(const std::vector<collision_event>& events, const std::vector<contact_extra_info>& extras, const std::vector<contact_state>& states) {
+					rynx_assert(events.size() == extras.size() && events.size() == states.size(), "contact arrays must match");
+					m_contacts.clear();
+					for (size_t i = 0; i < events.size(); ++i) {
+						// extra info is kept with the smaller id as body a.
+						const contact_extra_info& extra = extras[i];
+						m_contacts[key_of(events[i])] = entry{ events[i].a_id < events[i].b_id ? extra : swapped(extra), states[i].normal_impulse };
+					}
+				}
+
+				void clear() { m_contacts.clear(); }
+				size_t size() const { return m_contacts.size(); }
+
+			private:
+				struct key {
+					uint64_t a_id; // the smaller id of the pair.
+					uint64_t b_id;
+					uint32_t feature;
+					bool operator == (const key& other) const { return a_id == other.a_id && b_id == other.b_id && feature == other.feature; }
+				};
+
+				static key key_of(const collision_event& collision) {
+					return key{ std::min(collision.a_id, collision.b_id), std::max(collision.a_id, collision.b_id), collision.feature };
+				}
+
+				static contact_extra_info swapped(const contact_extra_info& extra) {
+					contact_extra_info result;
+					result.relative_position_a = extra.relative_position_b;
+					result.relative_position_b = extra.relative_position_a;
+					result.relative_position_tangent_a = extra.relative_position_tangent_b;
+					result.relative_position_tangent_b = extra.relative_position_tangent_a;
+					result.relative_position_length_a = extra.relative_position_length_b;
+					result.relative_position_length_b = extra.relative_position_length_a;
+					return result;
+				}
+
+				struct key_hash {
+					size_t operator()(const key& k) const {
+						// the map uses the low bits as is, so every input bit has to reach them.
+						uint64_t h = k.a_id * 0x9E3779B97F4A7C15ull;
+						h ^= h >> 32;
+						h += k.b_id * 0xC2B2AE3D27D4EB4Full + k.feature;
+						h ^= h >> 29;
+						h *= 0x165667B19E3779F9ull;
+						h ^= h >> 32;
+						return size_t(h);
+					}
+				};
+
+				struct entry {
+					contact_extra_info extra;
+					float normal_impulse = 0;
+				};
+
+				rynx::unordered_map<key, entry, key_hash> m_contacts;
+			};
+		}
+	}
+}
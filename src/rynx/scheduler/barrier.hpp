@@ -1,7 +1,9 @@
 #pragma once
 
 #include <rynx/std/memory.hpp>
-#include <rynx/std/string.hpp>
+#include <rynx/std/pool_allocator.hpp>
+#include <rynx/std/dynamic_bitset.hpp>
+#include <rynx/std/interned_string.hpp>
 #include <rynx/system/assert.hpp>
 
 #include <atomic>
@@ -11,9 +13,12 @@ namespace rynx {
 	namespace scheduler {
 		class context;
 
+		// per frame scheduler objects are allocated from the pool allocator, so that steady state frames do not touch the heap.
+		template<typename T> using pooled_vector = std::vector<T, rynx::memory::pool_allocator::allocator_t<T>>;
+
 		struct SchedulerDLL barrier {
 			barrier() : barrier("anon") {}
-			barrier(rynx::string name) : name(std::move(name)), counter(rynx::make_shared<std::atomic<int32_t>>(0)) {}
+			barrier(rynx::interned_string name) : name(name), counter(rynx::memory::pool_allocator::make_shared<std::atomic<int32_t>>(0)) {}
 			barrier(const barrier& other) = default;
 			barrier(barrier&& other) = default;
 			barrier& operator = (const barrier& other) = default;
@@ -21,7 +26,7 @@ namespace rynx {
 
 			operator bool() const { return counter->load(std::memory_order_acquire) == 0; }
 
-			rynx::string name;
+			rynx::interned_string name;
 			rynx::shared_ptr<std::atomic<int32_t>> counter; // counter object is shared by all copies of the same barrier.
 		};
 
@@ -31,6 +36,7 @@ namespace rynx {
 			operation_barriers(operation_barriers&&) = default;
 			operation_barriers(const operation_barriers& other) {
 				m_requires = other.m_requires;
+				m_requires_met = other.m_requires_met;
 				m_blocks = other.m_blocks;
 
 				for (auto&& bar : m_blocks) {
@@ -57,13 +63,22 @@ namespace rynx {
 				return *this;
 			}
 
+			// for tasks whose barrier counters were already incremented on their behalf. see context::replay.
+			operation_barriers& required_for_precounted(barrier bar) {
+				m_blocks.emplace_back(std::move(bar));
+				return *this;
+			}
+
+			const pooled_vector<barrier>& requirements() const { return m_requires; }
+			const pooled_vector<barrier>& blocks() const { return m_blocks; }
+
 			void dump() const;
 
 			bool can_start() {
-				while (!m_requires.empty()) {
-					if (m_requires.front()) {
-						m_requires[0] = std::move(m_requires.back()); // requirement met. erase it so we don't check it again.
-						m_requires.pop_back();
+				// requirements are kept for critical path measurements. met ones are skipped so we don't check them again.
+				while (m_requires_met < m_requires.size()) {
+					if (m_requires[m_requires_met]) {
+						++m_requires_met;
 					}
 					else {
 						return false;
@@ -100,14 +115,35 @@ namespace rynx {
 			}
 
 		private:
-			std::vector<barrier> m_requires; // barriers that must be completed before starting this task.
-			std::vector<barrier> m_blocks; // barriers that are not complete without this task.
-			std::vector<rynx::weak_ptr<operation_barriers>> m_extensions; // operations that extend this operation instance.
+			pooled_vector<barrier> m_requires; // barriers that must be completed before starting this task.
+			size_t m_requires_met = 0; // the first requirements are known to be complete.
+			pooled_vector<barrier> m_blocks; // barriers that are not complete without this task.
+			pooled_vector<rynx::weak_ptr<operation_barriers>> m_extensions; // operations that extend this operation instance.
 		};
 
 		class SchedulerDLL operation_resources {
-			std::vector<uint64_t> m_writeAccess;
-			std::vector<uint64_t> m_readAccess;
+		public:
+			// ecs categories that have all of include types and none of exclude types.
+			// resolved to actual categories when the operation is about to start.
+			// each scoped view type has one scope that lives for the whole program, operations only refer to it.
+			struct category_scope {
+				rynx::dynamic_bitset include;
+				rynx::dynamic_bitset exclude;
+				bool write = false;
+			};
+
+		private:
+			pooled_vector<uint64_t> m_writeAccess;
+			pooled_vector<uint64_t> m_readAccess;
+
+			// types accessed only in the categories of m_categoryScopes.
+			pooled_vector<uint64_t> m_scopedWriteAccess;
+			pooled_vector<uint64_t> m_scopedReadAccess;
+			pooled_vector<const category_scope*> m_categoryScopes;
+
+			// resource ids of categories in scope, filled in when the resources are reserved.
+			pooled_vector<uint64_t> m_categoryWriteAccess;
+			pooled_vector<uint64_t> m_categoryReadAccess;
 
 		public:
 			operation_resources& require_write(uint64_t resourceId) {
@@ -120,10 +156,33 @@ namespace rynx {
 				return *this;
 			}
 
-			const std::vector<uint64_t>& read_requirements() const { return m_readAccess; }
-			const std::vector<uint64_t>& write_requirements() const { return m_writeAccess; }
+			operation_resources& require_scoped_write(uint64_t resourceId) {
+				m_scopedWriteAccess.emplace_back(resourceId);
+				return *this;
+			}
+
+			operation_resources& require_scoped_read(uint64_t resourceId) {
+				m_scopedReadAccess.emplace_back(resourceId);
+				return *this;
+			}
+
+			operation_resources& require_category_scope(const category_scope& scope) {
+				m_categoryScopes.emplace_back(&scope);
+				return *this;
+			}
+
+			const pooled_vector<uint64_t>& read_requirements() const { return m_readAccess; }
+			const pooled_vector<uint64_t>& write_requirements() const { return m_writeAccess; }
+			const pooled_vector<uint64_t>& scoped_read_requirements() const { return m_scopedReadAccess; }
+			const pooled_vector<uint64_t>& scoped_write_requirements() const { return m_scopedWriteAccess; }
+			const pooled_vector<const category_scope*>& category_scopes() const { return m_categoryScopes; }
+
+			pooled_vector<uint64_t>& category_read_requirements() { return m_categoryReadAccess; }
+			pooled_vector<uint64_t>& category_write_requirements() { return m_categoryWriteAccess; }
+			const pooled_vector<uint64_t>& category_read_requirements() const { return m_categoryReadAccess; }
+			const pooled_vector<uint64_t>& category_write_requirements() const { return m_categoryWriteAccess; }
 
-			bool empty() const { return m_readAccess.empty() & m_writeAccess.empty(); }
+			bool empty() const { return m_readAccess.empty() & m_writeAccess.empty() & m_scopedReadAccess.empty() & m_scopedWriteAccess.empty(); }
 		};
 
 		// this barrier is attached to end of any new task added to scheduler while in scope.
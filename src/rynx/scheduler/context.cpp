@@ -3,148 +3,415 @@
 #include <rynx/scheduler/context.hpp>
 #include <rynx/scheduler/task.hpp>
 #include <rynx/scheduler/barrier.hpp>
+#include <rynx/scheduler/task_graph.hpp>
+#include <rynx/scheduler/worker_thread.hpp>
 
+#include <rynx/thread/this_thread.hpp>
+
+#include <algorithm>
 #include <mutex>
 
 rynx::scheduler::context::context(context_id id, task_scheduler* scheduler)
 	: m_id(id)
-	, m_scheduler(scheduler)
-	, m_tasks_parallel_for(uint32_t(scheduler->worker_count() + 1)) {
+	, m_scheduler(scheduler) {
 	m_resource_counters.resize(1024);
+	m_category_counters.resize(1024);
 	m_taskMutex = new std::mutex();
+	m_foreignReadyMutex = new std::mutex();
+	for (uint64_t i = 0; i < scheduler->worker_count() + 1; ++i) {
+		m_ready_tasks.emplace_back(rynx::make_unique<rynx::parallel::work_stealing_deque<task*>>());
+	}
 }
 
 rynx::scheduler::context::~context() {
+	for (auto& deque : m_ready_tasks) {
+		task* t = nullptr;
+		while (deque->steal(t)) {
+			rynx::memory::pool_allocator::deleter<task>()(t);
+		}
+	}
 	delete m_taskMutex;
+	delete m_foreignReadyMutex;
 }
 
-rynx::scheduler::task rynx::scheduler::context::findWork() {
-	rynx_profile("Profiler", "Find work self");
+void rynx::scheduler::context::push_ready_task(task t) {
+	const uint64_t self = rynx::this_thread::id();
+	if (self < m_ready_tasks.size()) [[likely]] {
+		m_ready_tasks[self]->push(rynx::memory::pool_allocator::make_unique<task>(std::move(t)).release());
+		return;
+	}
+
+	// this thread has no deque of its own here. called with the task mutex held too, so the shared list has its own lock.
+	std::scoped_lock lock(*m_foreignReadyMutex);
+	m_foreign_ready_tasks.emplace_back(std::move(t));
+	m_foreign_ready_count.fetch_add(1, std::memory_order_release);
+}
+
+bool rynx::scheduler::context::pop_foreign_ready_task(task& t) {
+	if (m_foreign_ready_count.load(std::memory_order_acquire) == 0) {
+		return false;
+	}
+
+	std::scoped_lock lock(*m_foreignReadyMutex);
+	if (m_foreign_ready_tasks.empty()) {
+		return false;
+	}
+	t = std::move(m_foreign_ready_tasks.back());
+	m_foreign_ready_tasks.pop_back();
+	m_foreign_ready_count.fetch_sub(1, std::memory_order_relaxed);
+	return true;
+}
+
+bool rynx::scheduler::context::pop_ready_task(task& t) {
+	const uint64_t self = rynx::this_thread::id();
+	const uint64_t count = m_ready_tasks.size();
+	task* found = nullptr;
+	bool success = (self < count) && m_ready_tasks[self]->pop(found);
 	
-	bool task_was_completed = false;
-	auto try_get_free_task = [this, &task_was_completed]() -> rynx::scheduler::task
+	// steal from the oldest end of other deques, starting from a random one so that thieves do not all hit the same victim.
+	thread_local uint64_t t_random_state = 0x9E3779B97F4A7C15ull ^ (self * 0xBF58476D1CE4E5B9ull);
+	t_random_state ^= t_random_state << 13;
+	t_random_state ^= t_random_state >> 7;
+	t_random_state ^= t_random_state << 17;
+	const uint64_t first_victim = t_random_state % count;
+	for (uint64_t i = 0; !success && i < count; ++i) {
+		const uint64_t victim = (first_victim + i) % count;
+		success = (victim != self) && m_ready_tasks[victim]->steal(found);
+	}
+
+	if (success) {
+		t = std::move(*found);
+		rynx::memory::pool_allocator::deleter<task>()(found);
+		return true;
+	}
+	return pop_foreign_ready_task(t);
+}
+
+bool rynx::scheduler::context::has_ready_tasks() const {
+	if (m_foreign_ready_count.load(std::memory_order_acquire) != 0) {
+		return true;
+	}
+	for (auto& deque : m_ready_tasks) {
+		if (!deque->empty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+rynx::scheduler::task rynx::scheduler::context::start_for_each(task t) {
+	if (!t.for_each_no_work_available()) {
+		// parallel for stays available for other workers while we work on it.
+		rynx::scheduler::task copy = t;
+		t.completion_blocked_by(copy);
+		push_ready_task(std::move(t));
+		return copy;
+	}
+
+	if (t.for_each_all_work_completed()) {
+		finish_for_each(t);
+		return {};
+	}
+
+	// all work is handed out. wait for the work in progress to finish without occupying the ready deques.
+	// whoever finishes the last piece of work looks for more work after, and completes the task in release_waiting_tasks.
+	std::scoped_lock lock(*m_taskMutex);
+	m_tasks_completing.emplace_back(std::move(t));
+	return {};
+}
+
+void rynx::scheduler::context::finish_for_each(task& t) {
+	if (t.m_enable_logging) {
+		logmsg("end parfor %s", t.name().c_str());
+	}
+
+	t.barriers().on_complete();
+	t = task();
+	task_finished();
+}
+
+bool rynx::scheduler::context::release_waiting_tasks(bool& task_was_completed) {
+	rynx_profile("Profiler", "Release waiting tasks");
+	bool found = false;
+	thread_local std::vector<task> completed; // kept around so that its capacity is reused.
 	{
-		task t;
-		if (m_tasks_parallel_for.deque(t)) {
-			if (t.is_for_each()) {
-				if (t.for_each_no_work_available()) {					
-					if (t.for_each_all_work_completed()) {
-						task_was_completed = true;
-						if (t.m_enable_logging) {
-							logmsg("end parfor %s", t.name().c_str());
-						}
-
-						t.barriers().on_complete();
-						t = task();
-						task_finished();
-					}
-					else {
-						m_tasks_parallel_for.enque(std::move(t));
-					}
-				}
-				else {
-					rynx::scheduler::task copy = t;
-					t.completion_blocked_by(copy);
-					m_tasks_parallel_for.enque(std::move(t));
-					return copy;
-				}
+		std::scoped_lock lock(*m_taskMutex);
+		for (size_t i = 0; i < m_tasks_completing.size();) {
+			if (m_tasks_completing[i].for_each_all_work_completed()) {
+				completed.emplace_back(std::move(m_tasks_completing[i]));
+				m_tasks_completing[i] = std::move(m_tasks_completing.back());
+				m_tasks_completing.pop_back();
 			}
 			else {
-				return t;
+				++i;
 			}
 		}
-		return {};
-	};
 
-	auto try_get_protected_task = [this]() -> rynx::scheduler::task
-	{
-		for (size_t i = 0; i < m_tasks.size(); ++i) {
-			auto& task = m_tasks[i];
-			if (task.barriers().can_start() & resourcesAvailableFor(task)) {
-				rynx::scheduler::task t(std::move(task));
-				if(i+1 < m_tasks.size())
+		if (uses_priorities()) {
+			found = release_waiting_tasks_by_priority();
+		}
+		else {
+			for (size_t i = 0; i < m_tasks.size();) {
+				auto& task = m_tasks[i];
+				if (task.barriers().can_start() && try_reserve_resources(task)) {
+					prioritized_task_released(task);
+					push_ready_task(std::move(task));
 					m_tasks[i] = std::move(m_tasks.back());
-				m_tasks.pop_back();
-				reserve_resources(t.resources());
-				
-				if (t.is_for_each()) {
-					rynx::scheduler::task copy = t;
-					m_tasks_parallel_for.enque(std::move(t));
-					return copy;
+					m_tasks.pop_back();
+					found = true;
+				}
+				else {
+					++i;
 				}
-
-				return t;
 			}
 		}
-		return {};
-	};
+	}
 
+	// completing tasks releases resources and barriers, which does not need the lock.
+	for (auto& t : completed) {
+		finish_for_each(t);
+		task_was_completed = true;
+	}
+	completed.clear();
+	return found;
+}
 
-	do {
-		task_was_completed = false;
-		if (m_taskMutex->try_lock())
-		{
-			{
-				task t = try_get_protected_task();
-				m_taskMutex->unlock();
-				if (t) {
-					return t;
-				}
-			}
+// called with the task mutex held. when tasks compete for the same resources, the higher priority one gets them.
+// only one task per thread is released at a time, the rest are compared again against tasks that become startable later.
+bool rynx::scheduler::context::release_waiting_tasks_by_priority() {
+	thread_local std::vector<uint32_t> startable; // kept around so that their capacity is reused.
+	thread_local std::vector<task> released;
+	for (uint32_t i = 0; i < m_tasks.size(); ++i) {
+		if (m_tasks[i].barriers().can_start()) {
+			startable.emplace_back(i);
+		}
+	}
 
-			{
-				task t = try_get_free_task();
-				if (t) {
-					return t;
-				}
-			}
+	std::sort(startable.begin(), startable.end(), [this](uint32_t a, uint32_t b) {
+		return m_tasks[a].m_priority != m_tasks[b].m_priority ? m_tasks[a].m_priority > m_tasks[b].m_priority : a < b;
+	});
+
+	for (uint32_t i : startable) {
+		if (released.size() == m_ready_tasks.size()) {
+			break;
 		}
-		else
-		{
-			{
-				task t = try_get_free_task();
-				if (t) {
-					return t;
-				}
-			}
+		if (try_reserve_resources(m_tasks[i])) {
+			prioritized_task_released(m_tasks[i]);
+			released.emplace_back(std::move(m_tasks[i]));
+		}
+	}
+	startable.clear();
 
-			{
-				m_taskMutex->lock();
-				task t = try_get_protected_task();
-				m_taskMutex->unlock();
-				if (t) {
-					return t;
-				}
+	for (size_t i = 0; i < m_tasks.size();) {
+		if (!m_tasks[i]) {
+			m_tasks[i] = std::move(m_tasks.back());
+			m_tasks.pop_back();
+		}
+		else {
+			++i;
+		}
+	}
+
+	// the owner pops from the newest end of its deque, so the highest priority goes in last.
+	const bool found = !released.empty();
+	for (size_t i = released.size(); i-- > 0;) {
+		push_ready_task(std::move(released[i]));
+	}
+	released.clear();
+	return found;
+}
+
+void rynx::scheduler::context::assign_priority(task& t) const {
+	if (m_critical_path && !t.m_priority_manual) {
+		t.m_priority = m_critical_path->priority_of(t.m_name);
+		t.m_on_critical_path = m_critical_path->on_critical_path(t.m_name);
+	}
+}
+
+void rynx::scheduler::context::prioritized_task_released(const task& t) {
+	if (t.m_priority_manual) {
+		m_prioritized_waiting.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+void rynx::scheduler::context::frame_completed() {
+	if (m_critical_path) {
+		m_critical_path->end_frame();
+	}
+}
+
+void rynx::scheduler::context::enable_critical_path_priorities(bool enabled) {
+	if (!enabled) {
+		m_critical_path_priorities.store(false);
+		m_critical_path.reset();
+		return;
+	}
+
+	if (!m_critical_path) {
+		m_critical_path = rynx::make_unique<critical_path_tracker>(m_ready_tasks.size());
+	}
+	m_critical_path_priorities.store(true);
+}
+
+rynx::scheduler::task rynx::scheduler::context::findWork() {
+	rynx_profile("Profiler", "Find work self");
+	for (;;) {
+		task t;
+		while (pop_ready_task(t)) {
+			if (!t.is_for_each()) {
+				return t;
+			}
+			
+			task work = start_for_each(std::move(t));
+			if (work) {
+				return work;
 			}
 		}
-	} while (!m_tasks_parallel_for.empty() | task_was_completed);
 
-	return {};
+		bool task_was_completed = false;
+		bool task_was_released = release_waiting_tasks(task_was_completed);
+		if (!task_was_released && !task_was_completed && !has_ready_tasks()) {
+			return {};
+		}
+	}
 }
 
 rynx::scheduler::task_token rynx::scheduler::context::add_task(task task) {
 	return task_token(std::move(task));
 }
 
-bool rynx::scheduler::context::resourcesAvailableFor(const task& t) const {
-	int resources_in_use = 0;
-	for (uint64_t readResource : t.resources().read_requirements()) {
-		resources_in_use += m_resource_counters[readResource].writers.load();
+// merged per resource so that a task does not conflict with itself.
+struct rynx::scheduler::context::resource_claim {
+	std::atomic<uint64_t>* state;
+	uint64_t units;
+	uint64_t conflicts;
+};
+
+void rynx::scheduler::context::merge_claims(std::vector<resource_claim>& claims) {
+	std::sort(claims.begin(), claims.end(), [](const resource_claim& a, const resource_claim& b) { return a.state < b.state; });
+	size_t merged = 0;
+	for (size_t i = 0; i < claims.size(); ++i) {
+		if (merged > 0 && claims[merged - 1].state == claims[i].state) {
+			claims[merged - 1].units += claims[i].units;
+			claims[merged - 1].conflicts |= claims[i].conflicts;
+		}
+		else {
+			claims[merged++] = claims[i];
+		}
 	}
-	for (uint64_t writeResource : t.resources().write_requirements()) {
-		resources_in_use += m_resource_counters[writeResource].writers.load();
-		resources_in_use += m_resource_counters[writeResource].readers.load();
+	claims.resize(merged);
+}
+
+// reserves every claim, or none. a failed attempt undoes its partial reservation, which other threads
+// may see as a brief false conflict, but nobody ever waits for a partial reservation to complete.
+bool rynx::scheduler::context::try_claim_all(const std::vector<resource_claim>& claims) {
+	for (size_t i = 0; i < claims.size(); ++i) {
+		const resource_claim& claim = claims[i];
+		uint64_t current = claim.state->load(std::memory_order_relaxed);
+		do {
+			if (current & claim.conflicts) {
+				for (size_t k = 0; k < i; ++k) {
+					claims[k].state->fetch_sub(claims[k].units, std::memory_order_release);
+				}
+				return false;
+			}
+		} while (!claim.state->compare_exchange_weak(current, current + claim.units, std::memory_order_acquire, std::memory_order_relaxed));
 	}
-	return resources_in_use == 0;
+	return true;
+}
+
+void rynx::scheduler::context::collect_claims(const operation_resources& resources, std::vector<resource_claim>& claims) {
+	claims.clear();
+	auto add = [&claims](resource_state& counter, uint64_t units, uint64_t conflicts) {
+		claims.emplace_back(resource_claim{ &counter.state, units, conflicts });
+	};
+	for (uint64_t readResource : resources.read_requirements()) {
+		add(m_resource_counters[readResource], resource_state::reader, resource_state::read_conflicts);
+	}
+	for (uint64_t writeResource : resources.write_requirements()) {
+		add(m_resource_counters[writeResource], resource_state::writer, resource_state::write_conflicts);
+	}
+	for (uint64_t readResource : resources.scoped_read_requirements()) {
+		add(m_resource_counters[readResource], resource_state::scoped_reader, resource_state::scoped_read_conflicts);
+	}
+	for (uint64_t writeResource : resources.scoped_write_requirements()) {
+		add(m_resource_counters[writeResource], resource_state::scoped_writer, resource_state::scoped_write_conflicts);
+	}
+	merge_claims(claims);
+}
+
+bool rynx::scheduler::context::try_reserve_resources(task& t) {
+	thread_local std::vector<resource_claim> claims; // kept around so that its capacity is reused.
+	collect_claims(t.resources(), claims);
+	if (!try_claim_all(claims)) {
+		return false;
+	}
+
+	if (t.resources().category_scopes().empty()) {
+		return true;
+	}
+
+	// scoped tasks also read the ecs, and now hold that read. so no task that can change categories is running,
+	// and none can start before these categories are reserved or the reservation is undone.
+	auto& category_reads = t.resources().category_read_requirements();
+	auto& category_writes = t.resources().category_write_requirements();
+	category_reads.clear();
+	category_writes.clear();
+	const rynx::ecs& ecs = get_resource<rynx::ecs>();
+	for (const auto* scope : t.resources().category_scopes()) {
+		ecs.category_resource_ids(scope->include, scope->exclude, scope->write ? category_writes : category_reads);
+	}
+
+	thread_local std::vector<resource_claim> category_claims;
+	category_claims.clear();
+	for (uint64_t category : category_reads) {
+		category_claims.emplace_back(resource_claim{ &category_counter(category).state, resource_state::reader, resource_state::writers });
+	}
+	for (uint64_t category : category_writes) {
+		category_claims.emplace_back(resource_claim{ &category_counter(category).state, resource_state::writer, resource_state::writers | resource_state::readers });
+	}
+	merge_claims(category_claims);
+	if (try_claim_all(category_claims)) {
+		return true;
+	}
+
+	category_reads.clear();
+	category_writes.clear();
+	for (const auto& claim : claims) {
+		claim.state->fetch_sub(claim.units, std::memory_order_release);
+	}
+	return false;
+}
+
+bool rynx::scheduler::context::resourcesAvailableFor(const task& t) {
+	thread_local std::vector<resource_claim> claims;
+	collect_claims(t.resources(), claims);
+	for (const auto& claim : claims) {
+		if (claim.state->load() & claim.conflicts) {
+			return false;
+		}
+	}
+	return true;
 }
 
 void rynx::scheduler::context::schedule_task(task task) {
 	++m_task_counter;
 	++m_tasks_per_frame;
 
-	if (task.resources().empty() && task.barriers().can_start())
+	task_graph* recording = m_recording.load(std::memory_order_relaxed);
+	if (recording && m_recording_thread == rynx::this_thread::id()) [[unlikely]] {
+		recording->record(task);
+	}
+	assign_priority(task);
+	if (task.m_priority_manual) {
+		m_prioritized_waiting.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// with priorities, every task goes through the waiting list so that it is released in priority order.
+	// otherwise a task that can start right away reserves its resources here, without the task mutex.
+	if (!uses_priorities() && task.barriers().can_start() && try_reserve_resources(task))
 	{
-		m_tasks_parallel_for.enque(std::move(task));
+		push_ready_task(std::move(task));
 	}
 	else
 	{
@@ -153,6 +420,82 @@ void rynx::scheduler::context::schedule_task(task task) {
 	}
 }
 
+void rynx::scheduler::context::release_barrier(const barrier& bar) {
+	bar.counter->fetch_sub(1);
+	wake_up_worker(); // workers may all be sleeping while tasks wait for the barrier.
+}
+
+// not using wake_up_sleeping_workers, since it is profiled and profiling is only available in rynx threads.
+void rynx::scheduler::context::wake_up_worker() {
+	for (auto* worker : m_scheduler->m_threads) {
+		if (worker->wake_up()) {
+			return;
+		}
+	}
+}
+
+void rynx::scheduler::context::begin_recording(task_graph& graph) {
+	rynx_assert(m_recording.load() == nullptr, "already recording a task graph");
+	graph.clear();
+	m_recording_thread = rynx::this_thread::id();
+	m_recording.store(&graph, std::memory_order_release);
+}
+
+void rynx::scheduler::context::end_recording() {
+	task_graph* graph = m_recording.exchange(nullptr);
+	rynx_assert(graph != nullptr, "end_recording called without begin_recording");
+	graph->compile();
+}
+
+void rynx::scheduler::context::replay(const task_graph& graph) {
+	rynx_profile("Profiler", "Replay task graph");
+
+	// all blockers are counted before any task is released, so that no task can observe a partially counted barrier.
+	for (size_t i = 0; i < graph.m_barriers.size(); ++i) {
+		if (graph.m_blocker_counts[i] != 0) {
+			graph.m_barriers[i].counter->fetch_add(graph.m_blocker_counts[i]);
+		}
+	}
+
+	m_task_counter += int32_t(graph.m_nodes.size());
+	m_tasks_per_frame += int32_t(graph.m_nodes.size());
+
+	thread_local std::vector<task> waiting; // kept around so that its capacity is reused.
+	for (const auto& recorded : graph.m_nodes) {
+		task t(*this, recorded.name);
+		t.m_op = recorded.op;
+		t.m_enable_logging = recorded.enable_logging;
+		t.m_priority = recorded.priority;
+		t.m_priority_manual = recorded.priority_manual;
+		assign_priority(t);
+		t.resources() = recorded.resources;
+		for (uint32_t bar : recorded.waits_for) {
+			t.barriers().depends_on(graph.m_barriers[bar]);
+		}
+		for (uint32_t bar : recorded.blocks) {
+			t.barriers().required_for_precounted(graph.m_barriers[bar]);
+		}
+
+		if (t.m_priority_manual) {
+			m_prioritized_waiting.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (recorded.starts_ready && !uses_priorities()) {
+			push_ready_task(std::move(t));
+		}
+		else {
+			waiting.emplace_back(std::move(t));
+		}
+	}
+
+	{
+		std::scoped_lock lock(*m_taskMutex);
+		for (auto& t : waiting) {
+			m_tasks.emplace_back(std::move(t));
+		}
+	}
+	waiting.clear();
+}
 
 // since logmsg doesn't output anything in retail builds, we use iostream for dumping the context state.
 #include <iostream>
@@ -166,14 +509,11 @@ void rynx::scheduler::context::dump() {
 		task.barriers().dump();
 	}
 
-	while (!m_tasks_parallel_for.empty()) {
-		task t;
-		m_tasks_parallel_for.deque(t);
-		if (t.is_for_each()) {
-			std::cout << "for each (" << t.name() << ")\n\tno work available: " << t.for_each_no_work_available() << "\n\tall work done: " << t.for_each_all_work_completed() << "\n";
-		}
-		else {
-			std::cout << "free task: " << t.name() << "\n";
-		}
+	for (auto&& task : m_tasks_completing) {
+		std::cout << "for each (" << task.name() << ")\n\tno work available: " << task.for_each_no_work_available() << "\n\tall work done: " << task.for_each_all_work_completed() << "\n";
+	}
+
+	for (size_t i = 0; i < m_ready_tasks.size(); ++i) {
+		std::cout << "thread " << i << ": " << m_ready_tasks[i]->size() << " ready tasks\n";
 	}
 }
@@ -2,12 +2,13 @@
 #pragma once
 
 #include <rynx/scheduler/barrier.hpp>
+#include <rynx/scheduler/critical_path.hpp>
 #include <rynx/std/unordered_map.hpp>
 #include <rynx/thread/object_storage.hpp>
 #include <rynx/ecs/ecs.hpp>
 #include <rynx/math/random.hpp>
 
-#include <rynx/tech/parallel/queue.hpp>
+#include <rynx/tech/parallel/work_stealing_deque.hpp>
 #include <rynx/tech/binary_config.hpp>
 
 #include <atomic>
@@ -24,6 +25,7 @@ namespace rynx {
 		class task_scheduler;
 		class scoped_barrier_after;
 		class scoped_barrier_before;
+		class task_graph;
 
 		class SchedulerDLL context {
 			friend class rynx::scheduler::task_token;
@@ -37,21 +39,44 @@ namespace rynx {
 			
 			context_id m_id;
 			
-			struct resource_state {
-				alignas(std::hardware_destructive_interference_size) std::atomic<int> readers = 0;
-				alignas(std::hardware_destructive_interference_size) std::atomic<int> writers = 0;
+			// the readers and writers of one resource packed in one word, so that an access can be checked and reserved with
+			// a single compare and swap. each counter has 16 bits. padded so that hot resources do not share cache lines.
+			struct alignas(std::hardware_destructive_interference_size) resource_state {
+				static constexpr uint64_t reader = uint64_t(1);
+				static constexpr uint64_t writer = uint64_t(1) << 16;
+				static constexpr uint64_t scoped_reader = uint64_t(1) << 32; // tasks that access the resource only in some ecs categories. see rynx::ecs::scoped_view.
+				static constexpr uint64_t scoped_writer = uint64_t(1) << 48;
+
+				// all bits of each counter.
+				static constexpr uint64_t readers = reader * 0xFFFF;
+				static constexpr uint64_t writers = writer * 0xFFFF;
+				static constexpr uint64_t scoped_readers = scoped_reader * 0xFFFF;
+				static constexpr uint64_t scoped_writers = scoped_writer * 0xFFFF;
+
+				// an access can not start while any of the counters it conflicts with is non-zero.
+				// scoped accesses only conflict with unscoped accesses at type level. between each other they conflict per category.
+				static constexpr uint64_t read_conflicts = writers | scoped_writers;
+				static constexpr uint64_t write_conflicts = ~uint64_t(0);
+				static constexpr uint64_t scoped_read_conflicts = writers;
+				static constexpr uint64_t scoped_write_conflicts = writers | readers;
+
+				std::atomic<uint64_t> state = 0;
 
 				resource_state() = default;
-				resource_state(resource_state&& other) noexcept :
-					readers(other.readers.load()),
-					writers(other.writers.load())
-				{}
-
+				resource_state(resource_state&& other) noexcept : state(other.state.load()) {}
 				resource_state& operator = (resource_state&& other) noexcept {
-					readers.store(other.readers.load());
-					writers.store(other.writers.load());
+					state.store(other.state.load());
 					return *this;
 				}
+
+				bool in_use() const {
+					return (state.load() & (readers | writers)) != 0;
+				}
+
+				void release(uint64_t unit) {
+					[[maybe_unused]] uint64_t previous = state.fetch_sub(unit, std::memory_order_release);
+					rynx_assert((previous & (unit * 0xFFFF)) != 0, "releasing a resource that is not reserved");
+				}
 			};
 
 			template<typename T>
@@ -68,6 +93,13 @@ namespace rynx {
 				}
 			};
 
+			template<typename With, typename Without, typename...Args>
+			struct resource_getter<rynx::ecs::scoped_view<With, Without, Args...>> {
+				rynx::ecs& operator()(context* context_) {
+					return context_->get_resource<rynx::ecs>();
+				}
+			};
+
 			template<typename...Args>
 			struct resource_getter<rynx::ecs::edit_view<Args...>> {
 				rynx::ecs& operator()(context* context_) {
@@ -88,53 +120,105 @@ namespace rynx {
 			std::atomic<int32_t> m_task_counter = 0;
 			std::atomic<int32_t> m_tasks_per_frame = 0;
 
-			std::vector<task> m_tasks;
-			rynx::parallel::queue<task, 1024> m_tasks_parallel_for;
+			// tasks ready to run. one deque per rynx thread id, the owner pushes and pops, others steal.
+			std::vector<rynx::unique_ptr<rynx::parallel::work_stealing_deque<task*>>> m_ready_tasks;
+
+			// ready tasks pushed by rynx threads that have no deque here, such as workers of another scheduler.
+			// protected by m_foreignReadyMutex.
+			std::vector<task> m_foreign_ready_tasks;
+			std::atomic<uint64_t> m_foreign_ready_count = 0;
+
+			// protected by m_taskMutex.
+			std::vector<task> m_tasks; // tasks waiting for barriers or resources.
+			std::vector<task> m_tasks_completing; // parallel for tasks with all work handed out, waiting for the work in progress to finish.
 
 			std::vector<barrier> m_activeTaskBarriers; // barriers that depend on any task that is created while they are here.
 			std::vector<barrier> m_activeTaskBarriers_Dependencies; // new tasks are not allowed to run until these barriers are complete.
 			
 			std::vector<resource_state> m_resource_counters;
+			std::vector<resource_state> m_category_counters; // indexed by category resource id modulo size. collisions only cause false conflicts.
 
 			rynx::object_storage m_resources;
 			
 			std::mutex* m_taskMutex = nullptr;
+			std::mutex* m_foreignReadyMutex = nullptr;
 			task_scheduler* m_scheduler = nullptr;
 
 			rynx::binary_config m_execution_state;
 
+			// task durations of the current frame, when critical path priorities are enabled.
+			rynx::unique_ptr<critical_path_tracker> m_critical_path;
+			std::atomic<bool> m_critical_path_priorities = false;
+			std::atomic<int32_t> m_prioritized_waiting = 0; // tasks with a priority of their own in m_tasks, or on their way there.
+
+			// tasks scheduled by the recording thread are also captured here. see begin_recording.
+			std::atomic<task_graph*> m_recording = nullptr;
+			int64_t m_recording_thread = 0; // rynx::this_thread::id() of the thread that began the recording.
+
 			// TODO: hide these as private.
 		public:
 			void release_resources(const operation_resources& resources) {
 				for (uint64_t readResource : resources.read_requirements()) {
 					rynx_assert(readResource < m_resource_counters.size(), "out of bounds");
-					m_resource_counters[readResource].readers.fetch_sub(1);
+					m_resource_counters[readResource].release(resource_state::reader);
 				}
 				for (uint64_t writeResource : resources.write_requirements()) {
 					rynx_assert(writeResource < m_resource_counters.size(), "out of bounds");
-					m_resource_counters[writeResource].writers.fetch_sub(1);
+					m_resource_counters[writeResource].release(resource_state::writer);
 				}
-			}
-
-			void reserve_resources(const operation_resources& resources) {
-				for (uint64_t readResource : resources.read_requirements()) {
-					rynx_assert(readResource < m_resource_counters.size(), "out of bounds");
-					m_resource_counters[readResource].readers.fetch_add(1);
+				for (uint64_t readResource : resources.scoped_read_requirements()) {
+					m_resource_counters[readResource].release(resource_state::scoped_reader);
 				}
-				for (uint64_t writeResource : resources.write_requirements()) {
-					rynx_assert(writeResource < m_resource_counters.size(), "out of bounds");
-					m_resource_counters[writeResource].writers.fetch_add(1);
+				for (uint64_t writeResource : resources.scoped_write_requirements()) {
+					m_resource_counters[writeResource].release(resource_state::scoped_writer);
+				}
+				for (uint64_t category : resources.category_read_requirements()) {
+					category_counter(category).release(resource_state::reader);
+				}
+				for (uint64_t category : resources.category_write_requirements()) {
+					category_counter(category).release(resource_state::writer);
 				}
 			}
 
 		private:
+			resource_state& category_counter(uint64_t category_resource_id) {
+				return m_category_counters[category_resource_id % m_category_counters.size()];
+			}
+
+			// all accesses of a task to one resource counter. see try_reserve_resources.
+			struct resource_claim;
+			void collect_claims(const operation_resources& resources, std::vector<resource_claim>& claims);
+			static void merge_claims(std::vector<resource_claim>& claims);
+			static bool try_claim_all(const std::vector<resource_claim>& claims);
+
+			void push_ready_task(task t);
+			[[nodiscard]] bool pop_ready_task(task& t);
+			[[nodiscard]] bool pop_foreign_ready_task(task& t);
+			[[nodiscard]] bool has_ready_tasks() const;
+
+			[[nodiscard]] task start_for_each(task t);
+			void finish_for_each(task& t);
+			
+			// moves waiting tasks that are now allowed to run to the ready deque of this thread.
+			[[nodiscard]] bool release_waiting_tasks(bool& task_was_completed);
+			[[nodiscard]] bool release_waiting_tasks_by_priority();
+
+			void assign_priority(task& t) const;
+			void prioritized_task_released(const task& t);
+			void frame_completed();
+
 			[[nodiscard]] task findWork();
 
 		public:
 
 			rynx::binary_config& access_state() { return m_execution_state; }
 
-			[[nodiscard]] bool resourcesAvailableFor(const task& t) const;
+			// reserves all resources of the task, or none of them if any is in use. does not need the task mutex.
+			// also resolves the categories of scoped resources of the task, so that release_resources can release them.
+			[[nodiscard]] bool try_reserve_resources(task& t);
+
+			// whether the type level resources of the task are free right now. categories are not checked.
+			[[nodiscard]] bool resourcesAvailableFor(const task& t);
 
 			context(context_id id, task_scheduler* scheduler);
 			~context();
@@ -147,8 +231,7 @@ namespace rynx {
 				m_resources.set_and_discard(rynx::as_observer(t));
 				uint64_t type_id = rynx::type_index::id<std::remove_cvref_t<T>>();
 				rynx_assert(
-					m_resource_counters[type_id].readers == 0 &&
-					m_resource_counters[type_id].writers == 0,
+					!m_resource_counters[type_id].in_use(),
 					"setting a resource for scheduler context, while the previous instance of the resource is in use! not ok."
 				);
 				return *this;
@@ -158,8 +241,7 @@ namespace rynx {
 				m_resources.set_and_discard(std::move(t));
 				uint64_t type_id = rynx::type_index::id<std::remove_cvref_t<T>>();
 				rynx_assert(
-					m_resource_counters[type_id].readers == 0 &&
-					m_resource_counters[type_id].writers == 0,
+					!m_resource_counters[type_id].in_use(),
 					"setting a resource for scheduler context, while the previous instance of the resource is in use! not ok."
 				);
 				return *this;
@@ -179,16 +261,47 @@ namespace rynx {
 
 			task_token add_task(task task);
 
-			template<typename F> task_token add_task(rynx::string taskName, F&& taskOp);
+			template<typename F> task_token add_task(rynx::interned_string taskName, F&& taskOp);
 
 			void schedule_task(task task);
 			void dump();
+
+			// for work done outside of the scheduler, such as file io. the barrier stays incomplete until
+			// release_barrier is called, which can be done from any thread.
+			void hold_barrier(const barrier& bar) { ++*bar.counter; }
+			void release_barrier(const barrier& bar);
+
+			// wakes up a sleeping worker, for example after releasing a semaphore that a task is waiting for.
+			// can be called from any thread.
+			void wake_up_worker();
+
+			// captures the tasks that this thread schedules until end_recording. tasks created by running tasks
+			// are not captured, they are created again when the recorded tasks run.
+			void begin_recording(task_graph& graph);
+			void end_recording();
+
+			// schedules the tasks of a recorded graph without running the code that created them.
+			void replay(const task_graph& graph);
+
+			// measures each frame, and starts the tasks that lead the longest chains of work first in the next frame.
+			// see task::priority. call between frames.
+			void enable_critical_path_priorities(bool enabled = true);
+
+			// whether waiting tasks are released in priority order. while they are, every task goes through the waiting list,
+			// instead of starting right away when it can. true while critical path priorities are enabled, or while any task
+			// with a priority of its own is waiting.
+			bool uses_priorities() const {
+				return m_critical_path_priorities.load(std::memory_order_relaxed) || m_prioritized_waiting.load(std::memory_order_relaxed) != 0;
+			}
+
+			// longest chain of tasks in the previous frame. null unless critical path priorities are enabled.
+			const critical_path_tracker* critical_path() const { return m_critical_path.get(); }
 		};
 	}
 }
 
 #include <rynx/scheduler/task.hpp>
 
-template<typename F> rynx::scheduler::task_token rynx::scheduler::context::add_task(rynx::string taskName, F&& taskOp) {
-	return add_task(task(*this, std::move(taskName), std::forward<F>(taskOp)));
+template<typename F> rynx::scheduler::task_token rynx::scheduler::context::add_task(rynx::interned_string taskName, F&& taskOp) {
+	return add_task(task(*this, taskName, std::forward<F>(taskOp)));
 }
\ No newline at end of file
@@ -0,0 +1,13 @@
+#include <rynx/scheduler/context.hpp>
+#include <rynx/scheduler/coroutine.hpp>
+
+void rynx::scheduler::coroutine::barrier_awaiter::await_suspend(handle_t handle) {
+	rynx::scheduler::task& current = *m_promise->current;
+	auto continuation = current.extend_task_execute_sequential(current.m_name + "_co", [handle](rynx::scheduler::task& next) {
+		handle.promise().current = &next;
+		handle.resume();
+	});
+	continuation.depends_on(m_barrier);
+
+	// the continuation is scheduled when the token goes out of scope, after that this awaiter may already be destroyed.
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <rynx/scheduler/context.hpp>
+#include <rynx/scheduler/barrier.hpp>
+#include <rynx/std/pool_allocator.hpp>
+#include <rynx/system/assert.hpp>
+
+#include <coroutine>
+#include <exception>
+
+namespace rynx {
+	namespace scheduler {
+
+		// return type for task bodies that co_await. for example
+		//
+		//   context.add_task("stages", [](rynx::scheduler::task& task, my_data& data) -> rynx::scheduler::coroutine {
+		//       rynx::scheduler::task& next = co_await task.parallel().range_auto(0, n).execute(...);
+		//       co_await other_barrier;
+		//   });
+		//
+		// a co_await that can not continue right away ends the current task, and the rest of the body runs in
+		// an extension task that starts when the awaited barrier completes. no worker is held while waiting.
+		// the extension reserves the same resources as the task again before it starts, like extend_task_execute_sequential.
+		// the task& parameter is only valid until the first suspension, co_await returns the task that continues the body.
+		class SchedulerDLL coroutine {
+		public:
+			// the task body is copied for each run, and kept alive until the coroutine completes.
+			struct closure_base {
+				virtual ~closure_base() = default;
+				virtual void destroy() = 0;
+			};
+
+			template<typename F>
+			struct closure : public closure_base {
+				closure(const F& f) : f(f) {}
+				virtual void destroy() override { rynx::memory::pool_allocator::deleter<closure<F>>()(this); }
+				F f;
+			};
+
+			struct promise_type;
+			using handle_t = std::coroutine_handle<promise_type>;
+
+			// suspends until the barrier is complete.
+			struct SchedulerDLL barrier_awaiter {
+				bool await_ready() const noexcept { return static_cast<bool>(m_barrier); }
+				void await_suspend(handle_t handle);
+				rynx::scheduler::task& await_resume() const noexcept { return *m_promise->current; }
+
+				rynx::scheduler::barrier m_barrier;
+				promise_type* m_promise = nullptr;
+			};
+
+			struct promise_type {
+				~promise_type() {
+					if (body) {
+						body->destroy();
+					}
+				}
+
+				coroutine get_return_object() { return coroutine(handle_t::from_promise(*this)); }
+				std::suspend_always initial_suspend() noexcept { return {}; }
+				std::suspend_never final_suspend() noexcept { return {}; }
+				void return_void() noexcept {}
+				void unhandled_exception() noexcept {
+					rynx_assert(false, "exception thrown from a coroutine task");
+					std::terminate();
+				}
+
+				barrier_awaiter await_transform(rynx::scheduler::barrier bar) {
+					return barrier_awaiter{ std::move(bar), this };
+				}
+
+				// starts the parallel work, and suspends until all of it is complete.
+				barrier_awaiter await_transform(rynx::scheduler::task::parallel_for_operation&& op) { return await_transform(op); }
+				barrier_awaiter await_transform(rynx::scheduler::task::parallel_for_operation& op) {
+					rynx::scheduler::barrier bar = op.barrier();
+					{
+						rynx::scheduler::task::parallel_for_operation started = std::move(op);
+					}
+					return barrier_awaiter{ std::move(bar), this };
+				}
+
+				// coroutine frames are created for every run of a task, so they come from the pool as well.
+				static void* operator new(size_t bytes) { return rynx::memory::pool_allocator::detail::allocate(bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+				static void operator delete(void* ptr, size_t bytes) { rynx::memory::pool_allocator::detail::deallocate(ptr, bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+
+				rynx::scheduler::task* current = nullptr; // task running the current part of the body.
+				closure_base* body = nullptr;
+			};
+
+			coroutine(coroutine&& other) noexcept : m_handle(other.m_handle) { other.m_handle = nullptr; }
+			coroutine(const coroutine&) = delete;
+			coroutine& operator = (const coroutine&) = delete;
+			coroutine& operator = (coroutine&&) = delete;
+
+			~coroutine() {
+				if (m_handle) {
+					m_handle.destroy();
+				}
+			}
+
+			template<typename F>
+			static closure<F>* make_closure(const F& f) {
+				return rynx::memory::pool_allocator::make_unique<closure<F>>(f).release();
+			}
+
+			// runs the body until it completes or suspends. after this the coroutine owns itself,
+			// and may already be running on another worker, so it must not be touched.
+			void start(rynx::scheduler::task& current, closure_base* body) {
+				handle_t handle = m_handle;
+				m_handle = nullptr;
+				handle.promise().current = &current;
+				handle.promise().body = body;
+				handle.resume();
+			}
+
+		private:
+			coroutine(handle_t handle) : m_handle(handle) {}
+			handle_t m_handle;
+		};
+	}
+}
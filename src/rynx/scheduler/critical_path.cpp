@@ -0,0 +1,149 @@
+
+#include <rynx/scheduler/critical_path.hpp>
+#include <rynx/thread/this_thread.hpp>
+
+#include <algorithm>
+
+namespace {
+	constexpr uint32_t no_next = ~uint32_t(0);
+}
+
+rynx::scheduler::critical_path_tracker::critical_path_tracker(uint64_t thread_count) : m_threads(thread_count) {}
+
+void rynx::scheduler::critical_path_tracker::record(const rynx::interned_string& name, const operation_barriers& barriers, int64_t duration_ns) {
+	const uint64_t self = rynx::this_thread::id();
+	if (self >= m_threads.size()) {
+		return;
+	}
+
+	thread_samples& local = m_threads[self];
+	sample& s = local.samples.emplace_back();
+	s.name = name;
+	s.duration_ns = duration_ns;
+	s.first_barrier = uint32_t(local.barriers.size());
+	s.blocks = uint32_t(barriers.blocks().size());
+	s.waits_for = uint32_t(barriers.requirements().size());
+	for (const auto& bar : barriers.blocks()) {
+		local.barriers.emplace_back(bar.counter.get());
+	}
+	for (const auto& bar : barriers.requirements()) {
+		local.barriers.emplace_back(bar.counter.get());
+	}
+}
+
+void rynx::scheduler::critical_path_tracker::end_frame() {
+	// nodes are the task runs followed by the barriers. a task leads to the barriers it blocks,
+	// and a barrier leads to the tasks that wait for it.
+	m_nodes.clear();
+	m_barrier_ids.clear();
+	for (const auto& local : m_threads) {
+		for (const auto& s : local.samples) {
+			m_nodes.emplace_back(&s);
+		}
+		m_barrier_ids.insert(m_barrier_ids.end(), local.barriers.begin(), local.barriers.end());
+	}
+	std::sort(m_barrier_ids.begin(), m_barrier_ids.end());
+	m_barrier_ids.erase(std::unique(m_barrier_ids.begin(), m_barrier_ids.end()), m_barrier_ids.end());
+
+	const uint32_t task_count = uint32_t(m_nodes.size());
+	const uint32_t node_count = task_count + uint32_t(m_barrier_ids.size());
+	auto barrier_node = [this, task_count](const void* id) {
+		return task_count + uint32_t(std::lower_bound(m_barrier_ids.begin(), m_barrier_ids.end(), id) - m_barrier_ids.begin());
+	};
+
+	m_edges.clear();
+	{
+		uint32_t node = 0;
+		for (const auto& local : m_threads) {
+			for (const auto& s : local.samples) {
+				const void* const* ids = local.barriers.data() + s.first_barrier;
+				for (uint32_t i = 0; i < s.blocks; ++i) {
+					m_edges.emplace_back(node, barrier_node(ids[i]));
+				}
+				for (uint32_t i = s.blocks; i < s.blocks + s.waits_for; ++i) {
+					m_edges.emplace_back(barrier_node(ids[i]), node);
+				}
+				++node;
+			}
+		}
+	}
+	std::sort(m_edges.begin(), m_edges.end());
+
+	m_edge_offsets.assign(node_count + 1, 0);
+	m_incoming.assign(node_count, 0);
+	for (const auto& edge : m_edges) {
+		++m_edge_offsets[edge.first + 1];
+		++m_incoming[edge.second];
+	}
+	for (uint32_t i = 0; i < node_count; ++i) {
+		m_edge_offsets[i + 1] += m_edge_offsets[i];
+	}
+
+	// kahn's algorithm, then longest paths from the back. nodes in cycles are never ordered and keep their own length.
+	m_order.clear();
+	for (uint32_t i = 0; i < node_count; ++i) {
+		if (m_incoming[i] == 0) {
+			m_order.emplace_back(i);
+		}
+	}
+	for (size_t i = 0; i < m_order.size(); ++i) {
+		for (uint32_t e = m_edge_offsets[m_order[i]]; e < m_edge_offsets[m_order[i] + 1]; ++e) {
+			if (--m_incoming[m_edges[e].second] == 0) {
+				m_order.emplace_back(m_edges[e].second);
+			}
+		}
+	}
+
+	m_length.assign(node_count, 0);
+	m_next.assign(node_count, no_next);
+	for (uint32_t i = 0; i < task_count; ++i) {
+		m_length[i] = m_nodes[i]->duration_ns;
+	}
+	for (size_t i = m_order.size(); i-- > 0;) {
+		const uint32_t node = m_order[i];
+		int64_t longest_after = 0;
+		for (uint32_t e = m_edge_offsets[node]; e < m_edge_offsets[node + 1]; ++e) {
+			const uint32_t next = m_edges[e].second;
+			if (m_next[node] == no_next || m_length[next] > longest_after) {
+				longest_after = m_length[next];
+				m_next[node] = next;
+			}
+		}
+		m_length[node] += longest_after;
+	}
+
+	// the same task may run many times in a frame, for example parallel for work. the longest run counts.
+	m_tasks.clear();
+	uint32_t first = no_next;
+	for (uint32_t i = 0; i < task_count; ++i) {
+		task_info& info = m_tasks[m_nodes[i]->name.c_str()];
+		info.priority = std::max(info.priority, uint32_t((m_length[i] + 999) / 1000));
+		if (first == no_next || m_length[i] > m_length[first]) {
+			first = i;
+		}
+	}
+
+	m_path.clear();
+	m_length_ns = first == no_next ? 0 : m_length[first];
+	for (uint32_t node = first; node != no_next; node = m_next[node]) {
+		if (node < task_count) {
+			m_path.emplace_back(entry{ m_nodes[node]->name, m_nodes[node]->duration_ns });
+			m_tasks[m_nodes[node]->name.c_str()].on_path = true;
+		}
+	}
+
+	for (auto& local : m_threads) {
+		local.samples.clear();
+		local.barriers.clear();
+	}
+}
+
+uint32_t rynx::scheduler::critical_path_tracker::priority_of(const rynx::interned_string& name) const {
+	auto it = m_tasks.find(name.c_str());
+	return it == m_tasks.end() ? 0 : it->second.priority;
+}
+
+bool rynx::scheduler::critical_path_tracker::on_critical_path(const rynx::interned_string& name) const {
+	auto it = m_tasks.find(name.c_str());
+	return it != m_tasks.end() && it->second.on_path;
+}
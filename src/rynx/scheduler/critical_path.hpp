@@ -0,0 +1,75 @@
+#pragma once
+
+#include <rynx/scheduler/barrier.hpp>
+#include <rynx/std/interned_string.hpp>
+#include <rynx/std/unordered_map.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace rynx {
+	namespace scheduler {
+
+		// measures the durations of tasks and the barriers between them during a frame, and finds the longest
+		// chain of tasks through the barrier graph when the frame is complete. the length of the longest chain
+		// starting from a task is that task's priority in the next frame.
+		class SchedulerDLL critical_path_tracker {
+		public:
+			struct entry {
+				rynx::interned_string name;
+				int64_t duration_ns = 0;
+			};
+
+			critical_path_tracker(uint64_t thread_count);
+
+			// called on the thread that ran the task, before the task is counted as finished.
+			void record(const rynx::interned_string& name, const operation_barriers& barriers, int64_t duration_ns);
+
+			// computes priorities from the tasks recorded since the previous call.
+			void end_frame();
+
+			// length of the longest chain starting from a task by this name in the previous frame, in microseconds.
+			// zero for tasks that did not run in the previous frame.
+			uint32_t priority_of(const rynx::interned_string& name) const;
+			bool on_critical_path(const rynx::interned_string& name) const;
+
+			// tasks of the longest chain in the previous frame, in execution order.
+			const std::vector<entry>& path() const { return m_path; }
+			int64_t length_ns() const { return m_length_ns; }
+
+		private:
+			struct sample {
+				rynx::interned_string name;
+				int64_t duration_ns;
+				uint32_t first_barrier; // index to thread_samples::barriers. blocked barriers first, then required ones.
+				uint32_t blocks;
+				uint32_t waits_for;
+			};
+
+			struct alignas(64) thread_samples {
+				std::vector<sample> samples;
+				std::vector<const void*> barriers;
+			};
+
+			struct task_info {
+				uint32_t priority = 0;
+				bool on_path = false;
+			};
+
+			std::vector<thread_samples> m_threads;
+			rynx::unordered_map<const char*, task_info> m_tasks; // by interned name.
+			std::vector<entry> m_path;
+			int64_t m_length_ns = 0;
+
+			// graph of the frame being processed. kept around so that their capacity is reused.
+			std::vector<const sample*> m_nodes;
+			std::vector<const void*> m_barrier_ids;
+			std::vector<std::pair<uint32_t, uint32_t>> m_edges;
+			std::vector<uint32_t> m_edge_offsets;
+			std::vector<uint32_t> m_incoming;
+			std::vector<uint32_t> m_order;
+			std::vector<int64_t> m_length;
+			std::vector<uint32_t> m_next;
+		};
+	}
+}
@@ -0,0 +1,135 @@
+
+#include <rynx/scheduler/context.hpp>
+#include <rynx/scheduler/fiber_pool.hpp>
+#include <rynx/thread/fiber.hpp>
+#include <rynx/system/assert.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+struct rynx::scheduler::fiber_pool::slot {
+	slot(size_t stack_size) : fiber(stack_size) {}
+
+	Fiber fiber;
+	rynx::scheduler::task current;
+	ready_check ready; // set while blocked.
+	bool blocked = false;
+	bool started = false;
+};
+
+struct rynx::scheduler::fiber_pool::state {
+	size_t stack_size = 0;
+	std::mutex mutex;
+	std::vector<rynx::unique_ptr<slot>> slots;
+	std::vector<slot*> free;
+	std::vector<slot*> blocked;
+	std::atomic<uint32_t> blocked_count = 0;
+};
+
+namespace {
+	// slot the calling worker is running. the task on it may continue on another thread after blocking,
+	// so this is only read before switching away.
+	thread_local void* t_running = nullptr;
+}
+
+rynx::scheduler::fiber_pool::fiber_pool(size_t stack_size) : m_state(rynx::make_opaque_unique_ptr<state>()) {
+	m_state->stack_size = stack_size;
+}
+
+rynx::scheduler::fiber_pool::~fiber_pool() {
+	rynx_assert(m_state->blocked.empty(), "fiber pool destroyed while tasks are blocked");
+}
+
+rynx::scheduler::fiber_pool::slot* rynx::scheduler::fiber_pool::acquire() {
+	{
+		std::scoped_lock lock(m_state->mutex);
+		if (!m_state->free.empty()) {
+			slot* fiber = m_state->free.back();
+			m_state->free.pop_back();
+			return fiber;
+		}
+	}
+
+	// stacks are kept for the lifetime of the pool, so new ones are only mapped until the pool covers
+	// the largest number of tasks blocked at the same time.
+	auto created = rynx::make_unique<slot>(m_state->stack_size);
+	slot* fiber = created.get();
+	std::scoped_lock lock(m_state->mutex);
+	m_state->slots.emplace_back(std::move(created));
+	m_state->free.reserve(m_state->slots.size());
+	m_state->blocked.reserve(m_state->slots.size());
+	return fiber;
+}
+
+void rynx::scheduler::fiber_pool::switch_to(slot* fiber) {
+	t_running = fiber;
+	if (!fiber->started) {
+		fiber->started = true;
+		fiber->fiber.go([fiber](Fiber*) {
+			fiber->current.run();
+			fiber->current.clear();
+		});
+	}
+	else {
+		fiber->fiber.resume();
+	}
+	t_running = nullptr;
+
+	// the fiber has switched out, so now it is safe to let another worker resume it.
+	std::scoped_lock lock(m_state->mutex);
+	if (fiber->blocked) {
+		m_state->blocked.emplace_back(fiber);
+		m_state->blocked_count.fetch_add(1);
+	}
+	else {
+		m_state->free.emplace_back(fiber);
+	}
+}
+
+void rynx::scheduler::fiber_pool::run(task&& t) {
+	slot* fiber = acquire();
+	fiber->current = std::move(t);
+	switch_to(fiber);
+}
+
+rynx::scheduler::fiber_pool::slot* rynx::scheduler::fiber_pool::take_ready() {
+	if (m_state->blocked_count.load(std::memory_order_relaxed) == 0) {
+		return nullptr;
+	}
+
+	std::scoped_lock lock(m_state->mutex);
+	auto& blocked = m_state->blocked;
+	for (size_t i = 0; i < blocked.size(); ++i) {
+		if (blocked[i]->ready()) {
+			slot* fiber = blocked[i];
+			blocked[i] = blocked.back();
+			blocked.pop_back();
+			m_state->blocked_count.fetch_sub(1);
+			return fiber;
+		}
+	}
+	return nullptr;
+}
+
+void rynx::scheduler::fiber_pool::resume(slot* fiber) {
+	fiber->blocked = false;
+	fiber->ready = nullptr;
+	switch_to(fiber);
+}
+
+bool rynx::scheduler::fiber_pool::block_until(ready_check& ready) {
+	slot* fiber = static_cast<slot*>(t_running);
+	if (!fiber) {
+		return false;
+	}
+
+	if (ready()) {
+		return true;
+	}
+
+	fiber->ready = std::move(ready);
+	fiber->blocked = true;
+	fiber->fiber.yield();
+	return true;
+}
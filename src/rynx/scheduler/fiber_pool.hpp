@@ -0,0 +1,45 @@
+#pragma once
+
+#include <rynx/std/function.hpp>
+#include <rynx/std/memory.hpp>
+
+#include <cstddef>
+
+namespace rynx {
+	namespace scheduler {
+		class task;
+
+		// runs tasks on pooled fibers, so that a task can block in the middle of its body. a blocked task keeps
+		// its fiber and its resources, and the worker continues with other work on another fiber.
+		// any worker can resume the blocked task once it can continue.
+		class SchedulerDLL fiber_pool {
+		public:
+			using ready_check = rynx::function_inplace<64, true, bool()>;
+			struct slot;
+
+			fiber_pool(size_t stack_size);
+			~fiber_pool();
+
+			// runs the task on a free fiber. returns when the task has completed or blocks.
+			void run(task&& t);
+
+			// takes one blocked task that can continue. returns null if there is none.
+			slot* take_ready();
+
+			// continues a task from take_ready. returns when the task has completed or blocks again.
+			void resume(slot* fiber);
+
+			// blocks the task running on the current fiber until ready returns true.
+			// returns false without blocking if the calling thread is not running a pooled fiber.
+			static bool block_until(ready_check& ready);
+
+		private:
+			struct state;
+
+			slot* acquire();
+			void switch_to(slot* fiber);
+
+			rynx::opaque_unique_ptr<state> m_state;
+		};
+	}
+}
@@ -3,6 +3,9 @@
 #include <rynx/scheduler/task.hpp>
 #include <rynx/scheduler/task_scheduler.hpp>
 #include <rynx/profiling/profiling.hpp>
+#include <rynx/thread/semaphore.hpp>
+
+#include <thread>
 
 rynx::scheduler::task* rynx::scheduler::task_token::operator -> () { return m_pTask.get(); }
 rynx::scheduler::task_token::~task_token() {
@@ -11,7 +14,7 @@ rynx::scheduler::task_token::~task_token() {
 }
 
 rynx::scheduler::task_token::task_token(task&& task) {
-	m_pTask = rynx::make_unique<rynx::scheduler::task>(std::move(task));
+	m_pTask = rynx::memory::pool_allocator::make_unique<rynx::scheduler::task>(std::move(task));
 }
 
 rynx::scheduler::task_token& rynx::scheduler::task_token::depends_on(task& other) {
@@ -38,6 +41,11 @@ rynx::scheduler::task_token& rynx::scheduler::task_token::required_for(barrier b
 	return *this;
 }
 
+rynx::scheduler::task_token& rynx::scheduler::task_token::priority(uint32_t value) {
+	m_pTask->priority(value);
+	return *this;
+}
+
 rynx::scheduler::task& rynx::scheduler::task_token::operator * () {
 	return *m_pTask;
 }
@@ -47,29 +55,44 @@ rynx::scheduler::task_token& rynx::scheduler::task_token::operator | (task_token
 	return other;
 }
 
+void rynx::scheduler::task::run_op() {
+	rynx_profile("Scheduler", "work");
+	if (m_on_critical_path) {
+		// the chain that bounded the previous frame can be followed in its own profiler category.
+		rynx_profile("Critical path", m_name);
+		m_op(this);
+	}
+	else {
+		m_op(this);
+	}
+}
+
 void rynx::scheduler::task::run() {
 	rynx_profile("Scheduler", m_name);
 	rynx_assert(static_cast<bool>(m_op), "no op in task that is being run!");
 	rynx_assert(m_barriers->can_start(), "task is being run while still blocked by barriers!");
 
+	critical_path_tracker* tracker = m_context->m_critical_path.get();
+	const auto start_time = tracker ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
 	if(!is_for_each())
 	{
 		if (m_enable_logging) {
 			logmsg("start %s", m_name.c_str());
 		}
 		
-		{
-			rynx_profile("Scheduler", "work");
-			m_op(this);
-		}
+		run_op();
 
 		if (m_enable_logging) {
 			logmsg("end %s", m_name.c_str());
 		}
 	}
 	else {
-		rynx_profile("Scheduler", "work");
-		m_op(this);
+		run_op();
+	}
+
+	if (tracker) {
+		tracker->record(m_name, *m_barriers, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count());
 	}
 
 	{
@@ -107,13 +130,16 @@ rynx::scheduler::task& rynx::scheduler::task::operator | (task_token& other) {
 rynx::scheduler::task::task(const task& other) {
 	m_name = other.m_name;
 	m_op = other.m_op;
-	m_barriers = rynx::make_shared<operation_barriers>(*other.m_barriers);
+	m_barriers = rynx::memory::pool_allocator::make_shared<operation_barriers>(*other.m_barriers);
 
 	m_resources = other.m_resources;
 	m_resources_shared = other.m_resources_shared;
 	m_for_each = other.m_for_each;
 
 	m_context = other.m_context;
+	m_priority = other.m_priority;
+	m_priority_manual = other.m_priority_manual;
+	m_on_critical_path = other.m_on_critical_path;
 	m_enable_logging = other.m_enable_logging;
 }
 
@@ -122,6 +148,40 @@ rynx::scheduler::task rynx::scheduler::task::clone() const {
 	return copy;
 }
 
-void rynx::scheduler::task::notify_work_available() const {
-	m_context->m_scheduler->wake_up_sleeping_workers();
+void rynx::scheduler::task::notify_work_available(int64_t workers) const {
+	if (workers <= 1) {
+		m_context->m_scheduler->wake_up_sleeping_workers();
+	}
+	else {
+		m_context->m_scheduler->wake_up_workers(uint64_t(workers));
+	}
+}
+
+void rynx::scheduler::task::wait(const rynx::scheduler::barrier& bar) {
+	wait_until([bar]() { return static_cast<bool>(bar); });
+}
+
+void rynx::scheduler::task::wait(semaphore& sem) {
+	wait_until([&sem]() { return sem.try_acquire(); });
+}
+
+void rynx::scheduler::task::wait_until(fiber_pool::ready_check ready) {
+	if (fiber_pool::block_until(ready)) {
+		return;
+	}
+
+	// not running on a fiber, so other work has to run on top of this task.
+	while (!ready()) {
+		rynx::scheduler::task other = m_context->findWork();
+		if (other) {
+			other.run();
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+int64_t rynx::scheduler::task::parallelism() const {
+	return int64_t(m_context->m_scheduler->worker_count()) + 1;
 }
\ No newline at end of file
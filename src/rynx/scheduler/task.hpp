@@ -3,22 +3,30 @@
 
 #include <rynx/tech/parallel/accumulator.hpp>
 #include <rynx/ecs/ecs.hpp>
-#include <rynx/std/string.hpp>
+#include <rynx/std/interned_string.hpp>
+#include <rynx/std/pool_allocator.hpp>
 #include <rynx/scheduler/barrier.hpp>
+#include <rynx/scheduler/fiber_pool.hpp>
 #include <rynx/system/assert.hpp>
 
+#include <chrono>
+
+class semaphore;
+
 namespace rynx {
 	namespace scheduler {
 		class task_scheduler;
 		class context;
 		class task;
 		class task_token;
+		class task_graph;
+		class coroutine;
 
 		class SchedulerDLL task_token {
 		private:
 			// TODO get rid of this
-			template<typename RynxTask, typename F> static task_token silly_delayed_evaluate(rynx::string&& name, RynxTask& task, F&& f) {
-				auto followUpTask = task.m_context->add_task(std::move(name), std::forward<F>(f));
+			template<typename RynxTask, typename F> static task_token silly_delayed_evaluate(rynx::interned_string name, RynxTask& task, F&& f) {
+				auto followUpTask = task.m_context->add_task(name, std::forward<F>(f));
 				followUpTask.depends_on(task);
 				return followUpTask;
 			}
@@ -39,10 +47,11 @@ namespace rynx {
 			task_token& required_for(task& other);
 			task_token& depends_on(task_token& other) { return depends_on(*other); }
 			task_token& required_for(task_token& other) { return required_for(*other); }
+			task_token& priority(uint32_t value);
 
 			template<typename F>
-			task_token then(rynx::string name, F&& f) {
-				return this->silly_delayed_evaluate(std::move(name), *m_pTask.get(), std::forward<F>(f));
+			task_token then(rynx::interned_string name, F&& f) {
+				return this->silly_delayed_evaluate(name, *m_pTask.get(), std::forward<F>(f));
 				/*
 				auto followUpTask = m_pTask->m_context->add_task(std::move(name), std::forward<F>(f));
 				followUpTask.depends_on(*this);
@@ -53,16 +62,20 @@ namespace rynx {
 			template<typename F> task_token then(F&& f) { return then("->", std::forward<F>(f)); }
 
 		private:
-			rynx::unique_ptr<task> m_pTask;
+			rynx::memory::pool_allocator::unique_ptr<task> m_pTask;
 		};
 
 		class SchedulerDLL task {
 		private:
 			friend class rynx::scheduler::context;
 			friend class rynx::scheduler::task_token;
+			friend class rynx::scheduler::task_graph;
+			friend class rynx::scheduler::coroutine;
 
 			template<typename F> struct resource_deducer {};
 			template<typename RetVal, typename Class, typename...Args> struct resource_deducer<RetVal(Class::*)(Args...) const> {
+				using return_type = RetVal;
+
 				template<typename T>
 				struct unpack_resource {
 					void operator()(task& host) {
@@ -92,6 +105,35 @@ namespace rynx {
 					}
 				};
 
+				// types of a scoped view are reserved per category. tasks that access the same types in disjoint categories can run in parallel.
+				template<typename... Include, typename... Exclude, typename... Ts>
+				struct unpack_resource<rynx::ecs::scoped_view<rynx::ecs::with<Include...>, rynx::ecs::without<Exclude...>, Ts...>> {
+					static const operation_resources::category_scope& scope() {
+						static const operation_resources::category_scope value = []() {
+							operation_resources::category_scope result;
+							(result.include.set(rynx::type_index::id<Include>()), ...);
+							(result.exclude.set(rynx::type_index::id<Exclude>()), ...);
+							result.write = (!std::is_const_v<std::remove_reference_t<Ts>> || ...);
+							return result;
+						}();
+						return value;
+					}
+
+					void operator()(task& host) {
+						([&host]() {
+							uint64_t typeId = rynx::type_index::id<std::remove_cvref_t<Ts>>();
+							if constexpr (std::is_const_v<std::remove_reference_t<Ts>>) {
+								host.resources().require_scoped_read(typeId);
+							}
+							else {
+								host.resources().require_scoped_write(typeId);
+							}
+						}(), ...);
+						host.resources().require_category_scope(scope());
+						unpack_resource<const rynx::ecs&>()(host); // same as view. categories can not change while the task runs.
+					}
+				};
+
 				// don't mark tasks as required resources. they are unique for each task, not shared.
 				template<> struct unpack_resource<rynx::scheduler::task&> { void operator()(task&) {} };
 				template<> struct unpack_resource<const rynx::scheduler::task&> { void operator()(task&) {} };
@@ -117,20 +159,21 @@ namespace rynx {
 			template<typename RetVal, typename Class, typename...Args> struct resource_deducer<RetVal(Class::*)(Args...)> : public resource_deducer<RetVal(Class::*)(Args...) const> {};
 			
 		public:
-			// TODO: use some memory pool thing for task_resources.
-			task() : m_name("EmptyTask"), m_context(nullptr) {}
-			task(context& context, rynx::string name)
-				: m_name(std::move(name))
+			using op_t = rynx::function_inplace<96, true, void(rynx::scheduler::task*)>; // task closures up to the buffer size are stored without allocating.
+
+			task() : m_name(empty_task_name()), m_context(nullptr) {}
+			task(context& context, rynx::interned_string name)
+				: m_name(name)
 				, m_context(&context)
-				, m_barriers(rynx::make_shared<rynx::scheduler::operation_barriers>())
-				, m_resources(rynx::make_shared<task_resources>(&context))
+				, m_barriers(rynx::memory::pool_allocator::make_shared<rynx::scheduler::operation_barriers>())
+				, m_resources(rynx::memory::pool_allocator::make_shared<task_resources>(&context))
 			{}
 			
-			template<typename F> task(context& context, rynx::string taskName, F&& op)
-				: m_name(std::move(taskName))
+			template<typename F> task(context& context, rynx::interned_string taskName, F&& op)
+				: m_name(taskName)
 				, m_context(&context)
-				, m_barriers(rynx::make_shared<rynx::scheduler::operation_barriers>())
-				, m_resources(rynx::make_shared<task_resources>(&context)) {
+				, m_barriers(rynx::memory::pool_allocator::make_shared<rynx::scheduler::operation_barriers>())
+				, m_resources(rynx::memory::pool_allocator::make_shared<task_resources>(&context)) {
 				set(std::forward<F>(op));
 			}
 
@@ -183,7 +226,7 @@ namespace rynx {
 			task& operator | (task_token& other);
 
 			// TODO: Rename all task creation functions.
-			template<typename F> task_token make_task(rynx::string name, F&& op) {
+			template<typename F> task_token make_task(rynx::interned_string name, F&& op) {
 				task_token t = m_context->add_task(name, std::forward<F>(op));
 				t->m_enable_logging = m_enable_logging;
 				return t;
@@ -192,8 +235,8 @@ namespace rynx {
 				return make_task("task", std::forward<F>(op));
 			}
 
-			template<typename F> task_token extend_task_independent(rynx::string name, F&& op) {
-				task_token followUpTask = m_context->add_task(std::move(name), std::forward<F>(op));
+			template<typename F> task_token extend_task_independent(rynx::interned_string name, F&& op) {
+				task_token followUpTask = m_context->add_task(name, std::forward<F>(op));
 				completion_blocked_by(*followUpTask);
 				followUpTask->m_enable_logging = m_enable_logging;
 				return followUpTask;
@@ -201,25 +244,25 @@ namespace rynx {
 
 			template<typename F> task_token extend_task_independent(F&& op) { return extend_task_independent(m_name + "_e", std::forward<F>(op)); }
 			
-			template<typename F> task_token make_extension_task_execute_sequential(rynx::string name, F&& op) {
-				task_token followUpTask = m_context->add_task(std::move(name), std::forward<F>(op));
+			template<typename F> task_token make_extension_task_execute_sequential(rynx::interned_string name, F&& op) {
+				task_token followUpTask = m_context->add_task(name, std::forward<F>(op));
 				completion_blocked_by(*followUpTask);
 				copy_resources(*followUpTask); // uses same resources but must reserve them individually.
 				followUpTask->m_enable_logging = m_enable_logging;
 				return followUpTask;
 			}
 			
-			template<typename F> task_token make_extension_task_execute_parallel(rynx::string name, F&& op) {
-				task_token followUpTask = m_context->add_task(std::move(name), std::forward<F>(op));
+			template<typename F> task_token make_extension_task_execute_parallel(rynx::interned_string name, F&& op) {
+				task_token followUpTask = m_context->add_task(name, std::forward<F>(op));
 				completion_blocked_by(*followUpTask);
 				share_resources(*followUpTask); // use and extend parent reservation on resources.
 				followUpTask->m_enable_logging = m_enable_logging;
 				return followUpTask;
 			}
 
-			template<typename F> task_token extend_task_execute_parallel(rynx::string name, F&& op) { return make_extension_task_execute_parallel(std::move(name), std::forward<F>(op)); }
+			template<typename F> task_token extend_task_execute_parallel(rynx::interned_string name, F&& op) { return make_extension_task_execute_parallel(name, std::forward<F>(op)); }
 			template<typename F> task_token extend_task_execute_parallel(F&& op) { return extend_task_execute_parallel(m_name + "_es", std::forward<F>(op)); }
-			template<typename F> task_token extend_task_execute_sequential(rynx::string name, F&& op) { return make_extension_task_execute_sequential(std::move(name), std::forward<F>(op)); }
+			template<typename F> task_token extend_task_execute_sequential(rynx::interned_string name, F&& op) { return make_extension_task_execute_sequential(name, std::forward<F>(op)); }
 			template<typename F> task_token extend_task_execute_sequential(F&& op) { return extend_task_execute_sequential(m_name + "_es", std::forward<F>(op)); }
 
 			void run();
@@ -230,7 +273,7 @@ namespace rynx {
 				m_op = nullptr;
 				m_barriers.reset();
 				m_for_each.clear();
-				m_name.clear();
+				m_name = empty_task_name();
 				m_resources.reset();
 				m_resources_shared.clear();
 			}
@@ -239,6 +282,17 @@ namespace rynx {
 				m_enable_logging = true;
 			}
 
+			// among tasks that can start at the same time, higher priorities start first. with critical path priorities
+			// (see context::enable_critical_path_priorities) tasks without a priority of their own get the length of
+			// the longest chain of tasks starting from them in the previous frame, in microseconds.
+			task& priority(uint32_t value) {
+				m_priority = value;
+				m_priority_manual = true;
+				return *this;
+			}
+
+			uint32_t priority() const { return m_priority; }
+
 		private:
 
 			template<typename F>
@@ -246,12 +300,24 @@ namespace rynx {
 				resource_deducer<decltype(&std::remove_reference_t<F>::operator())>()(*this);
 				context* ctx = m_context;
 
-				// this is marked as mutable in order to support f being mutable. since it is captured here in a lambda,
-				// if this were not mutable, f would not be allowed to change itself either. 
-				m_op = [ctx, f = std::move(f)](rynx::scheduler::task* myTask) mutable {
-					auto resources = resource_deducer<decltype(&std::remove_reference_t<F>::operator())>().fetchParams(ctx, myTask);
-					std::apply(f, resources);
-				};
+				using deducer = resource_deducer<decltype(&std::remove_reference_t<F>::operator())>;
+				using return_type = typename deducer::return_type;
+				if constexpr (std::is_same_v<return_type, rynx::scheduler::coroutine>) {
+					// coroutine frame refers to the body it was created from, so the body must outlive the frame.
+					m_op = [ctx, f = std::move(f)](rynx::scheduler::task* myTask) {
+						auto* body = return_type::make_closure(f);
+						auto resources = deducer().fetchParams(ctx, myTask);
+						std::apply(body->f, resources).start(*myTask, body);
+					};
+				}
+				else {
+					// this is marked as mutable in order to support f being mutable. since it is captured here in a lambda,
+					// if this were not mutable, f would not be allowed to change itself either. 
+					m_op = [ctx, f = std::move(f)](rynx::scheduler::task* myTask) mutable {
+						auto resources = deducer().fetchParams(ctx, myTask);
+						std::apply(f, resources);
+					};
+				}
 
 				// apply current barrier states.
 				for (auto&& bar : m_context->m_activeTaskBarriers_Dependencies)
@@ -262,6 +328,12 @@ namespace rynx {
 			}
 
 			struct parallel_for_each_data {
+				// adaptive ranges aim for chunks of this duration, and do not go below the minimum to keep the atomic traffic low.
+				static constexpr float target_chunk_ns = 50'000.0f;
+				static constexpr float min_chunk_ns = 5'000.0f;
+				static constexpr int64_t probe_chunk_size = 16; // chunk size before any chunk has been timed.
+				static constexpr float min_cost_per_item_ns = 0.1f; // chunks faster than the clock resolution measure zero, which would read as not timed.
+
 				parallel_for_each_data(int64_t begin, int64_t end) noexcept : index(begin), end(end) {
 					work_remaining = end - begin;
 				}
@@ -274,14 +346,70 @@ namespace rynx {
 					return work_remaining <= 0;
 				}
 
-				int64_t get_work() noexcept {
-					return index.fetch_add(work_size);
+				// number of chunks the remaining work is expected to be split into, for deciding how many workers to wake up.
+				int64_t chunk_count() const noexcept {
+					const int64_t remaining = end - index.load(std::memory_order_relaxed);
+					if (adaptive) {
+						return remaining < parallelism ? remaining : parallelism;
+					}
+					return (remaining + work_size - 1) / work_size;
+				}
+
+				// reserves the next chunk of work. returns false when all work has been handed out.
+				bool get_work(int64_t& chunk_begin, int64_t& chunk_end) noexcept {
+					if (!adaptive) {
+						chunk_begin = index.fetch_add(work_size);
+						chunk_end = chunk_begin + work_size >= end ? end : chunk_begin + work_size;
+						return chunk_begin < end;
+					}
+
+					int64_t current = index.load(std::memory_order_relaxed);
+					for (;;) {
+						if (current >= end) {
+							return false;
+						}
+						const int64_t chunk = adaptive_chunk_size(end - current);
+						if (index.compare_exchange_weak(current, current + chunk)) {
+							chunk_begin = current;
+							chunk_end = current + chunk;
+							return true;
+						}
+					}
+				}
+
+				// guided self scheduling. each chunk takes a share of the remaining work, so chunks start large and shrink
+				// towards the end of the range to balance the tail. the measured cost per item bounds the chunk duration.
+				int64_t adaptive_chunk_size(int64_t remaining) const noexcept {
+					int64_t chunk = remaining / (2 * parallelism);
+					const float ns_per_item = cost_per_item_ns.load(std::memory_order_relaxed);
+					if (ns_per_item > 0) {
+						const int64_t max_items = int64_t(target_chunk_ns / ns_per_item);
+						const int64_t min_items = int64_t(min_chunk_ns / ns_per_item);
+						chunk = chunk > max_items ? max_items : chunk;
+						chunk = chunk < min_items ? min_items : chunk;
+					}
+					else {
+						chunk = chunk > probe_chunk_size ? probe_chunk_size : chunk;
+					}
+					chunk = chunk < 1 ? 1 : chunk;
+					return chunk > remaining ? remaining : chunk;
+				}
+
+				// moving average of the measured cost. concurrent updates may lose samples, which is fine for an estimate.
+				void observe_chunk(int64_t items, int64_t duration_ns) noexcept {
+					const float measured = float(duration_ns) / float(items);
+					const float sample = measured < min_cost_per_item_ns ? min_cost_per_item_ns : measured;
+					const float previous = cost_per_item_ns.load(std::memory_order_relaxed);
+					cost_per_item_ns.store(previous > 0 ? previous * 0.75f + sample * 0.25f : sample, std::memory_order_relaxed);
 				}
 
 				alignas(std::hardware_destructive_interference_size) std::atomic<int64_t> index; // used when reserving new chunk of work. is updated when starting to work.
 				alignas(std::hardware_destructive_interference_size) std::atomic<int64_t> work_remaining; // used when checking if task is done. is updated when work chunk is completed.
+				alignas(std::hardware_destructive_interference_size) std::atomic<float> cost_per_item_ns = 0; // adaptive ranges only.
 				int64_t end;
 				int64_t work_size = 1;
+				int64_t parallelism = 1; // number of threads that can work on the range.
+				bool adaptive = false;
 			};
 
 		public:
@@ -293,8 +421,8 @@ namespace rynx {
 			//       approach to parallel fors was abandoned.
 			
 			struct parallel_for_operation {
-				parallel_for_operation(rynx::scheduler::task& parent) : m_parent(&parent), m_ops(rynx::make_shared<std::vector<rynx::function<void()>>>()) {
-					m_executor = rynx::make_unique<rynx::scheduler::task_token>(parent.extend_task_execute_parallel(this->m_parent->name() + "_pf", [ops = this->m_ops]() mutable {
+				parallel_for_operation(rynx::scheduler::task& parent) : m_parent(&parent), m_ops(rynx::memory::pool_allocator::make_shared<pooled_vector<work_op>>()) {
+					m_executor = rynx::memory::pool_allocator::make_unique<rynx::scheduler::task_token>(parent.extend_task_execute_parallel(this->m_parent->m_name + "_pf", [ops = this->m_ops]() mutable {
 						for (auto&& op : *ops) {
 							op();
 						}
@@ -312,8 +440,9 @@ namespace rynx {
 							logmsg("start parfor: %s", this->m_parent->name().c_str());
 						}
 
+						// every worker that can get a chunk is woken up at once. the calling thread takes one chunk itself.
 						if(notify_workers)
-							m_parent->notify_work_available();
+							m_parent->notify_work_available(m_chunks - self_participate);
 
 						if (self_participate) {
 							for (auto&& op : *m_ops) {
@@ -329,15 +458,24 @@ namespace rynx {
 				}
 
 				rynx::observer_ptr<rynx::scheduler::task_token> task() const {
-					return m_executor;
+					return m_executor.get();
 				}
 
 				parallel_for_operation& range(int64_t begin_, int64_t end_, int64_t work_size_ = 256) {
-					for_each_data = rynx::make_shared<parallel_for_each_data>(begin_, end_);
+					for_each_data = rynx::memory::pool_allocator::make_shared<parallel_for_each_data>(begin_, end_);
 					for_each_data->work_size = work_size_;
 					return *this;
 				}
 
+				// chunk sizes are chosen while the loop runs, based on the measured cost of the iterations.
+				// use this when the cost per iteration is unknown or varies, instead of guessing a work size.
+				parallel_for_operation& range_auto(int64_t begin_, int64_t end_) {
+					for_each_data = rynx::memory::pool_allocator::make_shared<parallel_for_each_data>(begin_, end_);
+					for_each_data->adaptive = true;
+					for_each_data->parallelism = m_parent->parallelism();
+					return *this;
+				}
+
 				parallel_for_operation& deferred_work() {
 					self_participate = false;
 					return *this;
@@ -353,21 +491,23 @@ namespace rynx {
 					rynx_assert(for_each_data != nullptr, "no operation range given. call range(..) first.");
 					
 					auto work_on_task = [for_each_data = this->for_each_data, op]() mutable  {
-						const int64_t work_segment_size = for_each_data->work_size;
-						const int64_t work_end = for_each_data->end;
-						for (;;) {
-							const int64_t work_segment_begin = for_each_data->get_work();
-							if (work_segment_begin >= work_end) {
-								return;
-							}
-							const int64_t work_segment_end = work_segment_begin + work_segment_size >= work_end ? work_end : work_segment_begin + work_segment_size;
+						const bool timed = for_each_data->adaptive;
+						int64_t work_segment_begin;
+						int64_t work_segment_end;
+						while (for_each_data->get_work(work_segment_begin, work_segment_end)) {
+							const auto segment_start_time = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
 							for (int64_t i = work_segment_begin; i < work_segment_end; ++i) {
 								op(i);
 							}
+							if (timed) {
+								const auto duration = std::chrono::steady_clock::now() - segment_start_time;
+								for_each_data->observe_chunk(work_segment_end - work_segment_begin, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+							}
 							for_each_data->work_remaining -= work_segment_end - work_segment_begin;
 						}
 					};
 
+					m_chunks += for_each_data->chunk_count();
 					(*m_executor)->m_for_each.emplace_back(for_each_data);
 					m_ops->emplace_back(std::move(work_on_task));
 					for_each_data.reset();
@@ -375,12 +515,15 @@ namespace rynx {
 				}
 
 			private:
-				rynx::unique_ptr<rynx::scheduler::task_token> m_executor;
+				using work_op = rynx::function_inplace<64, true, void()>;
+
+				rynx::memory::pool_allocator::unique_ptr<rynx::scheduler::task_token> m_executor;
 				rynx::scheduler::barrier m_barrier;
 
 				rynx::scheduler::task* m_parent;
 				rynx::shared_ptr<parallel_for_each_data> for_each_data;
-				rynx::shared_ptr<std::vector<rynx::function<void()>>> m_ops;
+				rynx::shared_ptr<pooled_vector<work_op>> m_ops;
+				int64_t m_chunks = 0;
 				bool self_participate = true;
 
 				// if you are creating multiple parallel for tasks with deferred_work, then might be better to
@@ -392,6 +535,25 @@ namespace rynx {
 				return parallel_for_operation(*this);
 			}
 
+			// blocks the task body until the barrier is complete. the task keeps its resources while blocked.
+			// with fiber workers the worker continues with other tasks, and the body may continue on another thread.
+			// with thread workers this thread runs other tasks of the context until the barrier is complete.
+			void wait(const rynx::scheduler::barrier& bar);
+			
+			// starts the parallel work, and blocks until all of it is complete.
+			void wait(parallel_for_operation&& op) { wait(op); }
+			void wait(parallel_for_operation& op) {
+				rynx::scheduler::barrier bar = op.barrier();
+				{
+					parallel_for_operation started = std::move(op);
+				}
+				wait(bar);
+			}
+
+			// blocks until the semaphore can be acquired. if it is released from outside of the scheduler's tasks,
+			// call context::wake_up_worker after releasing.
+			void wait(semaphore& sem);
+
 			explicit operator rynx::scheduler::context* () {
 				return m_context;
 			}
@@ -419,7 +581,10 @@ namespace rynx {
 			}
 
 		private:
-			void notify_work_available() const;
+			void run_op();
+			void notify_work_available(int64_t workers = 1) const; // wakes up at most this many sleeping workers, at least one.
+			void wait_until(fiber_pool::ready_check ready);
+			int64_t parallelism() const; // number of threads that can run tasks of this task's context.
 			
 			struct SchedulerDLL task_resources : public operation_resources {
 				task_resources(context* ctx) : m_context(ctx) {}
@@ -439,6 +604,15 @@ namespace rynx {
 					for (const auto resource_id : other.write_requirements()) {
 						require_write(resource_id);
 					}
+					for (const auto resource_id : other.scoped_read_requirements()) {
+						require_scoped_read(resource_id);
+					}
+					for (const auto resource_id : other.scoped_write_requirements()) {
+						require_scoped_write(resource_id);
+					}
+					for (const auto* scope : other.category_scopes()) {
+						require_category_scope(*scope);
+					}
 					return *this;
 				}
 
@@ -446,16 +620,26 @@ namespace rynx {
 				context* m_context = nullptr;
 			};
 
-			rynx::string m_name;
-			rynx::function<void(rynx::scheduler::task*)> m_op;
+			static const rynx::interned_string& empty_task_name() {
+				static const rynx::interned_string name("EmptyTask");
+				return name;
+			}
+
+			rynx::interned_string m_name;
+			op_t m_op;
 			rynx::shared_ptr<operation_barriers> m_barriers;
 
 			rynx::shared_ptr<task_resources> m_resources;
-			std::vector<rynx::shared_ptr<task_resources>> m_resources_shared;
-			std::vector<rynx::shared_ptr<parallel_for_each_data>> m_for_each;
+			pooled_vector<rynx::shared_ptr<task_resources>> m_resources_shared;
+			pooled_vector<rynx::shared_ptr<parallel_for_each_data>> m_for_each;
 
 			context* m_context = nullptr;
+			uint32_t m_priority = 0;
+			bool m_priority_manual = false;
+			bool m_on_critical_path = false; // was on the longest chain of the previous frame, profiled separately.
 			bool m_enable_logging = false;
 		};
 	}
 }
+
+#include <rynx/scheduler/coroutine.hpp>
@@ -0,0 +1,80 @@
+#include <rynx/scheduler/task_graph.hpp>
+
+void rynx::scheduler::task_graph::clear() {
+	m_nodes.clear();
+	m_barriers.clear();
+	m_blocker_counts.clear();
+}
+
+uint32_t rynx::scheduler::task_graph::barrier_index(const barrier& bar) {
+	for (uint32_t i = 0; i < m_barriers.size(); ++i) {
+		if (m_barriers[i].counter.get() == bar.counter.get()) {
+			return i;
+		}
+	}
+	m_barriers.emplace_back(bar);
+	return uint32_t(m_barriers.size() - 1);
+}
+
+void rynx::scheduler::task_graph::record(const task& t) {
+	rynx_assert(t.m_resources_shared.empty() && !t.is_for_each(), "only tasks created outside of running tasks can be recorded");
+	node& recorded = m_nodes.emplace_back();
+	recorded.name = t.m_name;
+	recorded.op = t.m_op;
+	recorded.resources = t.resources();
+	recorded.enable_logging = t.m_enable_logging;
+	recorded.priority_manual = t.m_priority_manual;
+	recorded.priority = t.m_priority_manual ? t.m_priority : 0;
+	for (const auto& bar : t.barriers().requirements()) {
+		recorded.waits_for.emplace_back(barrier_index(bar));
+	}
+	for (const auto& bar : t.barriers().blocks()) {
+		recorded.blocks.emplace_back(barrier_index(bar));
+	}
+	recorded.starts_ready = recorded.resources.empty() && recorded.waits_for.empty();
+}
+
+void rynx::scheduler::task_graph::compile() {
+	m_blocker_counts.assign(m_barriers.size(), 0);
+	for (const auto& recorded : m_nodes) {
+		for (uint32_t bar : recorded.blocks) {
+			++m_blocker_counts[bar];
+		}
+	}
+
+	// kahn's algorithm. barriers without recorded blockers do not order anything.
+	std::vector<int32_t> waiting_for(m_nodes.size(), 0);
+	std::vector<std::vector<uint32_t>> waiters_of_barrier(m_barriers.size());
+	for (uint32_t i = 0; i < m_nodes.size(); ++i) {
+		for (uint32_t bar : m_nodes[i].waits_for) {
+			waiting_for[i] += m_blocker_counts[bar];
+			waiters_of_barrier[bar].emplace_back(i);
+		}
+	}
+
+	std::vector<uint32_t> order;
+	order.reserve(m_nodes.size());
+	for (uint32_t i = 0; i < m_nodes.size(); ++i) {
+		if (waiting_for[i] == 0) {
+			order.emplace_back(i);
+		}
+	}
+
+	for (size_t k = 0; k < order.size(); ++k) {
+		for (uint32_t bar : m_nodes[order[k]].blocks) {
+			for (uint32_t waiter : waiters_of_barrier[bar]) {
+				if (--waiting_for[waiter] == 0) {
+					order.emplace_back(waiter);
+				}
+			}
+		}
+	}
+	rynx_assert(order.size() == m_nodes.size(), "recorded task graph has a dependency cycle");
+
+	std::vector<node> sorted;
+	sorted.reserve(m_nodes.size());
+	for (uint32_t i : order) {
+		sorted.emplace_back(std::move(m_nodes[i]));
+	}
+	m_nodes = std::move(sorted);
+}
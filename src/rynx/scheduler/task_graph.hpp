@@ -0,0 +1,48 @@
+#pragma once
+
+#include <rynx/scheduler/barrier.hpp>
+#include <rynx/scheduler/context.hpp>
+
+#include <vector>
+
+namespace rynx {
+	namespace scheduler {
+		class context;
+
+		// tasks of one frame captured by context::begin_recording, to be scheduled again with context::replay.
+		// replay skips creating the tasks through their creators, deducing resources and wiring barriers one edge at a time.
+		// recorded tasks keep whatever their closures captured, per frame values must be read from context resources instead.
+		class SchedulerDLL task_graph {
+		public:
+			bool empty() const { return m_nodes.empty(); }
+			size_t size() const { return m_nodes.size(); }
+			size_t barrier_count() const { return m_barriers.size(); }
+			void clear();
+
+		private:
+			friend class rynx::scheduler::context;
+
+			struct node {
+				rynx::interned_string name;
+				task::op_t op;
+				operation_resources resources;
+				std::vector<uint32_t> waits_for; // indices to m_barriers.
+				std::vector<uint32_t> blocks; // indices to m_barriers.
+				bool starts_ready = false; // no resources and no barriers, goes directly to a ready deque.
+				bool priority_manual = false;
+				uint32_t priority = 0;
+				bool enable_logging = false;
+			};
+
+			void record(const task& t);
+			uint32_t barrier_index(const barrier& bar);
+			
+			// sorts nodes so that each task comes after the tasks it waits for, and counts blockers of each barrier.
+			void compile();
+
+			std::vector<node> m_nodes;
+			std::vector<barrier> m_barriers;
+			std::vector<int32_t> m_blocker_counts; // number of recorded tasks blocking each barrier.
+		};
+	}
+}
@@ -6,6 +6,7 @@
 #include <rynx/scheduler/worker_thread.hpp>
 
 #include <iostream>
+#include <thread>
 
 // TODO: it would probably be better to just find work, and return the task. don't mix threads and worker state to this function. let them do that internally.
 bool rynx::scheduler::task_scheduler::find_work_for_thread_index(int threadIndex) {
@@ -29,8 +30,49 @@ void rynx::scheduler::task_scheduler::wake_up_sleeping_workers() {
 	}
 }
 
-rynx::scheduler::task_scheduler::task_scheduler(uint64_t numWorkers) : m_threads({ nullptr }), m_deadlock_detector(this) {
+// waking up one at a time takes a wake up latency per worker before all of them are busy. when the amount of work
+// is known, such as the chunks of a parallel for, the workers are woken up all at once instead.
+uint64_t rynx::scheduler::task_scheduler::wake_up_workers(uint64_t count) {
+	rynx_profile("Profiler", "Wake up sleeping workers");
+	uint64_t woken = 0;
+	for (auto* thread_ptr : m_threads) {
+		if (woken == count) {
+			break;
+		}
+		woken += thread_ptr->wake_up();
+	}
+	return woken;
+}
+
+bool rynx::scheduler::task_scheduler::has_tasks_in_flight() const {
+	for (auto& context : m_contexts) {
+		if (!context.second->isFinished()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+uint64_t rynx::scheduler::task_scheduler::pin_workers(uint32_t first_core) {
+	const std::vector<uint32_t> cores = task_thread::available_cores();
+	if (cores.empty()) {
+		return 0;
+	}
+
+	uint64_t pinned = 0;
+	for (uint64_t i = 0; i < m_threads.size(); ++i) {
+		pinned += m_threads[i]->pin_to_core(cores[(first_core + i) % cores.size()]);
+	}
+	return pinned;
+}
+
+rynx::scheduler::task_scheduler::task_scheduler(uint64_t numWorkers, worker_mode mode, size_t fiber_stack_size) : m_threads({ nullptr }), m_deadlock_detector(this) {
 	rynx::type_index::initialize();
+	if (mode == worker_mode::fibers) {
+		m_fibers = rynx::make_unique<fiber_pool>(fiber_stack_size);
+	}
+	// on a single cpu a spinning worker only delays the thread that would release its work.
+	m_idle_spin_rounds = std::thread::hardware_concurrency() > 1 ? 64 : 0;
 	m_threads.resize(numWorkers, nullptr);
 	for (int i = 0; i < numWorkers; ++i) {
 		m_threads[i] = new rynx::scheduler::task_thread(this, i);
@@ -73,6 +115,9 @@ bool rynx::scheduler::task_scheduler::checkComplete() {
 		return false;
 	
 	if (m_frameComplete.exchange(1) == 0) {
+		for (auto& context : m_contexts) {
+			context.second->frame_completed();
+		}
 		m_waitForComplete.signal();
 	}
 	return true;
@@ -9,6 +9,7 @@
 #include <rynx/scheduler/context.hpp>
 #include <rynx/scheduler/task.hpp>
 #include <rynx/scheduler/deadlock_detector.hpp>
+#include <rynx/scheduler/fiber_pool.hpp>
 #include <rynx/thread/semaphore.hpp>
 
 #include <vector>
@@ -21,6 +22,13 @@ namespace rynx {
 
 		class SchedulerDLL task_scheduler {
 		public:
+			// how workers run tasks. with fibers, a task that calls task::wait is set aside on its own stack
+			// and the worker continues with other tasks. with threads, the waiting task runs other tasks on top of its stack.
+			enum class worker_mode {
+				threads,
+				fibers
+			};
+
 			friend class scheduler::context;
 			friend class scheduler::task_thread;
 			friend class scheduler::task;
@@ -29,6 +37,7 @@ namespace rynx {
 			std::atomic<scheduler::context::context_id> m_contextIdGen = 0;
 			rynx::unordered_map<scheduler::context::context_id, rynx::unique_ptr<scheduler::context>> m_contexts;
 			std::vector<rynx::scheduler::task_thread*> m_threads;
+			rynx::unique_ptr<fiber_pool> m_fibers; // only in fiber mode.
 			
 			uint64_t m_activeFrame = 0;
 			std::atomic<int32_t> m_frameComplete = 1; // initially the scheduler is in a "frame completed" state.
@@ -37,15 +46,20 @@ namespace rynx {
 			dead_lock_detector m_deadlock_detector;
 
 
+			// rounds an idle worker keeps looking for work before it sleeps. see idle_spin_rounds.
+			std::atomic<uint32_t> m_idle_spin_rounds = 0;
+
 			bool find_work_for_thread_index(int threadIndex); // this is only allowed to be called from within the worker. TODO: architecture.
 			void wake_up_sleeping_workers();
+			uint64_t wake_up_workers(uint64_t count); // returns the number of workers woken up.
+			bool has_tasks_in_flight() const;
 
 			void worker_activated();
 			void worker_deactivated();
 
 		public:
 
-			task_scheduler(uint64_t numWorkers = 16);
+			task_scheduler(uint64_t numWorkers = 16, worker_mode mode = worker_mode::threads, size_t fiber_stack_size = 256 * 1024);
 			~task_scheduler();
 
 			// No move, no copy.
@@ -64,6 +78,21 @@ namespace rynx {
 				return m_threads.size();
 			}
 
+			worker_mode mode() const {
+				return m_fibers ? worker_mode::fibers : worker_mode::threads;
+			}
+
+			// pins worker i to the (first_core + i)th cpu this process is allowed to run on, wrapping around.
+			// first_core can be used to leave the first cpus to the main thread. only supported on linux,
+			// elsewhere nothing is pinned. returns the number of workers pinned.
+			uint64_t pin_workers(uint32_t first_core = 0);
+
+			// a worker that runs out of work keeps looking for this many rounds before it sleeps, as long as
+			// the frame has tasks in flight that may release more work. the first rounds spin, the rest yield
+			// the thread. zero sleeps right away, which is the better choice when the cpus are shared.
+			void idle_spin_rounds(uint32_t rounds) { m_idle_spin_rounds.store(rounds, std::memory_order_relaxed); }
+			uint32_t idle_spin_rounds() const { return m_idle_spin_rounds.load(std::memory_order_relaxed); }
+
 			// called once per frame.
 			void wait_until_complete() {
 				m_waitForComplete.wait();
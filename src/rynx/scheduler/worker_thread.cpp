@@ -2,8 +2,31 @@
 #include <rynx/scheduler/worker_thread.hpp>
 #include <rynx/scheduler/task_scheduler.hpp>
 #include <rynx/thread/this_thread.hpp>
+#include <rynx/thread/fiber.hpp>
 
+#include <atomic>
 #include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+	// idle rounds that spin on the cpu before the remaining rounds yield the thread instead.
+	constexpr uint32_t spin_rounds_before_yield = 16;
+
+	inline void cpu_relax() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		_mm_pause();
+#endif
+	}
+}
 
 rynx::scheduler::task_thread::task_thread(task_scheduler* pTaskMaster, int myIndex) {
 	m_scheduler = pTaskMaster;
@@ -44,20 +67,117 @@ bool rynx::scheduler::task_thread::is_sleeping() const {
 	return m_sleeping;
 }
 
+bool rynx::scheduler::task_thread::pin_to_core(uint32_t core) {
+#if defined(__linux__)
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(core, &cpus);
+	return pthread_setaffinity_np(m_thread->native_handle(), sizeof(cpus), &cpus) == 0;
+#else
+	(void)core;
+	return false;
+#endif
+}
+
+std::vector<uint32_t> rynx::scheduler::task_thread::available_cores() {
+	std::vector<uint32_t> cores;
+#if defined(__linux__)
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0) {
+		for (uint32_t core = 0; core < CPU_SETSIZE; ++core) {
+			if (CPU_ISSET(core, &cpus)) {
+				cores.emplace_back(core);
+			}
+		}
+	}
+#endif
+	return cores;
+}
+
+
+// blocked tasks that can continue go first, they are already holding their resources.
+bool rynx::scheduler::task_thread::find_work(int myThreadIndex) {
+	if (m_scheduler->m_fibers) {
+		m_resumed = m_scheduler->m_fibers->take_ready();
+		if (m_resumed) {
+			return true;
+		}
+	}
+	return m_scheduler->find_work_for_thread_index(myThreadIndex);
+}
+
+// work is often released moments later by a task that is still running, and sleeping in between
+// would add the wake up latency to the critical path. with no tasks in flight there is nothing to wait for.
+bool rynx::scheduler::task_thread::spin_for_work(int myThreadIndex) {
+	const uint32_t rounds = m_scheduler->m_idle_spin_rounds.load(std::memory_order_relaxed);
+	for (uint32_t round = 0; round < rounds && m_scheduler->has_tasks_in_flight(); ++round) {
+		if (round < spin_rounds_before_yield) {
+			for (int i = 0; i < 32; ++i) {
+				cpu_relax();
+			}
+		}
+		else {
+			std::this_thread::yield();
+		}
+
+		if (find_work(myThreadIndex)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void rynx::scheduler::task_thread::run_found_work() {
+	if (m_resumed) {
+		m_scheduler->m_fibers->resume(std::exchange(m_resumed, nullptr));
+		return;
+	}
+
+	m_scheduler->wake_up_sleeping_workers();
+	if (m_scheduler->m_fibers) {
+		m_scheduler->m_fibers->run(std::move(m_task));
+	}
+	else {
+		m_task.run();
+	}
+	m_task.clear();
+}
 
 void rynx::scheduler::task_thread::threadEntry(int myThreadIndex) {
 	rynx::this_thread::rynx_thread_raii rynx_thread_utilities_required_token;
+	Fiber* thread_fiber = m_scheduler->m_fibers ? Fiber::enterFiberMode() : nullptr;
 	while (m_alive) {
 		wait();
 
-		while (m_scheduler->find_work_for_thread_index(myThreadIndex)) {
-			m_scheduler->wake_up_sleeping_workers();
-			m_task.run();
-			m_task.clear();
+		for (;;) {
+			while (find_work(myThreadIndex)) {
+				run_found_work();
+			}
+
+			if (spin_for_work(myThreadIndex)) {
+				run_found_work();
+				continue;
+			}
+
+			m_sleeping.store(true);
+
+			// work released from outside of the workers after the last search, but before this worker was marked
+			// as sleeping, did not wake anyone up. see context::release_barrier.
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (!find_work(myThreadIndex)) {
+				break;
+			}
+
+			m_sleeping.store(false);
+			run_found_work();
 		}
 		
-		m_sleeping.store(true);
 		m_scheduler->checkComplete();
 	}
+
+	if (thread_fiber) {
+		Fiber::exitFiberMode(thread_fiber);
+	}
 	logmsg("task thread exit");
 }
@@ -4,8 +4,10 @@
 #include <rynx/thread/semaphore.hpp>
 #include <rynx/scheduler/context.hpp>
 #include <rynx/scheduler/task.hpp>
+#include <rynx/scheduler/fiber_pool.hpp>
 #include <rynx/std/memory.hpp>
 #include <atomic>
+#include <vector>
 
 namespace std {
 	class thread;
@@ -20,10 +22,14 @@ namespace rynx {
 			semaphore m_semaphore;
 			task_scheduler* m_scheduler;
 			task m_task;
+			fiber_pool::slot* m_resumed = nullptr; // blocked task found instead of m_task, in fiber mode.
 			std::atomic<bool> m_sleeping = true;
 			bool m_alive = false;
 
 			void threadEntry(int myThreadIndex);
+			bool find_work(int myThreadIndex);
+			bool spin_for_work(int myThreadIndex);
+			void run_found_work();
 
 		public:
 
@@ -37,6 +43,12 @@ namespace rynx {
 			bool wake_up();
 			void wait();
 			bool is_sleeping() const;
+
+			// only supported on linux. returns false if the thread was not pinned.
+			bool pin_to_core(uint32_t core);
+
+			// cpus the process is allowed to run on. empty where pinning is not supported.
+			static std::vector<uint32_t> available_cores();
 		};
 	}
 }
@@ -0,0 +1,67 @@
+
+#include <rynx/std/interned_string.hpp>
+#include <rynx/std/unordered_map.hpp>
+
+#include <mutex>
+#include <vector>
+
+namespace {
+	uint64_t hash_chars(uint64_t hash, char const* str) {
+		while (*str) {
+			hash ^= static_cast<uint8_t>(*str++);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	bool equals(const rynx::string& value, char const* const prefix, char const* const suffix) {
+		const size_t prefix_length = std::strlen(prefix);
+		return std::strncmp(value.c_str(), prefix, prefix_length) == 0 && std::strcmp(value.c_str() + prefix_length, suffix) == 0;
+	}
+
+	struct intern_table {
+		std::mutex mutex;
+		rynx::unordered_map<uint64_t, std::vector<const rynx::string*>> strings; // by hash.
+
+		const rynx::string* intern(uint64_t hash, char const* const prefix, char const* const suffix) {
+			std::scoped_lock lock(mutex);
+			auto& candidates = strings[hash];
+			for (auto& candidate : candidates) {
+				if (equals(*candidate, prefix, suffix)) {
+					return candidate;
+				}
+			}
+			candidates.emplace_back(new rynx::string(rynx::string(prefix) + rynx::string(suffix)));
+			return candidates.back();
+		}
+	};
+
+	// never destroyed, interned strings may be referenced by static objects.
+	intern_table& table() {
+		static intern_table* instance = new intern_table();
+		return *instance;
+	}
+
+	// avoids taking the table lock for strings this thread has seen before.
+	thread_local rynx::unordered_map<uint64_t, const rynx::string*> t_recent;
+
+	const rynx::string* intern(char const* const prefix, char const* const suffix) {
+		const uint64_t hash = hash_chars(hash_chars(14695981039346656037ull, prefix), suffix);
+		auto it = t_recent.find(hash);
+		if (it != t_recent.end() && equals(*it->second, prefix, suffix)) {
+			return it->second;
+		}
+
+		const rynx::string* value = table().intern(hash, prefix, suffix);
+		t_recent[hash] = value;
+		return value;
+	}
+}
+
+rynx::interned_string::interned_string() {
+	static const rynx::string* empty = intern("", "");
+	m_value = empty;
+}
+rynx::interned_string::interned_string(char const* const str) : m_value(intern(str, "")) {}
+rynx::interned_string::interned_string(const rynx::string& str) : m_value(intern(str.c_str(), "")) {}
+rynx::interned_string::interned_string(char const* const prefix, char const* const suffix) : m_value(intern(prefix, suffix)) {}
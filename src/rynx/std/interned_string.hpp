@@ -0,0 +1,28 @@
+
+#pragma once
+
+#include <rynx/std/string.hpp>
+
+namespace rynx {
+	// immutable string stored once in a process wide table. copies only copy a pointer.
+	// interning a string that is already known does not allocate, each distinct string is allocated once and never freed.
+	class RynxStdDLL interned_string {
+	public:
+		interned_string();
+		interned_string(char const* const str);
+		interned_string(const rynx::string& str);
+		interned_string(char const* const prefix, char const* const suffix); // interns prefix + suffix without building the concatenation first.
+
+		const rynx::string& str() const noexcept { return *m_value; }
+		char const* c_str() const noexcept { return m_value->c_str(); }
+		operator const rynx::string& () const noexcept { return *m_value; }
+
+		interned_string operator + (char const* const suffix) const { return interned_string(c_str(), suffix); }
+
+		bool operator == (const interned_string& other) const noexcept { return m_value == other.m_value; }
+		bool operator != (const interned_string& other) const noexcept { return m_value != other.m_value; }
+
+	private:
+		const rynx::string* m_value;
+	};
+}
@@ -6,6 +6,7 @@
 #include <cstddef>
 #include <type_traits>
 #include <atomic>
+#include <new>
 
 #define USE_RYNX_SMART_PTRS
 
@@ -328,27 +329,58 @@ namespace rynx {
         // Shared ptr
 
         struct shared_ptr_control_block {
+            virtual ~shared_ptr_control_block() {}
+            virtual void dispose(void* ptr) { m_deleter->operator()(ptr); } // destroys the managed object.
+            virtual void destroy() { delete this; } // frees the control block.
+
             std::atomic<int32_t> m_count = 1;
             std::atomic<int32_t> m_weak = 1;
             rynx::std_replacements::unique_ptr<rynx::std_replacements::dynamic_deleter> m_deleter;
         };
 
+        // control block and object in one allocation. see allocate_shared. only stateless allocators are supported.
+        template <typename T, template<typename> typename Allocator>
+        struct shared_ptr_inplace_control_block : public shared_ptr_control_block {
+            template<typename... Args>
+            shared_ptr_inplace_control_block(Args&&... args) {
+                new (m_storage) T(std::forward<Args>(args)...);
+            }
+
+            T* object() noexcept { return reinterpret_cast<T*>(m_storage); }
+
+            void dispose(void*) override { object()->~T(); }
+            void destroy() override {
+                this->~shared_ptr_inplace_control_block();
+                Allocator<shared_ptr_inplace_control_block>().deallocate(this, 1);
+            }
+
+            alignas(T) std::byte m_storage[sizeof(T)];
+        };
+
         template <typename T>
         class weak_ptr;
 
+        template <typename T>
+        class shared_ptr;
+
+        template <typename T, template<typename> typename Allocator, typename U, typename... Args>
+        shared_ptr<T> allocate_shared(const Allocator<U>&, Args&&... args);
+
         template <typename T>
         class shared_ptr {
             template<typename U> friend class rynx::std_replacements::weak_ptr;
             template<typename U> friend class rynx::std_replacements::shared_ptr;
+            template <typename U, template<typename> typename Allocator, typename V, typename... Args>
+            friend shared_ptr<U> rynx::std_replacements::allocate_shared(const Allocator<V>&, Args&&... args);
 
             T* m_ptr = nullptr;
             rynx::std_replacements::shared_ptr_control_block* m_control = nullptr;
 
             void release() {
                 if (m_control && m_control->m_count.fetch_add(-1) == 1) {
-                    m_control->m_deleter->operator()(m_ptr);
+                    m_control->dispose(m_ptr);
                     if (m_control->m_weak.fetch_add(-1) == 1)
-                        delete m_control;
+                        m_control->destroy();
                 }
 
                 m_ptr = nullptr;
@@ -509,7 +541,7 @@ namespace rynx {
                 // TODO: fix this.
                 if (m_control && m_control->m_weak.fetch_add(-1) == 1)
                     if (m_control->m_count == 0)
-                        delete m_control;
+                        m_control->destroy();
             }
 
             void acquire() {
@@ -651,6 +683,13 @@ namespace rynx {
                 return *this;
             }
         };
+
+        template <typename T, template<typename> typename Allocator, typename U, typename... Args>
+        shared_ptr<T> allocate_shared(const Allocator<U>&, Args&&... args) {
+            using block_t = shared_ptr_inplace_control_block<T, Allocator>;
+            auto* block = new (Allocator<block_t>().allocate(1)) block_t(std::forward<Args>(args)...);
+            return shared_ptr<T>(block->object(), block);
+        }
     }
         
 #ifdef USE_RYNX_SMART_PTRS
@@ -681,6 +720,13 @@ namespace rynx {
     
     template<typename T, typename... Args> rynx::shared_ptr<T> make_shared(Args&&... args) { return rynx::shared_ptr<T>(new T(std::forward<Args>(args)...)); }
 
+    // object and its reference counts in one allocation from the given allocator.
+#ifdef USE_RYNX_SMART_PTRS
+    template<typename T, typename Allocator, typename... Args> rynx::shared_ptr<T> allocate_shared(const Allocator& allocator, Args&&... args) { return rynx::std_replacements::allocate_shared<T>(allocator, std::forward<Args>(args)...); }
+#else
+    template<typename T, typename Allocator, typename... Args> rynx::shared_ptr<T> allocate_shared(const Allocator& allocator, Args&&... args) { return std::allocate_shared<T>(allocator, std::forward<Args>(args)...); }
+#endif
+
 
 	template<typename T>
 	class observer_ptr {
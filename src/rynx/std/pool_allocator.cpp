@@ -0,0 +1,152 @@
+
+#include <rynx/std/pool_allocator.hpp>
+
+#include <mutex>
+#include <new>
+
+namespace {
+	// size classes are 16, 32, 64, ... 2048 bytes. classes of 64 bytes and up are aligned to 64 bytes.
+	constexpr size_t num_size_classes = 8;
+	constexpr size_t smallest_size_class = 16;
+	constexpr size_t largest_size_class = smallest_size_class << (num_size_classes - 1);
+	constexpr size_t max_block_align = 64;
+	constexpr size_t slab_size = 64 * 1024;
+
+	// thread keeps at most this many free blocks per size class, half of them are handed to the shared list when exceeded.
+	constexpr uint32_t thread_cache_limit = rynx::memory::pool_allocator::max_blocks_cached_per_thread;
+	constexpr uint32_t refill_count = 32;
+
+	struct free_block {
+		free_block* next;
+	};
+
+	struct free_list {
+		free_block* head = nullptr;
+		uint32_t count = 0;
+
+		void push(free_block* block) {
+			block->next = head;
+			head = block;
+			++count;
+		}
+
+		free_block* pop() {
+			free_block* block = head;
+			head = block->next;
+			--count;
+			return block;
+		}
+
+		// moves up to n blocks from front of this list to front of other.
+		void move_to(free_list& other, uint32_t n) {
+			while (n-- && head) {
+				other.push(pop());
+			}
+		}
+	};
+
+	struct shared_pool {
+		std::mutex mutex;
+		free_list lists[num_size_classes];
+	};
+
+	// never destroyed, threads can return their blocks in any order during shutdown.
+	shared_pool& shared() {
+		static shared_pool* pool = new shared_pool();
+		return *pool;
+	}
+
+	struct thread_cache {
+		free_list lists[num_size_classes];
+
+		~thread_cache() {
+			auto& pool = shared();
+			std::scoped_lock lock(pool.mutex);
+			for (size_t i = 0; i < num_size_classes; ++i) {
+				lists[i].move_to(pool.lists[i], lists[i].count);
+			}
+		}
+	};
+
+	thread_local thread_cache t_cache;
+
+	size_t size_class_of(size_t bytes) {
+		size_t size_class = 0;
+		size_t class_bytes = smallest_size_class;
+		while (class_bytes < bytes) {
+			class_bytes <<= 1;
+			++size_class;
+		}
+		return size_class;
+	}
+
+	bool fits_in_pool(size_t bytes, size_t align) {
+		return bytes <= largest_size_class && align <= max_block_align;
+	}
+
+	// called with the shared pool mutex held.
+	void add_slab(free_list& shared_list, size_t size_class) {
+		const size_t block_bytes = smallest_size_class << size_class;
+		std::byte* slab = static_cast<std::byte*>(::operator new(slab_size, std::align_val_t(max_block_align)));
+		for (size_t offset = slab_size; offset >= block_bytes; offset -= block_bytes) {
+			shared_list.push(reinterpret_cast<free_block*>(slab + offset - block_bytes));
+		}
+	}
+
+	void refill(size_t size_class) {
+		auto& pool = shared();
+		std::scoped_lock lock(pool.mutex);
+		free_list& shared_list = pool.lists[size_class];
+		if (shared_list.count == 0) {
+			add_slab(shared_list, size_class);
+		}
+		shared_list.move_to(t_cache.lists[size_class], refill_count);
+	}
+}
+
+void* rynx::memory::pool_allocator::detail::allocate(size_t bytes, size_t align) {
+	if (!fits_in_pool(bytes, align)) {
+		return ::operator new(bytes, std::align_val_t(align < alignof(std::max_align_t) ? alignof(std::max_align_t) : align));
+	}
+
+	const size_t size_class = size_class_of(bytes);
+	free_list& local = t_cache.lists[size_class];
+	if (local.count == 0) {
+		refill(size_class);
+	}
+	return local.pop();
+}
+
+void rynx::memory::pool_allocator::detail::deallocate(void* ptr, size_t bytes, size_t align) {
+	if (ptr == nullptr) {
+		return;
+	}
+
+	if (!fits_in_pool(bytes, align)) {
+		::operator delete(ptr, std::align_val_t(align < alignof(std::max_align_t) ? alignof(std::max_align_t) : align));
+		return;
+	}
+
+	const size_t size_class = size_class_of(bytes);
+	free_list& local = t_cache.lists[size_class];
+	local.push(static_cast<free_block*>(ptr));
+	if (local.count > thread_cache_limit) {
+		auto& pool = shared();
+		std::scoped_lock lock(pool.mutex);
+		local.move_to(pool.lists[size_class], thread_cache_limit / 2);
+	}
+}
+
+void rynx::memory::pool_allocator::reserve(size_t bytes, size_t blocks) {
+	if (!fits_in_pool(bytes, alignof(std::max_align_t))) {
+		return;
+	}
+
+	const size_t size_class = size_class_of(bytes);
+	auto& pool = shared();
+	std::scoped_lock lock(pool.mutex);
+	free_list& shared_list = pool.lists[size_class];
+	while (shared_list.count < blocks) {
+		add_slab(shared_list, size_class);
+	}
+}
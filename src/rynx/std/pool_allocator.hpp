@@ -0,0 +1,77 @@
+
+#pragma once
+
+#include <rynx/std/frame_allocator.hpp>
+#include <rynx/std/memory.hpp>
+
+#include <cstdint>
+#include <type_traits>
+
+// fixed size class allocator for short lived objects that are created and destroyed at a high rate, like scheduler tasks.
+// each thread keeps its own free lists, surplus blocks are handed over in batches through a shared list so that memory
+// freed on one thread can be reused on another. blocks are never returned to the system.
+namespace rynx::memory {
+	namespace pool_allocator {
+		namespace detail {
+			void* allocate(size_t bytes, size_t align);
+			void deallocate(void* ptr, size_t bytes, size_t align);
+		}
+
+		// a thread keeps at most this many free blocks of each size class to itself.
+		constexpr uint32_t max_blocks_cached_per_thread = 256;
+
+		// makes sure the pool has at least this many free blocks for allocations of the given size, so that they can be
+		// taken without allocating from the system. blocks freed into the cache of a thread are only available to that thread
+		// until the cache overflows, so to never allocate, reserve room for a full cache on every thread on top of the peak use.
+		void reserve(size_t bytes, size_t blocks);
+
+		template<typename T>
+		struct allocator_t {
+			using value_type = T;
+			using pointer = T*;
+			using reference = T&;
+			using const_reference = const T&;
+			using const_pointer = const T*;
+			using propagate_on_container_move_assignment = std::true_type;
+			using size_type = size_t;
+			using is_always_equal = std::true_type;
+			using difference_type = std::ptrdiff_t;
+
+			allocator_t() {}
+			template<typename U> allocator_t(allocator_t<U>) {}
+
+			[[nodiscard]] static T* allocate(size_t n) {
+				return static_cast<T*>(rynx::memory::pool_allocator::detail::allocate(n * sizeof(T), alignof(T)));
+			}
+
+			static void deallocate(pointer ptr, size_t n) {
+				rynx::memory::pool_allocator::detail::deallocate(ptr, n * sizeof(T), alignof(T));
+			}
+
+			static pointer address(reference x) noexcept { return rynx::addressof(x); }
+			static const_pointer address(const_reference x) noexcept { return rynx::addressof(x); }
+			static size_type max_size() noexcept { return 1 * 1024 * 1024 * 1024; }
+		};
+
+		template<class T1, class T2> constexpr bool operator==(const allocator_t<T1>&, const allocator_t<T2>&) noexcept { return true; }
+		template<class T1, class T2> constexpr bool operator!=(const allocator_t<T1>&, const allocator_t<T2>&) noexcept { return false; }
+
+		template<typename T>
+		struct deleter {
+			void operator()(T* ptr) const {
+				ptr->~T();
+				rynx::memory::pool_allocator::detail::deallocate(ptr, sizeof(T), alignof(T));
+			}
+		};
+
+		template<typename T> using unique_ptr = rynx::unique_ptr<T, deleter<T>>;
+
+		template<typename T, typename... Args> [[nodiscard]] unique_ptr<T> make_unique(Args&&... args) {
+			return unique_ptr<T>(new (allocator_t<T>::allocate(1)) T(std::forward<Args>(args)...));
+		}
+
+		template<typename T, typename... Args> [[nodiscard]] rynx::shared_ptr<T> make_shared(Args&&... args) {
+			return rynx::allocate_shared<T>(allocator_t<T>(), std::forward<Args>(args)...);
+		}
+	}
+}
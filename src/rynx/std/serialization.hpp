@@ -59,9 +59,9 @@ namespace rynx {
 			}
 		};
 
-		template<typename T> struct Serialize<std::vector<T>> {
+		template<typename T, typename Allocator> struct Serialize<std::vector<T, Allocator>> {
 			template<typename IOStream>
-			void serialize(const std::vector<T>& vec_t, IOStream& writer) {
+			void serialize(const std::vector<T, Allocator>& vec_t, IOStream& writer) {
 				writer(vec_t.size());
 				if constexpr (
 					(sizeof(T) >= alignof(T)) &&
@@ -81,7 +81,7 @@ namespace rynx {
 			}
 
 			template<typename IOStream>
-			void deserialize(std::vector<T>& vec_t, IOStream& reader) {
+			void deserialize(std::vector<T, Allocator>& vec_t, IOStream& reader) {
 				size_t numElements = 0;
 				reader(numElements);
 				size_t originalSize = vec_t.size();
@@ -1,25 +1,45 @@
 #include <rynx/tech/collision_detection.hpp>
 #include <rynx/tech/sphere_tree.hpp>
+#include <rynx/tech/spatial_hash.hpp>
+#include <rynx/tech/lbvh.hpp>
 #include <rynx/tech/components.hpp>
 
-rynx::collision_detection::category_id rynx::collision_detection::add_category() {
-	m_sphere_trees.emplace_back(rynx::make_shared<sphere_tree>());
+rynx::collision_detection::category_id rynx::collision_detection::add_category(broadphase kind) {
+	m_sphere_trees.emplace_back(kind == broadphase::sphere_tree ? rynx::make_shared<sphere_tree>() : nullptr);
+	m_spatial_hashes.emplace_back(kind == broadphase::spatial_hash ? rynx::make_shared<spatial_hash>() : nullptr);
+	m_lbvhs.emplace_back(kind == broadphase::lbvh ? rynx::make_shared<lbvh>() : nullptr);
 	return category_id(int32_t(m_sphere_trees.size()) - 1);
 }
 
+void rynx::collision_detection::insert_entity(int32_t category, uint64_t id, vec3f pos, float radius) {
+	with_broadphase(category, [=](auto& broadphase) { broadphase.insert_entity(id, pos, radius); });
+}
+
+void rynx::collision_detection::update_entity(int32_t category, uint64_t id, vec3f pos, float radius) {
+	with_broadphase(category, [=](auto& broadphase) { broadphase.update_entity(id, pos, radius); });
+}
+
+bool rynx::collision_detection::contains(int32_t category, uint64_t id) {
+	return with_broadphase(category, [id](auto& broadphase) { return broadphase.contains(id); });
+}
+
+void rynx::collision_detection::erase_entity(int32_t category, uint64_t id) {
+	with_broadphase(category, [id](auto& broadphase) { broadphase.eraseEntity(id); });
+}
+
 rynx::collision_detection& rynx::collision_detection::enable_collisions_between(category_id category1, category_id category2) {
 	rynx_assert(!(category1.m_ignore_collisions && category2.m_ignore_collisions), "checking collisions between two categories who both ignore collisions, makes no sense");
 	if (category1.m_ignore_collisions) {
 		m_collision_checks.emplace_back(
-			m_sphere_trees[category2.value].get(),
-			m_sphere_trees[category1.value].get(),
+			category2.value,
+			category1.value,
 			check_type::b_is_static
 		);
 	}
 	else {
 		m_collision_checks.emplace_back(
-			m_sphere_trees[category1.value].get(),
-			m_sphere_trees[category2.value].get(),
+			category1.value,
+			category2.value,
 			category2.m_ignore_collisions ? check_type::b_is_static : check_type::both_are_dynamic
 		);
 	}
@@ -27,20 +47,20 @@ rynx::collision_detection& rynx::collision_detection::enable_collisions_between(
 }
 
 void rynx::collision_detection::clear() {
-	for (auto& tree : m_sphere_trees) {
-		tree->clear();
+	for (int32_t category = 0; category < int32_t(m_sphere_trees.size()); ++category) {
+		with_broadphase(category, [](auto& broadphase) { broadphase.clear(); });
 	}
 }
 
 void rynx::collision_detection::update_sphere_trees() {
-	for (auto& tree : m_sphere_trees) {
-		tree->update();
+	for (int32_t category = 0; category < int32_t(m_sphere_trees.size()); ++category) {
+		with_broadphase(category, [](auto& broadphase) { broadphase.update(); });
 	}
 }
 
 void rynx::collision_detection::update_sphere_trees_parallel(rynx::scheduler::task& task_context) {
-	for (auto& tree : m_sphere_trees) {
-		tree->update_parallel(task_context);
+	for (int32_t category = 0; category < int32_t(m_sphere_trees.size()); ++category) {
+		with_broadphase(category, [&task_context](auto& broadphase) { broadphase.update_parallel(task_context); });
 	}
 }
 
@@ -66,7 +86,7 @@ void rynx::collision_detection::track_entities(rynx::scheduler::task& task_conte
 			{
 				rynx_assert((id.value & rynx::collision_detection::mask_id) == id.value, "id out of bounds");
 				uint64_t part_id = id.value | mask_kind_sphere;
-				detection.m_sphere_trees[col.category]->insert_entity(part_id, pos.value, r.r);
+				detection.insert_entity(col.category, part_id, pos.value, r.r);
 			});
 
 			// boundaries
@@ -80,7 +100,7 @@ void rynx::collision_detection::track_entities(rynx::scheduler::task& task_conte
 					rynx::components::phys::collisions col)
 			{
 				const uint64_t part_id = id.value | mask_kind_boundary;
-				detection.m_sphere_trees[col.category]->insert_entity(part_id, pos.value, r.r);
+				detection.insert_entity(col.category, part_id, pos.value, r.r);
 			});
 
 			// projectiles
@@ -95,7 +115,7 @@ void rynx::collision_detection::track_entities(rynx::scheduler::task& task_conte
 			{
 				rynx_assert((id.value & rynx::collision_detection::mask_id) == id.value, "id out of bounds");
 				uint64_t part_id = id.value | mask_kind_projectile;
-				detection.m_sphere_trees[col.category]->insert_entity(part_id, pos.value, r.r);
+				detection.insert_entity(col.category, part_id, pos.value, r.r);
 			});
 
 
@@ -130,15 +150,15 @@ void rynx::collision_detection::editor_api_t::update_entity_forced(rynx::ecs& ec
 	// before running an iteration of collision detection updates, where this entity will become tracked.
 	// if this is the case, then just don't do anything - let the normal path pick the entity up.
 	// otherwise update immediately.
-	if(m_host->m_sphere_trees[collisions.category]->contains(part_id))
-		m_host->m_sphere_trees[collisions.category]->update_entity(part_id, pos.value, radius.r);
+	if(m_host->contains(collisions.category, part_id))
+		m_host->update_entity(collisions.category, part_id, pos.value, radius.r);
 }
 
 void rynx::collision_detection::editor_api_t::update_collider_kind_for_entity(rynx::ecs& ecs, rynx::ecs::id id) {
-	for (auto& tree : m_host->m_sphere_trees) {
-		auto try_erase = [&tree](auto id) {
-			if (tree->contains(id)) {
-				tree->eraseEntity(id);
+	for (int32_t category = 0; category < int32_t(m_host->m_sphere_trees.size()); ++category) {
+		auto try_erase = [this, category](auto id) {
+			if (m_host->contains(category, id)) {
+				m_host->erase_entity(category, id);
 			}
 		};
 
@@ -155,10 +175,10 @@ void rynx::collision_detection::editor_api_t::remove_collision_from_entity(
 	rynx::ecs::edit_view<const tracked_by_collisions, const rynx::components::phys::collisions> ecs,
 	rynx::ecs::id id)
 {
-	for (auto& tree : m_host->m_sphere_trees) {
-		auto try_erase = [&tree](auto id) {
-			if (tree->contains(id)) {
-				tree->eraseEntity(id);
+	for (int32_t category = 0; category < int32_t(m_host->m_sphere_trees.size()); ++category) {
+		auto try_erase = [this, category](auto id) {
+			if (m_host->contains(category, id)) {
+				m_host->erase_entity(category, id);
 			}
 		};
 
@@ -195,15 +215,15 @@ void rynx::collision_detection::editor_api_t::set_collision_category_for_entity(
 	
 	if (projectile & !boundary) {
 		const uint64_t part_id = id.value | mask_kind_projectile;
-		m_host->m_sphere_trees[col.category]->insert_entity(part_id, pos.value, r.r);
+		m_host->insert_entity(col.category, part_id, pos.value, r.r);
 	}
 	else if (boundary) {
 		const uint64_t part_id = id.value | mask_kind_boundary;
-		m_host->m_sphere_trees[col.category]->insert_entity(part_id, pos.value, r.r);
+		m_host->insert_entity(col.category, part_id, pos.value, r.r);
 	}
 	else {
 		const uint64_t part_id = id.value | mask_kind_sphere;
-		m_host->m_sphere_trees[col.category]->insert_entity(part_id, pos.value, r.r);
+		m_host->insert_entity(col.category, part_id, pos.value, r.r);
 	}
 	
 	ecs[id].add(tracked_by_collisions());
@@ -234,7 +254,7 @@ void rynx::collision_detection::update_entities(rynx::scheduler::task& task_cont
 		{
 			rynx_assert((id.value & rynx::collision_detection::mask_id) == id.value, "id out of bounds");
 			uint64_t part_id = id.value | mask_kind_sphere;
-			detection.m_sphere_trees[col.category]->update_entity(part_id, pos.value, r.r);
+			detection.update_entity(col.category, part_id, pos.value, r.r);
 		});
 
 		auto boundaries = ecs.query()
@@ -248,7 +268,7 @@ void rynx::collision_detection::update_entities(rynx::scheduler::task& task_cont
 		{
 			rynx_assert((id.value & rynx::collision_detection::mask_id) == id.value, "id out of bounds");
 			uint64_t part_id = id.value | mask_kind_boundary;
-			detection.m_sphere_trees[col.category]->update_entity(part_id, pos.value, r.r);
+			detection.update_entity(col.category, part_id, pos.value, r.r);
 		});
 
 		auto projectiles = ecs.query()
@@ -262,7 +282,7 @@ void rynx::collision_detection::update_entities(rynx::scheduler::task& task_cont
 		{
 			rynx_assert((id.value & rynx::collision_detection::mask_id) == id.value, "id out of bounds");
 			uint64_t part_id = id.value | mask_kind_projectile;
-			detection.m_sphere_trees[col.category]->update_entity(part_id, pos.value - motion.velocity * dt, r.r);
+			detection.update_entity(col.category, part_id, pos.value - motion.velocity * dt, r.r);
 		});
 	});
 
@@ -270,30 +290,28 @@ void rynx::collision_detection::update_entities(rynx::scheduler::task& task_cont
 }
 
 void rynx::collision_detection::erase(rynx::ecs::view<const rynx::components::phys::boundary, const rynx::components::projectile> ecs, uint64_t entityId, category_id from) {
-	auto& sphere_tree = m_sphere_trees[from.value];
-	
 	auto entity = ecs[entityId];
 	if (const auto* boundary = entity.try_get<const rynx::components::phys::boundary>()) {
 		/*
 		for (uint32_t i = 0; i < boundary->segments_world.size(); ++i) {
 			uint64_t id = mask_kind_boundary | entityId | (uint64_t(i) << bits_id);
-			rynx_assert(sphere_tree->contains(id), "");
-			sphere_tree->eraseEntity(id);
+			rynx_assert(contains(from.value, id), "");
+			erase_entity(from.value, id);
 		}
 		*/
 		uint64_t id = mask_kind_boundary | entityId;
-		rynx_assert(sphere_tree->contains(id), "");
-		sphere_tree->eraseEntity(id);
+		rynx_assert(contains(from.value, id), "");
+		erase_entity(from.value, id);
 	}
 	else if (entity.has<rynx::components::projectile>()) {
 		uint64_t id = mask_kind_projectile | entityId;
-		rynx_assert(sphere_tree->contains(id), "");
-		sphere_tree->eraseEntity(id);
+		rynx_assert(contains(from.value, id), "");
+		erase_entity(from.value, id);
 	}
 	else {
 		uint64_t id = mask_kind_sphere | entityId;
-		rynx_assert(sphere_tree->contains(id), "");
-		sphere_tree->eraseEntity(id);
+		rynx_assert(contains(from.value, id), "");
+		erase_entity(from.value, id);
 	}
 }
 
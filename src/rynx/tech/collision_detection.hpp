@@ -2,12 +2,16 @@
 
 #include <rynx/std/dynamic_bitset.hpp>
 #include <rynx/tech/sphere_tree.hpp>
+#include <rynx/tech/spatial_hash.hpp>
+#include <rynx/tech/lbvh.hpp>
 #include <rynx/tech/components.hpp>
 #include <rynx/math/vector.hpp>
 #include <vector>
 
 namespace rynx {
 	class sphere_tree;
+	class spatial_hash;
+	class lbvh;
 	template <typename... Ts> class parallel_accumulator;
 	
 	namespace scheduler {
@@ -25,14 +29,40 @@ namespace rynx {
 
 		struct collision_check {
 			collision_check() = default;
-			collision_check(sphere_tree* a, sphere_tree* b, check_type type = check_type::both_are_dynamic) : a(a), b(b), type(type) {}
-			sphere_tree* a;
-			sphere_tree* b;
+			collision_check(int32_t a, int32_t b, check_type type = check_type::both_are_dynamic) : a(a), b(b), type(type) {}
+			int32_t a;
+			int32_t b;
 			check_type type;
 		};
 
+		// one of these is set for each category, depending on its broadphase.
 		std::vector<rynx::shared_ptr<rynx::sphere_tree>> m_sphere_trees; // TODO: change back to unique_ptr
+		std::vector<rynx::shared_ptr<rynx::spatial_hash>> m_spatial_hashes;
+		std::vector<rynx::shared_ptr<rynx::lbvh>> m_lbvhs;
 		std::vector<collision_check> m_collision_checks;
+
+		// calls f with the broadphase of the category.
+		template<typename F> decltype(auto) with_broadphase(int32_t category, F&& f) {
+			if (m_spatial_hashes[category])
+				return f(*m_spatial_hashes[category]);
+			if (m_lbvhs[category])
+				return f(*m_lbvhs[category]);
+			return f(*m_sphere_trees[category]);
+		}
+
+		// calls f with the broadphase of a category that is not a sphere tree. these keep their entities in flat arrays,
+		// so they can be enumerated in parallel and queried against the other category of a collision check.
+		template<typename F> decltype(auto) with_flat_broadphase(int32_t category, F&& f) {
+			rynx_assert(!m_sphere_trees[category], "category uses a sphere tree");
+			if (m_spatial_hashes[category])
+				return f(*m_spatial_hashes[category]);
+			return f(*m_lbvhs[category]);
+		}
+
+		void insert_entity(int32_t category, uint64_t id, vec3f pos, float radius);
+		void update_entity(int32_t category, uint64_t id, vec3f pos, float radius);
+		bool contains(int32_t category, uint64_t id);
+		void erase_entity(int32_t category, uint64_t id);
 		
 	public:
 		struct category_id {
@@ -86,13 +116,26 @@ namespace rynx {
 
 		static_assert(bits_id + bits_part + bits_kind <= sizeof(mask_id) * 8);
 		
-		category_id add_category();
+		// how the entities of a category are searched for collisions.
+		// sphere_tree adapts to any mix of sizes and keeps its structure between frames.
+		// spatial_hash rebuilds a uniform grid every frame, and is faster for many moving entities of similar size.
+		// lbvh rebuilds a bounding volume hierarchy every frame, so its quality does not degrade under fast motion.
+		enum class broadphase {
+			sphere_tree,
+			spatial_hash,
+			lbvh
+		};
+
+		category_id add_category(broadphase kind = broadphase::sphere_tree);
 		collision_detection& enable_collisions_between(category_id category1, category_id category2);
 		
 		template<typename F> void in_radius(category_id category, vec3<float> point, float radius, F&& f) {
-			m_sphere_trees[category.value]->in_radius(point, radius, std::forward<F>(f));
+			with_broadphase(category.value, [point, radius, &f](auto& broadphase) { broadphase.in_radius(point, radius, f); });
 		}
 
+		// null for categories that do not use an lbvh.
+		lbvh* get_lbvh(category_id category) { return m_lbvhs[category.value].get(); }
+
 		void clear();
 		void update_sphere_trees();
 		void update_sphere_trees_parallel(rynx::scheduler::task& task_context);
@@ -117,64 +160,102 @@ namespace rynx {
 		
 
 		void erase(rynx::ecs::view<const rynx::components::phys::boundary, const rynx::components::projectile> ecs, uint64_t entityId, category_id from);
+		
+		// null for categories that do not use a sphere tree.
 		const sphere_tree* get(category_id category) const;
 
 		template<typename F> void collisions_for(category_id category, F&& f) {
-			sphere_tree::collisions_internal(std::forward<F>(f), &m_sphere_trees[category.value]->root);
+			with_broadphase(category.value, [&f](auto& broadphase) { broadphase.collisions(f); });
 		}
 
 		template<typename F> void collisions_for(category_id category1, category_id category2, F&& f) {
-			sphere_tree::collisions_internal(std::forward<F>(f), &m_sphere_trees[category1.value]->root, &m_sphere_trees[category2.value]->root);
+			sphere_tree* tree1 = m_sphere_trees[category1.value].get();
+			sphere_tree* tree2 = m_sphere_trees[category2.value].get();
+			if (tree1 && tree2) {
+				sphere_tree::collisions_internal(std::forward<F>(f), &tree1->root, &tree2->root);
+			}
+			else if (!tree1) {
+				with_flat_broadphase(category1.value, [this, &f, category2](auto& broadphase1) {
+					broadphase1.for_each_entity([this, &f, category2](uint64_t id1, vec3f pos1, float radius1) {
+						in_radius(category2, pos1, radius1, [&f, id1, pos1, radius1](uint64_t id2, vec3f pos2, float radius2) {
+							sphere_overlap::report_collision(f, id1, pos1, radius1, id2, pos2, radius2);
+						});
+					});
+				});
+			}
+			else {
+				with_flat_broadphase(category2.value, [tree1, &f](auto& broadphase2) {
+					broadphase2.for_each_entity([tree1, &f](uint64_t id2, vec3f pos2, float radius2) {
+						tree1->in_radius(pos2, radius2, [&f, id2, pos2, radius2](uint64_t id1, vec3f pos1, float radius1) {
+							sphere_overlap::report_collision(f, id1, pos1, radius1, id2, pos2, radius2);
+						});
+					});
+				});
+			}
 		}
 
 		template<typename F> void for_each_collision(F&& f) {
 			for (auto&& check : m_collision_checks) {
 				if (check.a == check.b)
-					sphere_tree::collisions_internal(std::forward<F>(f), &check.a->root);
+					collisions_for(check.a, f);
 				else
-					sphere_tree::collisions_internal(std::forward<F>(f), &check.a->root, &check.b->root);
+					collisions_for(check.a, check.b, f);
 			}
 		}
 
 		template<typename T, typename F> void for_each_collision_parallel(rynx::shared_ptr<rynx::parallel_accumulator<T>>& accumulator, F&& f, rynx::scheduler::task& task) {
 			using storage_t = decltype(accumulator->template get_local_storage<T>());
+			auto report = [f](storage_t& storage, uint64_t id1, uint64_t id2, vec3f pos1, float radius1, vec3f pos2, float radius2, vec3f normal, float penetration) {
+				collision_params params;
+				params.id1 = id1 & mask_id;
+				params.id2 = id2 & mask_id;
+				params.kind1 = id1 >> bitshift_kind;
+				params.kind2 = id2 >> bitshift_kind;
+				params.normal = normal;
+				params.part1 = (id1 & mask_part) >> bitshift_part;
+				params.part2 = (id2 & mask_part) >> bitshift_part;
+				rynx_assert(params.part1 == 0 && params.part2 == 0, "o ou");
+				params.penetration = penetration;
+				params.pos1 = pos1;
+				params.pos2 = pos2;
+				params.radius1 = radius1;
+				params.radius2 = radius2;
+				f(storage, params);
+			};
+
 			for (auto&& check : m_collision_checks) {
-				if (check.a == check.b)
-					sphere_tree::collisions_internal_parallel(accumulator, [f](storage_t& storage, uint64_t id1, uint64_t id2, vec3f pos1, float radius1, vec3f pos2, float radius2, vec3f normal, float penetration) {
-						collision_params params;
-						params.id1 = id1 & mask_id;
-						params.id2 = id2 & mask_id;
-						params.kind1 = id1 >> bitshift_kind;
-						params.kind2 = id2 >> bitshift_kind;
-						params.normal = normal;
-						params.part1 = (id1 & mask_part) >> bitshift_part;
-						params.part2 = (id2 & mask_part) >> bitshift_part;
-						rynx_assert(params.part1 == 0 && params.part2 == 0, "o ou");
-						params.penetration = penetration;
-						params.pos1 = pos1;
-						params.pos2 = pos2;
-						params.radius1 = radius1;
-						params.radius2 = radius2;
-						f(storage, params);
-					}, task, &check.a->root);
+				sphere_tree* tree_a = m_sphere_trees[check.a].get();
+				sphere_tree* tree_b = m_sphere_trees[check.b].get();
+
+				if (check.a == check.b) {
+					if (tree_a) {
+						sphere_tree::collisions_internal_parallel(accumulator, report, task, &tree_a->root);
+					}
+					else {
+						with_flat_broadphase(check.a, [&](auto& broadphase) { broadphase.collisions_parallel(accumulator, report, task); });
+					}
+				}
+				else if (tree_a && tree_b) {
+					sphere_tree::collisions_internal_parallel_node_node(accumulator, report, task, &tree_a->root, &tree_b->root);
+				}
+				else if (!tree_a) {
+					// entities of a are queried from b in parallel. the entity of a is always reported first.
+					with_flat_broadphase(check.a, [&](auto& broadphase_a) {
+						broadphase_a.for_each_entity_parallel(accumulator, [this, report, category_b = check.b](storage_t& storage, uint64_t id1, vec3f pos1, float radius1) {
+							in_radius(category_b, pos1, radius1, [&](uint64_t id2, vec3f pos2, float radius2) {
+								sphere_overlap::report_collision(report, id1, pos1, radius1, id2, pos2, radius2, storage);
+							});
+						}, task);
+					});
+				}
 				else {
-					sphere_tree::collisions_internal_parallel_node_node(accumulator, [f](storage_t& storage, uint64_t id1, uint64_t id2, vec3f pos1, float radius1, vec3f pos2, float radius2, vec3f normal, float penetration) {
-						collision_params params;
-						params.id1 = id1 & mask_id;
-						params.id2 = id2 & mask_id;
-						params.kind1 = id1 >> bitshift_kind;
-						params.kind2 = id2 >> bitshift_kind;
-						params.normal = normal;
-						params.part1 = (id1 & mask_part) >> bitshift_part;
-						params.part2 = (id2 & mask_part) >> bitshift_part;
-						rynx_assert(params.part1 == 0 && params.part2 == 0, "o ou");
-						params.penetration = penetration;
-						params.pos1 = pos1;
-						params.pos2 = pos2;
-						params.radius1 = radius1;
-						params.radius2 = radius2;
-						f(storage, params);
-					}, task, &check.a->root, &check.b->root);
+					with_flat_broadphase(check.b, [&](auto& broadphase_b) {
+						broadphase_b.for_each_entity_parallel(accumulator, [report, tree_a](storage_t& storage, uint64_t id2, vec3f pos2, float radius2) {
+							tree_a->in_radius(pos2, radius2, [&](uint64_t id1, vec3f pos1, float radius1) {
+								sphere_overlap::report_collision(report, id1, pos1, radius1, id2, pos2, radius2, storage);
+							});
+						}, task);
+					});
 				}
 			}
 		}
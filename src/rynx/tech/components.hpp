@@ -39,7 +39,8 @@ struct constant_force {
   rynx::vec3f force;
 };
 
-struct motion {
+// blocked storage keeps motion pointers valid while the table grows, see collision events in rulesets/collisions.cpp.
+struct motion : public rynx::ecs_blocked_storage_tag {
   motion() = default;
   motion(rynx::vec3<float> v, float av) : velocity(v), angularVelocity(av) {}
 
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <rynx/std/unordered_map.hpp>
+#include <rynx/system/assert.hpp>
+
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace rynx {
+	// groups contacts to batches in which no two contacts write to the same body. the contacts of one batch can be
+	// solved in parallel without races, and solving the batches in order gives the same result on any number of threads.
+	// contacts are coloured greedily in the order they are given, so the batches are deterministic if that order is.
+	class contact_partition {
+	public:
+		// body key for bodies that contacts do not write to. contacts never conflict through these.
+		static constexpr uint64_t static_body = ~uint64_t(0);
+
+		// contacts that find no free batch among these go to one more batch, which has to be solved on one thread.
+		static constexpr uint32_t max_parallel_batches = 63;
+
+		// bodies(i) returns the pair of body keys that contact i writes to.
+		template<typename F> void build(size_t contact_count, F&& bodies) {
+			m_used_batches.clear();
+			m_batch_of.resize(contact_count);
+
+			uint32_t batch_sizes[max_parallel_batches + 1] = {};
+			for (size_t i = 0; i < contact_count; ++i) {
+				const std::pair<uint64_t, uint64_t> keys = bodies(i);
+				const uint64_t used = used_batches(keys.first) | used_batches(keys.second);
+				const uint32_t batch = uint32_t(std::countr_zero(~used | (uint64_t(1) << max_parallel_batches)));
+				if (batch < max_parallel_batches) {
+					mark_used(keys.first, batch);
+					mark_used(keys.second, batch);
+				}
+				m_batch_of[i] = uint8_t(batch);
+				++batch_sizes[batch];
+			}
+
+			// a contact only gets batch n when batches below n are in use, so the non-empty batches are contiguous.
+			m_batch_begin.assign(1, 0);
+			for (uint32_t batch = 0; batch <= max_parallel_batches && batch_sizes[batch] > 0; ++batch) {
+				m_batch_begin.emplace_back(m_batch_begin.back() + batch_sizes[batch]);
+			}
+
+			// contacts sorted by batch, in their original order within each batch.
+			m_contacts.resize(contact_count);
+			std::vector<uint32_t> cursor(m_batch_begin.begin(), m_batch_begin.end() - 1);
+			for (size_t i = 0; i < contact_count; ++i) {
+				m_contacts[cursor[m_batch_of[i]]++] = uint32_t(i);
+			}
+		}
+
+		size_t batch_count() const {
+			return m_batch_begin.size() - 1;
+		}
+
+		size_t batch_size(size_t batch) const {
+			return m_batch_begin[batch + 1] - m_batch_begin[batch];
+		}
+
+		// contact index of the i'th contact of the batch.
+		uint32_t contact(size_t batch, size_t i) const {
+			rynx_assert(i < batch_size(batch), "index out of bounds");
+			return m_contacts[m_batch_begin[batch] + i];
+		}
+
+		bool is_parallel(size_t batch) const {
+			return batch < max_parallel_batches;
+		}
+
+	private:
+		uint64_t used_batches(uint64_t body) const {
+			if (body == static_body)
+				return 0;
+			auto it = m_used_batches.find(body);
+			return it == m_used_batches.end() ? 0 : it->second;
+		}
+
+		void mark_used(uint64_t body, uint32_t batch) {
+			if (body != static_body)
+				m_used_batches[body] |= uint64_t(1) << batch;
+		}
+
+		rynx::unordered_map<uint64_t, uint64_t> m_used_batches;
+		std::vector<uint8_t> m_batch_of;
+		std::vector<uint32_t> m_contacts;
+		std::vector<uint32_t> m_batch_begin = { 0 };
+	};
+}
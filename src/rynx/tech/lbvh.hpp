@@ -0,0 +1,532 @@
+#pragma once
+
+#include <rynx/math/vector.hpp>
+#include <rynx/profiling/profiling.hpp>
+#include <rynx/std/unordered_map.hpp>
+#include <rynx/tech/parallel/accumulator.hpp>
+#include <rynx/tech/sphere_overlap.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <vector>
+
+// for parallel collision detection
+#include <rynx/scheduler/context.hpp>
+
+namespace rynx {
+	// linear bounding volume hierarchy, built from scratch from the entity positions.
+	// entities are sorted along a morton curve with a radix sort, and the hierarchy is emitted from the sorted keys
+	// with every internal node computed independently (karras 2012). bounds are then refitted from the leaves up.
+	// the quality of the hierarchy does not depend on how far entities have moved since the last frame, which suits
+	// categories with fast moving entities. between full rebuilds, the hierarchy can be kept and only refitted.
+	class lbvh {
+	public:
+		size_t size() const {
+			return m_ids.size();
+		}
+
+		void insert_entity(uint64_t entityId, vec3f pos, float radius) {
+			rynx_assert(m_index_of.find(entityId) == m_index_of.end(), "entity already in lbvh");
+			m_index_of.emplace(entityId, uint32_t(m_ids.size()));
+			m_ids.emplace_back(entityId);
+			m_pos.emplace_back(pos);
+			m_radius.emplace_back(radius);
+			m_topology_changed = true;
+		}
+
+		// only writes the data of the entity, so different entities can be updated in parallel.
+		// the hierarchy sees the change on the next update.
+		void update_entity(uint64_t entityId, vec3f pos, float radius) {
+			auto it = m_index_of.find(entityId);
+			rynx_assert(it != m_index_of.end(), "entity not in lbvh");
+			m_pos[it->second] = pos;
+			m_radius[it->second] = radius;
+		}
+
+		void insert_or_update_entity(uint64_t entityId, vec3f pos, float radius) {
+			if (contains(entityId))
+				update_entity(entityId, pos, radius);
+			else
+				insert_entity(entityId, pos, radius);
+		}
+
+		std::pair<vec3f, float> eraseEntity(uint64_t entityId) {
+			auto it = m_index_of.find(entityId);
+			if (it == m_index_of.end())
+				return { vec3f(), 0.0f };
+
+			const uint32_t index = it->second;
+			const std::pair<vec3f, float> erased = { m_pos[index], m_radius[index] };
+			m_index_of.erase(it);
+
+			// the last entity takes the place of the erased one.
+			const uint32_t last = uint32_t(m_ids.size() - 1);
+			if (index != last) {
+				m_ids[index] = m_ids[last];
+				m_pos[index] = m_pos[last];
+				m_radius[index] = m_radius[last];
+				m_index_of.find(m_ids[index])->second = index;
+			}
+			m_ids.pop_back();
+			m_pos.pop_back();
+			m_radius.pop_back();
+			m_topology_changed = true;
+			return erased;
+		}
+
+		bool contains(uint64_t id) const {
+			return m_index_of.find(id) != m_index_of.end();
+		}
+
+		void clear() {
+			m_index_of.clear();
+			m_ids.clear();
+			m_pos.clear();
+			m_radius.clear();
+			m_topology_changed = true;
+			update();
+		}
+
+		// how many updates share one hierarchy. the updates in between only refit the bounds to the new positions.
+		// the default of 1 rebuilds on every update. inserting or erasing entities always rebuilds on the next update.
+		lbvh& rebuild_interval(uint32_t updates) {
+			m_rebuild_interval = std::max<uint32_t>(1, updates);
+			return *this;
+		}
+
+		void update() {
+			update_with([](int64_t count, int64_t, auto&& op) {
+				for (int64_t i = 0; i < count; ++i)
+					op(i);
+			});
+		}
+
+		rynx::scheduler::barrier update_parallel(rynx::scheduler::task& task_context) {
+			rynx::scheduler::barrier update_complete_barrier;
+			task_context.extend_task_execute_parallel("lbvh update", [this](rynx::scheduler::task& task_context) {
+				update_with([&task_context](int64_t count, int64_t work_size, auto&& op) {
+					task_context.wait(task_context.parallel().range(0, count, work_size).execute(op));
+				});
+			}).required_for(update_complete_barrier);
+			return update_complete_barrier;
+		}
+
+		// calls f(id, pos, radius) for every entity for which test(pos, radius) is true.
+		// test is also called with spheres that contain a group of entities, and must be true if it could be true for any of them.
+		template<typename VolumeTestFunc, typename F>
+		void in_volume(VolumeTestFunc&& test, F&& f) const {
+			traverse(
+				[this, &test](uint32_t node) {
+					const bounds& box = m_bounds[node];
+					return test((box.lo + box.hi) * 0.5f, (box.hi - box.lo).length() * 0.5f);
+				},
+				[this, &test, &f](size_t k) {
+					const vec3f pos(m_x[k], m_y[k], m_z[k]);
+					if (test(pos, m_r[k]))
+						f(m_sorted_ids[k], pos, m_r[k]);
+				});
+		}
+
+		// calls f(id, pos, radius) for every entity that overlaps the sphere (pos, radius), as positioned by the last update.
+		template<typename F>
+		void in_radius(vec3f pos, float radius, F&& f) const {
+			traverse(
+				[this, pos, radius](uint32_t node) {
+					return distance_squared(m_bounds[node], pos) < radius * radius;
+				},
+				[this, pos, radius, &f](size_t k) {
+					const vec3f other(m_x[k], m_y[k], m_z[k]);
+					const float range = radius + m_r[k];
+					if ((pos - other).length_squared() < range * range)
+						f(m_sorted_ids[k], other, m_r[k]);
+				});
+		}
+
+		// calls f(id, pos, radius) for every entity, as positioned by the last update.
+		template<typename F>
+		void for_each_entity(F&& f) const {
+			for (size_t k = 0; k < m_sorted_ids.size(); ++k)
+				f(m_sorted_ids[k], vec3f(m_x[k], m_y[k], m_z[k]), m_r[k]);
+		}
+
+		// parallel version of for_each_entity. f gets the thread local storage of the accumulator as its first argument.
+		template<typename T, typename F>
+		void for_each_entity_parallel(rynx::shared_ptr<rynx::parallel_accumulator<T>> accumulator, F&& f, rynx::scheduler::task& task_context) const {
+			task_context.parallel().range(0, int64_t(m_sorted_ids.size()), 256).execute([this, accumulator, f](int64_t k) mutable {
+				auto& local_accumulator = accumulator->template get_local_storage<T>();
+				f(local_accumulator, m_sorted_ids[k], vec3f(m_x[k], m_y[k], m_z[k]), m_r[k]);
+			});
+		}
+
+		template<typename F>
+		void collisions(F&& f) const {
+			for (size_t i = 0; i < m_sorted_ids.size(); ++i) {
+				leaf_collisions(i, [this, &f, i](size_t k) { report_leaf_pair(f, i, k); });
+			}
+		}
+
+		template<typename T, typename F>
+		void collisions_parallel(rynx::shared_ptr<rynx::parallel_accumulator<T>> accumulator, F&& f, rynx::scheduler::task& task_context) const {
+			task_context.parallel().range(0, int64_t(m_sorted_ids.size()), 256).execute([this, accumulator, f](int64_t i) mutable {
+				auto& local_accumulator = accumulator->template get_local_storage<T>();
+				leaf_collisions(size_t(i), [this, &f, &local_accumulator, i](size_t k) { report_leaf_pair(f, size_t(i), k, local_accumulator); });
+			});
+		}
+
+	private:
+		struct bounds {
+			vec3f lo;
+			vec3f hi;
+		};
+
+		// child references with this bit set are leaves, which are indices to the sorted entities.
+		static constexpr uint32_t leaf_bit = 0x80000000u;
+		static constexpr uint32_t no_parent = ~uint32_t(0);
+
+		static constexpr int64_t radix_bits = 8;
+		static constexpr int64_t radix_size = int64_t(1) << radix_bits;
+		static constexpr int64_t max_sort_chunks = 64;
+		static constexpr int64_t keys_per_sort_chunk = 16384;
+
+		// run(count, work_size, op) calls op(i) for all i in [0, count), and returns when all of them are done.
+		template<typename Run> void update_with(Run&& run) {
+			rynx_profile("LBVH", "update");
+			if (m_topology_changed || ++m_updates_since_rebuild >= m_rebuild_interval) {
+				rebuild(run);
+				m_topology_changed = false;
+				m_updates_since_rebuild = 0;
+			}
+			else {
+				const int64_t n = int64_t(m_ids.size());
+				run(n, 4096, [this](int64_t k) { gather_entity(size_t(k), m_entity_of[k]); });
+				refit(run);
+			}
+		}
+
+		template<typename Run> void rebuild(Run& run) {
+			const int64_t n = int64_t(m_ids.size());
+			m_keys.resize(n);
+			m_keys_swap.resize(n);
+			m_x.resize(n);
+			m_y.resize(n);
+			m_z.resize(n);
+			m_r.resize(n);
+			m_sorted_ids.resize(n);
+			m_entity_of.resize(n);
+			m_leaf_parent.assign(n, no_parent);
+			m_bounds.resize(std::max<int64_t>(n - 1, 0));
+			m_left.resize(m_bounds.size());
+			m_right.resize(m_bounds.size());
+			m_last.resize(m_bounds.size());
+			m_node_parent.resize(m_bounds.size());
+			m_root = n > 1 ? 0 : leaf_bit;
+			if (n == 0)
+				return;
+
+			m_sort_chunks = std::clamp<int64_t>((n + keys_per_sort_chunk - 1) / keys_per_sort_chunk, 1, max_sort_chunks);
+			m_chunk_bounds.resize(m_sort_chunks);
+			m_histograms.resize(m_sort_chunks * radix_size);
+
+			{
+				rynx_profile("LBVH", "morton codes");
+				run(m_sort_chunks, 1, [this](int64_t chunk) { chunk_center_bounds(chunk); });
+				bounds scene = m_chunk_bounds[0];
+				for (const bounds& chunk : m_chunk_bounds) {
+					scene.lo = vec3f(std::min(scene.lo.x, chunk.lo.x), std::min(scene.lo.y, chunk.lo.y), std::min(scene.lo.z, chunk.lo.z));
+					scene.hi = vec3f(std::max(scene.hi.x, chunk.hi.x), std::max(scene.hi.y, chunk.hi.y), std::max(scene.hi.z, chunk.hi.z));
+				}
+
+				m_morton_origin = scene.lo;
+				const vec3f extent = scene.hi - scene.lo;
+				m_morton_scale = vec3f(
+					extent.x > 0 ? 1023.0f / extent.x : 0.0f,
+					extent.y > 0 ? 1023.0f / extent.y : 0.0f,
+					extent.z > 0 ? 1023.0f / extent.z : 0.0f);
+				run(n, 4096, [this](int64_t i) {
+					m_keys[i] = (uint64_t(morton_code(m_pos[i])) << 32) | uint64_t(i);
+				});
+			}
+
+			{
+				// the entity index in the low bits is already in order, only the 30 bits of the morton code are sorted.
+				// the sort is stable, so the keys end up unique and fully sorted.
+				rynx_profile("LBVH", "radix sort");
+				for (int64_t shift = 32; shift < 62; shift += radix_bits) {
+					run(m_sort_chunks, 1, [this, shift](int64_t chunk) { count_digits(chunk, shift); });
+					if (digit_offsets()) {
+						run(m_sort_chunks, 1, [this, shift](int64_t chunk) { scatter_keys(chunk, shift); });
+						m_keys.swap(m_keys_swap);
+					}
+				}
+			}
+
+			{
+				rynx_profile("LBVH", "hierarchy");
+				run(n, 4096, [this](int64_t k) {
+					const uint32_t entity = uint32_t(m_keys[k]);
+					m_entity_of[k] = entity;
+					m_sorted_ids[k] = m_ids[entity];
+					gather_entity(size_t(k), entity);
+				});
+				run(n - 1, 1024, [this](int64_t node) { emit_node(node); });
+			}
+
+			refit(run);
+		}
+
+		template<typename Run> void refit(Run& run) {
+			rynx_profile("LBVH", "refit");
+			m_visits.assign(m_bounds.size(), 0);
+			run(int64_t(m_leaf_parent.size()), 1024, [this](int64_t k) { refit_from_leaf(size_t(k)); });
+		}
+
+		void gather_entity(size_t k, uint32_t entity) {
+			m_x[k] = m_pos[entity].x;
+			m_y[k] = m_pos[entity].y;
+			m_z[k] = m_pos[entity].z;
+			m_r[k] = m_radius[entity];
+		}
+
+		int64_t chunk_begin(int64_t chunk) const {
+			return chunk * int64_t(m_keys.size()) / m_sort_chunks;
+		}
+
+		void chunk_center_bounds(int64_t chunk) {
+			constexpr float max_float = std::numeric_limits<float>::max();
+			bounds result{ vec3f(max_float, max_float, max_float), vec3f(-max_float, -max_float, -max_float) };
+			for (int64_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); ++i) {
+				const vec3f p = m_pos[i];
+				result.lo = vec3f(std::min(result.lo.x, p.x), std::min(result.lo.y, p.y), std::min(result.lo.z, p.z));
+				result.hi = vec3f(std::max(result.hi.x, p.x), std::max(result.hi.y, p.y), std::max(result.hi.z, p.z));
+			}
+			m_chunk_bounds[chunk] = result;
+		}
+
+		static uint32_t spread_bits(uint32_t v) {
+			v = (v * 0x00010001u) & 0xFF0000FFu;
+			v = (v * 0x00000101u) & 0x0F00F00Fu;
+			v = (v * 0x00000011u) & 0xC30C30C3u;
+			v = (v * 0x00000005u) & 0x49249249u;
+			return v;
+		}
+
+		uint32_t morton_code(vec3f pos) const {
+			auto quantize = [](float v) { return uint32_t(std::clamp(v, 0.0f, 1023.0f)); };
+			const vec3f p = pos - m_morton_origin;
+			return
+				(spread_bits(quantize(p.x * m_morton_scale.x)) << 2) |
+				(spread_bits(quantize(p.y * m_morton_scale.y)) << 1) |
+				spread_bits(quantize(p.z * m_morton_scale.z));
+		}
+
+		void count_digits(int64_t chunk, int64_t shift) {
+			uint32_t* histogram = m_histograms.data() + chunk * radix_size;
+			std::fill(histogram, histogram + radix_size, 0);
+			for (int64_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); ++i)
+				++histogram[(m_keys[i] >> shift) & (radix_size - 1)];
+		}
+
+		// turns the digit counts of each chunk to the first output index of the digit in that chunk.
+		// returns false if every key has the same digit, in which case the pass would not change the order.
+		bool digit_offsets() {
+			uint32_t offset = 0;
+			for (int64_t digit = 0; digit < radix_size; ++digit) {
+				uint32_t digit_total = 0;
+				for (int64_t chunk = 0; chunk < m_sort_chunks; ++chunk) {
+					uint32_t& count = m_histograms[chunk * radix_size + digit];
+					const uint32_t chunk_count = count;
+					count = offset + digit_total;
+					digit_total += chunk_count;
+				}
+				if (digit_total == m_keys.size())
+					return false;
+				offset += digit_total;
+			}
+			return true;
+		}
+
+		void scatter_keys(int64_t chunk, int64_t shift) {
+			uint32_t* offsets = m_histograms.data() + chunk * radix_size;
+			for (int64_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); ++i)
+				m_keys_swap[offsets[(m_keys[i] >> shift) & (radix_size - 1)]++] = m_keys[i];
+		}
+
+		// length of the common prefix of two sorted keys, or -1 if j is out of range.
+		int common_prefix(int64_t i, int64_t j) const {
+			if (j < 0 || j >= int64_t(m_keys.size()))
+				return -1;
+			return std::countl_zero(m_keys[i] ^ m_keys[j]);
+		}
+
+		// finds the range of leaves that internal node i covers, and where that range splits to its two children.
+		void emit_node(int64_t i) {
+			const int64_t direction = common_prefix(i, i + 1) > common_prefix(i, i - 1) ? 1 : -1;
+			const int min_prefix = common_prefix(i, i - direction);
+
+			int64_t max_length = 2;
+			while (common_prefix(i, i + max_length * direction) > min_prefix)
+				max_length *= 2;
+
+			int64_t length = 0;
+			for (int64_t step = max_length / 2; step >= 1; step /= 2) {
+				if (common_prefix(i, i + (length + step) * direction) > min_prefix)
+					length += step;
+			}
+
+			const int64_t j = i + length * direction;
+			const int node_prefix = common_prefix(i, j);
+			int64_t split_offset = 0;
+			int64_t step = length;
+			do {
+				step = (step + 1) / 2;
+				if (common_prefix(i, i + (split_offset + step) * direction) > node_prefix)
+					split_offset += step;
+			} while (step > 1);
+
+			const int64_t split = i + split_offset * direction + std::min<int64_t>(direction, 0);
+			const int64_t first = std::min(i, j);
+			const int64_t last = std::max(i, j);
+
+			const uint32_t left = first == split ? uint32_t(split) | leaf_bit : uint32_t(split);
+			const uint32_t right = last == split + 1 ? uint32_t(split + 1) | leaf_bit : uint32_t(split + 1);
+			m_left[i] = left;
+			m_right[i] = right;
+			m_last[i] = uint32_t(last);
+			set_parent(left, uint32_t(i));
+			set_parent(right, uint32_t(i));
+			if (i == 0)
+				m_node_parent[0] = no_parent;
+		}
+
+		void set_parent(uint32_t child, uint32_t parent) {
+			if (child & leaf_bit)
+				m_leaf_parent[child & ~leaf_bit] = parent;
+			else
+				m_node_parent[child] = parent;
+		}
+
+		bounds child_bounds(uint32_t child) const {
+			if (child & leaf_bit) {
+				const uint32_t k = child & ~leaf_bit;
+				const vec3f pos(m_x[k], m_y[k], m_z[k]);
+				const vec3f extent(m_r[k], m_r[k], m_r[k]);
+				return { pos - extent, pos + extent };
+			}
+			return m_bounds[child];
+		}
+
+		// walks up from a leaf. the first child to reach a node stops there, the second one merges the bounds of both.
+		void refit_from_leaf(size_t k) {
+			uint32_t node = m_leaf_parent[k];
+			while (node != no_parent) {
+				if (std::atomic_ref<uint32_t>(m_visits[node]).fetch_add(1, std::memory_order_acq_rel) == 0)
+					return;
+
+				const bounds a = child_bounds(m_left[node]);
+				const bounds b = child_bounds(m_right[node]);
+				m_bounds[node] = {
+					vec3f(std::min(a.lo.x, b.lo.x), std::min(a.lo.y, b.lo.y), std::min(a.lo.z, b.lo.z)),
+					vec3f(std::max(a.hi.x, b.hi.x), std::max(a.hi.y, b.hi.y), std::max(a.hi.z, b.hi.z))
+				};
+				node = m_node_parent[node];
+			}
+		}
+
+		static float distance_squared(const bounds& box, vec3f p) {
+			const float dx = std::max({ box.lo.x - p.x, 0.0f, p.x - box.hi.x });
+			const float dy = std::max({ box.lo.y - p.y, 0.0f, p.y - box.hi.y });
+			const float dz = std::max({ box.lo.z - p.z, 0.0f, p.z - box.hi.z });
+			return dx * dx + dy * dy + dz * dz;
+		}
+
+		// depth first walk. enter(node) decides whether an internal node is visited, leaf(k) is called for the leaves reached.
+		template<typename Enter, typename Leaf> void traverse(Enter&& enter, Leaf&& leaf) const {
+			if (m_sorted_ids.empty())
+				return;
+
+			// every level of the hierarchy extends the common prefix of the 64 bit keys, so the depth is at most 64.
+			uint32_t stack[128];
+			int32_t top = 0;
+			stack[top++] = m_root;
+			while (top > 0) {
+				const uint32_t node = stack[--top];
+				if (node & leaf_bit) {
+					leaf(node & ~leaf_bit);
+				}
+				else if (enter(node)) {
+					stack[top++] = m_right[node];
+					stack[top++] = m_left[node];
+				}
+			}
+		}
+
+		// calls hit(k) for every leaf k > i that overlaps leaf i.
+		template<typename F> void leaf_collisions(size_t i, F&& hit) const {
+			const vec3f pos(m_x[i], m_y[i], m_z[i]);
+			const float radius = m_r[i];
+			const vec3f extent(radius, radius, radius);
+			const bounds query{ pos - extent, pos + extent };
+			traverse(
+				[this, i, &query](uint32_t node) {
+					const bounds& box = m_bounds[node];
+					return m_last[node] > i &&
+						box.lo.x <= query.hi.x && query.lo.x <= box.hi.x &&
+						box.lo.y <= query.hi.y && query.lo.y <= box.hi.y &&
+						box.lo.z <= query.hi.z && query.lo.z <= box.hi.z;
+				},
+				[this, i, pos, radius, &hit](size_t k) {
+					if (k <= i)
+						return;
+					const float range = radius + m_r[k];
+					if ((pos - vec3f(m_x[k], m_y[k], m_z[k])).length_squared() < range * range)
+						hit(k);
+				});
+		}
+
+		template<typename F, typename... Storage> void report_leaf_pair(F& f, size_t i, size_t k, Storage&... storage) const {
+			sphere_overlap::report_collision(f,
+				m_sorted_ids[i], vec3f(m_x[i], m_y[i], m_z[i]), m_r[i],
+				m_sorted_ids[k], vec3f(m_x[k], m_y[k], m_z[k]), m_r[k],
+				storage...);
+		}
+
+		// entities in insertion order. updates write here, the hierarchy is built from these.
+		rynx::unordered_map<uint64_t, uint32_t> m_index_of;
+		std::vector<uint64_t> m_ids;
+		std::vector<vec3f> m_pos;
+		std::vector<float> m_radius;
+
+		bool m_topology_changed = true;
+		uint32_t m_rebuild_interval = 1;
+		uint32_t m_updates_since_rebuild = 0;
+
+		// morton code sort state.
+		vec3f m_morton_origin;
+		vec3f m_morton_scale;
+		int64_t m_sort_chunks = 1;
+		std::vector<bounds> m_chunk_bounds;
+		std::vector<uint32_t> m_histograms;
+		std::vector<uint64_t> m_keys;
+		std::vector<uint64_t> m_keys_swap;
+
+		// leaves, in morton order.
+		std::vector<float> m_x;
+		std::vector<float> m_y;
+		std::vector<float> m_z;
+		std::vector<float> m_r;
+		std::vector<uint64_t> m_sorted_ids;
+		std::vector<uint32_t> m_entity_of;
+		std::vector<uint32_t> m_leaf_parent;
+
+		// internal nodes. node 0 is the root when there are at least two leaves.
+		uint32_t m_root = leaf_bit;
+		std::vector<bounds> m_bounds;
+		std::vector<uint32_t> m_left;
+		std::vector<uint32_t> m_right;
+		std::vector<uint32_t> m_last; // last leaf under the node, for skipping pairs that were already found.
+		std::vector<uint32_t> m_node_parent;
+		std::vector<uint32_t> m_visits;
+	};
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <rynx/system/assert.hpp>
+
+#include <vector>
+#include <mutex>
+#include <new>
+#include <cstddef>
+
+namespace rynx {
+	namespace tech {
+
+		// hands out fixed size memory blocks. released blocks are kept and reused, most recently released first.
+		// blocks are only returned to the system when the pool is destroyed, so blocks must not outlive their pool.
+		// thread safe.
+		class memory_block_pool {
+		public:
+			static constexpr size_t block_alignment = 64;
+
+			memory_block_pool(size_t block_size) : m_block_size(block_size) {
+				rynx_assert(block_size >= block_alignment, "block size must be at least one cache line");
+			}
+
+			memory_block_pool(const memory_block_pool&) = delete;
+			memory_block_pool& operator = (const memory_block_pool&) = delete;
+
+			~memory_block_pool() {
+				for (void* block : m_free) {
+					::operator delete(block, std::align_val_t(block_alignment));
+				}
+			}
+
+			void* acquire() {
+				std::scoped_lock lock(m_mutex);
+				if (!m_free.empty()) {
+					void* block = m_free.back();
+					m_free.pop_back();
+					return block;
+				}
+				++m_num_allocated;
+				return ::operator new(m_block_size, std::align_val_t(block_alignment));
+			}
+
+			void release(void* block) {
+				rynx_assert(block != nullptr, "releasing null block");
+				std::scoped_lock lock(m_mutex);
+				m_free.emplace_back(block);
+			}
+
+			size_t block_size() const { return m_block_size; }
+
+			// blocks allocated from the system, both in use and free.
+			size_t total_allocated_blocks() const {
+				std::scoped_lock lock(m_mutex);
+				return m_num_allocated;
+			}
+
+			size_t free_blocks() const {
+				std::scoped_lock lock(m_mutex);
+				return m_free.size();
+			}
+
+		private:
+			mutable std::mutex m_mutex;
+			std::vector<void*> m_free;
+			size_t m_num_allocated = 0;
+			size_t m_block_size;
+		};
+	}
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <rynx/std/memory.hpp>
+#include <rynx/system/assert.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace rynx {
+	namespace parallel {
+
+		// chase-lev work stealing deque.
+		// owner thread pushes and pops at the bottom, any other thread can steal from the top. all operations are lock-free.
+		// T must be trivially copyable, since thieves may read a slot that the owner is about to overwrite. store pointers for other types.
+		template<typename T>
+		class work_stealing_deque {
+			static_assert(std::is_trivially_copyable_v<T>, "work stealing deque elements must be trivially copyable");
+
+			struct ring {
+				ring(int64_t capacity) : m_mask(capacity - 1), m_slots(new std::atomic<T>[capacity]) {
+					rynx_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+				}
+
+				int64_t capacity() const { return m_mask + 1; }
+				T load(int64_t index) const { return m_slots[index & m_mask].load(std::memory_order_relaxed); }
+				void store(int64_t index, T value) { m_slots[index & m_mask].store(value, std::memory_order_relaxed); }
+
+				rynx::unique_ptr<ring> grow(int64_t bottom, int64_t top) const {
+					auto bigger = rynx::make_unique<ring>(capacity() * 2);
+					for (int64_t i = top; i < bottom; ++i) {
+						bigger->store(i, load(i));
+					}
+					return bigger;
+				}
+
+				int64_t m_mask;
+				rynx::unique_ptr<std::atomic<T>[]> m_slots;
+			};
+
+		public:
+			work_stealing_deque(int64_t capacity = 256) {
+				m_rings.emplace_back(rynx::make_unique<ring>(capacity));
+				m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+			}
+
+			work_stealing_deque(const work_stealing_deque&) = delete;
+			work_stealing_deque& operator = (const work_stealing_deque&) = delete;
+
+			// owner only.
+			void push(T value) {
+				const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+				const int64_t top = m_top.load(std::memory_order_acquire);
+				ring* current = m_ring.load(std::memory_order_relaxed);
+				if (bottom - top > current->capacity() - 1) [[unlikely]] {
+					// thieves may still be reading the old ring, it is kept alive until the deque is destroyed.
+					m_rings.emplace_back(current->grow(bottom, top));
+					current = m_rings.back().get();
+					m_ring.store(current, std::memory_order_release);
+				}
+				current->store(bottom, value);
+				std::atomic_thread_fence(std::memory_order_release);
+				m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+
+			// owner only. takes the most recently pushed value.
+			[[nodiscard]] bool pop(T& out) {
+				const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+				ring* current = m_ring.load(std::memory_order_relaxed);
+				m_bottom.store(bottom, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t top = m_top.load(std::memory_order_relaxed);
+
+				if (top > bottom) {
+					// empty.
+					m_bottom.store(bottom + 1, std::memory_order_relaxed);
+					return false;
+				}
+
+				out = current->load(bottom);
+				if (top == bottom) {
+					// last value, race against thieves for it.
+					const bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+					m_bottom.store(bottom + 1, std::memory_order_relaxed);
+					return won;
+				}
+				return true;
+			}
+
+			// any thread. takes the oldest value.
+			[[nodiscard]] bool steal(T& out) {
+				int64_t top = m_top.load(std::memory_order_acquire);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+				if (top >= bottom) {
+					return false;
+				}
+
+				ring* current = m_ring.load(std::memory_order_acquire);
+				T value = current->load(top);
+				if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					return false;
+				}
+				out = value;
+				return true;
+			}
+
+			bool empty() const {
+				return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+			}
+
+			int64_t size() const {
+				const int64_t size = m_bottom.load(std::memory_order_relaxed) - m_top.load(std::memory_order_relaxed);
+				return size > 0 ? size : 0;
+			}
+
+		private:
+			alignas(std::hardware_destructive_interference_size) std::atomic<int64_t> m_top = 0;
+			alignas(std::hardware_destructive_interference_size) std::atomic<int64_t> m_bottom = 0;
+			alignas(std::hardware_destructive_interference_size) std::atomic<ring*> m_ring = nullptr;
+			std::vector<rynx::unique_ptr<ring>> m_rings; // owner only. current ring is the last one.
+		};
+	}
+}
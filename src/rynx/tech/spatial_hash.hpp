@@ -0,0 +1,482 @@
+#pragma once
+
+#include <rynx/math/vector.hpp>
+#include <rynx/profiling/profiling.hpp>
+#include <rynx/std/unordered_map.hpp>
+#include <rynx/tech/parallel/accumulator.hpp>
+#include <rynx/tech/sphere_overlap.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+// for parallel collision detection
+#include <rynx/scheduler/context.hpp>
+
+namespace rynx {
+	// uniform grid broadphase for categories of many similarly sized spheres.
+	// the grid is rebuilt from scratch on every update with a counting sort of the entities to their cells.
+	// cells are found through a hash table, so the grid has no bounds. the cell size is picked from the radii of the entities,
+	// and the few entities that are much larger than the typical one are kept outside of the grid and tested separately.
+	class spatial_hash {
+	public:
+		size_t size() const {
+			return m_ids.size();
+		}
+
+		void insert_entity(uint64_t entityId, vec3f pos, float radius) {
+			rynx_assert(m_index_of.find(entityId) == m_index_of.end(), "entity already in spatial hash");
+			m_index_of.emplace(entityId, uint32_t(m_ids.size()));
+			m_ids.emplace_back(entityId);
+			m_pos.emplace_back(pos);
+			m_radius.emplace_back(radius);
+		}
+
+		// only writes the data of the entity, so different entities can be updated in parallel.
+		// the grid sees the change on the next update.
+		void update_entity(uint64_t entityId, vec3f pos, float radius) {
+			auto it = m_index_of.find(entityId);
+			rynx_assert(it != m_index_of.end(), "entity not in spatial hash");
+			m_pos[it->second] = pos;
+			m_radius[it->second] = radius;
+		}
+
+		void insert_or_update_entity(uint64_t entityId, vec3f pos, float radius) {
+			if (contains(entityId))
+				update_entity(entityId, pos, radius);
+			else
+				insert_entity(entityId, pos, radius);
+		}
+
+		std::pair<vec3f, float> eraseEntity(uint64_t entityId) {
+			auto it = m_index_of.find(entityId);
+			if (it == m_index_of.end())
+				return { vec3f(), 0.0f };
+
+			const uint32_t index = it->second;
+			const std::pair<vec3f, float> erased = { m_pos[index], m_radius[index] };
+			m_index_of.erase(it);
+
+			// the last entity takes the place of the erased one.
+			const uint32_t last = uint32_t(m_ids.size() - 1);
+			if (index != last) {
+				m_ids[index] = m_ids[last];
+				m_pos[index] = m_pos[last];
+				m_radius[index] = m_radius[last];
+				m_index_of.find(m_ids[index])->second = index;
+			}
+			m_ids.pop_back();
+			m_pos.pop_back();
+			m_radius.pop_back();
+			return erased;
+		}
+
+		bool contains(uint64_t id) const {
+			return m_index_of.find(id) != m_index_of.end();
+		}
+
+		void clear() {
+			m_index_of.clear();
+			m_ids.clear();
+			m_pos.clear();
+			m_radius.clear();
+			prepare();
+			sum_offsets();
+		}
+
+		float cell_size() const {
+			return m_cell_size;
+		}
+
+		void update() {
+			rynx_profile("SpatialHash", "update");
+			prepare();
+			for (size_t i = 0; i < m_ids.size(); ++i)
+				count_entity(i);
+			for (size_t block = 0; block < m_block_offsets.size(); ++block)
+				sum_block(block);
+			sum_offsets();
+			for (size_t block = 0; block < m_block_offsets.size(); ++block)
+				apply_block_offsets(block);
+			for (size_t i = 0; i < m_ids.size(); ++i)
+				sort_entity(i);
+		}
+
+		rynx::scheduler::barrier update_parallel(rynx::scheduler::task& task_context) {
+			prepare();
+			if (m_ids.empty()) {
+				sum_offsets();
+				return {};
+			}
+
+			const int64_t entity_count = int64_t(m_ids.size());
+			const int64_t block_count = int64_t(m_block_offsets.size());
+
+			rynx::scheduler::barrier counted_bar;
+			rynx::scheduler::barrier block_sums_bar;
+			rynx::scheduler::barrier offsets_bar;
+			rynx::scheduler::barrier update_complete_barrier;
+
+			task_context.extend_task_execute_parallel("spatial hash count", [this, entity_count](rynx::scheduler::task& task_context) {
+				task_context.parallel().range(0, entity_count, 2048).execute([this](int64_t i) { count_entity(i); });
+			}).required_for(counted_bar);
+
+			task_context.extend_task_execute_parallel("spatial hash block sums", [this, block_count](rynx::scheduler::task& task_context) {
+				task_context.parallel().range(0, block_count, 1).execute([this](int64_t block) { sum_block(block); });
+			}).depends_on(counted_bar).required_for(block_sums_bar);
+
+			task_context.extend_task_execute_parallel("spatial hash offsets", [this, block_count](rynx::scheduler::task& task_context) {
+				sum_offsets();
+				task_context.parallel().range(0, block_count, 1).execute([this](int64_t block) { apply_block_offsets(block); });
+			}).depends_on(block_sums_bar).required_for(offsets_bar);
+
+			task_context.extend_task_execute_parallel("spatial hash sort", [this, entity_count](rynx::scheduler::task& task_context) {
+				task_context.parallel().range(0, entity_count, 2048).execute([this](int64_t i) { sort_entity(i); });
+			}).depends_on(offsets_bar).required_for(update_complete_barrier);
+
+			return update_complete_barrier;
+		}
+
+		// calls f(id, pos, radius) for every entity that overlaps the sphere (pos, radius), as positioned by the last update.
+		template<typename F>
+		void in_radius(vec3f pos, float radius, F&& f) const {
+			grid_overlaps(pos.x, pos.y, pos.z, radius, [this, &f](size_t k) {
+				f(m_sorted_ids[k], vec3f(m_x[k], m_y[k], m_z[k]), m_r[k]);
+			});
+			sphere_overlap::one_vs_many(pos.x, pos.y, pos.z, radius, large_spheres(), 0, [this, &f](size_t k) {
+				f(m_large_ids[k], vec3f(m_large_x[k], m_large_y[k], m_large_z[k]), m_large_r[k]);
+			});
+		}
+
+		// calls f(id, pos, radius) for every entity, as positioned by the last update.
+		template<typename F>
+		void for_each_entity(F&& f) const {
+			for (size_t k = 0; k < m_grid_size; ++k)
+				f(m_sorted_ids[k], vec3f(m_x[k], m_y[k], m_z[k]), m_r[k]);
+			for (size_t k = 0; k < m_large_ids.size(); ++k)
+				f(m_large_ids[k], vec3f(m_large_x[k], m_large_y[k], m_large_z[k]), m_large_r[k]);
+		}
+
+		// parallel version of for_each_entity. f gets the thread local storage of the accumulator as its first argument.
+		template<typename T, typename F>
+		void for_each_entity_parallel(rynx::shared_ptr<rynx::parallel_accumulator<T>> accumulator, F&& f, rynx::scheduler::task& task_context) const {
+			const int64_t total = int64_t(m_grid_size + m_large_ids.size());
+			task_context.parallel().range(0, total, 256).execute([this, accumulator, f](int64_t i) mutable {
+				auto& local_accumulator = accumulator->template get_local_storage<T>();
+				const size_t k = size_t(i);
+				if (k < m_grid_size) {
+					f(local_accumulator, m_sorted_ids[k], vec3f(m_x[k], m_y[k], m_z[k]), m_r[k]);
+				}
+				else {
+					const size_t large = k - m_grid_size;
+					f(local_accumulator, m_large_ids[large], vec3f(m_large_x[large], m_large_y[large], m_large_z[large]), m_large_r[large]);
+				}
+			});
+		}
+
+		template<typename F>
+		void collisions(F&& f) const {
+			for (size_t i = 0; i < m_grid_size; ++i) {
+				grid_collisions_of(i, [this, &f, i](size_t k) { report_grid_pair(f, i, k); });
+			}
+			for (size_t i = 0; i < m_large_ids.size(); ++i) {
+				large_collisions_of(i, [this, &f, i](size_t k) { report_large_grid_pair(f, i, k); }, [this, &f, i](size_t k) { report_large_pair(f, i, k); });
+			}
+		}
+
+		template<typename T, typename F>
+		void collisions_parallel(rynx::shared_ptr<rynx::parallel_accumulator<T>> accumulator, F&& f, rynx::scheduler::task& task_context) const {
+			task_context.parallel().range(0, int64_t(m_grid_size), 256).execute([this, accumulator, f](int64_t i) mutable {
+				auto& local_accumulator = accumulator->template get_local_storage<T>();
+				grid_collisions_of(size_t(i), [this, &f, &local_accumulator, i](size_t k) { report_grid_pair(f, size_t(i), k, local_accumulator); });
+			});
+
+			if (!m_large_ids.empty()) {
+				task_context.parallel().range(0, int64_t(m_large_ids.size()), 1).execute([this, accumulator, f](int64_t i) mutable {
+					auto& local_accumulator = accumulator->template get_local_storage<T>();
+					large_collisions_of(size_t(i),
+						[this, &f, &local_accumulator, i](size_t k) { report_large_grid_pair(f, size_t(i), k, local_accumulator); },
+						[this, &f, &local_accumulator, i](size_t k) { report_large_pair(f, size_t(i), k, local_accumulator); });
+				});
+			}
+		}
+
+	private:
+		static constexpr uint32_t not_in_grid = ~uint32_t(0);
+		static constexpr size_t buckets_per_block = 4096;
+		static constexpr size_t radius_samples = 256;
+
+		// queries that would visit more cells than this test against every entity in the grid instead.
+		static constexpr int64_t max_query_cells = 512;
+
+		// the grid fits entities up to twice the median radius of a sample, or the largest sampled radius if it is smaller.
+		// cells are four times that radius, so that the reach of a grid entity to its possible collision partners
+		// touches at most two cells on each axis.
+		void pick_cell_size() {
+			const size_t count = m_radius.size();
+			float grid_radius = 0;
+			if (count > 0) {
+				const size_t stride = std::max<size_t>(1, count / radius_samples);
+				std::vector<float> sample;
+				sample.reserve(radius_samples + 1);
+				for (size_t i = 0; i < count; i += stride)
+					sample.emplace_back(m_radius[i]);
+
+				auto median = sample.begin() + sample.size() / 2;
+				std::nth_element(sample.begin(), median, sample.end());
+				grid_radius = std::min(*std::max_element(sample.begin(), sample.end()), 2.0f * (*median));
+			}
+			if (!(grid_radius > 0))
+				grid_radius = 1.0f;
+
+			m_grid_radius = grid_radius;
+			m_cell_size = 4.0f * grid_radius;
+			m_inv_cell_size = 1.0f / m_cell_size;
+		}
+
+		void prepare() {
+			pick_cell_size();
+
+			const size_t count = m_ids.size();
+			size_t bucket_count = 64;
+			while (bucket_count < count)
+				bucket_count *= 2;
+
+			m_bucket_mask = uint32_t(bucket_count - 1);
+			m_bucket_fill.assign(bucket_count, 0);
+			m_bucket_begin.resize(bucket_count + 1);
+			m_block_offsets.assign((bucket_count + buckets_per_block - 1) / buckets_per_block, 0);
+			m_bucket_of.resize(count);
+			m_large_indices.resize(count);
+			m_large_count.store(0, std::memory_order_relaxed);
+		}
+
+		int32_t cell_of(float v) const {
+			return int32_t(std::floor(v * m_inv_cell_size));
+		}
+
+		uint32_t bucket_of_cell(int32_t x, int32_t y, int32_t z) const {
+			return ((uint32_t(x) * 73856093u) ^ (uint32_t(y) * 19349663u) ^ (uint32_t(z) * 83492791u)) & m_bucket_mask;
+		}
+
+		void count_entity(size_t i) {
+			if (m_radius[i] > m_grid_radius) {
+				m_bucket_of[i] = not_in_grid;
+				m_large_indices[m_large_count.fetch_add(1, std::memory_order_relaxed)] = uint32_t(i);
+				return;
+			}
+
+			const vec3f pos = m_pos[i];
+			const uint32_t bucket = bucket_of_cell(cell_of(pos.x), cell_of(pos.y), cell_of(pos.z));
+			m_bucket_of[i] = bucket;
+			std::atomic_ref<uint32_t>(m_bucket_fill[bucket]).fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void sum_block(size_t block) {
+			const size_t begin = block * buckets_per_block;
+			const size_t end = std::min(begin + buckets_per_block, m_bucket_fill.size());
+			uint32_t sum = 0;
+			for (size_t bucket = begin; bucket < end; ++bucket)
+				sum += m_bucket_fill[bucket];
+			m_block_offsets[block] = sum;
+		}
+
+		// turns block sums to block offsets, and makes room for the sorted entities.
+		void sum_offsets() {
+			uint32_t offset = 0;
+			for (uint32_t& block : m_block_offsets) {
+				const uint32_t sum = block;
+				block = offset;
+				offset += sum;
+			}
+			m_grid_size = offset;
+			m_bucket_begin.back() = offset;
+
+			// padded so that the overlap kernels can load full vectors at the end of any bucket.
+			m_x.resize(m_grid_size + sphere_overlap::simd_width);
+			m_y.resize(m_grid_size + sphere_overlap::simd_width);
+			m_z.resize(m_grid_size + sphere_overlap::simd_width);
+			m_r.resize(m_grid_size + sphere_overlap::simd_width);
+			m_sorted_ids.resize(m_grid_size);
+
+			// large entities are few, so they are ordered here to keep the results independent of thread timing.
+			const size_t large_count = m_large_count.load(std::memory_order_relaxed);
+			std::sort(m_large_indices.begin(), m_large_indices.begin() + large_count);
+			const size_t padded = sphere_overlap::padded_size(large_count);
+			m_large_x.resize(padded);
+			m_large_y.resize(padded);
+			m_large_z.resize(padded);
+			m_large_r.resize(padded);
+			m_large_ids.resize(large_count);
+			for (size_t k = 0; k < large_count; ++k) {
+				const uint32_t index = m_large_indices[k];
+				m_large_x[k] = m_pos[index].x;
+				m_large_y[k] = m_pos[index].y;
+				m_large_z[k] = m_pos[index].z;
+				m_large_r[k] = m_radius[index];
+				m_large_ids[k] = m_ids[index];
+			}
+		}
+
+		// bucket counts become the first sorted index of each bucket. counts are reset for use as insertion cursors.
+		void apply_block_offsets(size_t block) {
+			const size_t begin = block * buckets_per_block;
+			const size_t end = std::min(begin + buckets_per_block, m_bucket_fill.size());
+			uint32_t offset = m_block_offsets[block];
+			for (size_t bucket = begin; bucket < end; ++bucket) {
+				m_bucket_begin[bucket] = offset;
+				offset += m_bucket_fill[bucket];
+				m_bucket_fill[bucket] = 0;
+			}
+		}
+
+		void sort_entity(size_t i) {
+			const uint32_t bucket = m_bucket_of[i];
+			if (bucket == not_in_grid)
+				return;
+
+			const uint32_t k = m_bucket_begin[bucket] + std::atomic_ref<uint32_t>(m_bucket_fill[bucket]).fetch_add(1, std::memory_order_relaxed);
+			m_x[k] = m_pos[i].x;
+			m_y[k] = m_pos[i].y;
+			m_z[k] = m_pos[i].z;
+			m_r[k] = m_radius[i];
+			m_sorted_ids[k] = m_ids[i];
+		}
+
+		sphere_overlap::spheres_view grid_spheres(size_t end) const {
+			return { m_x.data(), m_y.data(), m_z.data(), m_r.data(), end };
+		}
+
+		sphere_overlap::spheres_view large_spheres() const {
+			return { m_large_x.data(), m_large_y.data(), m_large_z.data(), m_large_r.data(), m_large_ids.size() };
+		}
+
+		// calls visit(bucket) once for every bucket of the cells that the box (x, y, z) +- reach touches.
+		// returns false without visiting anything if the box touches more than max_query_cells cells.
+		template<typename F> bool for_each_bucket_in_box(float x, float y, float z, float reach, F&& visit) const {
+			const int32_t x0 = cell_of(x - reach), x1 = cell_of(x + reach);
+			const int32_t y0 = cell_of(y - reach), y1 = cell_of(y + reach);
+			const int32_t z0 = cell_of(z - reach), z1 = cell_of(z + reach);
+			const int64_t cells = (int64_t(x1) - x0 + 1) * (int64_t(y1) - y0 + 1) * (int64_t(z1) - z0 + 1);
+			if (cells > max_query_cells)
+				return false;
+
+			// collision queries touch at most 2x2x2 cells, larger queries are rare.
+			uint32_t local_buckets[27];
+			std::vector<uint32_t> buckets_storage;
+			uint32_t* buckets = local_buckets;
+			if (cells > 27) {
+				buckets_storage.resize(size_t(cells));
+				buckets = buckets_storage.data();
+			}
+
+			uint32_t bucket_count = 0;
+			for (int32_t cz = z0; cz <= z1; ++cz)
+				for (int32_t cy = y0; cy <= y1; ++cy)
+					for (int32_t cx = x0; cx <= x1; ++cx)
+						buckets[bucket_count++] = bucket_of_cell(cx, cy, cz);
+
+			// different cells can share a bucket.
+			std::sort(buckets, buckets + bucket_count);
+			bucket_count = uint32_t(std::unique(buckets, buckets + bucket_count) - buckets);
+			for (uint32_t b = 0; b < bucket_count; ++b)
+				visit(buckets[b]);
+			return true;
+		}
+
+		// calls hit(k) for every grid entity k > i that overlaps grid entity i.
+		template<typename F> void grid_collisions_of(size_t i, F&& hit) const {
+			const float x = m_x[i];
+			const float y = m_y[i];
+			const float z = m_z[i];
+			const float r = m_r[i];
+			for_each_bucket_in_box(x, y, z, r + m_grid_radius, [&](uint32_t bucket) {
+				const size_t begin = std::max<size_t>(m_bucket_begin[bucket], i + 1);
+				const size_t end = m_bucket_begin[bucket + 1];
+				if (begin < end) {
+					sphere_overlap::one_vs_many(x, y, z, r, grid_spheres(end), begin, hit);
+				}
+			});
+		}
+
+		// calls hit(k) for every grid entity k that overlaps the sphere.
+		template<typename F> void grid_overlaps(float x, float y, float z, float r, F&& hit) const {
+			if (m_grid_size == 0)
+				return;
+
+			const bool visited = for_each_bucket_in_box(x, y, z, r + m_grid_radius, [&](uint32_t bucket) {
+				const size_t begin = m_bucket_begin[bucket];
+				const size_t end = m_bucket_begin[bucket + 1];
+				if (begin < end) {
+					sphere_overlap::one_vs_many(x, y, z, r, grid_spheres(end), begin, hit);
+				}
+			});
+
+			if (!visited) {
+				sphere_overlap::one_vs_many(x, y, z, r, grid_spheres(m_grid_size), 0, hit);
+			}
+		}
+
+		// calls grid_hit(k) for grid entities and large_hit(k) for large entities k > i that overlap large entity i.
+		template<typename GridF, typename LargeF> void large_collisions_of(size_t i, GridF&& grid_hit, LargeF&& large_hit) const {
+			grid_overlaps(m_large_x[i], m_large_y[i], m_large_z[i], m_large_r[i], grid_hit);
+			sphere_overlap::one_vs_many(m_large_x[i], m_large_y[i], m_large_z[i], m_large_r[i], large_spheres(), i + 1, large_hit);
+		}
+
+		template<typename F, typename... Storage> void report_grid_pair(F& f, size_t i, size_t k, Storage&... storage) const {
+			sphere_overlap::report_collision(f,
+				m_sorted_ids[i], vec3f(m_x[i], m_y[i], m_z[i]), m_r[i],
+				m_sorted_ids[k], vec3f(m_x[k], m_y[k], m_z[k]), m_r[k],
+				storage...);
+		}
+
+		template<typename F, typename... Storage> void report_large_grid_pair(F& f, size_t i, size_t k, Storage&... storage) const {
+			sphere_overlap::report_collision(f,
+				m_large_ids[i], vec3f(m_large_x[i], m_large_y[i], m_large_z[i]), m_large_r[i],
+				m_sorted_ids[k], vec3f(m_x[k], m_y[k], m_z[k]), m_r[k],
+				storage...);
+		}
+
+		template<typename F, typename... Storage> void report_large_pair(F& f, size_t i, size_t k, Storage&... storage) const {
+			sphere_overlap::report_collision(f,
+				m_large_ids[i], vec3f(m_large_x[i], m_large_y[i], m_large_z[i]), m_large_r[i],
+				m_large_ids[k], vec3f(m_large_x[k], m_large_y[k], m_large_z[k]), m_large_r[k],
+				storage...);
+		}
+
+		// entities in insertion order. updates write here, the grid is built from these.
+		rynx::unordered_map<uint64_t, uint32_t> m_index_of;
+		std::vector<uint64_t> m_ids;
+		std::vector<vec3f> m_pos;
+		std::vector<float> m_radius;
+
+		float m_grid_radius = 0.5f;
+		float m_cell_size = 1.0f;
+		float m_inv_cell_size = 1.0f;
+
+		// counting sort state.
+		uint32_t m_bucket_mask = 0;
+		std::vector<uint32_t> m_bucket_of;
+		std::vector<uint32_t> m_bucket_fill;
+		std::vector<uint32_t> m_bucket_begin = { 0 };
+		std::vector<uint32_t> m_block_offsets;
+		std::vector<uint32_t> m_large_indices;
+		std::atomic<uint32_t> m_large_count = 0;
+
+		// grid entities sorted by bucket, as of the last update.
+		size_t m_grid_size = 0;
+		std::vector<float> m_x;
+		std::vector<float> m_y;
+		std::vector<float> m_z;
+		std::vector<float> m_r;
+		std::vector<uint64_t> m_sorted_ids;
+
+		// entities too large for the grid.
+		std::vector<float> m_large_x;
+		std::vector<float> m_large_y;
+		std::vector<float> m_large_z;
+		std::vector<float> m_large_r;
+		std::vector<uint64_t> m_large_ids;
+	};
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <rynx/math/vector.hpp>
+#include <rynx/system/intrinsics.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+// the avx2 kernels are compiled for every x86-64 build, and are used when the cpu running the program supports them.
+#if defined(_M_X64) || defined(__x86_64__)
+#define rynx_sphere_overlap_avx2 1
+#include <immintrin.h>
+#if defined(__AVX2__) || defined(_MSC_VER)
+#define rynx_target_avx2
+#else
+#define rynx_target_avx2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace rynx {
+	namespace sphere_overlap {
+		// kernels load this many spheres at a time. arrays given to them must be readable up to their size rounded
+		// up to a multiple of this. the padding values do not matter, padded lanes never report hits.
+		static constexpr size_t simd_width = 8;
+
+		inline size_t padded_size(size_t size) {
+			return (size + simd_width - 1) & ~(simd_width - 1);
+		}
+
+		// calls f with the collision data of two overlapping spheres, the way every broadphase reports them: the normal points
+		// from the second sphere to the first, and the penetration is the sum of the radii minus the distance.
+		// storage is the thread local accumulator in parallel versions.
+		template<typename F, typename... Storage> void report_collision(F& f, uint64_t id1, vec3f pos1, float radius1, uint64_t id2, vec3f pos2, float radius2, Storage&... storage) {
+			float distSqr = (pos1 - pos2).length_squared();
+			float radiusSqr = (radius1 + radius2) * (radius1 + radius2);
+			f(storage..., id1, id2, pos1, radius1, pos2, radius2, (pos1 - pos2).normalize(), math::sqrt_approx(radiusSqr) - math::sqrt_approx(distSqr));
+		}
+
+		// spheres as separate coordinate arrays.
+		struct spheres_view {
+			const float* x;
+			const float* y;
+			const float* z;
+			const float* r;
+			size_t size;
+		};
+
+		// calls hit(k) for every sphere k in [begin, spheres.size) that overlaps the sphere (x, y, z, r).
+		template<typename F> void one_vs_many_scalar(float x, float y, float z, float r, const spheres_view& spheres, size_t begin, F&& hit) {
+			for (size_t k = begin; k < spheres.size; ++k) {
+				const float dx = x - spheres.x[k];
+				const float dy = y - spheres.y[k];
+				const float dz = z - spheres.z[k];
+				const float radius = r + spheres.r[k];
+				if (dx * dx + dy * dy + dz * dz < radius * radius) {
+					hit(k);
+				}
+			}
+		}
+
+#if defined(rynx_sphere_overlap_avx2)
+		inline bool cpu_has_avx2() noexcept {
+#if defined(__AVX2__)
+			return true;
+#elif defined(_MSC_VER)
+			static const bool supported = []() {
+				int info[4];
+				__cpuid(info, 0);
+				if (info[0] < 7) {
+					return false;
+				}
+				// the os must also save the ymm registers on context switches.
+				__cpuid(info, 1);
+				const bool ymm_saved = (info[2] & (1 << 27)) && ((_xgetbv(0) & 6) == 6);
+				__cpuidex(info, 7, 0);
+				return ymm_saved && (info[1] & (1 << 5));
+			}();
+			return supported;
+#else
+			static const bool supported = __builtin_cpu_supports("avx2");
+			return supported;
+#endif
+		}
+
+		template<typename F> rynx_target_avx2 void one_vs_many_avx2(float x, float y, float z, float r, const spheres_view& spheres, size_t begin, F&& hit) {
+			const __m256 px = _mm256_set1_ps(x);
+			const __m256 py = _mm256_set1_ps(y);
+			const __m256 pz = _mm256_set1_ps(z);
+			const __m256 pr = _mm256_set1_ps(r);
+
+			// starts from the vector containing begin, so that loads never go past the padded size.
+			for (size_t k = begin & ~(simd_width - 1); k < spheres.size; k += simd_width) {
+				const __m256 dx = _mm256_sub_ps(px, _mm256_loadu_ps(spheres.x + k));
+				const __m256 dy = _mm256_sub_ps(py, _mm256_loadu_ps(spheres.y + k));
+				const __m256 dz = _mm256_sub_ps(pz, _mm256_loadu_ps(spheres.z + k));
+				const __m256 radius = _mm256_add_ps(pr, _mm256_loadu_ps(spheres.r + k));
+				const __m256 dist_sqr = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+				uint64_t hits = uint64_t(_mm256_movemask_ps(_mm256_cmp_ps(dist_sqr, _mm256_mul_ps(radius, radius), _CMP_LT_OQ)));
+
+				// lanes before begin, and padding lanes after the last sphere.
+				hits &= ~uint64_t(0) << (k < begin ? begin - k : 0);
+				hits &= spheres.size - k >= simd_width ? ~uint64_t(0) : (uint64_t(1) << (spheres.size - k)) - 1;
+				while (hits) {
+					hit(k + findFirstSetBit(hits));
+					hits &= hits - 1;
+				}
+			}
+		}
+#else
+		inline bool cpu_has_avx2() noexcept { return false; }
+#endif
+
+		template<typename F> void one_vs_many(float x, float y, float z, float r, const spheres_view& spheres, size_t begin, F&& hit) {
+#if defined(rynx_sphere_overlap_avx2)
+			if (cpu_has_avx2()) {
+				one_vs_many_avx2(x, y, z, r, spheres, begin, hit);
+				return;
+			}
+#endif
+			one_vs_many_scalar(x, y, z, r, spheres, begin, hit);
+		}
+
+		// calls hit(i, k) with i < k for every overlapping pair of spheres.
+		template<typename F> void all_pairs(const spheres_view& spheres, F&& hit) {
+			for (size_t i = 0; i + 1 < spheres.size; ++i) {
+				one_vs_many(spheres.x[i], spheres.y[i], spheres.z[i], spheres.r[i], spheres, i + 1, [&hit, i](size_t k) { hit(i, k); });
+			}
+		}
+
+		template<typename F> void all_pairs_scalar(const spheres_view& spheres, F&& hit) {
+			for (size_t i = 0; i + 1 < spheres.size; ++i) {
+				one_vs_many_scalar(spheres.x[i], spheres.y[i], spheres.z[i], spheres.r[i], spheres, i + 1, [&hit, i](size_t k) { hit(i, k); });
+			}
+		}
+
+#if defined(rynx_sphere_overlap_avx2)
+		// only when cpu_has_avx2.
+		template<typename F> void all_pairs_avx2(const spheres_view& spheres, F&& hit) {
+			for (size_t i = 0; i + 1 < spheres.size; ++i) {
+				one_vs_many_avx2(spheres.x[i], spheres.y[i], spheres.z[i], spheres.r[i], spheres, i + 1, [&hit, i](size_t k) { hit(i, k); });
+			}
+		}
+#endif
+	}
+}
@@ -5,6 +5,7 @@
 #include <rynx/profiling/profiling.hpp>
 #include <rynx/std/unordered_map.hpp>
 #include <rynx/tech/parallel/accumulator.hpp>
+#include <rynx/tech/sphere_overlap.hpp>
 
 #include <vector>
 
@@ -38,6 +39,68 @@ namespace rynx {
 			uint64_t entityId;
 		};
 
+		// members of a leaf as separate arrays, padded for the kernels of rynx::sphere_overlap.
+		class leaf_members {
+		public:
+			size_t size() const { return m_size; }
+			bool empty() const { return m_size == 0; }
+
+			entry operator[](size_t i) const { return entry(pos(i), m_r[i], m_id[i]); }
+			entry back() const { return (*this)[m_size - 1]; }
+
+			vec3<float> pos(size_t i) const { return vec3<float>(m_x[i], m_y[i], m_z[i]); }
+			float radius(size_t i) const { return m_r[i]; }
+			uint64_t id(size_t i) const { return m_id[i]; }
+
+			void set(size_t i, const entry& item) {
+				set_sphere(i, item.pos, item.radius);
+				m_id[i] = item.entityId;
+			}
+
+			void set_sphere(size_t i, vec3<float> p, float r) {
+				m_x[i] = p.x;
+				m_y[i] = p.y;
+				m_z[i] = p.z;
+				m_r[i] = r;
+			}
+
+			void emplace_back(const entry& item) {
+				if (m_size == m_id.size()) {
+					const size_t capacity = m_size < sphere_overlap::simd_width ? sphere_overlap::simd_width : m_size * 2;
+					m_x.resize(capacity);
+					m_y.resize(capacity);
+					m_z.resize(capacity);
+					m_r.resize(capacity);
+					m_id.resize(capacity);
+				}
+				set(m_size++, item);
+			}
+
+			void pop_back() { --m_size; }
+			void clear() { m_size = 0; }
+
+			sphere_overlap::spheres_view spheres() const {
+				return { m_x.data(), m_y.data(), m_z.data(), m_r.data(), m_size };
+			}
+
+			// for algorithms written for arrays of spheres.
+			void gather(std::vector<entry>& out) const {
+				out.clear();
+				for (size_t i = 0; i < m_size; ++i) {
+					out.emplace_back((*this)[i]);
+				}
+			}
+
+		private:
+			// sizes are kept at a multiple of the simd width.
+			std::vector<float> m_x;
+			std::vector<float> m_y;
+			std::vector<float> m_z;
+			std::vector<float> m_r;
+			std::vector<uint64_t> m_id;
+			size_t m_size = 0;
+		};
+
 		struct node {
 			node(vec3<float> pos, node* parent, int depth = 0) : pos(pos), m_parent(parent), depth(depth) {}
 
@@ -53,9 +116,9 @@ namespace rynx {
 			}
 
 			uint64_t entity_migrates(index_t member_index, sphere_tree* container) {
-				auto id_of_erased = m_members[member_index].entityId;
-				m_members[member_index] = std::move(m_members.back());
-				container->entryMap.find(m_members[member_index].entityId)->second.second = member_index;
+				auto id_of_erased = m_members.id(member_index);
+				m_members.set(member_index, m_members.back());
+				container->entryMap.find(m_members.id(member_index))->second.second = member_index;
 				m_members.pop_back();
 				return id_of_erased;
 			}
@@ -81,19 +144,19 @@ namespace rynx {
 				container->entryMap.erase(erasedEntity);
 			}
 
-			void insert(entry&& item, sphere_tree* container) {
+			void insert(const entry& item, sphere_tree* container) {
 				rynx_assert(m_children.empty(), "insert can only be done on leaf nodes");
-				m_members.emplace_back(std::move(item));
-				container->entryMap.insert_or_assign(m_members.back().entityId, std::pair<node*, index_t>(this, index_t(m_members.size() - 1)));
+				m_members.emplace_back(item);
+				container->entryMap.insert_or_assign(item.entityId, std::pair<node*, index_t>(this, index_t(m_members.size() - 1)));
 
 				if (m_members.size() >= MaxElementsInNode) [[unlikely]] {
 					// if we have no parent (we are root node), add a couple of new child nodes under me.
 					if (!m_parent) [[unlikely]] {
 						for (size_t i = 0; i < MaxNodesInNode; ++i) {
-							m_children.emplace_back(rynx::make_unique<node>(m_members[i].pos, this, depth + 1));
+							m_children.emplace_back(rynx::make_unique<node>(m_members.pos(i), this, depth + 1));
 						}
 						for (size_t i = 0; i < m_members.size(); ++i) {
-							m_children[i % m_children.size()]->insert(std::move(m_members[i]), container);
+							m_children[i % m_children.size()]->insert(m_members[i], container);
 						}
 						m_members.clear();
 						for (auto& child : m_children) {
@@ -126,11 +189,13 @@ namespace rynx {
 						}
 
 						// now there should be space in parent node's children list, add new siblings to self there.
-						auto f1 = rynx::math::farPoint(m_members.back().pos, m_members);
+						thread_local std::vector<entry> members;
+						m_members.gather(members);
+						auto f1 = rynx::math::farPoint(members.back().pos, members);
 						{
-							m_parent->m_children.emplace_back(rynx::make_unique<node>(m_members[f1.first].pos, m_parent, depth));
-							auto id = m_members[f1.first].entityId;
-							m_parent->m_children.back()->m_members.emplace_back(std::move(m_members[f1.first]));
+							m_parent->m_children.emplace_back(rynx::make_unique<node>(m_members.pos(f1.first), m_parent, depth));
+							auto id = m_members.id(f1.first);
+							m_parent->m_children.back()->m_members.emplace_back(m_members[f1.first]);
 
 							auto& datap = container->entryMap.find(id)->second;
 							datap.first = m_parent->m_children.back().get();
@@ -138,7 +203,7 @@ namespace rynx {
 						}
 						if (f1.first != m_members.size() - 1) {
 							auto id = m_members.back().entityId;
-							m_members[f1.first] = std::move(m_members.back());
+							m_members.set(f1.first, m_members.back());
 							container->entryMap.find(id)->second.second = index_t(f1.first); // also need to update mapping of new f1.first
 
 						}
@@ -190,7 +255,9 @@ namespace rynx {
 					if (m_members.empty()) {
 						return;
 					}
-					posInfo = rynx::math::bounding_sphere(m_members);
+					thread_local std::vector<entry> members;
+					m_members.gather(members);
+					posInfo = rynx::math::bounding_sphere(members);
 				}
 				else {
 					posInfo = rynx::math::bounding_sphere(m_children);
@@ -290,9 +357,10 @@ namespace rynx {
 			void in_volume(VolumeTestFunc&& test, F&& f) {
 				if (test(pos, radius)) {
 					if (m_children.empty()) {
-						for (auto&& item : m_members) {
-							if (test(item.pos, item.radius)) {
-								f(item.entityId, item.pos, item.radius);
+						for (size_t i = 0; i < m_members.size(); ++i) {
+							const vec3<float> item_pos = m_members.pos(i);
+							if (test(item_pos, m_members.radius(i))) {
+								f(m_members.id(i), item_pos, m_members.radius(i));
 							}
 						}
 					}
@@ -342,7 +410,7 @@ namespace rynx {
 			node* m_parent = nullptr;
 			node* m_new_parent = nullptr;
 			std::vector<rynx::unique_ptr<node>> m_children; // child nodes
-			std::vector<entry> m_members;
+			leaf_members m_members;
 		};
 
 		rynx::unordered_map<uint64_t, std::pair<node*, index_t>> entryMap;
@@ -366,17 +434,13 @@ namespace rynx {
 		void update_entity(uint64_t entityId, vec3f pos, float radius) {
 			auto it = entryMap.find(entityId);
 			rynx_assert(it != entryMap.end(), "entity not in sphere tree");
-			auto& data = it->second.first->m_members[it->second.second];
-			data.pos = pos;
-			data.radius = radius;
+			it->second.first->m_members.set_sphere(it->second.second, pos, radius);
 		}
 
 		void insert_or_update_entity(uint64_t entityId, vec3<float> pos, float radius) {
 			auto it = entryMap.find(entityId);
 			if (it != entryMap.end()) {
-				auto& data = it->second.first->m_members[it->second.second];
-				data.pos = pos;
-				data.radius = radius;
+				it->second.first->m_members.set_sphere(it->second.second, pos, radius);
 			}
 			else {
 				auto res = root.findNearestLeaf(pos, std::numeric_limits<float>::max());
@@ -430,7 +494,7 @@ namespace rynx {
 
 					// move to new bucket.
 					it->second.first->entity_migrates(it->second.second, this);
-					newLeaf.first->insert(std::move(item), this);
+					newLeaf.first->insert(item, this);
 				}
 
 				update_next_index = it.index();
@@ -517,7 +581,7 @@ namespace rynx {
 						auto item = entry.second.first->m_members[entry.second.second];
 
 						entry.second.first->entity_migrates(entry.second.second, this);
-						migratee.new_parent->insert(std::move(item), this);
+						migratee.new_parent->insert(item, this);
 					}
 				});
 			}).depends_on(bar).required_for(entities_migrated_bar);
@@ -698,6 +762,34 @@ namespace rynx {
 			}
 		}
 
+		// calls f with the collision data of two overlapping members. storage is the thread local accumulator in parallel versions.
+		template<typename F, typename... Storage> static void report_collision(F& f, const entry& m1, const entry& m2, Storage&... storage) {
+			sphere_overlap::report_collision(f, m1.entityId, m1.pos, m1.radius, m2.entityId, m2.pos, m2.radius, storage...);
+		}
+
+		// calls hit(m1, m2) for every overlapping pair of members of a leaf.
+		template<typename F> static void leaf_collisions(const node* a, F&& hit) {
+			const leaf_members& members = a->m_members;
+			sphere_overlap::all_pairs(members.spheres(), [&members, &hit](size_t i, size_t k) {
+				hit(members[i], members[k]);
+			});
+		}
+
+		// calls hit(m1, m2) for every overlapping pair of a member of leaf a and a member of leaf b.
+		// only the members of a that reach the bounds of b are tested against the members of b.
+		template<typename F> static void leaf_leaf_collisions(const node* a, const node* b, F&& hit) {
+			const leaf_members& members_a = a->m_members;
+			const leaf_members& members_b = b->m_members;
+			const sphere_overlap::spheres_view spheres_a = members_a.spheres();
+			const sphere_overlap::spheres_view spheres_b = members_b.spheres();
+			sphere_overlap::one_vs_many(b->pos.x, b->pos.y, b->pos.z, b->radius, spheres_a, 0, [&](size_t i) {
+				const entry member1 = members_a[i];
+				sphere_overlap::one_vs_many(spheres_a.x[i], spheres_a.y[i], spheres_a.z[i], spheres_a.r[i], spheres_b, 0, [&](size_t k) {
+					hit(member1, members_b[k]);
+				});
+			});
+		}
+
 		template<typename T, typename F> static void collisions_internal_parallel_intra_node(
 			rynx::shared_ptr<rynx::parallel_accumulator<T>> accumulator,
 			F&& f,
@@ -709,18 +801,9 @@ namespace rynx {
 			auto leaf_node_count = leaf_nodes.size();
 			task.parallel().range(0, leaf_node_count, 8).execute([accumulator, f, leaf_nodes = std::move(leaf_nodes)](int64_t node_index) mutable {
 				auto& local_accumulator = accumulator->template get_local_storage<T>();
-				const node* a = leaf_nodes[node_index];
-				for (size_t i = 0; i < a->m_members.size(); ++i) {
-					const auto& m1 = a->m_members[i];
-					for (size_t k = i + 1; k < a->m_members.size(); ++k) {
-						const auto& m2 = a->m_members[k];
-						float distSqr = (m1.pos - m2.pos).length_squared();
-						float radiusSqr = sqr(m1.radius + m2.radius);
-						if (distSqr < radiusSqr) {
-							f(local_accumulator, m1.entityId, m2.entityId, m1.pos, m1.radius, m2.pos, m2.radius, (m1.pos - m2.pos).normalize(), math::sqrt_approx(radiusSqr) - math::sqrt_approx(distSqr));
-						}
-					}
-				}
+				leaf_collisions(leaf_nodes[node_index], [&f, &local_accumulator](const entry& m1, const entry& m2) {
+					report_collision(f, m1, m2, local_accumulator);
+				});
 			});
 		}
 
@@ -742,22 +825,13 @@ namespace rynx {
 				if (!leaf_pairs->slot_test(i))
 					return;
 
-				auto& entry = leaf_pairs->slot_get(i);
-				const node* a = entry.first;
-				for (const node* b : entry.second) {
-					for (const auto& member1 : a->m_members) {
-						if ((member1.pos - b->pos).length_squared() < sqr(member1.radius + b->radius)) {
-							for (const auto& member2 : b->m_members) {
-								float distSqr = (member1.pos - member2.pos).length_squared();
-								float radiusSqr = sqr(member1.radius + member2.radius);
-								if (distSqr < radiusSqr) {
-									auto normal = (member1.pos - member2.pos).normalize();
-									float penetration = math::sqrt_approx(radiusSqr) - math::sqrt_approx(distSqr);
-									f(accumulator->template get_local_storage<T>(), member1.entityId, member2.entityId, member1.pos, member1.radius, member2.pos, member2.radius, normal, penetration);
-								}
-							}
-						}
-					}
+				auto& leaf_pair = leaf_pairs->slot_get(i);
+				const node* a = leaf_pair.first;
+				auto& local_accumulator = accumulator->template get_local_storage<T>();
+				for (const node* b : leaf_pair.second) {
+					leaf_leaf_collisions(a, b, [&f, &local_accumulator](const entry& m1, const entry& m2) {
+						report_collision(f, m1, m2, local_accumulator);
+					});
 				}
 			});
 		}
@@ -784,17 +858,9 @@ namespace rynx {
 			rynx_assert(a != nullptr, "node cannot be null");
 
 			if (a->m_children.empty()) {
-				for (size_t i = 0; i < a->m_members.size(); ++i) {
-					const auto& m1 = a->m_members[i];
-					for (size_t k = i + 1; k < a->m_members.size(); ++k) {
-						const auto& m2 = a->m_members[k];
-						float distSqr = (m1.pos - m2.pos).length_squared();
-						float radiusSqr = sqr(m1.radius + m2.radius);
-						if (distSqr < radiusSqr) {
-							f(m1.entityId, m2.entityId, m1.pos, m1.radius, m2.pos, m2.radius, (m1.pos - m2.pos).normalize(), math::sqrt_approx(radiusSqr) - math::sqrt_approx(distSqr));
-						}
-					}
-				}
+				leaf_collisions(a, [&f](const entry& m1, const entry& m2) {
+					report_collision(f, m1, m2);
+				});
 			}
 			else {
 				for (const auto& child : a->m_children) {
@@ -843,19 +909,9 @@ namespace rynx {
 						b = tmp;
 					}
 
-					for (const auto& member1 : a->m_members) {
-						if ((member1.pos - b->pos).length_squared() < sqr(member1.radius + b->radius)) {
-							for (const auto& member2 : b->m_members) {
-								float distSqr = (member1.pos - member2.pos).length_squared();
-								float radiusSqr = sqr(member1.radius + member2.radius);
-								if (distSqr < radiusSqr) {
-									auto normal = (member1.pos - member2.pos).normalize();
-									float penetration = math::sqrt_approx(radiusSqr) - math::sqrt_approx(distSqr);
-									f(member1.entityId, member2.entityId, member1.pos, member1.radius, member2.pos, member2.radius, normal, penetration);
-								}
-							}
-						}
-					}
+					leaf_leaf_collisions(a, b, [&f](const entry& m1, const entry& m2) {
+						report_collision(f, m1, m2);
+					});
 				}
 				else {
 					for (const auto& child : b->m_children) {
@@ -3,18 +3,26 @@
 
 #include <rynx/std/function.hpp>
 
+#include <cstddef>
+
 #ifndef _WIN32
 #include <ucontext.h>
 #endif
 
-class Fiber {
+class ThreadDLL Fiber {
 private:
 	Fiber(void* platformFiber);
 
 public:
-	Fiber();
+	static constexpr size_t default_stack_size = 1024 * 1024;
+
+	// the stack has an inaccessible guard page below it, so an overflow faults instead of corrupting memory.
+	Fiber(size_t stack_size = default_stack_size);
 	~Fiber();
 
+	Fiber(const Fiber&) = delete;
+	Fiber& operator = (const Fiber&) = delete;
+
 	void go(rynx::function<void(Fiber*)>);
 	void resume();
 	void yield() const;
@@ -46,5 +54,7 @@ private:
 	// assume linux
 	ucontext_t caller;
 	ucontext_t callee;
+	void* m_stack = nullptr; // mapping starts with the guard page.
+	size_t m_stack_bytes = 0;
 #endif
 };
@@ -2,9 +2,12 @@
 #if __linux__
 
 #include <ucontext.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <cstdint>
 
 #include <rynx/thread/fiber.hpp>
+#include <rynx/system/assert.hpp>
 
 // TLS pointer, since multiple threads can be in fiber mode.
 thread_local ucontext_t g_activeContext;
@@ -21,10 +24,17 @@ Fiber::Fiber(void* platformFiber) {
 	m_callingFiber = nullptr;
 }
 
-Fiber::Fiber() {
+Fiber::Fiber(size_t stack_size) {
+	const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t usable_bytes = (stack_size + page_size - 1) / page_size * page_size;
+	m_stack_bytes = usable_bytes + page_size;
+	m_stack = mmap(nullptr, m_stack_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+	rynx_assert(m_stack != MAP_FAILED, "failed to map fiber stack");
+	mprotect(m_stack, page_size, PROT_NONE); // stack grows down, towards the guard page.
+
 	getcontext(&callee);
-	callee.uc_stack.ss_size = 1024 * 1024;
-	callee.uc_stack.ss_sp = new char[1024 * 1024]; // 1MB stack
+	callee.uc_stack.ss_size = usable_bytes;
+	callee.uc_stack.ss_sp = static_cast<char*>(m_stack) + page_size;
 	
 	unsigned highBits = (reinterpret_cast<long long>(this) >> 32);
 	unsigned lowBits = reinterpret_cast<long long>(this);
@@ -39,7 +49,7 @@ Fiber::~Fiber() {
 	if(m_isThread) {
 	}
 	else {
-		delete[] (char*)callee.uc_stack.ss_sp; // release stack
+		munmap(m_stack, m_stack_bytes); // release stack
 	}
 	m_fiber = nullptr;
 }
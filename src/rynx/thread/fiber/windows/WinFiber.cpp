@@ -9,9 +9,10 @@ Fiber::Fiber(void* platformFiber) {
 	m_fiber = platformFiber;
 }
 
-Fiber::Fiber() {
+Fiber::Fiber(size_t stack_size) {
+	// windows fiber stacks are reserved with a guard page already.
 	m_isThread = false;
-	m_fiber = CreateFiber(0, Fiber::fiberStartingFunction, this);
+	m_fiber = CreateFiber(stack_size, Fiber::fiberStartingFunction, this);
 }
 
 Fiber::~Fiber() {
@@ -1,7 +1,9 @@
 
 #include <rynx/thread/this_thread.hpp>
 #include <rynx/std/unordered_map.hpp>
+#include <algorithm>
 #include <atomic>
+#include <functional>
 #include <thread>
 #include <mutex>
 #include <vector>
@@ -10,7 +12,7 @@ namespace {
 	std::atomic<uint64_t> g_tid_counter = 0;
 	rynx::unordered_map<std::thread::id, uint64_t> g_thread_id_map;
 	thread_local uint64_t t_my_tid = ~uint64_t(0);
-	std::vector<uint64_t> g_free_tids;
+	std::vector<uint64_t> g_free_tids; // min heap. reusing the smallest free id keeps ids dense, so that they can index per thread arrays.
 	std::mutex m_init_mutex;
 }
 
@@ -18,6 +20,7 @@ void init_for_this_thread() {
 	std::unique_lock lock(m_init_mutex);
 	uint64_t my_tid;
 	if (!g_free_tids.empty()) {
+		std::pop_heap(g_free_tids.begin(), g_free_tids.end(), std::greater<uint64_t>());
 		my_tid = g_free_tids.back();
 		g_free_tids.pop_back();
 	}
@@ -32,6 +35,7 @@ void release_for_this_thread() {
 	std::unique_lock lock(m_init_mutex);
 	g_thread_id_map.erase(std::this_thread::get_id());
 	g_free_tids.emplace_back(t_my_tid);
+	std::push_heap(g_free_tids.begin(), g_free_tids.end(), std::greater<uint64_t>());
 }
 
 int64_t rynx::this_thread::id() {
@@ -0,0 +1,422 @@
+
+#include <catch.hpp>
+
+#include <rynx/rulesets/physics/contacts.hpp>
+#include <rynx/scheduler/task_scheduler.hpp>
+#include <rynx/tech/contact_partition.hpp>
+#include <rynx/thread/this_thread.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+	using rynx::ruleset::physics::collision_event;
+	using rynx::ruleset::physics::contact_extra_info;
+	using rynx::ruleset::physics::contact_solver_settings;
+	using rynx::ruleset::physics::contact_state;
+
+	// balls integrated the way the motion ruleset does it. by default a pile of overlapping balls without gravity or walls.
+	struct ball_scene {
+		ball_scene() = default;
+		ball_scene(size_t side, uint32_t seed) {
+			std::mt19937 rng(seed);
+			std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+			std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+			for (size_t y = 0; y < side; ++y) {
+				for (size_t x = 0; x < side; ++x) {
+					pos.emplace_back(float(x) * 0.9f + jitter(rng), float(y) * 0.9f + jitter(rng), 0.0f);
+					motion.emplace_back(rynx::vec3f(speed(rng), speed(rng), 0.0f), 0.0f);
+					body.emplace_back(rynx::components::phys::body().mass(5.0f + 5.0f * float(x % 3)));
+				}
+			}
+		}
+
+		std::vector<collision_event> contacts() {
+			std::vector<collision_event> events;
+			for (size_t i = 0; i < pos.size(); ++i) {
+				for (size_t k = i + 1; k < pos.size(); ++k) {
+					const rynx::vec3f delta = pos[i] - pos[k];
+					const float distance = delta.length();
+					if (distance >= 2.0f * radius || distance == 0.0f)
+						continue;
+
+					collision_event event;
+					event.a_id = i;
+					event.b_id = k;
+					event.a_body = body[i];
+					event.b_body = body[k];
+					event.a_motion = &motion[i];
+					event.b_motion = &motion[k];
+					event.a_pos = pos[i];
+					event.b_pos = pos[k];
+					event.c_pos = (pos[i] + pos[k]) * 0.5f;
+					event.normal = delta / distance;
+					event.penetration = 2.0f * radius - distance;
+					events.emplace_back(event);
+				}
+			}
+
+			if (box_width > 0) {
+				// floor and walls do not move. their ids come after the balls.
+				rynx::components::phys::body wall;
+				wall.inv_mass = 0;
+				wall.inv_moment_of_inertia = 0;
+				for (size_t i = 0; i < pos.size(); ++i) {
+					const std::pair<rynx::vec3f, float> walls[3] = {
+						{ rynx::vec3f(0.0f, 1.0f, 0.0f), pos[i].y },
+						{ rynx::vec3f(1.0f, 0.0f, 0.0f), pos[i].x },
+						{ rynx::vec3f(-1.0f, 0.0f, 0.0f), box_width - pos[i].x } };
+					for (uint64_t w = 0; w < 3; ++w) {
+						if (walls[w].second >= radius)
+							continue;
+
+						collision_event event;
+						event.a_id = i;
+						event.b_id = pos.size() + w;
+						event.a_body = body[i];
+						event.b_body = wall;
+						event.a_motion = &motion[i];
+						event.b_motion = nullptr;
+						event.a_pos = pos[i];
+						event.c_pos = pos[i] - walls[w].first * radius;
+						event.b_pos = event.c_pos;
+						event.normal = walls[w].first;
+						event.penetration = radius - walls[w].second;
+						events.emplace_back(event);
+					}
+				}
+			}
+			return events;
+		}
+
+		void apply_gravity() {
+			for (auto& m : motion)
+				m.acceleration += gravity;
+		}
+
+		void integrate(float dt) {
+			for (size_t i = 0; i < pos.size(); ++i) {
+				auto& m = motion[i];
+				pos[i] += m.acceleration * dt * dt + m.velocity * dt;
+				m.velocity += m.acceleration * dt;
+				m.angularVelocity += m.angularAcceleration * dt;
+				m.acceleration.set(0, 0, 0);
+				m.angularAcceleration = 0;
+			}
+		}
+
+		rynx::vec3f momentum() const {
+			rynx::vec3f sum;
+			for (size_t i = 0; i < pos.size(); ++i)
+				sum += motion[i].velocity / body[i].inv_mass;
+			return sum;
+		}
+
+		float momentum_magnitude() const {
+			float sum = 0;
+			for (size_t i = 0; i < pos.size(); ++i)
+				sum += motion[i].velocity.length() / body[i].inv_mass;
+			return sum;
+		}
+
+		float energy() const {
+			float sum = 0;
+			for (size_t i = 0; i < pos.size(); ++i) {
+				sum += 0.5f * motion[i].velocity.length_squared() / body[i].inv_mass;
+				sum += 0.5f * motion[i].angularVelocity * motion[i].angularVelocity / body[i].inv_moment_of_inertia;
+			}
+			return sum;
+		}
+
+		static constexpr float radius = 0.5f;
+		float box_width = 0;
+		rynx::vec3f gravity;
+		std::vector<rynx::vec3f> pos;
+		std::vector<rynx::components::transform::motion> motion;
+		std::vector<rynx::components::phys::body> body;
+	};
+
+	std::vector<contact_extra_info> extras_of(const std::vector<collision_event>& events) {
+		std::vector<contact_extra_info> extras;
+		for (const auto& event : events)
+			extras.emplace_back(rynx::ruleset::physics::make_contact_extra_info(event));
+		return extras;
+	}
+
+	constexpr float dt = 1.0f / 60.0f;
+	constexpr int steps = 60;
+	constexpr int iterations = 10;
+
+	// fixed iteration count without warm starting.
+	constexpr contact_solver_settings fixed_iterations{ iterations, iterations, 0.0f, 0.0f };
+
+	// every contact solved in order on one thread. this is what the coloured solver is compared against.
+	void step_reference(ball_scene& scene) {
+		const auto events = scene.contacts();
+		const auto extras = extras_of(events);
+		std::vector<contact_state> states(events.size());
+		for (int iteration = 0; iteration < iterations; ++iteration)
+			for (size_t i = 0; i < events.size(); ++i)
+				rynx::ruleset::physics::resolve_contact(events[i], extras[i], states[i], dt);
+		scene.integrate(dt);
+	}
+
+	void step_coloured(ball_scene& scene) {
+		const auto events = scene.contacts();
+		const auto extras = extras_of(events);
+		std::vector<contact_state> states(events.size());
+		rynx::contact_partition partition;
+		rynx::ruleset::physics::partition_contacts(partition, events);
+		rynx::ruleset::physics::solve_contacts(events, extras, states, partition, dt, fixed_iterations);
+		scene.integrate(dt);
+	}
+
+	void step_coloured_parallel(ball_scene& scene, rynx::scheduler::task_scheduler& scheduler) {
+		const auto events = scene.contacts();
+		const auto extras = extras_of(events);
+		std::vector<contact_state> states(events.size());
+		rynx::contact_partition partition;
+		rynx::ruleset::physics::partition_contacts(partition, events);
+
+		auto context = scheduler.make_context();
+		context->add_task("solve", [&](rynx::scheduler::task& task) {
+			rynx::ruleset::physics::solve_contacts(task, events, extras, states, partition, dt, fixed_iterations);
+		});
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+		scene.integrate(dt);
+	}
+
+	// columns of balls resting on the floor of a box, under gravity.
+	ball_scene ball_stack(size_t columns, size_t rows) {
+		ball_scene scene;
+		scene.box_width = float(columns) + 0.1f;
+		scene.gravity = rynx::vec3f(0.0f, -10.0f, 0.0f);
+		for (size_t y = 0; y < rows; ++y) {
+			for (size_t x = 0; x < columns; ++x) {
+				scene.pos.emplace_back(0.55f + float(x), 0.5f + float(y), 0.0f);
+				scene.motion.emplace_back();
+				scene.body.emplace_back(rynx::components::phys::body().mass(5.0f + 5.0f * float((x + y) % 3)));
+			}
+		}
+		return scene;
+	}
+
+	struct stack_statistics {
+		float iterations = 0;
+		float kinetic_energy = 0;
+		float max_penetration = 0;
+	};
+
+	// runs the scene with the contact cache, and averages the statistics over the frames after the first half.
+	stack_statistics simulate_stack(ball_scene& scene, const contact_solver_settings& settings, int frames) {
+		rynx::ruleset::physics::contact_cache cache;
+		rynx::contact_partition partition;
+		stack_statistics result;
+		for (int frame = 0; frame < frames; ++frame) {
+			scene.apply_gravity();
+			const auto events = scene.contacts();
+			std::vector<contact_extra_info> extras(events.size());
+			std::vector<contact_state> states(events.size());
+			for (size_t i = 0; i < events.size(); ++i)
+				cache.fetch(events[i], extras[i], states[i], settings.warm_start);
+
+			rynx::ruleset::physics::partition_contacts(partition, events);
+			const int iterations_run = rynx::ruleset::physics::solve_contacts(events, extras, states, partition, dt, settings);
+			cache.store(events, extras, states);
+			scene.integrate(dt);
+
+			if (frame >= frames / 2) {
+				result.iterations += float(iterations_run);
+				result.kinetic_energy += scene.energy();
+				for (const auto& event : events)
+					result.max_penetration = std::max(result.max_penetration, event.penetration);
+			}
+		}
+		result.iterations /= float(frames - frames / 2);
+		result.kinetic_energy /= float(frames - frames / 2);
+		return result;
+	}
+
+	bool same_state(const ball_scene& a, const ball_scene& b) {
+		for (size_t i = 0; i < a.pos.size(); ++i) {
+			if (!(a.pos[i] == b.pos[i]) || !(a.motion[i].velocity == b.motion[i].velocity) || a.motion[i].angularVelocity != b.motion[i].angularVelocity)
+				return false;
+		}
+		return true;
+	}
+}
+
+TEST_CASE("contact partition batches share no bodies", "[contact_partition]")
+{
+	std::mt19937 rng(5);
+	std::uniform_int_distribution<uint64_t> body(0, 120);
+	std::vector<std::pair<uint64_t, uint64_t>> contacts;
+	for (size_t i = 0; i < 2000; ++i) {
+		const uint64_t a = body(rng);
+		const uint64_t b = body(rng);
+		if (a == b)
+			continue;
+		// bodies above 100 do not move, and never conflict with each other.
+		contacts.emplace_back(a > 100 ? rynx::contact_partition::static_body : a, b > 100 ? rynx::contact_partition::static_body : b);
+	}
+	// one body in more contacts than there are parallel batches.
+	for (uint64_t i = 0; i < 100; ++i) {
+		contacts.emplace_back(1000, 2000 + i);
+	}
+
+	rynx::contact_partition partition;
+	partition.build(contacts.size(), [&contacts](size_t i) { return contacts[i]; });
+	REQUIRE(partition.batch_count() == rynx::contact_partition::max_parallel_batches + 1);
+	REQUIRE(!partition.is_parallel(partition.batch_count() - 1));
+
+	std::vector<int> seen(contacts.size(), 0);
+	for (size_t batch = 0; batch < partition.batch_count(); ++batch) {
+		std::vector<uint64_t> bodies;
+		for (size_t i = 0; i < partition.batch_size(batch); ++i) {
+			const uint32_t contact = partition.contact(batch, i);
+			++seen[contact];
+			if (i > 0) {
+				REQUIRE(partition.contact(batch, i - 1) < contact);
+			}
+			for (uint64_t key : { contacts[contact].first, contacts[contact].second }) {
+				if (key != rynx::contact_partition::static_body)
+					bodies.emplace_back(key);
+			}
+		}
+		if (partition.is_parallel(batch)) {
+			std::sort(bodies.begin(), bodies.end());
+			REQUIRE(std::adjacent_find(bodies.begin(), bodies.end()) == bodies.end());
+		}
+	}
+	REQUIRE(std::count(seen.begin(), seen.end(), 1) == int(contacts.size()));
+}
+
+TEST_CASE("coloured contact solver is deterministic and keeps the drift of the sequential solver", "[contact_partition]")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler;
+
+	ball_scene reference(32, 7);
+	ball_scene coloured = reference;
+	ball_scene parallel = reference;
+	ball_scene parallel_again = reference;
+
+	const rynx::vec3f momentum_start = reference.momentum();
+	const float momentum_scale = reference.momentum_magnitude();
+	const float energy_start = reference.energy();
+	{
+		// large enough batches that the parallel solver does not fall back to solving on one thread.
+		rynx::contact_partition partition;
+		rynx::ruleset::physics::partition_contacts(partition, reference.contacts());
+		REQUIRE(partition.batch_size(0) >= 256);
+	}
+
+	for (int step = 0; step < steps; ++step) {
+		step_reference(reference);
+		step_coloured(coloured);
+		step_coloured_parallel(parallel, scheduler);
+		step_coloured_parallel(parallel_again, scheduler);
+	}
+
+	// the batches never share bodies, so the thread count can not change the result.
+	REQUIRE(same_state(coloured, parallel));
+	REQUIRE(same_state(parallel, parallel_again));
+
+	// contact forces are equal and opposite, so momentum only drifts by rounding.
+	REQUIRE((reference.momentum() - momentum_start).length() < 1e-6f * momentum_scale);
+	REQUIRE((coloured.momentum() - momentum_start).length() < 1e-6f * momentum_scale);
+
+	// the solve order changes the trajectories, but the energy drift should stay close to the sequential solver.
+	const float reference_drift = reference.energy() - energy_start;
+	const float coloured_drift = coloured.energy() - energy_start;
+	REQUIRE(std::abs(coloured_drift - reference_drift) < 0.02f * energy_start);
+}
+
+TEST_CASE("contact cache warm starts contacts that persist", "[contact_cache]")
+{
+	ball_scene scene(2, 3);
+	const auto events = scene.contacts();
+	REQUIRE(events.size() == 4);
+
+	std::vector<contact_extra_info> extras = extras_of(events);
+	std::vector<contact_state> states(events.size());
+	states[0].normal_impulse = 3.0f;
+
+	rynx::ruleset::physics::contact_cache cache;
+	cache.store(events, extras, states);
+	REQUIRE(cache.size() == events.size());
+
+	contact_extra_info extra;
+	contact_state state;
+	cache.fetch(events[0], extra, state, 0.5f);
+	REQUIRE(state.warm_impulse == 1.5f);
+	REQUIRE(state.normal_impulse == 1.5f);
+	REQUIRE(extra.relative_position_length_a == extras[0].relative_position_length_a);
+
+	// another feature of the same pair is a new contact.
+	collision_event other_feature = events[0];
+	other_feature.feature = 1;
+	cache.fetch(other_feature, extra, state, 0.5f);
+	REQUIRE(state.warm_impulse == 0.0f);
+
+	// the contact point moved on the bodies, so the extra info is computed again.
+	collision_event moved = events[0];
+	moved.c_pos += rynx::vec3f(0.1f, 0.0f, 0.0f);
+	cache.fetch(moved, extra, state, 0.5f);
+	REQUIRE(state.warm_impulse == 1.5f);
+	REQUIRE(extra.relative_position_a == moved.c_pos - moved.a_pos);
+}
+
+TEST_CASE("contact cache finds a contact reported in the other orientation", "[contact_cache]")
+{
+	ball_scene scene(2, 3);
+	const auto events = scene.contacts();
+	std::vector<contact_extra_info> extras = extras_of(events);
+	std::vector<contact_state> states(events.size());
+	states[0].normal_impulse = 3.0f;
+
+	rynx::ruleset::physics::contact_cache cache;
+	cache.store(events, extras, states);
+
+	// the broadphase reported the pair the other way around on the next frame.
+	collision_event swapped = events[0];
+	std::swap(swapped.a_id, swapped.b_id);
+	std::swap(swapped.a_body, swapped.b_body);
+	std::swap(swapped.a_motion, swapped.b_motion);
+	std::swap(swapped.a_pos, swapped.b_pos);
+	swapped.normal = -swapped.normal;
+
+	contact_extra_info extra;
+	contact_state state;
+	cache.fetch(swapped, extra, state, 1.0f);
+	REQUIRE(state.warm_impulse == 3.0f);
+	REQUIRE(extra.relative_position_a == extras[0].relative_position_b);
+	REQUIRE(extra.relative_position_b == extras[0].relative_position_a);
+	REQUIRE(extra.relative_position_length_a == extras[0].relative_position_length_b);
+
+	// stored in the swapped orientation, found again in the original one.
+	cache.store({ swapped }, { extra }, { state });
+	cache.fetch(events[0], extra, state, 1.0f);
+	REQUIRE(state.warm_impulse == 3.0f);
+	REQUIRE(extra.relative_position_a == extras[0].relative_position_a);
+	REQUIRE(extra.relative_position_tangent_b == extras[0].relative_position_tangent_b);
+}
+
+TEST_CASE("contact cache warm starts a resting stack with fewer iterations", "[contact_cache]")
+{
+	ball_scene cold = ball_stack(10, 10);
+	ball_scene warm = cold;
+
+	const contact_solver_settings adaptive{ 2, iterations, 0.01f, 1.0f };
+	const stack_statistics cold_stats = simulate_stack(cold, fixed_iterations, 300);
+	const stack_statistics warm_stats = simulate_stack(warm, adaptive, 300);
+
+	// once the stack has settled, warm starting leaves little for the iterations to do.
+	REQUIRE(warm_stats.iterations <= 3.0f);
+	REQUIRE(warm_stats.kinetic_energy < cold_stats.kinetic_energy);
+	REQUIRE(warm_stats.max_penetration < cold_stats.max_penetration);
+}
@@ -0,0 +1,74 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include <catch.hpp>
+
+#include <rynx/ecs/ecs.hpp>
+#include <rynx/rulesets/motion.hpp>
+#include <rynx/scheduler/task_scheduler.hpp>
+#include <rynx/tech/components.hpp>
+#include <rynx/thread/this_thread.hpp>
+
+TEST_CASE("ecs chunked parallel for vs per element", "[!benchmark]")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	using rynx::components::transform::position;
+	using rynx::components::transform::motion;
+	using rynx::components::transform::dampening;
+	using rynx::ruleset::motion_updates;
+
+	rynx::ecs ecs;
+	for (int i = 0; i < 1000000; ++i) {
+		motion m({ 1, 1, 1 }, 1);
+		m.acceleration = { 1, 1, 1 };
+		m.angularAcceleration = 1;
+		ecs.create(position(), m, dampening{ 0.1f, 0.1f });
+	}
+
+	rynx::scheduler::task_scheduler scheduler;
+	auto context = scheduler.make_context();
+	context->set_resource(&ecs);
+	constexpr float dt = 0.016f;
+
+	auto run_frame = [&](auto&& task_func) {
+		context->add_task("bench", task_func);
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+		return ecs.size();
+	};
+
+	BENCHMARK("motion per element") {
+		return run_frame([](rynx::ecs::view<position, motion> ecs, rynx::scheduler::task& task) {
+			ecs.query().for_each_parallel(task, [](position& p, motion& m) {
+				motion_updates::integrate(dt, p, m);
+			});
+		});
+	};
+
+	BENCHMARK("motion chunked") {
+		return run_frame([](rynx::ecs::view<position, motion> ecs, rynx::scheduler::task& task) {
+			ecs.query().for_each_chunk_parallel(task, [](size_t n, position* rynx_restrict p, motion* rynx_restrict m) {
+				for (size_t i = 0; i < n; ++i) {
+					motion_updates::integrate(dt, p[i], m[i]);
+				}
+			});
+		});
+	};
+
+	BENCHMARK("dampening per element") {
+		return run_frame([](rynx::ecs::view<motion, const dampening> ecs, rynx::scheduler::task& task) {
+			ecs.query().for_each_parallel(task, [](motion& m, dampening d) {
+				motion_updates::dampen(dt, m, d);
+			});
+		});
+	};
+
+	BENCHMARK("dampening chunked") {
+		return run_frame([](rynx::ecs::view<motion, const dampening> ecs, rynx::scheduler::task& task) {
+			ecs.query().for_each_chunk_parallel(task, [](size_t n, motion* rynx_restrict m, const dampening* rynx_restrict d) {
+				for (size_t i = 0; i < n; ++i) {
+					motion_updates::dampen(dt, m[i], d[i]);
+				}
+			});
+		});
+	};
+}
@@ -0,0 +1,168 @@
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include <catch.hpp>
+
+#include <rynx/application/logic.hpp>
+#include <rynx/ecs/ecs.hpp>
+#include <rynx/rulesets/collisions.hpp>
+#include <rynx/rulesets/motion.hpp>
+#include <rynx/scheduler/task_scheduler.hpp>
+#include <rynx/tech/collision_detection.hpp>
+#include <rynx/tech/components.hpp>
+#include <rynx/thread/this_thread.hpp>
+
+#include <random>
+#include <vector>
+
+namespace {
+	struct scene_state {
+		std::vector<rynx::vec3f> positions;
+		std::vector<rynx::vec3f> velocities;
+		std::vector<float> angular_velocities;
+		size_t collision_events = 0;
+
+		bool operator == (const scene_state& other) const {
+			if (positions.size() != other.positions.size() || collision_events != other.collision_events)
+				return false;
+			for (size_t i = 0; i < positions.size(); ++i) {
+				if (!(positions[i] == other.positions[i]) || !(velocities[i] == other.velocities[i]) || angular_velocities[i] != other.angular_velocities[i])
+					return false;
+			}
+			return true;
+		}
+	};
+
+	// a pile of overlapping balls in a spatial hash category, simulated by the physics ruleset on the given number of workers.
+	// there are enough balls that the spatial hash places them from several threads.
+	scene_state simulate_balls(uint64_t workers, size_t side, int frames) {
+		rynx::this_thread::rynx_thread_raii obj;
+		rynx::scheduler::task_scheduler scheduler(workers);
+		auto context = scheduler.make_context();
+
+		rynx::ecs ecs;
+		rynx::collision_detection detection;
+		auto category = detection.add_category(rynx::collision_detection::broadphase::spatial_hash);
+		detection.enable_collisions_between(category, category);
+		context->set_resource(ecs);
+		context->set_resource(detection);
+
+		std::mt19937 rng(11);
+		std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+		std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+		std::vector<rynx::id> ids;
+		for (size_t y = 0; y < side; ++y) {
+			for (size_t x = 0; x < side; ++x) {
+				ids.emplace_back(ecs.create(
+					rynx::components::transform::position(rynx::vec3f(float(x) * 0.9f + jitter(rng), float(y) * 0.9f + jitter(rng), 0.0f)),
+					rynx::components::transform::radius(0.5f),
+					rynx::components::transform::motion(rynx::vec3f(speed(rng), speed(rng), 0.0f), 0.0f),
+					rynx::components::phys::body().mass(5.0f + 5.0f * float(x % 3)),
+					rynx::components::phys::collisions{ category.value },
+					rynx::components::phys::collision_events()
+				));
+			}
+		}
+
+		constexpr float dt = 1.0f / 60.0f;
+		rynx::ruleset::physics_2d physics;
+		scene_state result;
+		for (int frame = 0; frame < frames; ++frame) {
+			physics.process(*context, dt);
+			scheduler.start_frame();
+			scheduler.wait_until_complete();
+
+			ecs.query().for_each([dt](rynx::components::transform::position& pos, rynx::components::transform::motion& m) {
+				pos.value += m.acceleration * dt * dt + m.velocity * dt;
+				m.velocity += m.acceleration * dt;
+				m.angularVelocity += m.angularAcceleration * dt;
+				m.acceleration.set(0, 0, 0);
+				m.angularAcceleration = 0;
+			});
+			ecs.query().for_each([&result](const rynx::components::phys::collision_events& events) {
+				result.collision_events += events.events.size();
+			});
+		}
+
+		for (auto id : ids) {
+			result.positions.emplace_back(ecs[id].get<rynx::components::transform::position>().value);
+			result.velocities.emplace_back(ecs[id].get<rynx::components::transform::motion>().velocity);
+			result.angular_velocities.emplace_back(ecs[id].get<rynx::components::transform::motion>().angularVelocity);
+		}
+		return result;
+	}
+}
+
+TEST_CASE("physics ruleset gives the same result on any thread count", "[physics_2d]")
+{
+	constexpr size_t side = 64;
+	constexpr int frames = 8;
+	const scene_state single = simulate_balls(1, side, frames);
+	REQUIRE(single.collision_events > 0);
+
+	for (uint64_t workers : { uint64_t(2), uint64_t(4), uint64_t(8) }) {
+		// twice per thread count, since the spatial hash places entities in a different order on every run.
+		REQUIRE(simulate_balls(workers, side, frames) == single);
+		REQUIRE(simulate_balls(workers, side, frames) == single);
+	}
+}
+
+namespace {
+	// counts the frames on which the motion ruleset created its tasks instead of replaying them.
+	class counting_motion_updates : public rynx::ruleset::motion_updates {
+	public:
+		int frames_created = 0;
+
+		virtual void onFrameProcess(rynx::scheduler::context& context, float dt) override {
+			++frames_created;
+			motion_updates::onFrameProcess(context, dt);
+		}
+	};
+}
+
+TEST_CASE("replayable rulesets replay next to the physics ruleset", "[physics_2d]")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler;
+	auto context = scheduler.make_context();
+
+	rynx::ecs ecs;
+	rynx::collision_detection detection;
+	auto category = detection.add_category(rynx::collision_detection::broadphase::spatial_hash);
+	detection.enable_collisions_between(category, category);
+	context->set_resource(ecs);
+	context->set_resource(detection);
+
+	rynx::application::logic logic;
+	context->set_resource(logic.parameters());
+
+	auto physics = rynx::make_unique<rynx::ruleset::physics_2d>();
+	auto motion = rynx::make_unique<counting_motion_updates>();
+	counting_motion_updates* motion_updates = motion.get();
+	physics->depends_on(*motion);
+	logic.add_ruleset(std::move(physics));
+	logic.add_ruleset(std::move(motion));
+
+	auto ball = ecs.create(
+		rynx::components::transform::position(rynx::vec3f(0, 0, 0)),
+		rynx::components::transform::radius(0.5f),
+		rynx::components::transform::motion(rynx::vec3f(1, 0, 0), 0.0f),
+		rynx::components::phys::body().mass(1.0f),
+		rynx::components::phys::collisions{ category.value }
+	);
+
+	constexpr float dt = 1.0f / 60.0f;
+	float previous_x = 0;
+	for (int frame = 0; frame < 4; ++frame) {
+		logic.generate_tasks(*context, dt);
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+
+		// replayed motion tasks still move the ball every frame.
+		const float x = ecs[ball].get<rynx::components::transform::position>().value.x;
+		REQUIRE(x > previous_x);
+		previous_x = x;
+	}
+
+	REQUIRE(motion_updates->frames_created == 1);
+}
@@ -5,13 +5,78 @@
 #include <catch.hpp>
 
 #include <rynx/ecs/ecs.hpp>
+#include <rynx/ecs/command_buffer.hpp>
 #include <rynx/scheduler/task_scheduler.hpp>
+#include <rynx/scheduler/task_graph.hpp>
+#include <rynx/scheduler/coroutine.hpp>
 #include <thread>
 
 
 #include <rynx/tech/parallel/queue.hpp>
+#include <rynx/tech/parallel/work_stealing_deque.hpp>
 #include <rynx/thread/this_thread.hpp>
 
+#include <rynx/std/pool_allocator.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// counts heap allocations of all threads while enabled.
+namespace {
+	std::atomic<bool> g_count_allocations = false;
+	std::atomic<int64_t> g_allocation_count = 0;
+
+	void count_allocation() {
+		if (g_count_allocations.load(std::memory_order_relaxed))
+			g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// msvc has no std::aligned_alloc, and its aligned blocks must be freed with _aligned_free instead of free.
+	void* aligned_malloc(size_t bytes, size_t align) {
+		bytes = (bytes + align - 1) / align * align;
+#if defined(_WIN32)
+		return _aligned_malloc(bytes ? bytes : align, align);
+#else
+		return std::aligned_alloc(align, bytes ? bytes : align);
+#endif
+	}
+
+	void aligned_free(void* ptr) {
+#if defined(_WIN32)
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+}
+
+void* operator new(size_t bytes) {
+	count_allocation();
+	void* ptr = std::malloc(bytes ? bytes : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new(size_t bytes, std::align_val_t align) {
+	count_allocation();
+	void* ptr = aligned_malloc(bytes, size_t(align));
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { aligned_free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { aligned_free(ptr); }
+
 TEST_CASE("parallel que", "single thread")
 {
 	rynx::this_thread::rynx_thread_raii kek;
@@ -33,6 +98,153 @@ TEST_CASE("parallel que", "single thread")
 }
 
 
+TEST_CASE("work stealing deque", "parallel")
+{
+	rynx::parallel::work_stealing_deque<int> deque(4);
+	int value = 0;
+	REQUIRE(deque.pop(value) == false);
+	REQUIRE(deque.steal(value) == false);
+
+	// owner takes the newest, thieves the oldest. grows past initial capacity.
+	for (int i = 0; i < 10; ++i)
+		deque.push(i);
+	REQUIRE(deque.pop(value));
+	REQUIRE(value == 9);
+	REQUIRE(deque.steal(value));
+	REQUIRE(value == 0);
+	REQUIRE(deque.size() == 8);
+
+	// every value is taken exactly once while owner and thieves race.
+	constexpr int numValues = 200000;
+	std::vector<std::atomic<int>> taken(numValues);
+	std::atomic<bool> done = false;
+	std::vector<std::thread> thieves;
+	for (int k = 0; k < 3; ++k) {
+		thieves.emplace_back([&]() {
+			int stolen = 0;
+			while (!done.load() || !deque.empty()) {
+				if (deque.steal(stolen) && stolen >= 10)
+					++taken[stolen - 10];
+			}
+		});
+	}
+
+	for (int i = 0; i < numValues; ++i) {
+		deque.push(i + 10);
+		if (i % 3 == 0 && deque.pop(value) && value >= 10)
+			++taken[value - 10];
+	}
+	done = true;
+	for (auto& thief : thieves)
+		thief.join();
+	while (deque.pop(value)) {
+		if (value >= 10)
+			++taken[value - 10];
+	}
+
+	int taken_once = 0;
+	for (auto& count : taken)
+		taken_once += (count.load() == 1);
+	REQUIRE(taken_once == numValues);
+}
+
+TEST_CASE("scheduler many small tasks", "[!benchmark]")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler;
+	auto context = scheduler.make_context();
+
+	BENCHMARK("frame of 1000 empty tasks") {
+		std::atomic<int> c = 0;
+		for (int i = 0; i < 1000; ++i)
+			context->add_task("", [&c]() { ++c; });
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+		return c.load();
+	};
+}
+
+TEST_CASE("scheduler steady state frames do not allocate", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler(4);
+	auto context = scheduler.make_context();
+
+	struct shared_counter { std::atomic<int> value = 0; };
+	struct summed_values { std::vector<int> values = std::vector<int>(1000, 1); std::atomic<int64_t> sum = 0; };
+	context->set_resource<shared_counter>();
+	context->set_resource<summed_values>();
+
+	struct scoped_component { int value; };
+	struct group_a {};
+	struct group_b {};
+	rynx::ecs ecs;
+	const rynx::id in_a = ecs.create(scoped_component{ 0 }, group_a());
+	const rynx::id in_b = ecs.create(scoped_component{ 0 }, group_b());
+	context->set_resource(&ecs);
+
+	auto frame = [&]() {
+		for (int i = 0; i < 50; ++i) {
+			context->add_task("write", [](shared_counter& counter) { ++counter.value; })
+				.then("read", [](const shared_counter& counter) { (void)counter.value.load(); });
+		}
+
+		auto parallel_sum = context->add_task("sum", [](rynx::scheduler::task& task_context, summed_values& data) {
+			data.sum = 0;
+			task_context.parallel().range(0, data.values.size(), 64).execute([&data](int64_t i) { data.sum += data.values[i]; });
+		});
+		auto after_sum = context->add_task("after sum", [](const summed_values& data) { (void)data.sum.load(); });
+		after_sum.depends_on(parallel_sum);
+
+		rynx::scheduler::barrier frame_barrier("frame barrier");
+		context->add_task("extended", [](rynx::scheduler::task& task_context) {
+			task_context.extend_task_independent([](shared_counter& counter) { ++counter.value; });
+		}).required_for(frame_barrier);
+		context->add_task("last", []() {}).depends_on(frame_barrier);
+
+		// scoped views reserve the categories in their scope when they start.
+		context->add_task("scoped a", [in_a](rynx::ecs::scoped_view<rynx::ecs::with<group_a>, rynx::ecs::without<>, scoped_component> ecs) {
+			++ecs[in_a].get<scoped_component>().value;
+		});
+		context->add_task("scoped b", [in_b](rynx::ecs::scoped_view<rynx::ecs::with<scoped_component>, rynx::ecs::without<group_a>, scoped_component> ecs) {
+			++ecs[in_b].get<scoped_component>().value;
+		});
+	};
+
+	// the pools are filled up front with room for a full cache on every thread, so they never grow however the tasks
+	// end up spread over the workers.
+	for (size_t bytes = 16; bytes <= 2048; bytes *= 2) {
+		rynx::memory::pool_allocator::reserve(bytes, (scheduler.worker_count() + 1) * rynx::memory::pool_allocator::max_blocks_cached_per_thread + 1024);
+	}
+
+	// what is left are the capacities of task lists and the per thread caches, such as recently interned task names.
+	// a thread only fills its caches once it has run each kind of task, so the frames must stop allocating eventually,
+	// but how soon depends on os scheduling. so instead of a fixed warm up, wait for a run of frames without allocations.
+	constexpr int required_clean_frames = 20;
+	constexpr int max_frames = 2000;
+	int frames_run = 0;
+	int clean_frames = 0;
+	int64_t allocations_in_last_frame = 0;
+	g_count_allocations = true;
+	while (clean_frames < required_clean_frames && frames_run < max_frames) {
+		g_allocation_count = 0;
+		frame();
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+		++frames_run;
+		allocations_in_last_frame = g_allocation_count.load();
+		clean_frames = allocations_in_last_frame == 0 ? clean_frames + 1 : 0;
+	}
+	g_count_allocations = false;
+
+	INFO("frames run: " << frames_run << ", allocations in the last frame: " << allocations_in_last_frame);
+	REQUIRE(clean_frames == required_clean_frames);
+	REQUIRE(context->get_resource<shared_counter>().value.load() == frames_run * 51);
+	REQUIRE(context->get_resource<summed_values>().sum.load() == 1000);
+	REQUIRE(ecs[in_a].get<scoped_component>().value == frames_run);
+	REQUIRE(ecs[in_b].get<scoped_component>().value == frames_run);
+}
+
 /*
 TEST_CASE("empty tasks bench", "scheduler")
 {
@@ -69,6 +281,338 @@ TEST_CASE("tasks and barriers", "scheduler")
 	scheduler.wait_until_complete();
 }
 
+TEST_CASE("tasks scheduled from workers of another scheduler", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler target(2);
+	auto target_context = target.make_context();
+
+	// created second, so its workers have rynx thread ids that the target has no ready deques for.
+	rynx::scheduler::task_scheduler source(4);
+	auto source_context = source.make_context();
+
+	std::atomic<int> foreign_threads = 0;
+	std::atomic<int> completed = 0;
+	for (int i = 0; i < 64; ++i) {
+		source_context->add_task("schedule to target", [&]() {
+			if (uint64_t(rynx::this_thread::id()) > target.worker_count()) {
+				++foreign_threads;
+			}
+			target_context->add_task("first", [&]() { ++completed; })
+				.then("second", [&]() { ++completed; });
+		});
+	}
+
+	source.start_frame();
+	source.wait_until_complete();
+
+	target.start_frame();
+	target.wait_until_complete();
+
+	REQUIRE(foreign_threads.load() > 0);
+	REQUIRE(completed.load() == 64 * 2);
+}
+
+
+TEST_CASE("recorded task graph replays", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler(4);
+	auto context = scheduler.make_context();
+
+	struct frame_parameters { int frame = 0; };
+	struct frame_log { std::vector<int> values; std::atomic<int> parallel_work = 0; };
+	context->set_resource<frame_parameters>();
+	context->set_resource<frame_log>();
+
+	int tasks_created = 0;
+	auto frame = [&]() {
+		++tasks_created;
+		rynx::scheduler::barrier first_done("first done");
+		context->add_task("first", [](const frame_parameters& params, frame_log& log) {
+			log.values.emplace_back(params.frame * 10 + 1);
+		}).required_for(first_done);
+
+		context->add_task("second", [](rynx::scheduler::task& task_context, const frame_parameters& params, frame_log& log) {
+			log.values.emplace_back(params.frame * 10 + 2);
+			task_context.parallel().range(0, 100, 8).execute([&log](int64_t) { ++log.parallel_work; });
+		}).depends_on(first_done)
+		.then("third", [](const frame_parameters& params, frame_log& log) {
+			log.values.emplace_back(params.frame * 10 + 3);
+		});
+	};
+
+	auto& params = context->get_resource<frame_parameters>();
+	auto& log = context->get_resource<frame_log>();
+
+	rynx::scheduler::task_graph graph;
+	context->begin_recording(graph);
+	frame();
+	context->end_recording();
+	scheduler.start_frame();
+	scheduler.wait_until_complete();
+	REQUIRE(graph.size() == 3);
+
+	for (int i = 1; i < 20; ++i) {
+		params.frame = i;
+		context->replay(graph);
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+	}
+
+	REQUIRE(tasks_created == 1);
+	REQUIRE(log.parallel_work.load() == 20 * 100);
+	REQUIRE(log.values.size() == 20 * 3);
+	for (int i = 0; i < 20; ++i) {
+		REQUIRE(log.values[i * 3 + 0] == i * 10 + 1);
+		REQUIRE(log.values[i * 3 + 1] == i * 10 + 2);
+		REQUIRE(log.values[i * 3 + 2] == i * 10 + 3);
+	}
+}
+
+TEST_CASE("coroutine tasks await barriers and parallel work", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler(4);
+	auto context = scheduler.make_context();
+
+	struct stage_data { std::vector<int> log; std::vector<int> values = std::vector<int>(1000, 0); int produced = 0; };
+	context->set_resource<stage_data>();
+
+	for (int frame = 0; frame < 10; ++frame) {
+		rynx::scheduler::barrier produced("produced");
+		context->add_task("producer", [](stage_data& data) {
+			data.produced = 7;
+		}).required_for(produced);
+
+		context->add_task("stages", [produced](rynx::scheduler::task& task, stage_data& data) -> rynx::scheduler::coroutine {
+			data.log.emplace_back(1);
+			rynx::scheduler::task& after_produce = co_await produced;
+			data.log.emplace_back(data.produced);
+
+			rynx::scheduler::task& after_fill = co_await after_produce.parallel().range_auto(0, 1000).execute([&data](int64_t i) { data.values[i] = int(i); });
+			int64_t sum = 0;
+			for (int v : data.values) {
+				sum += v;
+			}
+			data.log.emplace_back(sum == 999 * 1000 / 2 ? 3 : -1);
+
+			co_await after_fill.parallel().range(0, 1000, 10).execute([&data](int64_t i) { data.values[i] = 0; });
+			data.log.emplace_back(4);
+		});
+
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+
+		auto& data = context->get_resource<stage_data>();
+		REQUIRE(data.log == std::vector<int>{ 1, 7, 3, 4 });
+		REQUIRE(data.values[999] == 0);
+		data.log.clear();
+		data.produced = 0;
+	}
+}
+
+TEST_CASE("coroutine task waiting for io does not hold a worker", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler(1);
+	auto context = scheduler.make_context();
+
+	// the io only completes after another task has run. if waiting held the only worker, the frame would never complete.
+	std::atomic<bool> other_task_done = false;
+	std::atomic<int> io_result = 0;
+	std::atomic<int> observed_result = 0;
+	rynx::scheduler::barrier io_done("io done");
+	context->hold_barrier(io_done);
+	std::thread io_thread([&]() {
+		while (!other_task_done) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		io_result = 42;
+		context->release_barrier(io_done);
+	});
+
+	context->add_task("wait for io", [&, io_done]() -> rynx::scheduler::coroutine {
+		co_await io_done;
+		observed_result = io_result.load();
+	});
+	context->add_task("other", [&]() { other_task_done = true; });
+
+	scheduler.start_frame();
+	scheduler.wait_until_complete();
+	io_thread.join();
+	REQUIRE(observed_result.load() == 42);
+}
+
+TEST_CASE("tasks block on barriers parallel work and semaphores", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	for (auto mode : { rynx::scheduler::task_scheduler::worker_mode::threads, rynx::scheduler::task_scheduler::worker_mode::fibers }) {
+		rynx::scheduler::task_scheduler scheduler(2, mode);
+		auto context = scheduler.make_context();
+
+		struct stage_data { std::vector<int> log; std::vector<int> values = std::vector<int>(1000, 0); };
+		context->set_resource<stage_data>();
+
+		for (int frame = 0; frame < 10; ++frame) {
+			// the waiting task holds stage_data while blocked, so the other tasks can not touch it.
+			std::atomic<int> produced = 0;
+			semaphore signaled;
+			rynx::scheduler::barrier produced_barrier("produced");
+			context->add_task("producer", [&produced]() {
+				produced = 7;
+			}).required_for(produced_barrier);
+			context->add_task("signal", [&signaled]() { signaled.signal(); });
+
+			context->add_task("stages", [&produced, &signaled, produced_barrier](rynx::scheduler::task& task, stage_data& data) {
+				data.log.emplace_back(1);
+				task.wait(produced_barrier);
+				data.log.emplace_back(produced.load());
+
+				task.wait(task.parallel().range_auto(0, 1000).execute([&data](int64_t i) { data.values[i] = int(i); }));
+				int64_t sum = 0;
+				for (int v : data.values) {
+					sum += v;
+				}
+				data.log.emplace_back(sum == 999 * 1000 / 2 ? 3 : -1);
+
+				task.wait(signaled);
+				data.log.emplace_back(4);
+			});
+
+			scheduler.start_frame();
+			scheduler.wait_until_complete();
+
+			auto& data = context->get_resource<stage_data>();
+			REQUIRE(data.log == std::vector<int>{ 1, 7, 3, 4 });
+			data.log.clear();
+		}
+	}
+}
+
+TEST_CASE("fiber workers resume blocked tasks in any order", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler(1, rynx::scheduler::task_scheduler::worker_mode::fibers);
+	auto context = scheduler.make_context();
+
+	// the first blocked task must finish before the second one can continue. with a single thread worker the
+	// second task would be running on top of the first one's stack, and neither could ever finish.
+	semaphore first;
+	semaphore second;
+	std::vector<int> log;
+	rynx::scheduler::barrier first_done("first done");
+	context->add_task("wait first", [&](rynx::scheduler::task& task) { task.wait(first); log.emplace_back(1); }).required_for(first_done);
+	context->add_task("wait second", [&](rynx::scheduler::task& task) { task.wait(second); log.emplace_back(2); });
+	context->add_task("release first", [&]() { first.signal(); });
+	context->add_task("release second", [&]() { second.signal(); }).depends_on(first_done);
+
+	scheduler.start_frame();
+	scheduler.wait_until_complete();
+	REQUIRE(log == std::vector<int>{ 1, 2 });
+}
+
+TEST_CASE("task priorities order competing tasks", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler(1);
+	auto context = scheduler.make_context();
+
+	struct order_log { std::vector<int> values; };
+	context->set_resource<order_log>();
+
+	// all tasks write the log, so they can only start one at a time.
+	for (int frame = 0; frame < 5; ++frame) {
+		context->add_task("low", [](order_log& log) { log.values.emplace_back(1); }).priority(1);
+		context->add_task("high", [](order_log& log) { log.values.emplace_back(5); }).priority(5);
+		context->add_task("middle", [](order_log& log) { log.values.emplace_back(3); }).priority(3);
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+
+		auto& log = context->get_resource<order_log>();
+		REQUIRE(log.values == std::vector<int>{ 5, 3, 1 });
+		log.values.clear();
+	}
+}
+
+TEST_CASE("critical path priorities start the longest chain first", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler(1);
+	auto context = scheduler.make_context();
+	context->enable_critical_path_priorities();
+
+	std::vector<rynx::string> order;
+	auto frame = [&]() {
+		order.clear();
+		for (int i = 0; i < 6; ++i) {
+			context->add_task("leaf", [&order]() { order.emplace_back("leaf"); });
+		}
+		context->add_task("chain 1", [&order]() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); order.emplace_back("chain 1"); })
+			.then("chain 2", [&order]() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); order.emplace_back("chain 2"); })
+			.then("chain 3", [&order]() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); order.emplace_back("chain 3"); });
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+	};
+
+	frame(); // measures the first frame.
+	const rynx::scheduler::critical_path_tracker* tracker = context->critical_path();
+	REQUIRE(tracker != nullptr);
+	REQUIRE(tracker->path().size() == 3);
+	REQUIRE(tracker->path()[0].name == rynx::interned_string("chain 1"));
+	REQUIRE(tracker->path()[2].name == rynx::interned_string("chain 3"));
+	REQUIRE(tracker->length_ns() >= 3 * 1000 * 1000);
+
+	for (int i = 0; i < 5; ++i) {
+		frame();
+		REQUIRE(order.size() == 9);
+		REQUIRE(order.front() == "chain 1");
+		auto chain_end = std::find(order.begin(), order.end(), rynx::string("chain 3"));
+		REQUIRE(chain_end - order.begin() < 6); // the chain does not wait behind all of the leaves.
+	}
+}
+
+TEST_CASE("tasks start right away again once priorities are no longer used", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler(2);
+	auto context = scheduler.make_context();
+
+	std::atomic<int> count = 0;
+	auto frame = [&]() {
+		for (int i = 0; i < 10; ++i) {
+			context->add_task("work", [&count]() { ++count; });
+		}
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+	};
+
+	REQUIRE(!context->uses_priorities());
+	context->enable_critical_path_priorities();
+	REQUIRE(context->uses_priorities());
+	frame();
+	context->enable_critical_path_priorities(false);
+	REQUIRE(!context->uses_priorities());
+	frame();
+
+	// a task with a priority of its own uses priorities only while it waits.
+	context->add_task("prioritized", [&count]() { ++count; }).priority(3);
+	REQUIRE(context->uses_priorities());
+	scheduler.start_frame();
+	scheduler.wait_until_complete();
+	REQUIRE(!context->uses_priorities());
+
+	// tasks started from inside a task set their priorities on the worker.
+	context->add_task("spawner", [&count](rynx::scheduler::task& task) {
+		for (int i = 0; i < 10; ++i) {
+			task.extend_task_independent("prioritized child", [&count]() { ++count; }).priority(uint32_t(i));
+		}
+	});
+	scheduler.start_frame();
+	scheduler.wait_until_complete();
+	REQUIRE(!context->uses_priorities());
+	REQUIRE(count.load() == 10 + 10 + 1 + 10);
+}
 
 TEST_CASE("ecs component resource accesses respected", "scheduler")
 {
@@ -152,6 +696,130 @@ TEST_CASE("ecs component resource accesses respected", "scheduler")
 }
 
 
+TEST_CASE("tasks reserve all of their resources or none", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	struct resource_a { std::atomic<int> users = 0; };
+	struct resource_b { std::atomic<int> users = 0; };
+	struct component { int value = 0; };
+
+	rynx::ecs ecs;
+	resource_a a;
+	resource_b b;
+	rynx::scheduler::task_scheduler scheduler(4);
+	auto context = scheduler.make_context();
+	context->set_resource(&ecs).set_resource(&a).set_resource(&b);
+	ecs.create(component{ 1 });
+
+	std::atomic<int> overlaps = 0;
+	std::atomic<int> runs = 0;
+	auto use = [&overlaps](std::atomic<int>& users) {
+		overlaps += users.fetch_add(1) != 0;
+	};
+	auto done = [&runs](std::atomic<int>& users) {
+		users.fetch_sub(1);
+		++runs;
+	};
+
+	for (int frame = 0; frame < 10; ++frame) {
+		for (int i = 0; i < 20; ++i) {
+			context->add_task("writes a", [&](resource_a& a) { use(a.users); std::this_thread::yield(); done(a.users); });
+			context->add_task("writes b", [&](resource_b& b) { use(b.users); std::this_thread::yield(); done(b.users); });
+			context->add_task("writes a and b", [&](resource_b& b, resource_a& a) {
+				use(a.users); use(b.users); std::this_thread::yield(); done(a.users); done(b.users);
+			});
+
+			// the ecs is both read and written by this task, which must not stop it from starting.
+			context->add_task("reads and edits ecs", [&](rynx::ecs::view<const component> view, rynx::ecs::edit_view<component>, const resource_a&) {
+				view.query().for_each([](const component&) {});
+				++runs;
+			});
+		}
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+	}
+
+	REQUIRE(overlaps == 0);
+	REQUIRE(runs == 10 * 20 * 5);
+}
+
+TEST_CASE("ecs scoped views reserve per category", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+
+	struct component {
+		int a;
+	};
+	struct group_a {};
+	struct group_b {};
+
+	rynx::ecs ecs;
+	for (int i = 0; i < 10; ++i) {
+		ecs.create(component{ 1 }, group_a());
+		ecs.create(component{ 1 }, group_b());
+	}
+
+	rynx::scheduler::task_scheduler scheduler;
+	auto context = scheduler.make_context();
+	context->set_resource(&ecs);
+
+	std::atomic<int> active = 0;
+	std::atomic<int> violations = 0;
+	std::atomic<int> visited_a = 0;
+	std::atomic<int> visited_b = 0;
+
+	// the scoped writers wait for each other, which only completes if they run at the same time.
+	// the wait is bounded so that a scheduler that runs them one after the other fails the test instead of hanging it.
+	const bool parallel = scheduler.worker_count() > 1;
+	std::atomic<int> arrived = 0;
+	std::atomic<bool> met = true;
+	auto meet = [&]() {
+		++arrived;
+		if (!parallel)
+			return;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (arrived.load() < 2) {
+			if (std::chrono::steady_clock::now() > deadline) {
+				met = false;
+				return;
+			}
+			std::this_thread::yield();
+		}
+	};
+
+	// same component type written in disjoint categories. can be scheduled at same time.
+	context->add_task("WriteA", [&](rynx::ecs::scoped_view<rynx::ecs::with<group_a>, rynx::ecs::without<>, component> ecs) {
+		++active;
+		meet();
+		ecs.query().for_each([&](component& c) { c.a += 1; ++visited_a; });
+		--active;
+	});
+
+	context->add_task("WriteB", [&](rynx::ecs::scoped_view<rynx::ecs::with<component>, rynx::ecs::without<group_a>, component> ecs) {
+		++active;
+		meet();
+		ecs.query().for_each([&](component& c) { c.a += 10; ++visited_b; });
+		--active;
+	});
+
+	// unscoped write access to component. can't be scheduled while scoped writers are running.
+	context->add_task("WriteAll", [&](rynx::ecs::view<component> ecs) {
+		if (++active != 1)
+			++violations;
+		ecs.query().for_each([](component& c) { c.a *= 2; });
+		--active;
+	});
+
+	scheduler.start_frame();
+	scheduler.wait_until_complete();
+
+	REQUIRE(violations == 0);
+	REQUIRE(met);
+	REQUIRE(arrived == 2);
+	REQUIRE(visited_a == 10);
+	REQUIRE(visited_b == 10);
+}
+
 TEST_CASE("task extensions respected", "scheduler")
 {
 	rynx::this_thread::rynx_thread_raii obj;
@@ -241,6 +909,65 @@ TEST_CASE("task parallel for dependencies", "scheduler")
 	});
 }
 
+TEST_CASE("adaptive parallel range visits every index once", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler(4);
+	auto context = scheduler.make_context();
+
+	for (int64_t count : { 0, 1, 7, 1000, 100000 }) {
+		std::vector<std::atomic<int>> visits(count);
+		context->add_task("adaptive", [&visits, count](rynx::scheduler::task& task_context) {
+			task_context.parallel().range_auto(0, count).execute([&visits](int64_t index) {
+				// a few expensive iterations so that chunk sizes change during the loop.
+				if (index % 97 == 0) {
+					std::this_thread::sleep_for(std::chrono::microseconds(20));
+				}
+				++visits[index];
+			});
+		});
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+
+		int64_t wrong_visit_counts = 0;
+		for (auto& visit_count : visits) {
+			wrong_visit_counts += visit_count.load() != 1;
+		}
+		REQUIRE(wrong_visit_counts == 0);
+	}
+}
+
+TEST_CASE("pinned workers with idle spinning complete parallel work", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler(8);
+	auto context = scheduler.make_context();
+
+#if defined(__linux__)
+	REQUIRE(scheduler.pin_workers(1) == scheduler.worker_count());
+#endif
+
+	for (uint32_t spin_rounds : { 0u, 1000u }) {
+		scheduler.idle_spin_rounds(spin_rounds);
+		for (int frame = 0; frame < 20; ++frame) {
+			std::vector<std::atomic<int>> visits(1000);
+			context->add_task("fork", [&visits](rynx::scheduler::task& task_context) {
+				task_context.parallel().range(0, 1000, 8).execute([&visits](int64_t index) { ++visits[index]; });
+			}).then("join", [&visits](rynx::scheduler::task& task_context) {
+				task_context.parallel().range(0, 1000, 1).deferred_work().execute([&visits](int64_t index) { ++visits[index]; });
+			});
+			scheduler.start_frame();
+			scheduler.wait_until_complete();
+
+			int64_t wrong_visit_counts = 0;
+			for (auto& visit_count : visits) {
+				wrong_visit_counts += visit_count.load() != 2;
+			}
+			REQUIRE(wrong_visit_counts == 0);
+		}
+	}
+}
+
 TEST_CASE("ecs parallel for dependencies to outside task", "scheduler")
 {
 	rynx::this_thread::rynx_thread_raii obj;
@@ -284,4 +1011,432 @@ TEST_CASE("ecs parallel for dependencies to outside task", "scheduler")
 	scheduler.wait_until_complete();
 
 	REQUIRE(test_state->load() == 3);
-}
\ No newline at end of file
+}
+
+TEST_CASE("ecs chunked parallel for", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+
+	struct value {
+		int64_t a;
+	};
+
+	struct multiplier {
+		float b;
+	};
+
+	rynx::ecs ecs;
+	for (int i = 0; i < 10000; ++i) {
+		if (i % 3 == 0)
+			ecs.create(value{ i }, multiplier{ 2.0f }, 0.5);
+		else
+			ecs.create(value{ i }, multiplier{ 2.0f });
+	}
+
+	std::atomic<int64_t> entities_visited = 0;
+	std::atomic<int> misaligned_chunks = 0;
+
+	rynx::scheduler::task_scheduler scheduler;
+	auto context = scheduler.make_context();
+	context->set_resource(&ecs);
+	context->add_task("chunks", [&](rynx::ecs::view<value, const multiplier> ecs, rynx::scheduler::task& task_context) {
+		ecs.query().for_each_chunk_parallel(task_context, [&](size_t n, value* rynx_restrict v, const multiplier* rynx_restrict m) {
+			if ((reinterpret_cast<uintptr_t>(v) % 64) != 0 || (reinterpret_cast<uintptr_t>(m) % 64) != 0)
+				++misaligned_chunks;
+			for (size_t i = 0; i < n; ++i) {
+				v[i].a = int64_t(v[i].a * m[i].b);
+			}
+			entities_visited += n;
+		}, 100);
+	});
+
+	scheduler.start_frame();
+	scheduler.wait_until_complete();
+
+	REQUIRE(entities_visited == 10000);
+	REQUIRE(misaligned_chunks == 0);
+
+	int64_t sum = 0;
+	ecs.query().for_each([&sum](value v) { sum += v.a; });
+	REQUIRE(sum == 2 * (int64_t(9999) * 10000 / 2));
+}
+
+TEST_CASE("ecs chunked parallel for with sparse tag filter", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+
+	struct value {
+		int64_t a;
+	};
+
+	struct selected : rynx::ecs_sparse_tag {};
+
+	// tagged entities are scattered, spans of the query begin at arbitrary entity indices.
+	rynx::ecs ecs;
+	int64_t expected_sum = 0;
+	int64_t expected_count = 0;
+	for (int i = 0; i < 10000; ++i) {
+		auto id = ecs.create(value{ i });
+		if (i % 7 == 3 || (i / 500) % 2 == 1) {
+			ecs.set_tags<selected>(id);
+			expected_sum += i;
+			++expected_count;
+		}
+	}
+
+	std::atomic<int64_t> entities_visited = 0;
+	std::atomic<int64_t> sum = 0;
+
+	rynx::scheduler::task_scheduler scheduler;
+	auto context = scheduler.make_context();
+	context->set_resource(&ecs);
+	context->add_task("chunks", [&](rynx::ecs::view<const value> ecs, rynx::scheduler::task& task_context) {
+		ecs.query().in<selected>().for_each_chunk_parallel(task_context, [&](size_t n, const value* rynx_restrict v) {
+			int64_t partial = 0;
+			for (size_t i = 0; i < n; ++i) {
+				partial += v[i].a;
+			}
+			sum += partial;
+			entities_visited += n;
+		}, 64);
+	});
+
+	scheduler.start_frame();
+	scheduler.wait_until_complete();
+
+	REQUIRE(entities_visited == expected_count);
+	REQUIRE(sum == expected_sum);
+}
+
+TEST_CASE("ecs command buffer records in parallel", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+
+	struct flag {};
+
+	constexpr int numEntities = 10000;
+	rynx::ecs ecs;
+	for (int i = 0; i < numEntities; ++i) {
+		ecs.create(i, float(i));
+	}
+
+	rynx::ecs_command_buffer commands;
+	rynx::scheduler::task_scheduler scheduler;
+	auto context = scheduler.make_context();
+	context->set_resource(&ecs);
+	context->add_task("record", [&commands](rynx::ecs::view<const int, const float> ecs, rynx::scheduler::task& task_context) {
+		ecs.query().for_each_parallel(task_context, [&commands](rynx::ecs::id id, int i) {
+			if (i % 2 == 0)
+				commands.attach(id, double(i), flag());
+			if (i % 3 == 0)
+				commands.remove<float>(id);
+			if (i % 5 == 0)
+				commands.create(int16_t(i));
+			if (i % 7 == 0)
+				commands.erase(id);
+		});
+	});
+
+	scheduler.start_frame();
+	scheduler.wait_until_complete();
+
+	REQUIRE(!commands.empty());
+	commands.apply(ecs);
+	REQUIRE(commands.empty());
+
+	int num_alive = 0;
+	ecs.query().for_each([&](rynx::ecs::id id, int i) {
+		++num_alive;
+		auto entity = ecs[id];
+		REQUIRE(i % 7 != 0);
+		REQUIRE(entity.has<double, flag>() == (i % 2 == 0));
+		REQUIRE(entity.has<float>() == (i % 3 != 0));
+		if (entity.has<double>()) {
+			REQUIRE(entity.get<double>() == double(i));
+		}
+		if (entity.has<float>()) {
+			REQUIRE(entity.get<float>() == float(i));
+		}
+	});
+	REQUIRE(num_alive == numEntities - (numEntities + 6) / 7);
+	REQUIRE(ecs.query().in<int16_t>().count() == (numEntities + 4) / 5);
+}
+
+TEST_CASE("ecs command buffer replaces components removed and attached again", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+
+	rynx::ecs ecs;
+	std::vector<rynx::id> ids;
+	for (int i = 0; i < 30; ++i) {
+		ids.emplace_back(ecs.create(i, float(i)));
+	}
+
+	rynx::ecs_command_buffer commands;
+	for (int i = 0; i < 30; ++i) {
+		commands.remove<float>(ids[i]);
+		commands.attach(ids[i], -float(i));
+		if (i % 3 == 1)
+			commands.attach(ids[i], double(i));
+		if (i % 3 == 2)
+			commands.remove<float>(ids[i]);
+	}
+	commands.apply(ecs);
+
+	for (int i = 0; i < 30; ++i) {
+		auto entity = ecs[ids[i]];
+		REQUIRE(entity.get<int>() == i);
+		REQUIRE(entity.has<double>() == (i % 3 == 1));
+		REQUIRE(entity.has<float>() == (i % 3 != 2));
+		if (entity.has<float>()) {
+			REQUIRE(entity.get<float>() == -float(i));
+		}
+	}
+}
+
+TEST_CASE("ecs spatial sort in parallel", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	using rynx::components::transform::position;
+
+	rynx::ecs ecs;
+	std::vector<std::pair<rynx::id, int>> created;
+	for (int i = 0; i < 10000; ++i) {
+		const float x = float((i * 7919) % 1000);
+		const float y = float((i * 104729) % 997);
+		if (i % 2 == 0)
+			created.emplace_back(ecs.create(position({ x, y, 0.0f }), i), i);
+		else
+			created.emplace_back(ecs.create(position({ x, y, 0.0f }), i, 0.5f), i);
+	}
+
+	rynx::scheduler::task_scheduler scheduler;
+	auto context = scheduler.make_context();
+	context->set_resource(&ecs);
+	context->add_task("sort", [](rynx::ecs& ecs, rynx::scheduler::task& task_context) {
+		ecs.query().sort_spatially_parallel(task_context, 8.0f);
+	});
+
+	scheduler.start_frame();
+	scheduler.wait_until_complete();
+
+	for (auto [id, i] : created) {
+		REQUIRE(ecs[id].get<int>() == i);
+	}
+
+	ecs.query().for_each_buffer([](size_t n, const position* p) {
+		for (size_t i = 1; i < n; ++i) {
+			REQUIRE(rynx::math::morton_key_2d(p[i - 1].value, 8.0f) <= rynx::math::morton_key_2d(p[i].value, 8.0f));
+		}
+	});
+}
+
+TEST_CASE("ecs mirror copies what changed", "scheduler")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	using rynx::components::transform::position;
+	constexpr size_t chunk = rynx::ecs_internal::change_chunk_size;
+
+	rynx::ecs ecs;
+	std::vector<rynx::id> plain_ids;
+	std::vector<rynx::id> float_ids;
+	for (int i = 0; i < 2000; ++i) {
+		plain_ids.emplace_back(ecs.create(position({ float(i), 0, 0 }), i, 0.0));
+	}
+	for (int i = 2000; i < 2100; ++i) {
+		float_ids.emplace_back(ecs.create(position({ float(i), 0, 0 }), i, 0.5f));
+	}
+
+	// doubles are derived in the mirror, like model matrices for rendering.
+	rynx::dynamic_bitset mirror_owned;
+	mirror_owned.set(rynx::type_index::id<double>());
+
+	rynx::scheduler::task_scheduler scheduler;
+	auto context = scheduler.make_context();
+	rynx::ecs mirror;
+	uint64_t synced_version = 0;
+	auto sync = [&]() {
+		context->add_task("mirror", [&](rynx::scheduler::task& task_context) {
+			const uint64_t changed_since = std::exchange(synced_version, rynx::ecs::change_version());
+			ecs.mirror_to(mirror, changed_since, mirror_owned, task_context);
+		});
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+	};
+
+	auto matches_source = [&](int moved) {
+		size_t count = 0;
+		bool equal = true;
+		mirror.query().for_each([&](const position& p, int i) {
+			equal &= (p.value.x == float(i)) && (p.value.y == (i == moved ? 1.0f : 0.0f));
+			++count;
+		});
+		return equal && count == ecs.query().in<position>().count();
+	};
+
+	sync();
+	REQUIRE(mirror.size() == ecs.size());
+	REQUIRE(matches_source(-1));
+	mirror.query().for_each([](double& d) { d = -1.0; });
+
+	// one chunk of the first category is written, the second category loses an entity, and a new category appears.
+	ecs[plain_ids[10]].get<position>().value.y = 1.0f;
+	ecs.erase(float_ids[5]);
+	rynx::id created = ecs.create(5000);
+
+	const uint64_t version = rynx::ecs::change_version();
+	sync();
+	REQUIRE(mirror.query().changed_since<position>(version).count() == chunk + float_ids.size() - 1);
+	REQUIRE(mirror.size() == ecs.size());
+	REQUIRE(!mirror.exists(float_ids[5]));
+	REQUIRE(mirror.exists(created));
+	REQUIRE(matches_source(10));
+
+	int derived = 0;
+	mirror.query().for_each([&derived](double d) { derived += (d == -1.0); });
+	REQUIRE(derived == int(plain_ids.size()));
+}
+
+TEST_CASE("ecs mirror vs clone", "[!benchmark]")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	using rynx::components::transform::position;
+
+	rynx::ecs ecs;
+	std::vector<rynx::id> ids;
+	for (int i = 0; i < 1000000; ++i) {
+		ids.emplace_back(ecs.create(position({ float(i), 0, 0 }), rynx::vec3f(1, 0, 0), i));
+	}
+
+	rynx::scheduler::task_scheduler scheduler;
+	auto context = scheduler.make_context();
+	rynx::ecs mirror;
+	uint64_t synced_version = 0;
+	rynx::dynamic_bitset mirror_owned;
+
+	// a frame where one percent of the entities move.
+	auto move_some = [&]() {
+		for (size_t i = 0; i < ids.size() / 100; ++i) {
+			ecs[ids[i]].get<position>().value.y += 1.0f;
+		}
+	};
+
+	BENCHMARK("clone") {
+		move_some();
+		return ecs.clone().size();
+	};
+
+	BENCHMARK("mirror") {
+		move_some();
+		context->add_task("mirror", [&](rynx::scheduler::task& task_context) {
+			const uint64_t changed_since = std::exchange(synced_version, rynx::ecs::change_version());
+			ecs.mirror_to(mirror, changed_since, mirror_owned, task_context);
+		});
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+		return mirror.size();
+	};
+}
+
+namespace {
+	// busy work that the compiler can not remove.
+	float bench_spin(int64_t iterations) {
+		float value = 1.0f;
+		for (int64_t i = 0; i < iterations; ++i) {
+			value = value * 0.999f + 0.001f;
+		}
+		return value;
+	}
+}
+
+TEST_CASE("parallel range fixed vs adaptive grain size", "[!benchmark]")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	rynx::scheduler::task_scheduler scheduler;
+	auto context = scheduler.make_context();
+
+	static constexpr int64_t count = 100000;
+	std::vector<float> results(count);
+	auto uniform_cost = [](int64_t) { return int64_t(50); };
+	auto skewed_cost = [](int64_t index) { return index >= count * 9 / 10 ? int64_t(2000) : int64_t(10); }; // expensive tail.
+
+	auto run_frame = [&](auto cost, int64_t work_size) {
+		context->add_task("bench", [&results, cost, work_size](rynx::scheduler::task& task) {
+			auto work = [&results, cost](int64_t i) { results[i] = bench_spin(cost(i)); };
+			if (work_size > 0) {
+				task.parallel().range(0, count, work_size).execute(work);
+			}
+			else {
+				task.parallel().range_auto(0, count).execute(work);
+			}
+		});
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+		return results[count - 1];
+	};
+
+	BENCHMARK("uniform, fixed 64") { return run_frame(uniform_cost, 64); };
+	BENCHMARK("uniform, fixed 2048") { return run_frame(uniform_cost, 2048); };
+	BENCHMARK("uniform, adaptive") { return run_frame(uniform_cost, 0); };
+	BENCHMARK("skewed, fixed 64") { return run_frame(skewed_cost, 64); };
+	BENCHMARK("skewed, fixed 2048") { return run_frame(skewed_cost, 2048); };
+	BENCHMARK("skewed, adaptive") { return run_frame(skewed_cost, 0); };
+}
+
+TEST_CASE("blocking waits with thread vs fiber workers", "[!benchmark]")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	static constexpr int64_t count = 1000;
+	static constexpr int64_t task_count = 32;
+	std::vector<float> results(count * task_count);
+
+	auto run_frame = [&results](rynx::scheduler::task_scheduler& scheduler, rynx::scheduler::context& context) {
+		for (int64_t t = 0; t < task_count; ++t) {
+			context.add_task("waits for parallel work", [&results, t](rynx::scheduler::task& task) {
+				for (int64_t round = 0; round < 4; ++round) {
+					task.wait(task.parallel().range(0, count, 64).execute([&results, t, round](int64_t i) {
+						results[t * count + i] = bench_spin(50 + round);
+					}));
+				}
+			});
+		}
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+		return results.back();
+	};
+
+	{
+		rynx::scheduler::task_scheduler scheduler(16, rynx::scheduler::task_scheduler::worker_mode::threads);
+		auto context = scheduler.make_context();
+		BENCHMARK("thread workers") { return run_frame(scheduler, *context); };
+	}
+	{
+		rynx::scheduler::task_scheduler scheduler(16, rynx::scheduler::task_scheduler::worker_mode::fibers);
+		auto context = scheduler.make_context();
+		BENCHMARK("fiber workers") { return run_frame(scheduler, *context); };
+	}
+}
+
+TEST_CASE("fork join latency by worker count", "[!benchmark]")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	for (uint64_t workers : { 1, 2, 4, 8, 16, 32, 64 }) {
+		for (uint32_t spin_rounds : { 0u, 64u }) {
+			rynx::scheduler::task_scheduler scheduler(workers);
+			scheduler.idle_spin_rounds(spin_rounds);
+			auto context = scheduler.make_context();
+
+			// one chunk per worker, so that the frame time is dominated by waking the workers up and joining them.
+			std::vector<int64_t> results(workers + 1);
+			std::string name = std::to_string(workers) + " workers" + (spin_rounds ? " with idle spinning" : "");
+			BENCHMARK(std::move(name)) {
+				context->add_task("fork join", [&results](rynx::scheduler::task& task) {
+					task.parallel().range(0, int64_t(results.size()), 1).execute([&results](int64_t i) { results[i] = i; });
+				});
+				scheduler.start_frame();
+				scheduler.wait_until_complete();
+				return results.back();
+			};
+		}
+	}
+}
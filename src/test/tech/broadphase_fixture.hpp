@@ -0,0 +1,101 @@
+#pragma once
+
+#include <rynx/math/vector.hpp>
+#include <rynx/scheduler/task_scheduler.hpp>
+#include <rynx/tech/parallel/accumulator.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+// random spheres and brute force answers for testing the broadphases against each other.
+namespace broadphase_fixture {
+	using pair_list = std::vector<std::pair<size_t, size_t>>;
+
+	struct spheres {
+		spheres(size_t count, float extent, float min_radius, float max_radius, uint32_t seed) : rng(seed), extent(extent) {
+			std::uniform_real_distribution<float> coordinate(0.0f, extent);
+			std::uniform_real_distribution<float> radius(min_radius, max_radius);
+			for (size_t i = 0; i < count; ++i) {
+				pos.emplace_back(coordinate(rng), coordinate(rng), coordinate(rng));
+				r.emplace_back(radius(rng));
+			}
+		}
+
+		// every sphere jumps by up to the given distance, wrapping around the edges of the volume.
+		void move(float distance) {
+			std::uniform_real_distribution<float> step(-distance, distance);
+			auto wrap = [this](float v) { return v < 0 ? v + extent : (v >= extent ? v - extent : v); };
+			for (auto& p : pos) {
+				p = rynx::vec3f(wrap(p.x + step(rng)), wrap(p.y + step(rng)), wrap(p.z + step(rng)));
+			}
+		}
+
+		// pairs that are so close to touching that rounding may decide either way.
+		bool borderline(size_t i, size_t k) const {
+			const float radius = r[i] + r[k];
+			return std::abs((pos[i] - pos[k]).length_squared() - radius * radius) < 1e-4f * radius * radius;
+		}
+
+		pair_list overlapping_pairs() const {
+			pair_list pairs;
+			for (size_t i = 0; i < pos.size(); ++i) {
+				for (size_t k = i + 1; k < pos.size(); ++k) {
+					const float radius = r[i] + r[k];
+					if ((pos[i] - pos[k]).length_squared() < radius * radius && !borderline(i, k)) {
+						pairs.emplace_back(i, k);
+					}
+				}
+			}
+			return pairs;
+		}
+
+		std::mt19937 rng;
+		float extent;
+		std::vector<rynx::vec3f> pos;
+		std::vector<float> r;
+	};
+
+	inline pair_list sorted(pair_list pairs) {
+		std::sort(pairs.begin(), pairs.end());
+		return pairs;
+	}
+
+	// pairs reported by the broadphase, leaving out the borderline ones.
+	template<typename Broadphase> pair_list found_pairs(const spheres& data, Broadphase& broadphase) {
+		pair_list found;
+		broadphase.collisions([&](uint64_t id1, uint64_t id2, rynx::vec3f, float, rynx::vec3f, float, rynx::vec3f, float) {
+			if (!data.borderline(id1, id2)) {
+				found.emplace_back(std::min(id1, id2), std::max(id1, id2));
+			}
+		});
+		return sorted(std::move(found));
+	}
+
+	// builds the broadphase and finds its pairs in parallel tasks.
+	template<typename Broadphase> pair_list found_pairs_parallel(Broadphase& broadphase) {
+		rynx::scheduler::task_scheduler scheduler;
+		auto context = scheduler.make_context();
+		auto accumulator = rynx::make_accumulator_shared_ptr<std::pair<size_t, size_t>>();
+
+		rynx::scheduler::barrier built;
+		context->add_task("build", [&broadphase](rynx::scheduler::task& task_context) {
+			broadphase.update_parallel(task_context);
+		}).required_for(built);
+		context->add_task("collisions", [&broadphase, accumulator](rynx::scheduler::task& task_context) {
+			broadphase.collisions_parallel(accumulator, [](pair_list& storage, uint64_t id1, uint64_t id2, rynx::vec3f, float, rynx::vec3f, float, rynx::vec3f, float) {
+				storage.emplace_back(std::min(id1, id2), std::max(id1, id2));
+			}, task_context);
+		}).depends_on(built);
+		scheduler.start_frame();
+		scheduler.wait_until_complete();
+
+		pair_list found;
+		accumulator->for_each([&found](pair_list& pairs) {
+			found.insert(found.end(), pairs.begin(), pairs.end());
+		});
+		return sorted(std::move(found));
+	}
+}
@@ -0,0 +1,61 @@
+#include <catch.hpp>
+
+#include "broadphase_fixture.hpp"
+
+#include <rynx/tech/lbvh.hpp>
+#include <rynx/tech/spatial_hash.hpp>
+#include <rynx/tech/sphere_tree.hpp>
+#include <rynx/thread/this_thread.hpp>
+
+#include <type_traits>
+
+using namespace broadphase_fixture;
+
+TEMPLATE_TEST_CASE("broadphase finds every overlapping pair once", "[broadphase]", rynx::sphere_tree, rynx::spatial_hash, rynx::lbvh)
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	for (size_t count : { 0, 1, 2, 3, 17, 3000 }) {
+		// a few spheres are far larger than the rest. the spatial hash handles them outside of its grid.
+		spheres data(count, 60.0f, 0.1f, 1.0f, uint32_t(count));
+		for (size_t i = 0; i < count; i += 300) {
+			data.r[i] = 8.0f;
+		}
+
+		TestType broadphase;
+		for (size_t i = 0; i < count; ++i) {
+			broadphase.insert_entity(i, data.pos[i], data.r[i]);
+		}
+
+		// every other frame the lbvh is only refitted to the moved entities.
+		if constexpr (std::is_same_v<TestType, rynx::lbvh>) {
+			broadphase.rebuild_interval(2);
+		}
+
+		for (int frame = 0; frame < 3; ++frame) {
+			for (size_t i = 0; i < count; ++i) {
+				broadphase.update_entity(i, data.pos[i], data.r[i]);
+			}
+			broadphase.update();
+			REQUIRE(found_pairs(data, broadphase) == data.overlapping_pairs());
+			data.move(5.0f);
+		}
+	}
+}
+
+TEMPLATE_TEST_CASE("broadphase parallel build and collisions match the sequential ones", "[broadphase]", rynx::spatial_hash, rynx::lbvh)
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	spheres data(50000, 80.0f, 0.2f, 0.6f, 3);
+	TestType broadphase;
+	for (size_t i = 0; i < data.pos.size(); ++i) {
+		broadphase.insert_entity(i, data.pos[i], data.r[i]);
+	}
+
+	broadphase.update();
+	pair_list expected;
+	broadphase.collisions([&](uint64_t id1, uint64_t id2, rynx::vec3f, float, rynx::vec3f, float, rynx::vec3f, float) {
+		expected.emplace_back(std::min(id1, id2), std::max(id1, id2));
+	});
+	REQUIRE(expected.size() > 0);
+	REQUIRE(found_pairs_parallel(broadphase) == sorted(expected));
+}
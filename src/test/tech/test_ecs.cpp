@@ -5,7 +5,15 @@
 #include <rynx/ecs/ecs.hpp>
 #include <rynx/ecs/raw_serialization.hpp>
 #include <rynx/ecs/scene_serialization.hpp>
+#include <rynx/math/morton.hpp>
 #include <rynx/std/serialization.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <span>
 // #include <rynx/generated/serialization.hpp>
 
 TEST_CASE("serialization", "strings & vectors") {
@@ -560,6 +568,463 @@ TEST_CASE("rynx ecs: insert & delete") {
   */
 }
 
+TEST_CASE("ecs ids: erased ids go stale when slots are reused") {
+  rynx::ecs db;
+  auto a = db.create(1);
+  auto b = db.create(2);
+  db.erase(a);
+  REQUIRE(!db.exists(a));
+  REQUIRE(db.exists(b));
+
+  // slot of a is reused, but the id value differs by generation.
+  auto c = db.create(3);
+  REQUIRE(c != a);
+  REQUIRE(rynx::ecs_internal::slot_of(c) == rynx::ecs_internal::slot_of(a));
+  REQUIRE(!db.exists(a));
+  REQUIRE(db[c].get<int>() == 3);
+  REQUIRE(db[b].get<int>() == 2);
+  REQUIRE(db.size() == 2);
+
+  // bulk created ids are consecutive even when there are free slots.
+  db.erase(b);
+  db.create_n(std::vector<int>(10, 5));
+  REQUIRE(db.size() == 11);
+
+  auto ids = db.query().in<int>().ids();
+  std::sort(ids.begin(), ids.end());
+  REQUIRE(ids.back() == c);
+  for (size_t i = 1; i < 10; ++i) {
+    REQUIRE(ids[i] == ids[i - 1] + 1);
+    REQUIRE(db[ids[i]].get<int>() == 5);
+  }
+}
+
+TEST_CASE("ecs cached query follows category changes") {
+  rynx::ecs db;
+  rynx::ecs::query_cache cache;
+  auto sum_ints = [&]() {
+    int sum = 0;
+    db.query().cached(cache).notIn<double>().for_each([&sum](int a) { sum += a; });
+    return sum;
+  };
+
+  db.create(1);
+  db.create(2, 1.0f);
+  REQUIRE(sum_ints() == 3);
+  REQUIRE(cache.num_categories() == 2);
+
+  // new matching category is picked up, non-matching one is not.
+  db.create(4, 'c');
+  db.create(8, 1.0);
+  REQUIRE(sum_ints() == 7);
+  REQUIRE(cache.num_categories() == 3);
+
+  // entities migrating to an existing category need no cache update.
+  auto id = db.create(16);
+  db[id].add(2.0f);
+  REQUIRE(sum_ints() == 23);
+  REQUIRE(cache.num_categories() == 3);
+
+  // different filters on the same cache rebuild the matches.
+  int count = 0;
+  db.query().cached(cache).in<float>().for_each([&count](int) { ++count; });
+  REQUIRE(count == 2);
+  REQUIRE(cache.num_categories() == 1);
+
+  // erasing categories invalidates the cache.
+  db.clear();
+  db.create(32);
+  REQUIRE(sum_ints() == 32);
+  REQUIRE(cache.num_categories() == 1);
+
+  // cache built for one ecs is not used for another.
+  rynx::ecs other;
+  other.create(64);
+  int other_sum = 0;
+  other.query().cached(cache).notIn<double>().for_each([&other_sum](int a) { other_sum += a; });
+  REQUIRE(other_sum == 64);
+}
+
+TEST_CASE("ecs change tracking visits written chunks only") {
+  using position = rynx::components::transform::position;
+  constexpr int numEntities = 1000; // multiple change tracking chunks.
+  constexpr size_t chunk = rynx::ecs_internal::change_chunk_size;
+
+  rynx::ecs db;
+  std::vector<rynx::id> ids;
+  for (int i = 0; i < numEntities; ++i) {
+    ids.emplace_back(db.create(position({ float(i), 0, 0 }), i));
+  }
+
+  // everything is new.
+  REQUIRE(db.query().changed_since<position>(0).count() == numEntities);
+
+  uint64_t version = db.change_version();
+  REQUIRE(db.query().changed_since<position>(version).count() == 0);
+
+  // reading or writing other types does not count as a change.
+  db.query().for_each([](const position&, int& i) { ++i; });
+  REQUIRE(db.query().changed_since<position>(version).count() == 0);
+
+  // writing through an entity marks the chunk of the entity.
+  db[ids[600]].get<position>().value.y = 1.0f;
+  auto changed = db.query().changed_since<position>(version).ids();
+  REQUIRE(changed.size() == chunk);
+  REQUIRE(std::find(changed.begin(), changed.end(), ids[600]) != changed.end());
+  
+  int num_moved = 0;
+  db.query().changed_since<position>(version).for_each([&num_moved](const position& p) { num_moved += (p.value.y == 1.0f); });
+  REQUIRE(num_moved == 1);
+
+  // non-const query access marks everything it visits.
+  version = db.change_version();
+  db.query().for_each([](position& p) { p.value.y = 2.0f; });
+  REQUIRE(db.query().changed_since<position>(version).count() == numEntities);
+
+  // erasing moves the last entity to the erased slot.
+  version = db.change_version();
+  db.erase(ids[10]);
+  REQUIRE(db.query().changed_since<position>(version).count() == chunk);
+}
+
+struct sparse_hidden : rynx::ecs_sparse_tag {};
+struct sparse_selected : rynx::ecs_sparse_tag {};
+
+TEST_CASE("ecs sparse tags toggle without moving entities") {
+  rynx::ecs db;
+  std::vector<rynx::id> ids;
+  for (int i = 0; i < 100; ++i) {
+    ids.emplace_back(db.create(i, float(i)));
+  }
+  auto id = ids[50];
+  auto category_of = [&db](rynx::id id) { return db.category_and_index_for(id.value); };
+  auto before = category_of(id);
+
+  db.set_tags<sparse_hidden>(id);
+  db.attachToEntity(ids[51], sparse_hidden(), sparse_selected());
+  REQUIRE(category_of(id) == before);
+  REQUIRE(category_of(ids[51]).first == before.first);
+  REQUIRE(db[id].has<sparse_hidden>());
+  REQUIRE(!db[id].has<sparse_selected>());
+  REQUIRE(db[ids[51]].has<int, sparse_hidden, sparse_selected>());
+
+  REQUIRE(db.query().in<sparse_hidden>().count() == 2);
+  REQUIRE(db.query().notIn<sparse_hidden>().count() == 98);
+  REQUIRE(db.query().in<sparse_hidden>().notIn<sparse_selected>().ids() == std::vector<rynx::id>{ id });
+
+  int sum = 0;
+  db.query().notIn<sparse_hidden>().for_each([&sum](int i) { sum += i; });
+  REQUIRE(sum == 99 * 100 / 2 - 50 - 51);
+
+  // tags follow the entity when its category changes, or when it is moved in its category.
+  db[id].add(2.0);
+  db.erase(ids[0]);
+  REQUIRE(db[id].has<sparse_hidden>());
+  REQUIRE(db[ids[51]].has<sparse_hidden, sparse_selected>());
+  REQUIRE(db.query().in<sparse_hidden>().count() == 2);
+  REQUIRE(db.query().in<sparse_hidden, double>().count() == 1);
+
+  db.removeFromEntity<sparse_hidden>(ids[51]);
+  db.clear_tags<sparse_hidden>(id);
+  REQUIRE(db.query().in<sparse_hidden>().count() == 0);
+  REQUIRE(db.query().in<sparse_selected>().count() == 1);
+
+  // created with tags.
+  auto tagged = db.create(1000, sparse_hidden());
+  REQUIRE(db.query().in<int, sparse_hidden>().ids() == std::vector<rynx::id>{ tagged });
+}
+
+struct sparse_erased_only : rynx::ecs_sparse_tag {};
+
+TEST_CASE("ecs type erased edits see sparse tags") {
+  rynx::ecs db;
+  rynx::id id = db.create(1, 2.0f);
+  rynx::id other = db.create(3, 4.0f);
+  db.set_tags<sparse_hidden>(id);
+
+  const rynx::type_id_t hidden_type = rynx::type_index::id<sparse_hidden>();
+  REQUIRE(db[id].has(hidden_type));
+  REQUIRE(!db[other].has(hidden_type));
+
+  // the first use of this tag is through its reflection, so no typed code has assigned its bit yet.
+  rynx::reflection::reflections reflections;
+  auto& reflection = reflections.create<sparse_erased_only>();
+  REQUIRE(reflection.m_is_sparse_tag);
+
+  auto category_before = db.category_and_index_for(id.value);
+  db.attachToEntity_typeErased(
+    id.value,
+    reflection.m_type_index_value,
+    reflection.m_is_type_segregated,
+    reflection.m_is_sparse_tag,
+    reflection.m_create_table_func,
+    reflection.m_create_map_func,
+    reflection.m_create_instance_func()
+  );
+  REQUIRE(db.category_and_index_for(id.value) == category_before);
+  REQUIRE(db[id].has(rynx::type_id_t(reflection.m_type_index_value)));
+  REQUIRE(!db[other].has(rynx::type_id_t(reflection.m_type_index_value)));
+  REQUIRE(db[id].has<sparse_erased_only>());
+  REQUIRE(db.query().in<sparse_erased_only>().ids() == std::vector<rynx::id>{ id });
+
+  db.removeFromEntity(id.value, rynx::type_id_t(reflection.m_type_index_value));
+  REQUIRE(!db[id].has(rynx::type_id_t(reflection.m_type_index_value)));
+  REQUIRE(db.query().in<sparse_erased_only>().count() == 0);
+}
+
+TEST_CASE("ecs change tracking sees entities whose sparse tags were toggled") {
+  using position = rynx::components::transform::position;
+  struct drawn_position { rynx::vec3f value; };
+
+  rynx::ecs db;
+  std::vector<rynx::id> ids;
+  for (int i = 0; i < 100; ++i) {
+    ids.emplace_back(db.create(position({ float(i), 0, 0 }), drawn_position()));
+  }
+
+  // same shape as the model matrix update: only visible entities that moved since the previous update.
+  uint64_t update_version = 0;
+  auto update_drawn = [&db, &update_version]() {
+    uint64_t changed_since = std::exchange(update_version, db.change_version());
+    db.query().notIn<sparse_hidden>().changed_since<position>(changed_since).for_each([](const position& pos, drawn_position& drawn) {
+      drawn.value = pos.value;
+    });
+  };
+
+  auto id = ids[50];
+  update_drawn();
+  db.set_tags<sparse_hidden>(id);
+  update_drawn();
+
+  // moved while hidden, the update skips it.
+  db[id].get<position>().value.y = 5.0f;
+  update_drawn();
+  REQUIRE(db[id].get<drawn_position>().value.y == 0.0f);
+
+  // nothing moves after the tag is cleared, the drawn position still has to catch up.
+  db.clear_tags<sparse_hidden>(id);
+  update_drawn();
+  REQUIRE(db[id].get<drawn_position>().value.y == 5.0f);
+
+  // setting a tag that is already set is not a change.
+  uint64_t version = db.change_version();
+  db.set_tags<sparse_selected>(id);
+  REQUIRE(db.query().in<sparse_selected>().changed_since<position>(version).count() == 1);
+  version = db.change_version();
+  db.set_tags<sparse_selected>(id);
+  REQUIRE(db.query().in<sparse_selected>().changed_since<position>(version).count() == 0);
+}
+
+struct spawned_tag {};
+
+TEST_CASE("ecs spawner creates entities in bulk") {
+  rynx::ecs db;
+  db.create(-1, 0.0f); // same category, spawned entities are appended after it.
+
+  auto spawner = db.make_spawner<int, float, spawned_tag, sparse_hidden>();
+  auto generated = spawner.reserve(100).spawn(100, [](size_t i, int& a, float& b, spawned_tag&, sparse_hidden&) {
+    a = int(i);
+    b = float(i) * 0.5f;
+  });
+  REQUIRE(generated.size() == 100);
+  REQUIRE(db.size() == 101);
+  for (auto id : generated) {
+    auto entity = db[id];
+    REQUIRE(entity.has<int, float, spawned_tag, sparse_hidden>());
+    REQUIRE(entity.get<float>() == float(entity.get<int>()) * 0.5f);
+  }
+  REQUIRE(db.query().in<spawned_tag>().count() == 100);
+  REQUIRE(db.query().in<sparse_hidden>().count() == 100);
+
+  auto copied = spawner.spawn(std::vector<int>{ 1000, 1001 }, std::vector<float>{ 1.0f, 2.0f }, std::vector<spawned_tag>(2), std::vector<sparse_hidden>(2));
+  REQUIRE(db[copied.m_begin].get<int>() == 1000);
+  REQUIRE(db[copied.m_begin.value + 1].get<float>() == 2.0f);
+
+  // categories are looked up again after they have been invalidated.
+  db.erase(generated.m_begin);
+  db.clear();
+  std::array<int, 3> ints{ 7, 8, 9 };
+  std::array<float, 3> floats{ 0.0f, 1.0f, 2.0f };
+  std::array<spawned_tag, 3> tags;
+  std::array<sparse_hidden, 3> hidden;
+  auto after_clear = spawner.spawn(std::span<const int>(ints), std::span<const float>(floats), std::span<const spawned_tag>(tags), std::span<const sparse_hidden>(hidden));
+  REQUIRE(db.size() == 3);
+  REQUIRE(db.query().in<spawned_tag, sparse_hidden>().count() == 3);
+  REQUIRE(db[after_clear.m_begin].get<int>() == 7);
+  REQUIRE(db[after_clear.m_begin.value + 2].get<int>() == 9);
+}
+
+TEST_CASE("rynx ecs: spawn 100k particles", "[!benchmark]") {
+  constexpr int numEntities = 100000;
+
+  BENCHMARK_ADVANCED("create one by one")(Catch::Benchmark::Chronometer meter) {
+    rynx::ecs db;
+    meter.measure([&db]() {
+      for (int i = 0; i < numEntities; ++i) {
+        db.create(i, float(i), spawned_tag());
+      }
+      return db.size();
+    });
+  };
+
+  BENCHMARK_ADVANCED("create_n")(Catch::Benchmark::Chronometer meter) {
+    rynx::ecs db;
+    meter.measure([&db]() {
+      std::vector<int> ints(numEntities);
+      std::vector<float> floats(numEntities);
+      for (int i = 0; i < numEntities; ++i) {
+        ints[i] = i;
+        floats[i] = float(i);
+      }
+      db.create_n<spawned_tag>(std::move(ints), std::move(floats));
+      return db.size();
+    });
+  };
+
+  BENCHMARK_ADVANCED("spawner")(Catch::Benchmark::Chronometer meter) {
+    rynx::ecs db;
+    auto spawner = db.make_spawner<int, float, spawned_tag>();
+    meter.measure([&spawner]() {
+      return spawner.spawn(numEntities, [](size_t i, int& a, float& b, spawned_tag&) {
+        a = int(i);
+        b = float(i);
+      }).size();
+    });
+  };
+}
+
+TEST_CASE("ecs create_n takes over component vectors of empty tables") {
+  rynx::ecs db;
+  rynx::ecs::component_vector<int> ints(100, 7);
+  const int* buffer = ints.data();
+  db.create_n(std::move(ints));
+
+  const int* stored = nullptr;
+  db.query().for_each_buffer([&stored](size_t, const int* p) { stored = p; });
+  REQUIRE(stored == buffer);
+
+  // plain vectors and non-empty tables move the values over.
+  db.create_n(std::vector<int>(50, 3));
+  db.create_n(rynx::ecs::component_vector<int>(50, 5));
+  int sum = 0;
+  db.query().for_each([&sum](int i) { sum += i; });
+  REQUIRE(db.size() == 200);
+  REQUIRE(sum == 100 * 7 + 50 * 3 + 50 * 5);
+}
+
+TEST_CASE("ecs spatial sort orders entities along z-order curve") {
+  using rynx::components::transform::position;
+  rynx::ecs db;
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+  for (int i = 0; i < 1000; ++i) {
+    db.create(position({ coordinate(rng), coordinate(rng), 0.0f }), i, sparse_hidden());
+  }
+  std::vector<std::pair<rynx::id, int>> before;
+  db.query().for_each([&](rynx::id id, int i) { before.emplace_back(id, i); });
+
+  db.query().sort_spatially(4.0f);
+
+  uint64_t previous_key = 0;
+  db.query().for_each([&](const position& p) {
+    uint64_t key = rynx::math::morton_key_2d(p.value, 4.0f);
+    REQUIRE(key >= previous_key);
+    previous_key = key;
+  });
+
+  // entities keep their ids, components and tags.
+  for (auto [id, i] : before) {
+    REQUIRE(db[id].get<int>() == i);
+    REQUIRE(db[id].has<sparse_hidden>());
+  }
+  REQUIRE(db.query().in<sparse_hidden>().count() == 1000);
+}
+
+struct neighbour_velocity {
+  rynx::vec3f velocity;
+};
+
+TEST_CASE("rynx ecs: spatial sort and neighbour access", "[!benchmark]") {
+  using rynx::components::transform::position;
+  constexpr int numEntities = 200000;
+  constexpr float cellSize = 1.0f;
+
+  // entities are created in random order, pairs are between neighbours in a grid, as in collision detection.
+  rynx::ecs db;
+  std::mt19937 rng(1234);
+  std::vector<int> cells(numEntities);
+  std::iota(cells.begin(), cells.end(), 0);
+  std::shuffle(cells.begin(), cells.end(), rng);
+  const int side = int(std::sqrt(float(numEntities)));
+  std::vector<rynx::id> id_of_cell(numEntities);
+  for (int cell : cells) {
+    id_of_cell[cell] = db.create(position({ float(cell % side), float(cell / side), 0.0f }), neighbour_velocity());
+  }
+  std::vector<std::pair<rynx::id, rynx::id>> pairs;
+  for (int cell = 0; cell + side + 1 < numEntities; ++cell) {
+    pairs.emplace_back(id_of_cell[cell], id_of_cell[cell + 1]);
+    pairs.emplace_back(id_of_cell[cell], id_of_cell[cell + side]);
+  }
+  std::sort(pairs.begin(), pairs.end(), [&db](auto a, auto b) {
+    auto key = [&db](rynx::id id) { return rynx::math::morton_key_2d(db[id].get<position>().value, cellSize); };
+    return key(a.first) < key(b.first);
+  });
+
+  auto resolve_pairs = [&db, &pairs]() {
+    float sum = 0;
+    for (auto [a, b] : pairs) {
+      auto& a_velocity = db[a].get<neighbour_velocity>();
+      auto& b_velocity = db[b].get<neighbour_velocity>();
+      const auto d = db[a].get<position>().value - db[b].get<position>().value;
+      a_velocity.velocity += d * 0.001f;
+      b_velocity.velocity -= d * 0.001f;
+      sum += d.x;
+    }
+    return sum;
+  };
+
+  BENCHMARK("neighbour pairs, creation order") { return resolve_pairs(); };
+  BENCHMARK("sort spatially") { db.query().sort_spatially(cellSize); return db.size(); };
+  BENCHMARK("neighbour pairs, z-order") { return resolve_pairs(); };
+}
+
+TEST_CASE("rynx ecs: random access get", "[!benchmark]") {
+  constexpr int numEntities = 1000000;
+
+  rynx::ecs db;
+  std::vector<rynx::id> ids;
+  ids.reserve(numEntities);
+  for (int i = 0; i < numEntities; ++i) {
+    ids.emplace_back(db.create(i, float(i)));
+  }
+
+  // the id -> category and index map that the entity index replaced, filled in creation order like the ecs used to.
+  rynx::unordered_map<rynx::entity_id_t, std::pair<rynx::ecs::entity_category*, rynx::index_t>> old_index;
+  for (auto id : ids) {
+    old_index.emplace(id.value, db.category_and_index_for(id.value));
+  }
+
+  std::mt19937 rng(1234);
+  std::shuffle(ids.begin(), ids.end(), rng);
+
+  BENCHMARK("get<T> via hash map") {
+    int64_t sum = 0;
+    for (auto id : ids) {
+      auto [category, index] = old_index.find(id.value)->second;
+      sum += category->table<int>()[index];
+    }
+    return sum;
+  };
+
+  BENCHMARK("get<T> via entity index") {
+    int64_t sum = 0;
+    for (auto id : ids) {
+      sum += db[id].get<int>();
+    }
+    return sum;
+  };
+}
+
 #include <rynx/ecs/blocked_table.hpp>
 #include <rynx/tech/memory_block_pool.hpp>
 
@@ -637,3 +1102,43 @@ TEST_CASE("rynx ecs internal: blocked table") {
   REQUIRE(table.size() == 0);
   REQUIRE(pool.free_blocks() == initial_allocations);
 }
+
+struct blocked_component : rynx::ecs_blocked_storage_tag {
+  blocked_component() = default;
+  blocked_component(int v) : value(v) {}
+  int value = 0;
+  char padding[60];
+};
+
+TEST_CASE("ecs blocked storage keeps component addresses stable") {
+  rynx::ecs db;
+  auto first = db.create(blocked_component(0), 0.0f);
+  const blocked_component *first_address = &db[first].get<blocked_component>();
+
+  constexpr int numEntities = 2000; // spans several blocks.
+  for (int i = 1; i < numEntities; ++i) {
+    db.create(blocked_component(i), float(i));
+  }
+  REQUIRE(&db[first].get<blocked_component>() == first_address);
+
+  int64_t sum = 0;
+  int visited = 0;
+  db.query().for_each([&](const blocked_component &c, float f) {
+    REQUIRE(float(c.value) == f);
+    sum += c.value;
+    ++visited;
+  });
+  REQUIRE(visited == numEntities);
+  REQUIRE(sum == int64_t(numEntities - 1) * numEntities / 2);
+
+  // buffers are handed out per block.
+  const size_t per_block = rynx::ecs_internal::component_block_size / sizeof(blocked_component);
+  size_t largest_buffer = 0;
+  db.query().for_each_buffer([&](size_t n, const blocked_component *, const float *) {
+    largest_buffer = std::max(largest_buffer, n);
+  });
+  REQUIRE(largest_buffer == per_block);
+
+  db.erase(first);
+  REQUIRE(db.query().count() == numEntities - 1);
+}
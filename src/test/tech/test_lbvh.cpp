@@ -0,0 +1,80 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include <catch.hpp>
+
+#include "broadphase_fixture.hpp"
+
+#include <rynx/tech/lbvh.hpp>
+#include <rynx/tech/sphere_tree.hpp>
+#include <rynx/thread/this_thread.hpp>
+
+using namespace broadphase_fixture;
+
+TEST_CASE("lbvh queries match a linear search", "[lbvh]")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	spheres data(2000, 40.0f, 0.1f, 1.0f, 17);
+	rynx::lbvh bvh;
+	for (size_t i = 0; i < data.pos.size(); ++i) {
+		bvh.insert_entity(i, data.pos[i], data.r[i]);
+	}
+	bvh.eraseEntity(7);
+	data.r[7] = -100.0f;
+	bvh.update();
+
+	for (size_t query = 0; query < 20; ++query) {
+		const rynx::vec3f point(float(query) * 2.0f, 20.0f, 20.0f);
+		const float range = float(query) * 0.5f;
+		std::vector<uint64_t> expected;
+		for (size_t i = 0; i < data.pos.size(); ++i) {
+			const float radius = range + data.r[i];
+			if (radius > 0 && (point - data.pos[i]).length_squared() < radius * radius) {
+				expected.emplace_back(i);
+			}
+		}
+
+		std::vector<uint64_t> hits;
+		bvh.in_radius(point, range, [&](uint64_t id, rynx::vec3f, float) { hits.emplace_back(id); });
+		std::sort(hits.begin(), hits.end());
+		REQUIRE(hits == expected);
+
+		hits.clear();
+		bvh.in_volume([point, range](rynx::vec3f p, float r) { return (point - p).length_squared() < (range + r) * (range + r); },
+			[&](uint64_t id, rynx::vec3f, float) { hits.emplace_back(id); });
+		std::sort(hits.begin(), hits.end());
+		REQUIRE(hits == expected);
+	}
+}
+
+TEST_CASE("lbvh rebuild vs refit vs sphere tree under motion", "[!benchmark]")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	for (size_t count : { 10'000, 100'000 }) {
+		// about ten neighbours per sphere. every frame the spheres jump up to one diameter.
+		spheres data(count, 2.0f * std::cbrt(float(count)), 0.5f, 1.0f, 5);
+		rynx::lbvh rebuilt;
+		rynx::lbvh refitted;
+		rynx::sphere_tree tree;
+		refitted.rebuild_interval(~0u);
+		for (size_t i = 0; i < count; ++i) {
+			rebuilt.insert_entity(i, data.pos[i], data.r[i]);
+			refitted.insert_entity(i, data.pos[i], data.r[i]);
+			tree.insert_entity(i, data.pos[i], data.r[i]);
+		}
+
+		auto frame = [&data](auto& broadphase) {
+			data.move(1.0f);
+			for (size_t i = 0; i < data.pos.size(); ++i) {
+				broadphase.update_entity(i, data.pos[i], data.r[i]);
+			}
+			broadphase.update();
+			size_t hits = 0;
+			broadphase.collisions([&hits](uint64_t, uint64_t, rynx::vec3f, float, rynx::vec3f, float, rynx::vec3f, float) { ++hits; });
+			return hits;
+		};
+
+		BENCHMARK("lbvh rebuild, " + std::to_string(count) + " spheres") { return frame(rebuilt); };
+		BENCHMARK("lbvh refit, " + std::to_string(count) + " spheres") { return frame(refitted); };
+		BENCHMARK("sphere tree, " + std::to_string(count) + " spheres") { return frame(tree); };
+	}
+}
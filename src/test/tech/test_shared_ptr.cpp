@@ -1,6 +1,7 @@
 
 #include <catch.hpp>
 #include <rynx/std/memory.hpp>
+#include <rynx/std/pool_allocator.hpp>
 
 TEST_CASE("shared_ptr", "copying increments use count")
 {
@@ -193,4 +194,33 @@ TEST_CASE("weak_ptr", "lock success/fail")
 
 	REQUIRE(t.expired());
 	REQUIRE(t.lock() == nullptr);
-}
\ No newline at end of file
+}
+TEST_CASE("shared_ptr from pool allocator", "object and control block in one allocation")
+{
+	struct tracked {
+		tracked(int& destroyed) : destroyed(&destroyed) {}
+		~tracked() { ++*destroyed; }
+		int* destroyed;
+	};
+
+	int destroyed = 0;
+	rynx::weak_ptr<tracked> weak;
+	{
+		rynx::shared_ptr<tracked> a = rynx::memory::pool_allocator::make_shared<tracked>(destroyed);
+		rynx::shared_ptr<tracked> b = a;
+		weak = b;
+		REQUIRE(a.do_not_use_counter_() == 2);
+		REQUIRE(weak.lock().get() == a.get());
+	}
+	REQUIRE(destroyed == 1);
+	REQUIRE(weak.expired());
+	weak.reset();
+
+	// freed blocks are reused.
+	auto first = rynx::memory::pool_allocator::make_shared<int>(1);
+	int* first_address = first.get();
+	first.reset();
+	auto second = rynx::memory::pool_allocator::make_shared<int>(2);
+	REQUIRE(second.get() == first_address);
+	REQUIRE(*second == 2);
+}
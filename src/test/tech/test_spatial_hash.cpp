@@ -0,0 +1,97 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include <catch.hpp>
+
+#include "broadphase_fixture.hpp"
+
+#include <rynx/tech/spatial_hash.hpp>
+#include <rynx/tech/sphere_tree.hpp>
+#include <rynx/thread/this_thread.hpp>
+
+using namespace broadphase_fixture;
+
+TEST_CASE("spatial hash forgets erased entities and sees moved ones", "[spatial_hash]")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+
+	// a few spheres are far larger than the rest, and have to be handled outside of the grid.
+	spheres data(3000, 60.0f, 0.1f, 1.0f, 11);
+	for (size_t i = 0; i < 10; ++i) {
+		data.r[i * 100] = 8.0f;
+	}
+
+	rynx::spatial_hash hash;
+	for (size_t i = 0; i < data.pos.size(); ++i) {
+		hash.insert_entity(i, data.pos[i], data.r[i]);
+	}
+
+	// erased entities are not reported, and the last entity moves to the freed slot.
+	hash.eraseEntity(0);
+	hash.eraseEntity(1500);
+	data.r[0] = 0;
+	data.r[1500] = 0;
+	data.pos[0] = rynx::vec3f(-1000.0f, 0.0f, 0.0f);
+	data.pos[1500] = rynx::vec3f(-2000.0f, 0.0f, 0.0f);
+	REQUIRE(!hash.contains(0));
+	REQUIRE(hash.contains(2999));
+
+	// moved entities are seen after the next update.
+	data.pos[2999] = data.pos[2998];
+	hash.update_entity(2999, data.pos[2999], data.r[2999]);
+	hash.update();
+
+	const auto expected = data.overlapping_pairs();
+	REQUIRE(expected.size() > 0);
+
+	REQUIRE(found_pairs(data, hash) == expected);
+
+	// queries see the same entities as a linear search.
+	for (size_t query = 0; query < 20; ++query) {
+		const rynx::vec3f point(float(query) * 3.0f, 30.0f, 30.0f);
+		const float range = float(query) * 0.5f;
+		std::vector<uint64_t> hits;
+		hash.in_radius(point, range, [&](uint64_t id, rynx::vec3f, float) { hits.emplace_back(id); });
+
+		std::vector<uint64_t> expected_hits;
+		for (size_t i = 0; i < data.pos.size(); ++i) {
+			const float radius = range + data.r[i];
+			if (i != 0 && i != 1500 && (point - data.pos[i]).length_squared() < radius * radius) {
+				expected_hits.emplace_back(i);
+			}
+		}
+		std::sort(hits.begin(), hits.end());
+		REQUIRE(hits == expected_hits);
+	}
+}
+
+TEST_CASE("spatial hash vs sphere tree collisions", "[!benchmark]")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	for (size_t count : { 10'000, 100'000, 1'000'000 }) {
+		// about ten neighbours per sphere regardless of the count.
+		spheres data(count, 2.0f * std::cbrt(float(count)), 0.5f, 1.0f, 5);
+		rynx::spatial_hash hash;
+		rynx::sphere_tree tree;
+		for (size_t i = 0; i < count; ++i) {
+			hash.insert_entity(i, data.pos[i], data.r[i]);
+			tree.insert_entity(i, data.pos[i], data.r[i]);
+		}
+		hash.update();
+		tree.update();
+
+		BENCHMARK("spatial hash build, " + std::to_string(count) + " spheres") {
+			hash.update();
+			return hash.size();
+		};
+		BENCHMARK("spatial hash collisions, " + std::to_string(count) + " spheres") {
+			size_t hits = 0;
+			hash.collisions([&hits](uint64_t, uint64_t, rynx::vec3f, float, rynx::vec3f, float, rynx::vec3f, float) { ++hits; });
+			return hits;
+		};
+		BENCHMARK("sphere tree collisions, " + std::to_string(count) + " spheres") {
+			size_t hits = 0;
+			tree.collisions([&hits](uint64_t, uint64_t, rynx::vec3f, float, rynx::vec3f, float, rynx::vec3f, float) { ++hits; });
+			return hits;
+		};
+	}
+}
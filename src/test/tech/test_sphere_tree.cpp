@@ -0,0 +1,115 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include <catch.hpp>
+
+#include "broadphase_fixture.hpp"
+
+#include <rynx/tech/sphere_tree.hpp>
+#include <rynx/tech/sphere_overlap.hpp>
+#include <rynx/thread/this_thread.hpp>
+
+using broadphase_fixture::sorted;
+
+namespace {
+	struct sphere_arrays {
+		sphere_arrays(size_t count, float extent, float max_radius, uint32_t seed) {
+			std::mt19937 rng(seed);
+			std::uniform_real_distribution<float> coordinate(0.0f, extent);
+			std::uniform_real_distribution<float> radius(0.1f, max_radius);
+			const size_t padded = rynx::sphere_overlap::padded_size(count);
+			x.resize(padded);
+			y.resize(padded);
+			z.resize(padded);
+			r.resize(padded);
+			for (size_t i = 0; i < count; ++i) {
+				x[i] = coordinate(rng);
+				y[i] = coordinate(rng);
+				z[i] = coordinate(rng);
+				r[i] = radius(rng);
+			}
+			size = count;
+		}
+
+		rynx::sphere_overlap::spheres_view view(size_t begin = 0, size_t count = ~size_t(0)) const {
+			return { x.data() + begin, y.data() + begin, z.data() + begin, r.data() + begin, std::min(count, size - begin) };
+		}
+
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+		std::vector<float> r;
+		size_t size = 0;
+	};
+}
+
+TEST_CASE("sphere overlap kernels match the scalar path", "[sphere_tree]")
+{
+	for (size_t count : { 0, 1, 7, 8, 9, 31, 128, 333 }) {
+		sphere_arrays spheres(count, 10.0f, 1.5f, uint32_t(count));
+
+		std::vector<std::pair<size_t, size_t>> scalar_pairs;
+		std::vector<std::pair<size_t, size_t>> pairs;
+		rynx::sphere_overlap::all_pairs_scalar(spheres.view(), [&](size_t i, size_t k) { scalar_pairs.emplace_back(i, k); });
+		rynx::sphere_overlap::all_pairs(spheres.view(), [&](size_t i, size_t k) { pairs.emplace_back(i, k); });
+		REQUIRE(sorted(pairs) == sorted(scalar_pairs));
+
+		// starting from every offset exercises the masking of lanes before the first sphere.
+		for (size_t begin = 0; begin < std::min<size_t>(count, 20); ++begin) {
+			std::vector<size_t> scalar_hits;
+			std::vector<size_t> hits;
+			rynx::sphere_overlap::one_vs_many_scalar(5.0f, 5.0f, 5.0f, 2.0f, spheres.view(), begin, [&](size_t k) { scalar_hits.emplace_back(k); });
+			rynx::sphere_overlap::one_vs_many(5.0f, 5.0f, 5.0f, 2.0f, spheres.view(), begin, [&](size_t k) { hits.emplace_back(k); });
+			REQUIRE(hits == scalar_hits);
+		}
+	}
+}
+
+TEST_CASE("sphere overlap kernels vs scalar", "[!benchmark]")
+{
+	// the avx2 kernel is only timed on cpus that have it.
+	WARN("avx2 kernel " << (rynx::sphere_overlap::cpu_has_avx2() ? "used" : "not available"));
+
+	// leaf sized groups, the way the sphere tree runs the kernels.
+	static constexpr size_t group_size = 128;
+	for (size_t count : { 10'000, 100'000, 1'000'000 }) {
+		sphere_arrays spheres(count, 20.0f, 1.0f, 3);
+		auto run = [&spheres](auto&& all_pairs) {
+			size_t hits = 0;
+			for (size_t begin = 0; begin < spheres.size; begin += group_size) {
+				all_pairs(spheres.view(begin, group_size), [&hits](size_t, size_t) { ++hits; });
+			}
+			return hits;
+		};
+
+		BENCHMARK("scalar, " + std::to_string(count) + " spheres") {
+			return run([](const auto& view, auto&& hit) { rynx::sphere_overlap::all_pairs_scalar(view, hit); });
+		};
+#if defined(rynx_sphere_overlap_avx2)
+		if (rynx::sphere_overlap::cpu_has_avx2()) {
+			BENCHMARK("avx2, " + std::to_string(count) + " spheres") {
+				return run([](const auto& view, auto&& hit) { rynx::sphere_overlap::all_pairs_avx2(view, hit); });
+			};
+		}
+#endif
+	}
+}
+
+TEST_CASE("sphere tree collisions", "[!benchmark]")
+{
+	rynx::this_thread::rynx_thread_raii obj;
+	for (size_t count : { 10'000, 100'000, 1'000'000 }) {
+		// about ten neighbours per sphere regardless of the count.
+		sphere_arrays spheres(count, 2.0f * std::cbrt(float(count)), 1.0f, 5);
+		rynx::sphere_tree tree;
+		for (size_t i = 0; i < count; ++i) {
+			tree.insert_entity(i, { spheres.x[i], spheres.y[i], spheres.z[i] }, spheres.r[i]);
+		}
+		tree.update();
+
+		BENCHMARK("collisions, " + std::to_string(count) + " spheres") {
+			size_t hits = 0;
+			tree.collisions([&hits](uint64_t, uint64_t, rynx::vec3f, float, rynx::vec3f, float, rynx::vec3f, float) { ++hits; });
+			return hits;
+		};
+	}
+}